@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Platform hooks of the benchmark suite, implemented in host/ and esp/
+
+// Platform name reported in the JSON output
+const char *bench_platform_name(void);
+
+// Engine behind hal_jpeg on this platform
+const char *bench_platform_jpeg_engine(void);
+
+// Writable directory for the end-to-end slide case
+const char *bench_platform_scratch_dir(void);
+
+// Encode packed RGB888 to baseline JPEG, *out comes from image_buffer_alloc
+esp_err_t bench_platform_encode_jpeg(const uint8_t *rgb888, uint32_t width, uint32_t height,
+                                     uint8_t **out, size_t *out_size);
+
+// Software JPEG decoder (not hal_jpeg) into a width x height RGB565 buffer
+esp_err_t bench_platform_sw_jpeg_decode(const uint8_t *data, size_t data_size,
+                                        uint16_t *rgb565, uint32_t width, uint32_t height);
+
+#ifdef __cplusplus
+}
+#endif
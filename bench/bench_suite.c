@@ -0,0 +1,1612 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "bench_suite.h"
+#include "bench_platform.h"
+#include "photo_album.h"
+#include "file_manager.h"
+#include "image_decoder.h"
+#include "image_processor.h"
+#include "video_transform.h"
+#include "video_output.h"
+#include "frame_index.h"
+#include "mp4_layout.h"
+#include "read_ahead.h"
+#include "jpeg_sched.h"
+#include "frame_hash.h"
+#include "yuv_convert.h"
+#ifndef PHOTO_ALBUM_HOST_BUILD
+#include "app_extractor.h"
+#include "resume_store.h"
+#endif
+// The host runs the H.264 cases against its stand-in codec (host/shim/esp_h264_shim.c)
+#if defined(PHOTO_ALBUM_HOST_BUILD) || CONFIG_VIDEO_H264_DECODE
+#define BENCH_H264              1
+#include "h264_decoder.h"
+#include "esp_h264_enc.h"
+#include "esp_h264_enc_sw.h"
+#endif
+#include "hal_display.h"
+#include "image_buffer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "png.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *TAG = "bench";
+
+#define BENCH_RESULTS_GROW      64          // Result rows added whenever the table is full
+#define BENCH_NAME_LEN          32
+#define BENCH_CLIP_FRAMES       9000        // 5 minutes at 30 fps
+#define BENCH_CLIP_FPS          30
+#define BENCH_READ_FILE_SIZE    (4 * 1024 * 1024)
+#define BENCH_SCHED_TASKS       2           // Background decoders contending with the measured slide decodes
+#define BENCH_SCHED_TASK_STACK  (4 * 1024)
+#define BENCH_SCHED_TASK_PRIO   2
+#define BENCH_READ_CHUNK        (512 * 1024 / 3)    // The extractor's cache block, what it asks the file for
+#define BENCH_YUV_MAX_ERROR     2           // Levels the integer conversion may be off the exact BT.601 result
+#define BENCH_H264_FRAMES       30          // One GOP of the encoded clip, an IDR and P frames
+#define BENCH_H264_SCROLL       2           // Pixels the picture moves per frame, so P frames carry motion
+#define BENCH_H264_MIN_PSNR     30.0        // dB every decoded frame must reach against its source
+#ifdef PHOTO_ALBUM_HOST_BUILD
+#define BENCH_H264_CLIP_BPP     4           // Bytes per pixel for the whole clip; the stand-in sends raw IDR samples
+#else
+#define BENCH_H264_CLIP_BPP     2
+#endif
+
+// Synthetic input sizes: landscape full HD/HD, portrait panel, small VGA
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+} bench_size_t;
+
+static const bench_size_t s_sizes[] = {
+    {1920, 1080},
+    {1280, 720},
+    {800, 1280},
+    {640, 480},
+};
+
+typedef struct {
+    char name[BENCH_NAME_LEN];
+    uint32_t width;
+    uint32_t height;
+    uint32_t iterations;
+    double ms_per_frame;
+    double mpix_per_s;
+    size_t peak_buffer_bytes;       // Peak image_buffer usage above the case's baseline
+    double mb_per_s;                // Read cases: sustained file throughput
+    double headroom;                // Read cases: mb_per_s over the MJPEG stream rate of this size
+    esp_err_t result;
+    bool skipped;                   // Nothing to measure at this size, reported as such instead of as 0 ms
+} bench_result_t;
+
+// Grown as cases run, so every case of every size ends up in the report
+static bench_result_t *s_results;
+static int s_result_count = 0;
+static int s_result_capacity = 0;
+static esp_err_t s_results_error;  // Set when a row could not be added; fails the run
+
+typedef esp_err_t (*bench_fn_t)(void *ctx);
+
+// Case contexts
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    image_format_t format;
+} decode_ctx_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    uint16_t *out;
+    uint32_t width;
+    uint32_t height;
+} sw_decode_ctx_t;
+
+typedef struct {
+    const uint8_t *rgb888;
+    uint16_t *rgb565;
+    uint32_t pixels;
+} convert_ctx_t;
+
+typedef struct {
+    const decoded_image_t *input;
+    process_params_t params;
+} scale_ctx_t;
+
+typedef struct {
+    video_transform_handle_t transform;
+    video_transform_plan_t plan;
+    const decoded_image_t *input;
+    void *out;
+    size_t out_size;
+} video_srm_ctx_t;
+
+typedef struct {
+    video_output_handle_t output;
+    const decoded_image_t *input;
+} video_direct_ctx_t;
+
+typedef struct {
+    char path[MAX_FILENAME_LEN];
+} slide_ctx_t;
+
+typedef struct {
+    char path[MAX_FILENAME_LEN];
+    char cache_dir[MAX_FILENAME_LEN];
+    frame_index_handle_t index;
+    uint8_t *frame;
+    uint32_t next_ms;
+} frame_index_ctx_t;
+
+typedef struct {
+    char path[MAX_FILENAME_LEN];
+    uint8_t *chunk;
+} card_read_ctx_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    volatile bool stop;
+    SemaphoreHandle_t done;         // Given by each background task as it exits
+} sched_ctx_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    uint32_t hash;                  // Kept so the hashing is not optimised away
+} hash_ctx_t;
+
+typedef struct {
+    yuv_i420_t picture;
+    void *out;                      // Frame of the output format
+    bool rgb888;
+} yuv_ctx_t;
+
+#ifdef BENCH_H264
+typedef struct {
+    h264_decoder_handle_t decoder;
+    uint8_t *stream;                // BENCH_H264_FRAMES access units back to back, the first an IDR
+    size_t offsets[BENCH_H264_FRAMES + 1];
+    uint32_t next;
+    uint16_t *rgb565;               // Converted into like the stream adapter does, NULL to only decode
+} h264_ctx_t;
+#endif
+
+#ifndef PHOTO_ALBUM_HOST_BUILD
+typedef struct {
+    const char *path;
+    const char *cache_dir;          // Resume the clip from the entry stored here, NULL for a full parse
+    app_extractor_handle_t extractor;
+    bool shown;
+    esp_err_t decode_result;
+} video_open_ctx_t;
+
+// Extractor frame callbacks carry no context
+static video_open_ctx_t *s_video_open;
+#endif
+
+static const char *s_scale_mode_names[] = {
+    [SCALE_MODE_FIT] = "fit",
+    [SCALE_MODE_FILL] = "fill",
+    [SCALE_MODE_CENTER] = "center",
+    [SCALE_MODE_CROP_ONLY] = "crop_only",
+};
+
+static esp_err_t run_decode(void *ctx)
+{
+    decode_ctx_t *c = (decode_ctx_t *)ctx;
+    decoded_image_t image;
+    esp_err_t ret = image_decoder_decode(c->data, c->size, c->format, &image);
+    image_decoder_free_image(&image);
+    return ret;
+}
+
+static esp_err_t run_sw_decode(void *ctx)
+{
+    sw_decode_ctx_t *c = (sw_decode_ctx_t *)ctx;
+    return bench_platform_sw_jpeg_decode(c->data, c->size, c->out, c->width, c->height);
+}
+
+static esp_err_t run_convert(void *ctx)
+{
+    convert_ctx_t *c = (convert_ctx_t *)ctx;
+    image_decoder_rgb888_to_rgb565(c->rgb888, c->rgb565, c->pixels);
+    return ESP_OK;
+}
+
+static esp_err_t run_scale(void *ctx)
+{
+    scale_ctx_t *c = (scale_ctx_t *)ctx;
+    decoded_image_t output = {0};
+    esp_err_t ret = image_processor_process(c->input, &output, &c->params);
+    image_decoder_free_image(&output);
+    return ret;
+}
+
+static esp_err_t run_video_srm(void *ctx)
+{
+    video_srm_ctx_t *c = (video_srm_ctx_t *)ctx;
+    return video_transform_run(c->transform, &c->plan, c->input->rgb_data, c->input->data_size,
+                               c->out, c->out_size);
+}
+
+static esp_err_t run_video_direct(void *ctx)
+{
+    video_direct_ctx_t *c = (video_direct_ctx_t *)ctx;
+    return video_output_present(c->output, c->input->rgb_data, c->input->data_size,
+                                c->input->width, c->input->height);
+}
+
+// Index a clip from its sample tables, as the first play of it does
+static esp_err_t run_frame_index_build(void *ctx)
+{
+    frame_index_ctx_t *c = (frame_index_ctx_t *)ctx;
+    frame_index_handle_t index = NULL;
+    esp_err_t ret = frame_index_open(c->path, NULL, &index);
+    frame_index_close(index);
+    return ret;
+}
+
+// Load it back from the cache, as every later play does
+static esp_err_t run_frame_index_load(void *ctx)
+{
+    frame_index_ctx_t *c = (frame_index_ctx_t *)ctx;
+    frame_index_handle_t index = NULL;
+    esp_err_t ret = frame_index_open(c->path, c->cache_dir, &index);
+    frame_index_close(index);
+    return ret;
+}
+
+// The scan-time check for a clip whose moov follows its media data
+static esp_err_t run_mp4_probe(void *ctx)
+{
+    frame_index_ctx_t *c = (frame_index_ctx_t *)ctx;
+    mp4_layout_t layout;
+    esp_err_t ret = mp4_layout_probe(c->path, &layout);
+    if (ret == ESP_OK && !layout.moov_at_end) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ret;
+}
+
+// One scrub step: find the frame a little further on, read and decode only it
+static esp_err_t run_frame_index_scrub(void *ctx)
+{
+    frame_index_ctx_t *c = (frame_index_ctx_t *)ctx;
+    c->next_ms = (c->next_ms + 7919) % frame_index_duration_ms(c->index);
+    uint32_t frame = frame_index_find(c->index, c->next_ms);
+    const frame_index_entry_t *entry = frame_index_get(c->index, frame);
+
+    esp_err_t ret = frame_index_read(c->index, frame, c->frame, frame_index_max_size(c->index));
+    if (ret == ESP_OK) {
+        decoded_image_t image;
+        ret = image_decoder_decode(c->frame, entry->size, IMAGE_FORMAT_JPEG, &image);
+        image_decoder_free_image(&image);
+    }
+    return ret;
+}
+
+// Keeps the JPEG engine queue full of background jobs until told to stop
+static void sched_background_task(void *arg)
+{
+    sched_ctx_t *c = (sched_ctx_t *)arg;
+    while (!c->stop) {
+        decoded_image_t image;
+        if (image_decoder_decode_background(c->data, c->size, IMAGE_FORMAT_JPEG, &image) == ESP_OK) {
+            image_decoder_free_image(&image);
+        }
+    }
+    xSemaphoreGive(c->done);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t run_frame_hash(void *ctx)
+{
+    hash_ctx_t *c = (hash_ctx_t *)ctx;
+    c->hash ^= frame_hash(c->data, c->size);
+    return ESP_OK;
+}
+
+static esp_err_t run_yuv_convert(void *ctx)
+{
+    yuv_ctx_t *c = (yuv_ctx_t *)ctx;
+    if (c->rgb888) {
+        yuv_i420_to_rgb888(&c->picture, c->out, c->picture.width, false);
+    } else {
+        yuv_i420_to_rgb565(&c->picture, c->out, c->picture.width, true);
+    }
+    return ESP_OK;
+}
+
+#ifdef BENCH_H264
+// Next frame of the clip, wrapping to its IDR; the adapter's decode stage per frame
+static esp_err_t run_h264_decode(void *ctx)
+{
+    h264_ctx_t *c = (h264_ctx_t *)ctx;
+    uint32_t i = c->next;
+    c->next = (c->next + 1) % BENCH_H264_FRAMES;
+
+    yuv_i420_t picture;
+    esp_err_t ret = h264_decoder_decode(c->decoder, c->stream + c->offsets[i],
+                                        c->offsets[i + 1] - c->offsets[i], &picture);
+    if (ret == ESP_ERR_NOT_FINISHED) {
+        return ESP_OK;
+    }
+    if (ret == ESP_OK && c->rgb565) {
+        yuv_i420_to_rgb565(&picture, c->rgb565, picture.width, true);
+    }
+    return ret;
+}
+#endif
+
+// The whole file in extractor sized reads, straight from the card
+static esp_err_t run_card_read(void *ctx)
+{
+    card_read_ctx_t *c = (card_read_ctx_t *)ctx;
+    int fd = open(c->path, O_RDONLY);
+    if (fd < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    size_t total = 0;
+    ssize_t n;
+    while ((n = read(fd, c->chunk, BENCH_READ_CHUNK)) > 0) {
+        total += n;
+    }
+    close(fd);
+    return (n == 0 && total == BENCH_READ_FILE_SIZE) ? ESP_OK : ESP_FAIL;
+}
+
+// The same reads served from the read-ahead window
+static esp_err_t run_card_read_ahead(void *ctx)
+{
+    card_read_ctx_t *c = (card_read_ctx_t *)ctx;
+    read_ahead_config_t config = {
+        .block_size = READ_AHEAD_DEFAULT_BLOCK_SIZE,
+        .block_count = READ_AHEAD_DEFAULT_BLOCK_COUNT,
+        .task_priority = READ_AHEAD_DEFAULT_TASK_PRIO,
+        .task_stack_size = READ_AHEAD_DEFAULT_TASK_STACK,
+    };
+    read_ahead_handle_t reader = NULL;
+    esp_err_t ret = read_ahead_open(c->path, &config, &reader);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    size_t total = 0;
+    int n;
+    while ((n = read_ahead_read(reader, c->chunk, BENCH_READ_CHUNK)) > 0) {
+        total += n;
+    }
+    read_ahead_close(reader);
+    return (n == 0 && total == BENCH_READ_FILE_SIZE) ? ESP_OK : ESP_FAIL;
+}
+
+#ifndef PHOTO_ALBUM_HOST_BUILD
+static esp_err_t video_open_frame_cb(uint8_t *buffer, uint32_t buffer_size, bool is_video, uint32_t pts)
+{
+    video_open_ctx_t *c = s_video_open;
+    if (is_video && !c->shown) {
+        decoded_image_t image;
+        c->decode_result = image_decoder_decode(buffer, buffer_size, IMAGE_FORMAT_JPEG, &image);
+        image_decoder_free_image(&image);
+        c->shown = true;
+    }
+    // Not retained, the extractor frees it
+    return ESP_FAIL;
+}
+
+// Open a clip and decode its first frame, with or without its stored resume info
+static esp_err_t run_video_open(void *ctx)
+{
+    video_open_ctx_t *c = (video_open_ctx_t *)ctx;
+    esp_extractor_resume_info_t info = {0};
+    uint32_t position_ms = 0;
+    if (c->cache_dir) {
+        esp_err_t ret = resume_store_load(c->cache_dir, c->path, &info, &position_ms);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        app_extractor_set_resume_info(c->extractor, &info);
+    }
+
+    c->shown = false;
+    esp_err_t ret = app_extractor_prepare(c->extractor, c->path, true, false);
+    for (int reads = 0; ret == ESP_OK && !c->shown && reads < 64; reads++) {
+        ret = app_extractor_read_frame(c->extractor);
+    }
+    if (ret == ESP_OK) {
+        ret = !c->shown ? ESP_ERR_NOT_FOUND :
+              (c->cache_dir && !app_extractor_is_resumed(c->extractor)) ? ESP_ERR_NOT_SUPPORTED : c->decode_result;
+    }
+    app_extractor_stop(c->extractor);
+    resume_store_free(&info);
+    return ret;
+}
+#endif
+
+// Same stages as load_and_display_image() without the UI
+static esp_err_t run_slide(void *ctx)
+{
+    slide_ctx_t *c = (slide_ctx_t *)ctx;
+    uint8_t *file_data = NULL;
+    size_t file_size = 0;
+    decoded_image_t decoded = {0};
+    decoded_image_t processed = {0};
+
+    esp_err_t ret = file_manager_load_image(c->path, &file_data, &file_size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ret = image_decoder_decode(file_data, file_size, IMAGE_FORMAT_JPEG, &decoded);
+    image_buffer_free(file_data);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (decoded.width != SCREEN_WIDTH || decoded.height != SCREEN_HEIGHT) {
+        process_params_t params;
+        scale_mode_t mode = image_processor_select_display_mode(decoded.width, decoded.height,
+                                                                SCREEN_WIDTH, SCREEN_HEIGHT);
+        ret = image_processor_calculate_params(decoded.width, decoded.height,
+                                               SCREEN_WIDTH, SCREEN_HEIGHT, mode, &params);
+        if (ret == ESP_OK) {
+            ret = image_processor_process(&decoded, &processed, &params);
+        }
+    }
+
+    image_decoder_free_image(&processed);
+    image_decoder_free_image(&decoded);
+    return ret;
+}
+
+// Next row of the result table, NULL when the case is filtered out or the table cannot grow
+static bench_result_t *bench_add_result(const bench_config_t *config, const char *name,
+                                        uint32_t width, uint32_t height)
+{
+    if (config->filter && !strstr(name, config->filter)) {
+        return NULL;
+    }
+    if (s_results_error != ESP_OK) {
+        return NULL;
+    }
+    if (s_result_count == s_result_capacity) {
+        bench_result_t *results = realloc(s_results, (s_result_capacity + BENCH_RESULTS_GROW) * sizeof(*results));
+        if (!results) {
+            ESP_LOGE(TAG, "No memory for the result of %s, stopping", name);
+            s_results_error = ESP_ERR_NO_MEM;
+            return NULL;
+        }
+        s_results = results;
+        s_result_capacity += BENCH_RESULTS_GROW;
+    }
+
+    bench_result_t *r = &s_results[s_result_count++];
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->width = width;
+    r->height = height;
+    return r;
+}
+
+// A case with nothing to measure at this size, kept in the table as skipped
+static void bench_skip(const bench_config_t *config, const char *name,
+                       uint32_t width, uint32_t height, const char *reason)
+{
+    bench_result_t *r = bench_add_result(config, name, width, height);
+    if (!r) {
+        return;
+    }
+    r->result = ESP_OK;
+    r->skipped = true;
+    ESP_LOGI(TAG, "%-18s %4"PRIu32"x%-4"PRIu32" skipped: %s", name, width, height, reason);
+}
+
+static void bench_case(const bench_config_t *config, const char *name,
+                       uint32_t width, uint32_t height, bench_fn_t fn, void *ctx)
+{
+    bench_result_t *r = bench_add_result(config, name, width, height);
+    if (!r) {
+        return;
+    }
+
+    // Warm-up run pays for first-touch allocations and engine setup
+    esp_err_t ret = fn(ctx);
+
+    image_buffer_stats_t before;
+    image_buffer_get_stats(&before);
+    image_buffer_reset_peak();
+
+    int64_t start_us = esp_timer_get_time();
+    uint32_t done = 0;
+    while (ret == ESP_OK && done < config->iterations) {
+        ret = fn(ctx);
+        done++;
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+    image_buffer_stats_t after;
+    image_buffer_get_stats(&after);
+
+    r->result = ret;
+    r->iterations = done;
+    r->peak_buffer_bytes = (after.peak_bytes > before.bytes_in_use) ? after.peak_bytes - before.bytes_in_use : 0;
+    if (done > 0 && elapsed_us > 0) {
+        r->ms_per_frame = (double)elapsed_us / 1000.0 / done;
+        r->mpix_per_s = (double)width * height * done / elapsed_us;
+    }
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "%-18s %4"PRIu32"x%-4"PRIu32" %9.3f ms %8.2f MP/s peak %zu B",
+                 name, width, height, r->ms_per_frame, r->mpix_per_s, r->peak_buffer_bytes);
+    } else {
+        ESP_LOGW(TAG, "%-18s %4"PRIu32"x%-4"PRIu32" failed: %s", name, width, height, esp_err_to_name(ret));
+    }
+
+    // Let the idle task run between cases
+    vTaskDelay(1);
+}
+
+// Gradient with a checkerboard and fine texture so the codecs see real work
+static uint8_t *generate_rgb888(uint32_t width, uint32_t height)
+{
+    uint8_t *rgb = heap_caps_malloc((size_t)width * height * 3, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!rgb) {
+        return NULL;
+    }
+
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t *row = rgb + (size_t)y * width * 3;
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t texture = (uint8_t)((x ^ y) & 0x1F);
+            uint8_t checker = (((x >> 5) + (y >> 5)) & 1) ? 0x40 : 0;
+            row[x * 3 + 0] = (uint8_t)(x * 255 / width) ^ texture;
+            row[x * 3 + 1] = (uint8_t)(y * 255 / height) ^ checker;
+            row[x * 3 + 2] = (uint8_t)((x + y) * 255 / (width + height)) + texture;
+        }
+    }
+    return rgb;
+}
+
+static esp_err_t encode_png(const uint8_t *rgb888, uint32_t width, uint32_t height,
+                            uint8_t **out, size_t *out_size)
+{
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    image.width = width;
+    image.height = height;
+    image.format = PNG_FORMAT_RGB;
+
+    png_alloc_size_t size = 0;
+    if (!png_image_write_to_memory(&image, NULL, &size, 0, rgb888, 0, NULL)) {
+        ESP_LOGE(TAG, "PNG size query failed: %s", image.message);
+        return ESP_FAIL;
+    }
+
+    *out = image_buffer_alloc(size, NULL);
+    if (!*out) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (!png_image_write_to_memory(&image, *out, &size, 0, rgb888, 0, NULL)) {
+        ESP_LOGE(TAG, "PNG encode failed: %s", image.message);
+        image_buffer_free(*out);
+        *out = NULL;
+        return ESP_FAIL;
+    }
+    *out_size = size;
+    return ESP_OK;
+}
+
+static esp_err_t write_file(const char *path, const uint8_t *data, size_t size)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to create %s", path);
+        return ESP_FAIL;
+    }
+    size_t written = fwrite(data, 1, size, f);
+    fclose(f);
+    return (written == size) ? ESP_OK : ESP_FAIL;
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+} box_writer_t;
+
+static void box_u32(box_writer_t *w, uint32_t v)
+{
+    put_be32(w->data + w->len, v);
+    w->len += 4;
+}
+
+static size_t box_begin(box_writer_t *w, const char *type)
+{
+    size_t start = w->len;
+    box_u32(w, 0);
+    memcpy(w->data + w->len, type, 4);
+    w->len += 4;
+    return start;
+}
+
+static void box_end(box_writer_t *w, size_t start)
+{
+    put_be32(w->data + start, (uint32_t)(w->len - start));
+}
+
+// Identity transform of mvhd and tkhd
+static void box_matrix(box_writer_t *w)
+{
+    static const uint32_t identity[9] = {0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000};
+    for (int i = 0; i < 9; i++) {
+        box_u32(w, identity[i]);
+    }
+}
+
+// MP4 with one MJPEG track whose samples all point at the same JPEG: the
+// sample tables of a long clip for the disk space of a single frame
+static esp_err_t write_mjpeg_clip(const char *path, const uint8_t *jpeg, size_t jpeg_size,
+                                  uint32_t width, uint32_t height, uint32_t frames)
+{
+    box_writer_t w = { .data = calloc(1, 1024 + (size_t)frames * 4) };
+    if (!w.data) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t box = box_begin(&w, "ftyp");
+    memcpy(w.data + w.len, "isom\0\0\0\0isom", 12);
+    w.len += 12;
+    box_end(&w, box);
+    size_t mdat_header = w.len;
+    uint32_t data_offset = (uint32_t)mdat_header + 8;
+    w.len += 8;
+
+    size_t moov_start = w.len;
+    size_t moov = box_begin(&w, "moov");
+    box = box_begin(&w, "mvhd");
+    box_u32(&w, 0);                                 // Version 0, flags
+    w.len += 8;                                     // Creation, modification time
+    box_u32(&w, 1000);                              // Timescale
+    box_u32(&w, frames * 1000 / BENCH_CLIP_FPS);    // Duration
+    box_u32(&w, 0x00010000);                        // Rate 1.0
+    box_u32(&w, 0x01000000);                        // Volume 1.0, reserved
+    w.len += 8;
+    box_matrix(&w);
+    w.len += 24;                                    // Pre-defined
+    box_u32(&w, 2);                                 // Next track ID
+    box_end(&w, box);
+    size_t trak = box_begin(&w, "trak");
+    box = box_begin(&w, "tkhd");
+    box_u32(&w, 3);                                 // Version 0, enabled and in movie
+    w.len += 8;                                     // Creation, modification time
+    box_u32(&w, 1);                                 // Track ID
+    w.len += 4;
+    box_u32(&w, frames * 1000 / BENCH_CLIP_FPS);    // Duration in mvhd timescale
+    w.len += 16;                                    // Reserved, layer, group, volume
+    box_matrix(&w);
+    box_u32(&w, width << 16);
+    box_u32(&w, height << 16);
+    box_end(&w, box);
+    size_t mdia = box_begin(&w, "mdia");
+    box = box_begin(&w, "mdhd");
+    box_u32(&w, 0);                                 // Version 0, flags
+    box_u32(&w, 0);                                 // Creation time
+    box_u32(&w, 0);                                 // Modification time
+    box_u32(&w, BENCH_CLIP_FPS * 1000);             // Timescale
+    box_u32(&w, frames * 1000);                     // Duration
+    box_u32(&w, 0);                                 // Language, pre-defined
+    box_end(&w, box);
+    box = box_begin(&w, "hdlr");
+    box_u32(&w, 0);
+    box_u32(&w, 0);
+    memcpy(w.data + w.len, "vide", 4);
+    w.len += 4 + 12 + 1;                            // Reserved, empty name
+    box_end(&w, box);
+    size_t minf = box_begin(&w, "minf");
+    size_t stbl = box_begin(&w, "stbl");
+    box = box_begin(&w, "stsd");
+    box_u32(&w, 0);
+    box_u32(&w, 1);
+    size_t entry = box_begin(&w, "jpeg");
+    w.len += 6;
+    w.data[w.len++] = 0;                            // Data reference index 1
+    w.data[w.len++] = 1;
+    w.len += 16;                                    // Pre-defined, reserved
+    w.data[w.len++] = width >> 8;
+    w.data[w.len++] = width;
+    w.data[w.len++] = height >> 8;
+    w.data[w.len++] = height;
+    box_u32(&w, 0x00480000);                        // 72 dpi
+    box_u32(&w, 0x00480000);
+    w.len += 4;
+    w.data[w.len++] = 0;                            // One frame per sample
+    w.data[w.len++] = 1;
+    w.len += 32;                                    // Compressor name
+    w.data[w.len++] = 0;                            // Depth 24
+    w.data[w.len++] = 24;
+    w.data[w.len++] = 0xff;                         // Pre-defined -1
+    w.data[w.len++] = 0xff;
+    box_end(&w, entry);
+    box_end(&w, box);
+    box = box_begin(&w, "stts");
+    box_u32(&w, 0);
+    box_u32(&w, 1);
+    box_u32(&w, frames);
+    box_u32(&w, 1000);
+    box_end(&w, box);
+    box = box_begin(&w, "stsc");
+    box_u32(&w, 0);
+    box_u32(&w, 1);
+    box_u32(&w, 1);                                 // From chunk 1, one sample per chunk
+    box_u32(&w, 1);
+    box_u32(&w, 1);
+    box_end(&w, box);
+    box = box_begin(&w, "stsz");
+    box_u32(&w, 0);
+    box_u32(&w, (uint32_t)jpeg_size);
+    box_u32(&w, frames);
+    box_end(&w, box);
+    box = box_begin(&w, "stco");
+    box_u32(&w, 0);
+    box_u32(&w, frames);
+    for (uint32_t i = 0; i < frames; i++) {
+        box_u32(&w, data_offset);
+    }
+    box_end(&w, box);
+    box_end(&w, stbl);
+    box_end(&w, minf);
+    box_end(&w, mdia);
+    box_end(&w, trak);
+    box_end(&w, moov);
+
+    // mdat sits between the headers and moov, as a recorder writes it
+    put_be32(w.data + mdat_header, 8 + (uint32_t)jpeg_size);
+    memcpy(w.data + mdat_header + 4, "mdat", 4);
+
+    FILE *f = fopen(path, "wb");
+    bool ok = f && fwrite(w.data, 1, moov_start, f) == moov_start &&
+              fwrite(jpeg, 1, jpeg_size, f) == jpeg_size &&
+              fwrite(w.data + moov_start, 1, w.len - moov_start, f) == w.len - moov_start;
+    if (f) {
+        ok = fclose(f) == 0 && ok;
+    }
+    free(w.data);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+static void remove_dir(const char *path)
+{
+    DIR *dir = opendir(path);
+    if (dir) {
+        struct dirent *entry;
+        char file[MAX_FILENAME_LEN * 2];
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] != '.') {
+                snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+                remove(file);
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(path);
+}
+
+// Open to first decoded frame of a clip with moov at the end, parsing its
+// container and then from the resume info a stopped play, or the parse ahead at
+// scan time, stored. The extractor only runs on the P4.
+static void bench_video_open(const bench_config_t *config, uint32_t width, uint32_t height,
+                             const char *path, const char *cache_dir)
+{
+#ifndef PHOTO_ALBUM_HOST_BUILD
+    video_open_ctx_t ctx = { .path = path };
+    s_video_open = &ctx;
+    if (app_extractor_init(video_open_frame_cb, NULL, &ctx.extractor) != ESP_OK) {
+        return;
+    }
+    bench_case(config, "video_open", width, height, run_video_open, &ctx);
+
+    // Stored the way a stop of the clip does
+    esp_extractor_resume_info_t info;
+    if (app_extractor_prepare(ctx.extractor, path, true, false) == ESP_OK &&
+            app_extractor_get_resume_info(ctx.extractor, &info) == ESP_OK) {
+        resume_store_save(cache_dir, path, &info, 0);
+        esp_extractor_free_resume_info(&info);
+    }
+    app_extractor_stop(ctx.extractor);
+
+    ctx.cache_dir = cache_dir;
+    bench_case(config, "video_open_resumed", width, height, run_video_open, &ctx);
+    app_extractor_deinit(ctx.extractor);
+#endif
+}
+
+// Frame index of a 5 minute MJPEG clip: building it, loading it from the cache
+// and scrubbing through it one decoded frame at a time
+static void bench_frame_index(const bench_config_t *config, uint32_t width, uint32_t height,
+                              const uint8_t *jpeg, size_t jpeg_size)
+{
+    frame_index_ctx_t ctx = {0};
+    snprintf(ctx.path, sizeof(ctx.path), "%s/bench_%"PRIu32"x%"PRIu32".mp4",
+             bench_platform_scratch_dir(), width, height);
+    snprintf(ctx.cache_dir, sizeof(ctx.cache_dir), "%s/bench_index", bench_platform_scratch_dir());
+    if (write_mjpeg_clip(ctx.path, jpeg, jpeg_size, width, height, BENCH_CLIP_FRAMES) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to write %s", ctx.path);
+        return;
+    }
+
+    bench_case(config, "frame_index_build", width, height, run_frame_index_build, &ctx);
+    bench_case(config, "frame_index_load", width, height, run_frame_index_load, &ctx);
+    bench_case(config, "mp4_probe", width, height, run_mp4_probe, &ctx);
+
+    if (frame_index_open(ctx.path, NULL, &ctx.index) == ESP_OK) {
+        ctx.frame = image_buffer_alloc(frame_index_max_size(ctx.index), NULL);
+        if (ctx.frame) {
+            bench_case(config, "frame_index_scrub", width, height, run_frame_index_scrub, &ctx);
+        }
+        image_buffer_free(ctx.frame);
+        frame_index_close(ctx.index);
+    }
+
+    bench_video_open(config, width, height, ctx.path, ctx.cache_dir);
+
+    remove_dir(ctx.cache_dir);
+    remove(ctx.path);
+}
+
+// Slide decodes against background decodes of the same frame: each slide should
+// wait for at most the one background job holding the engine
+static void bench_jpeg_sched(const bench_config_t *config, uint32_t width, uint32_t height,
+                             const uint8_t *jpeg, size_t jpeg_size)
+{
+    const char *name = "jpeg_sched_slide";
+    if (config->filter && !strstr(name, config->filter)) {
+        return;
+    }
+
+    sched_ctx_t ctx = { .data = jpeg, .size = jpeg_size, .done = xSemaphoreCreateCounting(BENCH_SCHED_TASKS, 0) };
+    if (!ctx.done) {
+        return;
+    }
+    uint32_t started = 0;
+    for (; started < BENCH_SCHED_TASKS; started++) {
+        if (xTaskCreate(sched_background_task, "bench_sched", BENCH_SCHED_TASK_STACK, &ctx,
+                        BENCH_SCHED_TASK_PRIO, NULL) != pdPASS) {
+            break;
+        }
+    }
+
+    jpeg_sched_reset_stats();
+    decode_ctx_t slide_ctx = { .data = jpeg, .size = jpeg_size, .format = IMAGE_FORMAT_JPEG };
+    bench_case(config, name, width, height, run_decode, &slide_ctx);
+
+    ctx.stop = true;
+    for (uint32_t i = 0; i < started; i++) {
+        xSemaphoreTake(ctx.done, portMAX_DELAY);
+    }
+    vSemaphoreDelete(ctx.done);
+
+    jpeg_sched_stats_t slide;
+    jpeg_sched_stats_t background;
+    jpeg_sched_get_stats(JPEG_SCHED_SLIDE, &slide);
+    jpeg_sched_get_stats(JPEG_SCHED_BACKGROUND, &background);
+    uint32_t background_run_us = background.jobs ? (uint32_t)(background.run_us / background.jobs) : 0;
+    ESP_LOGI(TAG, "%-18s slide wait avg %u us max %u us, %u background jobs of %u us passed over %u times",
+             name, slide.jobs ? (uint32_t)(slide.wait_us / slide.jobs) : 0, slide.wait_max_us,
+             background.jobs, background_run_us, background.passed_over);
+    jpeg_sched_reset_stats();
+}
+
+// Hashing a compressed frame, which demux pays for every frame, against the
+// decode a frame identical to the one before saves
+static void bench_frame_hash(const bench_config_t *config, uint32_t width, uint32_t height,
+                             const uint8_t *jpeg, size_t jpeg_size)
+{
+    const char *name = "frame_hash";
+    int index = s_result_count;
+    hash_ctx_t ctx = { .data = jpeg, .size = jpeg_size };
+    bench_case(config, name, width, height, run_frame_hash, &ctx);
+    if (index == s_result_count || s_results[index].result != ESP_OK) {
+        return;
+    }
+
+    const bench_result_t *decode = NULL;
+    for (int i = index - 1; i >= 0 && !decode; i--) {
+        if (strcmp(s_results[i].name, "jpeg_decode") == 0 && s_results[i].width == width &&
+                s_results[i].height == height && s_results[i].result == ESP_OK) {
+            decode = &s_results[i];
+        }
+    }
+    if (decode && decode->ms_per_frame > 0) {
+        double hash_ms = s_results[index].ms_per_frame;
+        ESP_LOGI(TAG, "%-18s %.1f%% of a decode, a held frame saves %.3f ms", name,
+                 hash_ms * 100.0 / decode->ms_per_frame, decode->ms_per_frame - hash_ms);
+    }
+}
+
+// Planar BT.601 limited range, chroma averaged over each 2x2 block
+static void rgb888_to_i420(const uint8_t *rgb888, uint32_t rgb_stride, const yuv_i420_t *picture)
+{
+    uint8_t *y_plane = (uint8_t *)picture->y;
+    uint8_t *u_plane = (uint8_t *)picture->u;
+    uint8_t *v_plane = (uint8_t *)picture->v;
+
+    for (uint32_t y = 0; y < picture->height; y++) {
+        const uint8_t *px = rgb888 + (size_t)y * rgb_stride * 3;
+        for (uint32_t x = 0; x < picture->width; x++, px += 3) {
+            y_plane[y * picture->y_stride + x] = (uint8_t)(((66 * px[0] + 129 * px[1] + 25 * px[2] + 128) >> 8) + 16);
+        }
+    }
+    for (uint32_t y = 0; y < picture->height; y += 2) {
+        for (uint32_t x = 0; x < picture->width; x += 2) {
+            int32_t r = 0, g = 0, b = 0;
+            for (uint32_t i = 0; i < 4; i++) {
+                const uint8_t *px = rgb888 + ((size_t)(y + i / 2) * rgb_stride + x + i % 2) * 3;
+                r += px[0];
+                g += px[1];
+                b += px[2];
+            }
+            r /= 4;
+            g /= 4;
+            b /= 4;
+            size_t i = (size_t)(y / 2) * picture->uv_stride + x / 2;
+            u_plane[i] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            v_plane[i] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+static uint8_t clamp_level(double v)
+{
+    v = v < 0 ? 0 : (v > 255 ? 255 : v);
+    return (uint8_t)(v + 0.5);
+}
+
+// Largest channel difference between R G B output of the converter and the
+// exact BT.601 formula
+static uint32_t yuv_convert_max_error(const yuv_i420_t *in, const uint8_t *rgb888)
+{
+    uint32_t max_error = 0;
+    for (uint32_t y = 0; y < in->height; y++) {
+        for (uint32_t x = 0; x < in->width; x++) {
+            double l = 1.164383 * (in->y[y * in->y_stride + x] - 16);
+            double d = in->u[(y / 2) * in->uv_stride + x / 2] - 128;
+            double e = in->v[(y / 2) * in->uv_stride + x / 2] - 128;
+            uint8_t exact[3] = {
+                clamp_level(l + 1.596027 * e),
+                clamp_level(l - 0.391762 * d - 0.812968 * e),
+                clamp_level(l + 2.017232 * d),
+            };
+            const uint8_t *px = rgb888 + ((size_t)y * in->width + x) * 3;
+            for (int c = 0; c < 3; c++) {
+                uint32_t error = px[c] > exact[c] ? px[c] - exact[c] : exact[c] - px[c];
+                if (error > max_error) {
+                    max_error = error;
+                }
+            }
+        }
+    }
+    return max_error;
+}
+
+#ifdef BENCH_H264
+// One plane moved left by shift pixels, wrapping, into a plane of stride width
+static void scroll_plane(const uint8_t *in, uint32_t stride, uint32_t width, uint32_t height,
+                         uint32_t shift, uint8_t *out)
+{
+    shift %= width;
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t *row = in + (size_t)y * stride;
+        uint8_t *out_row = out + (size_t)y * width;
+        memcpy(out_row, row + shift, width - shift);
+        memcpy(out_row + width - shift, row, shift);
+    }
+}
+
+// Source of frame index of the clip, as contiguous I420
+static void h264_clip_frame(const yuv_i420_t *picture, uint32_t index, uint8_t *frame)
+{
+    uint32_t width = picture->width;
+    uint32_t height = picture->height;
+    size_t luma = (size_t)width * height;
+    uint32_t shift = index * BENCH_H264_SCROLL;
+    scroll_plane(picture->y, picture->y_stride, width, height, shift, frame);
+    scroll_plane(picture->u, picture->uv_stride, width / 2, height / 2, shift / 2, frame + luma);
+    scroll_plane(picture->v, picture->uv_stride, width / 2, height / 2, shift / 2, frame + luma + luma / 4);
+}
+
+// PSNR of a decoded picture over all three planes, INFINITY when identical
+static double h264_psnr(const yuv_i420_t *decoded, const uint8_t *frame)
+{
+    uint32_t width = decoded->width;
+    uint32_t height = decoded->height;
+    size_t luma = (size_t)width * height;
+    const uint8_t *planes[3] = { decoded->y, decoded->u, decoded->v };
+    const uint8_t *refs[3] = { frame, frame + luma, frame + luma + luma / 4 };
+    uint64_t sse = 0;
+    for (int p = 0; p < 3; p++) {
+        uint32_t w = p ? width / 2 : width;
+        uint32_t h = p ? height / 2 : height;
+        uint32_t stride = p ? decoded->uv_stride : decoded->y_stride;
+        for (uint32_t y = 0; y < h; y++) {
+            for (uint32_t x = 0; x < w; x++) {
+                int d = planes[p][(size_t)y * stride + x] - refs[p][(size_t)y * w + x];
+                sse += (uint64_t)(d * d);
+            }
+        }
+    }
+    if (sse == 0) {
+        return INFINITY;
+    }
+    return 10.0 * log10(255.0 * 255.0 * (luma * 3 / 2) / (double)sse);
+}
+
+// Rewrite the clip's 4-byte start codes to NAL lengths, as an MP4 stores
+// samples, and build the avcC record from its parameter sets. Returns the
+// record length, 0 when the clip has other start codes or no SPS/PPS.
+static uint32_t h264_clip_to_avcc(const h264_ctx_t *c, uint8_t *stream, uint8_t *avcc, uint32_t avcc_size)
+{
+    const uint8_t *sps = NULL;
+    const uint8_t *pps = NULL;
+    uint32_t sps_len = 0;
+    uint32_t pps_len = 0;
+    for (uint32_t i = 0; i < BENCH_H264_FRAMES; i++) {
+        size_t pos = c->offsets[i];
+        size_t end = c->offsets[i + 1];
+        while (pos < end) {
+            if (end - pos < 5 || memcmp(stream + pos, "\0\0\0\1", 4) != 0) {
+                return 0;
+            }
+            size_t next = pos + 4;
+            while (next + 4 <= end && memcmp(stream + next, "\0\0\0\1", 4) != 0) {
+                next++;
+            }
+            if (next + 4 > end) {
+                next = end;
+            }
+            uint32_t len = (uint32_t)(next - pos - 4);
+            uint8_t type = stream[pos + 4] & 0x1F;
+            if (type == 7 && !sps) {
+                sps = stream + pos + 4;
+                sps_len = len;
+            } else if (type == 8 && !pps) {
+                pps = stream + pos + 4;
+                pps_len = len;
+            }
+            stream[pos] = len >> 24;
+            stream[pos + 1] = len >> 16;
+            stream[pos + 2] = len >> 8;
+            stream[pos + 3] = len;
+            pos = next;
+        }
+    }
+    if (!sps || !pps || sps_len < 4 || 11 + sps_len + pps_len > avcc_size) {
+        return 0;
+    }
+
+    uint32_t n = 0;
+    avcc[n++] = 1;                  // configurationVersion
+    avcc[n++] = sps[1];             // Profile, constraint flags and level straight from the SPS
+    avcc[n++] = sps[2];
+    avcc[n++] = sps[3];
+    avcc[n++] = 0xFF;               // 4-byte NAL lengths
+    avcc[n++] = 0xE1;               // One SPS
+    avcc[n++] = sps_len >> 8;
+    avcc[n++] = sps_len;
+    memcpy(avcc + n, sps, sps_len);
+    n += sps_len;
+    avcc[n++] = 1;                  // One PPS
+    avcc[n++] = pps_len >> 8;
+    avcc[n++] = pps_len;
+    memcpy(avcc + n, pps, pps_len);
+    return n + pps_len;
+}
+
+// Decode the whole clip and compare every frame with its source, as Annex-B
+// and as MP4 samples with an avcC record; a P frame straight after a flush
+// must be held back until the IDR. Returns the worst PSNR, or -1 on failure.
+static double check_h264_clip(h264_ctx_t *c, const yuv_i420_t *picture)
+{
+    size_t size = c->offsets[BENCH_H264_FRAMES];
+    size_t luma = (size_t)picture->width * picture->height;
+    uint8_t *frame = image_buffer_alloc(luma * 3 / 2, NULL);
+    uint8_t *samples = image_buffer_alloc(size, NULL);
+    uint8_t avcc[256];
+    h264_decoder_handle_t mp4_decoder = NULL;
+    double worst = -1;
+    if (!frame || !samples) {
+        goto cleanup;
+    }
+    memcpy(samples, c->stream, size);
+    uint32_t avcc_len = h264_clip_to_avcc(c, samples, avcc, sizeof(avcc));
+    if (avcc_len == 0 || h264_decoder_create(picture->width, picture->height, &mp4_decoder) != ESP_OK ||
+            h264_decoder_set_config(mp4_decoder, avcc, avcc_len) != ESP_OK) {
+        ESP_LOGW(TAG, "%-18s no avcC record for the clip", "h264_decode");
+        goto cleanup;
+    }
+
+    h264_decoder_flush(c->decoder);
+    yuv_i420_t decoded;
+    if (h264_decoder_decode(c->decoder, c->stream + c->offsets[1], c->offsets[2] - c->offsets[1],
+                            &decoded) != ESP_ERR_NOT_FINISHED) {
+        ESP_LOGW(TAG, "%-18s P frame decoded without its IDR after a flush", "h264_decode");
+        goto cleanup;
+    }
+
+    worst = INFINITY;
+    for (int pass = 0; pass < 2; pass++) {
+        h264_decoder_handle_t decoder = pass == 0 ? c->decoder : mp4_decoder;
+        uint8_t *stream = pass == 0 ? c->stream : samples;
+        for (uint32_t i = 0; i < BENCH_H264_FRAMES; i++) {
+            if (h264_decoder_decode(decoder, stream + c->offsets[i], c->offsets[i + 1] - c->offsets[i],
+                                    &decoded) != ESP_OK ||
+                    decoded.width != picture->width || decoded.height != picture->height) {
+                ESP_LOGW(TAG, "%-18s frame %"PRIu32" of the %s clip did not decode", "h264_decode", i,
+                         pass == 0 ? "Annex-B" : "MP4");
+                worst = -1;
+                goto cleanup;
+            }
+            h264_clip_frame(picture, i, frame);
+            double psnr = h264_psnr(&decoded, frame);
+            if (psnr < worst) {
+                worst = psnr;
+            }
+        }
+    }
+
+cleanup:
+    h264_decoder_delete(mp4_decoder);
+    image_buffer_free(samples);
+    image_buffer_free(frame);
+    return worst;
+}
+
+// BENCH_H264_FRAMES of the picture scrolling sideways, one GOP of baseline
+// H.264 from the esp_h264 software encoder
+static esp_err_t encode_h264_clip(const yuv_i420_t *picture, h264_ctx_t *c, size_t capacity)
+{
+    uint32_t width = picture->width;
+    uint32_t height = picture->height;
+    size_t luma = (size_t)width * height;
+    uint8_t *frame = image_buffer_alloc(luma * 3 / 2, NULL);
+    esp_h264_enc_handle_t enc = NULL;
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (!frame) {
+        goto cleanup;
+    }
+
+    esp_h264_enc_cfg_sw_t cfg = {
+        .gop = BENCH_H264_FRAMES,
+        .fps = BENCH_CLIP_FPS,
+        .res = { .width = width, .height = height },
+        .rc = { .bitrate = width * height * BENCH_CLIP_FPS / 10, .qp_min = 20, .qp_max = 36 },
+        .pic_type = ESP_H264_RAW_FMT_I420,
+    };
+    ret = ESP_FAIL;
+    if (esp_h264_enc_sw_new(&cfg, &enc) != ESP_H264_ERR_OK || esp_h264_enc_open(enc) != ESP_H264_ERR_OK) {
+        goto cleanup;
+    }
+
+    c->offsets[0] = 0;
+    for (uint32_t i = 0; i < BENCH_H264_FRAMES; i++) {
+        h264_clip_frame(picture, i, frame);
+
+        esp_h264_enc_in_frame_t in = {
+            .raw_data = { .buffer = frame, .len = luma * 3 / 2 },
+            .pts = i * 1000 / BENCH_CLIP_FPS,
+        };
+        esp_h264_enc_out_frame_t out = {
+            .raw_data = { .buffer = c->stream + c->offsets[i], .len = capacity - c->offsets[i] },
+        };
+        if (esp_h264_enc_process(enc, &in, &out) != ESP_H264_ERR_OK) {
+            goto cleanup;
+        }
+        c->offsets[i + 1] = c->offsets[i] + out.length;
+    }
+    ret = ESP_OK;
+
+cleanup:
+    if (enc) {
+        esp_h264_enc_close(enc);
+        esp_h264_enc_del(enc);
+    }
+    image_buffer_free(frame);
+    return ret;
+}
+
+// Software H.264 decode of a clip of this size, alone and with the conversion
+// the stream adapter adds, against the clip's frame rate and its MJPEG size
+static void bench_h264(const bench_config_t *config, const yuv_i420_t *picture, size_t jpeg_size)
+{
+    uint32_t width = picture->width;
+    uint32_t height = picture->height;
+    size_t capacity = (size_t)width * height * BENCH_H264_CLIP_BPP;
+    h264_ctx_t ctx = { .stream = image_buffer_alloc(capacity, NULL) };
+    uint16_t *rgb565 = image_buffer_alloc((size_t)width * height * sizeof(uint16_t), NULL);
+    if (!ctx.stream || !rgb565 || encode_h264_clip(picture, &ctx, capacity) != ESP_OK ||
+            h264_decoder_create(width, height, &ctx.decoder) != ESP_OK) {
+        ESP_LOGW(TAG, "No H.264 clip at %"PRIu32"x%"PRIu32", skipping its cases", width, height);
+        goto cleanup;
+    }
+
+    int index = s_result_count;
+    bench_case(config, "h264_decode", width, height, run_h264_decode, &ctx);
+    if (index < s_result_count && s_results[index].result == ESP_OK) {
+        double psnr = check_h264_clip(&ctx, picture);
+        if (psnr < BENCH_H264_MIN_PSNR) {
+            s_results[index].result = ESP_FAIL;
+            ESP_LOGW(TAG, "%-18s frames off their source, %.1f dB", "h264_decode", psnr);
+        } else if (isinf(psnr)) {
+            ESP_LOGI(TAG, "%-18s every frame identical to its source", "h264_decode");
+        } else {
+            ESP_LOGI(TAG, "%-18s every frame at least %.1f dB against its source", "h264_decode", psnr);
+        }
+    }
+
+    ctx.rgb565 = rgb565;
+    ctx.next = 0;
+    h264_decoder_flush(ctx.decoder);
+    index = s_result_count;
+    bench_case(config, "h264_play", width, height, run_h264_decode, &ctx);
+    if (index < s_result_count && s_results[index].result == ESP_OK && s_results[index].ms_per_frame > 0) {
+        double fps = 1000.0 / s_results[index].ms_per_frame;
+        ESP_LOGI(TAG, "%-18s %.1f fps, %s %u fps clips; %u KB per second against %u KB as MJPEG",
+                 "h264_play", fps, fps >= BENCH_CLIP_FPS ? "enough for" : "too slow for", BENCH_CLIP_FPS,
+                 (uint32_t)(ctx.offsets[BENCH_H264_FRAMES] / 1024), (uint32_t)(jpeg_size * BENCH_CLIP_FPS / 1024));
+    }
+
+cleanup:
+    h264_decoder_delete(ctx.decoder);
+    image_buffer_free(rgb565);
+    image_buffer_free(ctx.stream);
+}
+#endif
+
+// Colour conversion of decoded H.264 pictures, checked against the exact BT.601
+// formula. Sizes are cut to whole macroblocks, as an H.264 clip of them would be.
+static void bench_yuv(const bench_config_t *config, uint32_t width, uint32_t height,
+                      const uint8_t *rgb888, size_t jpeg_size)
+{
+    uint32_t w = width & ~15U;
+    uint32_t h = height & ~15U;
+    size_t luma = (size_t)w * h;
+    uint8_t *i420 = image_buffer_alloc(luma * 3 / 2, NULL);
+    uint8_t *out = image_buffer_alloc(luma * 3, NULL);
+    if (!i420 || !out) {
+        goto cleanup;
+    }
+
+    yuv_ctx_t ctx = {
+        .picture = {
+            .y = i420, .u = i420 + luma, .v = i420 + luma + luma / 4,
+            .y_stride = w, .uv_stride = w / 2, .width = w, .height = h,
+        },
+        .out = out,
+    };
+    rgb888_to_i420(rgb888, width, &ctx.picture);
+    bench_case(config, "i420_to_rgb565", w, h, run_yuv_convert, &ctx);
+
+    ctx.rgb888 = true;
+    int index = s_result_count;
+    bench_case(config, "i420_to_rgb888", w, h, run_yuv_convert, &ctx);
+    if (index < s_result_count && s_results[index].result == ESP_OK) {
+        uint32_t error = yuv_convert_max_error(&ctx.picture, out);
+        if (error > BENCH_YUV_MAX_ERROR) {
+            s_results[index].result = ESP_FAIL;
+            ESP_LOGW(TAG, "%-18s off by up to %u levels from exact BT.601", "i420_to_rgb888", error);
+        } else {
+            ESP_LOGI(TAG, "%-18s within %u levels of exact BT.601", "i420_to_rgb888", error);
+        }
+    }
+
+#ifdef BENCH_H264
+    bench_h264(config, &ctx.picture, jpeg_size);
+#endif
+
+cleanup:
+    image_buffer_free(out);
+    image_buffer_free(i420);
+}
+
+// File throughput, direct and through read-ahead, and how far above the rate of
+// an MJPEG stream of this size at BENCH_CLIP_FPS it stays
+static void bench_card_read(const bench_config_t *config, uint32_t width, uint32_t height,
+                            const uint8_t *jpeg, size_t jpeg_size)
+{
+    card_read_ctx_t ctx;
+    snprintf(ctx.path, sizeof(ctx.path), "%s/bench_read.bin", bench_platform_scratch_dir());
+    FILE *f = fopen(ctx.path, "wb");
+    if (!f) {
+        ESP_LOGW(TAG, "Failed to create %s", ctx.path);
+        return;
+    }
+    bool ok = true;
+    for (size_t written = 0; ok && written < BENCH_READ_FILE_SIZE; written += jpeg_size) {
+        size_t len = BENCH_READ_FILE_SIZE - written < jpeg_size ? BENCH_READ_FILE_SIZE - written : jpeg_size;
+        ok = fwrite(jpeg, 1, len, f) == len;
+    }
+    ok = fclose(f) == 0 && ok;
+    ctx.chunk = image_buffer_alloc(BENCH_READ_CHUNK, NULL);
+    if (!ok || !ctx.chunk) {
+        ESP_LOGW(TAG, "Failed to prepare %s", ctx.path);
+        goto cleanup;
+    }
+
+    double stream_mb_per_s = (double)jpeg_size * BENCH_CLIP_FPS / 1e6;
+    static const struct {
+        const char *name;
+        bench_fn_t fn;
+    } cases[] = {
+        { "card_read", run_card_read },
+        { "card_read_ahead", run_card_read_ahead },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int index = s_result_count;
+        bench_case(config, cases[i].name, width, height, cases[i].fn, &ctx);
+        if (index == s_result_count || s_results[index].result != ESP_OK) {
+            continue;
+        }
+        bench_result_t *r = &s_results[index];
+        r->mb_per_s = BENCH_READ_FILE_SIZE / (r->ms_per_frame * 1000.0);
+        r->headroom = r->mb_per_s / stream_mb_per_s;
+        ESP_LOGI(TAG, "%-18s %8.2f MB/s, %.1fx the %.2f MB/s of the stream", cases[i].name,
+                 r->mb_per_s, r->headroom, stream_mb_per_s);
+    }
+
+cleanup:
+    image_buffer_free(ctx.chunk);
+    remove(ctx.path);
+}
+
+// Video frame fitted to the screen upright and rotated, as the video pipeline's SRM stage would
+static void bench_video_srm(const bench_config_t *config, const decoded_image_t *decoded)
+{
+    static const struct {
+        const char *name;
+        video_rotation_t rotation;
+    } variants[] = {
+        {"video_srm", VIDEO_ROTATION_0},
+        {"video_srm_rot90", VIDEO_ROTATION_90},
+    };
+
+    size_t out_size = 0;
+    void *out = image_buffer_alloc((size_t)SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(uint16_t), &out_size);
+    if (!out) {
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+        video_transform_config_t transform_config = {
+            .screen_width = SCREEN_WIDTH,
+            .screen_height = SCREEN_HEIGHT,
+            .rotation = variants[i].rotation,
+        };
+        video_srm_ctx_t ctx = { .input = decoded, .out = out, .out_size = out_size };
+        if (video_transform_create(&transform_config, &ctx.transform) != ESP_OK) {
+            continue;
+        }
+        if (video_transform_plan(ctx.transform, decoded->width, decoded->height,
+                                 decoded->data_size, &ctx.plan) == ESP_OK) {
+            bench_case(config, variants[i].name, decoded->width, decoded->height, run_video_srm, &ctx);
+        }
+        video_transform_delete(ctx.transform);
+    }
+
+    image_buffer_free(out);
+}
+
+// Frames presented straight into the panel frame buffers: ms_per_frame settles
+// at the refresh period once the buffers are full, fps and jitter come from vsync
+static void bench_video_direct(const bench_config_t *config, const decoded_image_t *decoded)
+{
+    const char *name = "video_direct";
+    if (config->filter && !strstr(name, config->filter)) {
+        return;
+    }
+
+    video_direct_ctx_t ctx = { .input = decoded };
+    esp_err_t ret = hal_display_start();
+    if (ret == ESP_OK) {
+        ret = video_output_create(&ctx.output);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "%-18s skipped: %s", name, esp_err_to_name(ret));
+        return;
+    }
+
+    if (hal_display_lock(0)) {
+        ret = video_output_begin(ctx.output);
+        hal_display_unlock();
+    } else {
+        ret = ESP_ERR_TIMEOUT;
+    }
+    if (ret == ESP_OK) {
+        bench_case(config, name, decoded->width, decoded->height, run_video_direct, &ctx);
+
+        video_output_stats_t stats;
+        video_output_get_stats(ctx.output, &stats);
+        ESP_LOGI(TAG, "%-18s %4"PRIu32"x%-4"PRIu32" %6.1f fps jitter %"PRIu32" us, refresh %"PRIu32" us, "
+                 "blit max %"PRIu32" us",
+                 name, decoded->width, decoded->height, stats.fps, stats.jitter_us, stats.refresh_us,
+                 stats.blit_us_max);
+
+        hal_display_lock(0);
+        video_output_end(ctx.output);
+        hal_display_unlock();
+    }
+    video_output_delete(ctx.output);
+}
+
+static void bench_size(const bench_config_t *config, uint32_t width, uint32_t height)
+{
+    uint8_t *rgb888 = generate_rgb888(width, height);
+    uint16_t *rgb565 = image_buffer_alloc((size_t)width * height * sizeof(uint16_t), NULL);
+    uint8_t *jpeg = NULL;
+    uint8_t *png = NULL;
+    size_t jpeg_size = 0;
+    size_t png_size = 0;
+    decoded_image_t decoded = {0};
+
+    if (!rgb888 || !rgb565) {
+        ESP_LOGE(TAG, "Out of memory for %"PRIu32"x%"PRIu32" inputs", width, height);
+        goto cleanup;
+    }
+    if (bench_platform_encode_jpeg(rgb888, width, height, &jpeg, &jpeg_size) != ESP_OK ||
+        encode_png(rgb888, width, height, &png, &png_size) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to generate %"PRIu32"x%"PRIu32" inputs", width, height);
+        goto cleanup;
+    }
+
+    decode_ctx_t jpeg_ctx = { .data = jpeg, .size = jpeg_size, .format = IMAGE_FORMAT_JPEG };
+    bench_case(config, "jpeg_decode", width, height, run_decode, &jpeg_ctx);
+
+    sw_decode_ctx_t sw_ctx = { .data = jpeg, .size = jpeg_size, .out = rgb565, .width = width, .height = height };
+    bench_case(config, "jpeg_decode_sw", width, height, run_sw_decode, &sw_ctx);
+
+    bench_jpeg_sched(config, width, height, jpeg, jpeg_size);
+    bench_frame_hash(config, width, height, jpeg, jpeg_size);
+
+    decode_ctx_t png_ctx = { .data = png, .size = png_size, .format = IMAGE_FORMAT_PNG };
+    bench_case(config, "png_decode", width, height, run_decode, &png_ctx);
+
+    convert_ctx_t convert_ctx = { .rgb888 = rgb888, .rgb565 = rgb565, .pixels = width * height };
+    bench_case(config, "rgb888_to_rgb565", width, height, run_convert, &convert_ctx);
+    bench_yuv(config, width, height, rgb888, jpeg_size);
+
+    // Scale every mode from the decoded frame, as the slideshow would
+    if (image_decoder_decode(jpeg, jpeg_size, IMAGE_FORMAT_JPEG, &decoded) == ESP_OK) {
+        for (int mode = SCALE_MODE_FIT; mode <= SCALE_MODE_CROP_ONLY; mode++) {
+            scale_ctx_t scale_ctx = { .input = &decoded };
+            if (image_processor_calculate_params(width, height, SCREEN_WIDTH, SCREEN_HEIGHT,
+                                                 (scale_mode_t)mode, &scale_ctx.params) != ESP_OK) {
+                continue;
+            }
+            char name[BENCH_NAME_LEN];
+            snprintf(name, sizeof(name), "scale_%s", s_scale_mode_names[mode]);
+            // Centering a frame that fits hands the input back untouched, there is no PPA work to time
+            if (scale_ctx.params.operation == PROCESS_OP_SCALE &&
+                    scale_ctx.params.target_width == width && scale_ctx.params.target_height == height) {
+                bench_skip(config, name, width, height, "fits the panel, passed through unscaled");
+                continue;
+            }
+            bench_case(config, name, width, height, run_scale, &scale_ctx);
+        }
+        bench_video_srm(config, &decoded);
+        bench_video_direct(config, &decoded);
+    }
+
+    slide_ctx_t slide_ctx;
+    snprintf(slide_ctx.path, sizeof(slide_ctx.path), "%s/bench_%"PRIu32"x%"PRIu32".jpg",
+             bench_platform_scratch_dir(), width, height);
+    if (write_file(slide_ctx.path, jpeg, jpeg_size) == ESP_OK) {
+        bench_case(config, "slide", width, height, run_slide, &slide_ctx);
+        remove(slide_ctx.path);
+    }
+
+    bench_frame_index(config, width, height, jpeg, jpeg_size);
+    bench_card_read(config, width, height, jpeg, jpeg_size);
+
+cleanup:
+    image_decoder_free_image(&decoded);
+    image_buffer_free(png);
+    image_buffer_free(jpeg);
+    image_buffer_free(rgb565);
+    free(rgb888);
+}
+
+static void write_json(const bench_config_t *config, FILE *out)
+{
+    if (config->json_markers) {
+        fprintf(out, "BENCH_JSON_BEGIN\n");
+    }
+    fprintf(out, "{\n  \"platform\": \"%s\",\n  \"jpeg_engine\": \"%s\",\n",
+            bench_platform_name(), bench_platform_jpeg_engine());
+    fprintf(out, "  \"display\": [%d, %d],\n  \"iterations\": %"PRIu32",\n  \"results\": [\n",
+            SCREEN_WIDTH, SCREEN_HEIGHT, config->iterations);
+
+    for (int i = 0; i < s_result_count; i++) {
+        const bench_result_t *r = &s_results[i];
+        fprintf(out, "    {\"case\": \"%s\", \"width\": %"PRIu32", \"height\": %"PRIu32", "
+                     "\"iterations\": %"PRIu32", \"ms_per_frame\": %.3f, \"mpix_per_s\": %.3f, "
+                     "\"peak_buffer_bytes\": %zu, \"mb_per_s\": %.3f, \"headroom\": %.2f, \"status\": \"%s\"}%s\n",
+                r->name, r->width, r->height, r->iterations, r->ms_per_frame, r->mpix_per_s,
+                r->peak_buffer_bytes, r->mb_per_s, r->headroom,
+                r->skipped ? "skipped" : esp_err_to_name(r->result),
+                (i + 1 < s_result_count) ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    if (config->json_markers) {
+        fprintf(out, "BENCH_JSON_END\n");
+    }
+    fflush(out);
+}
+
+esp_err_t bench_run(const bench_config_t *config, FILE *json_out)
+{
+    if (!config || !json_out || config->iterations == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    decoder_config_t decoder_config = {
+        .max_width = MAX_DECODE_WIDTH,
+        .max_height = MAX_DECODE_HEIGHT,
+        .use_psram = true
+    };
+
+    esp_err_t ret = file_manager_init();
+    if (ret == ESP_OK) {
+        ret = image_decoder_init(&decoder_config);
+    }
+    if (ret == ESP_OK) {
+        ret = image_processor_init();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Pipeline init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Running on %s (JPEG: %s), %"PRIu32" iterations per case",
+             bench_platform_name(), bench_platform_jpeg_engine(), config->iterations);
+
+    s_result_count = 0;
+    s_results_error = ESP_OK;
+    for (size_t i = 0; i < sizeof(s_sizes) / sizeof(s_sizes[0]) && s_results_error == ESP_OK; i++) {
+        bench_size(config, s_sizes[i].width, s_sizes[i].height);
+    }
+
+    if (s_results_error == ESP_OK) {
+        write_json(config, json_out);
+    } else {
+        ESP_LOGE(TAG, "Benchmark incomplete, no report written: %s", esp_err_to_name(s_results_error));
+    }
+
+    free(s_results);
+    s_results = NULL;
+    s_result_capacity = 0;
+    image_processor_deinit();
+    image_decoder_deinit();
+    file_manager_deinit();
+    return s_results_error;
+}
@@ -0,0 +1,30 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Benchmark configuration
+typedef struct {
+    uint32_t iterations;        // Timed runs per case, after one warm-up run
+    const char *filter;         // Only run cases whose name contains this, NULL for all
+    bool json_markers;          // Wrap the JSON in BENCH_JSON_BEGIN/END lines (console scraping)
+} bench_config_t;
+
+// Run the image kernel and pipeline benchmarks on synthetic inputs and write
+// the results as one JSON document to json_out
+esp_err_t bench_run(const bench_config_t *config, FILE *json_out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,99 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "bench_platform.h"
+#include "image_buffer.h"
+#include "esp_log.h"
+#include "esp_jpeg_enc.h"
+#include "esp_jpeg_dec.h"
+#include "bsp/esp-bsp.h"
+
+static const char *TAG = "bench_esp";
+
+#define BENCH_JPEG_QUALITY      85
+
+const char *bench_platform_name(void)
+{
+    return CONFIG_IDF_TARGET;
+}
+
+const char *bench_platform_jpeg_engine(void)
+{
+    return "hardware";
+}
+
+const char *bench_platform_scratch_dir(void)
+{
+    return BSP_SD_MOUNT_POINT;
+}
+
+esp_err_t bench_platform_encode_jpeg(const uint8_t *rgb888, uint32_t width, uint32_t height,
+                                     uint8_t **out, size_t *out_size)
+{
+    jpeg_enc_config_t enc_config = DEFAULT_JPEG_ENC_CONFIG();
+    enc_config.width = width;
+    enc_config.height = height;
+    enc_config.src_type = JPEG_PIXEL_FORMAT_RGB888;
+    enc_config.subsampling = JPEG_SUBSAMPLE_420;
+    enc_config.quality = BENCH_JPEG_QUALITY;
+
+    jpeg_enc_handle_t encoder = NULL;
+    if (jpeg_enc_open(&enc_config, &encoder) != JPEG_ERR_OK) {
+        ESP_LOGE(TAG, "Failed to open JPEG encoder");
+        return ESP_FAIL;
+    }
+
+    // RGB888 size is a safe upper bound for the compressed stream
+    size_t capacity = (size_t)width * height * 3;
+    *out = image_buffer_alloc(capacity, NULL);
+    if (!*out) {
+        jpeg_enc_close(encoder);
+        return ESP_ERR_NO_MEM;
+    }
+
+    int encoded = 0;
+    jpeg_error_t err = jpeg_enc_process(encoder, rgb888, (int)capacity, *out, (int)capacity, &encoded);
+    jpeg_enc_close(encoder);
+    if (err != JPEG_ERR_OK) {
+        ESP_LOGE(TAG, "JPEG encode failed: %d", err);
+        image_buffer_free(*out);
+        *out = NULL;
+        return ESP_FAIL;
+    }
+
+    *out_size = (size_t)encoded;
+    return ESP_OK;
+}
+
+esp_err_t bench_platform_sw_jpeg_decode(const uint8_t *data, size_t data_size,
+                                        uint16_t *rgb565, uint32_t width, uint32_t height)
+{
+    jpeg_dec_config_t dec_config = DEFAULT_JPEG_DEC_CONFIG();
+    dec_config.output_type = JPEG_PIXEL_FORMAT_RGB565_LE;
+
+    jpeg_dec_handle_t decoder = NULL;
+    if (jpeg_dec_open(&dec_config, &decoder) != JPEG_ERR_OK) {
+        return ESP_FAIL;
+    }
+
+    jpeg_dec_io_t io = {
+        .inbuf = (uint8_t *)data,
+        .inbuf_len = (int)data_size,
+        .outbuf = (uint8_t *)rgb565,
+    };
+    jpeg_dec_header_info_t info;
+    esp_err_t ret = ESP_OK;
+
+    if (jpeg_dec_parse_header(decoder, &io, &info) != JPEG_ERR_OK) {
+        ret = ESP_FAIL;
+    } else if (info.width != width || info.height != height) {
+        ret = ESP_ERR_INVALID_SIZE;
+    } else if (jpeg_dec_process(decoder, &io) != JPEG_ERR_OK) {
+        ret = ESP_FAIL;
+    }
+
+    jpeg_dec_close(decoder);
+    return ret;
+}
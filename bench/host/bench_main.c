@@ -0,0 +1,54 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "bench_suite.h"
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-n iterations] [-f filter] [-o results.json] [-v]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    bench_config_t config = {
+        .iterations = 5,
+        .filter = NULL,
+        .json_markers = false,
+    };
+    const char *json_path = NULL;
+    int opt;
+
+    // Keep the pipeline quiet, the suite prints one line per case
+    esp_log_level_set("*", ESP_LOG_WARN);
+    esp_log_level_set("bench", ESP_LOG_INFO);
+    while ((opt = getopt(argc, argv, "n:f:o:vh")) != -1) {
+        switch (opt) {
+            case 'n': config.iterations = (uint32_t)atoi(optarg); break;
+            case 'f': config.filter = optarg; break;
+            case 'o': json_path = optarg; break;
+            case 'v': esp_log_level_set("*", ESP_LOG_DEBUG); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+
+    FILE *json_out = stdout;
+    if (json_path) {
+        json_out = fopen(json_path, "w");
+        if (!json_out) {
+            perror(json_path);
+            return 1;
+        }
+    }
+
+    esp_err_t ret = bench_run(&config, json_out);
+    if (json_out != stdout) {
+        fclose(json_out);
+    }
+    return ret == ESP_OK ? 0 : 1;
+}
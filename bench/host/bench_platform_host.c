@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "bench_platform.h"
+#include "image_buffer.h"
+#include <jpeglib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_JPEG_QUALITY      85
+
+const char *bench_platform_name(void)
+{
+    return "host";
+}
+
+const char *bench_platform_jpeg_engine(void)
+{
+    return "libjpeg";
+}
+
+const char *bench_platform_scratch_dir(void)
+{
+    const char *dir = getenv("TMPDIR");
+    return dir ? dir : "/tmp";
+}
+
+esp_err_t bench_platform_encode_jpeg(const uint8_t *rgb888, uint32_t width, uint32_t height,
+                                     uint8_t **out, size_t *out_size)
+{
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    unsigned char *mem = NULL;
+    unsigned long mem_size = 0;
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, &mem, &mem_size);
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, BENCH_JPEG_QUALITY, TRUE);
+
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = (JSAMPROW)(rgb888 + (size_t)cinfo.next_scanline * width * 3);
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    // Hand out an aligned copy, like a file loaded by file_manager
+    *out = image_buffer_alloc(mem_size, NULL);
+    if (!*out) {
+        free(mem);
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(*out, mem, mem_size);
+    *out_size = mem_size;
+    free(mem);
+    return ESP_OK;
+}
+
+esp_err_t bench_platform_sw_jpeg_decode(const uint8_t *data, size_t data_size,
+                                        uint16_t *rgb565, uint32_t width, uint32_t height)
+{
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, (unsigned long)data_size);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+
+    if (cinfo.output_width != width || cinfo.output_height != height) {
+        jpeg_destroy_decompress(&cinfo);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint8_t *row = malloc((size_t)width * 3);
+    if (!row) {
+        jpeg_destroy_decompress(&cinfo);
+        return ESP_ERR_NO_MEM;
+    }
+
+    while (cinfo.output_scanline < cinfo.output_height) {
+        uint16_t *dst = rgb565 + (size_t)cinfo.output_scanline * width;
+        JSAMPROW rows[1] = { row };
+        jpeg_read_scanlines(&cinfo, rows, 1);
+        for (uint32_t x = 0; x < width; x++) {
+            dst[x] = (uint16_t)(((row[x * 3] >> 3) << 11) | ((row[x * 3 + 1] >> 2) << 5) | (row[x * 3 + 2] >> 3));
+        }
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    free(row);
+    return ESP_OK;
+}
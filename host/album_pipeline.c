@@ -0,0 +1,244 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host driver for the slideshow image pipeline: runs the real file manager,
+// decoder and processor over a photo directory and reports per-stage timings
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "photo_album.h"
+#include "file_manager.h"
+#include "image_decoder.h"
+#include "image_processor.h"
+#include "image_buffer.h"
+
+static const char *TAG = "album_host";
+
+typedef enum {
+    STAGE_LOAD,
+    STAGE_DECODE,
+    STAGE_PROCESS,
+    STAGE_PRESENT,
+    STAGE_COUNT
+} pipeline_stage_t;
+
+static const char *s_stage_names[STAGE_COUNT] = {
+    "load", "decode", "process", "present",
+};
+
+typedef struct {
+    uint32_t count;
+    int64_t total_us;
+    int64_t min_us;
+    int64_t max_us;
+} stage_stats_t;
+
+static stage_stats_t s_stages[STAGE_COUNT];
+
+static void stage_record(pipeline_stage_t stage, int64_t elapsed_us)
+{
+    stage_stats_t *st = &s_stages[stage];
+    if (st->count == 0 || elapsed_us < st->min_us) {
+        st->min_us = elapsed_us;
+    }
+    if (elapsed_us > st->max_us) {
+        st->max_us = elapsed_us;
+    }
+    st->total_us += elapsed_us;
+    st->count++;
+}
+
+// Stand-in for the LCD: optionally dump the frame as binary PPM
+static esp_err_t present_image(const decoded_image_t *image, const char *out_dir, int index)
+{
+    if (!out_dir) {
+        return ESP_OK;
+    }
+
+    char path[MAX_FILENAME_LEN + 32];
+    snprintf(path, sizeof(path), "%s/slide_%04d.ppm", out_dir, index);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to create %s", path);
+        return ESP_FAIL;
+    }
+
+    // Decoder output keeps its 16-pixel padded stride
+    uint32_t stride = image->width;
+    if (image->data_size > (size_t)image->width * image->height * 2) {
+        stride = (image->width + 15) & ~15;
+    }
+
+    fprintf(f, "P6\n%" PRIu32 " %" PRIu32 "\n255\n", image->width, image->height);
+    const uint16_t *pixels = (const uint16_t *)image->rgb_data;
+    for (uint32_t y = 0; y < image->height; y++) {
+        for (uint32_t x = 0; x < image->width; x++) {
+            uint16_t p = pixels[(size_t)y * stride + x];
+            uint8_t rgb[3] = {
+                (uint8_t)(((p >> 11) & 0x1F) << 3),
+                (uint8_t)(((p >> 5) & 0x3F) << 2),
+                (uint8_t)((p & 0x1F) << 3),
+            };
+            fwrite(rgb, 1, sizeof(rgb), f);
+        }
+    }
+    fclose(f);
+    return ESP_OK;
+}
+
+static esp_err_t run_slide(const image_file_info_t *file_info, const char *out_dir, int index)
+{
+    uint8_t *file_data = NULL;
+    size_t file_size = 0;
+    decoded_image_t decoded = {0};
+    decoded_image_t processed = {0};
+    const decoded_image_t *display_image = &decoded;
+
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t ret = file_manager_load_image(file_info->full_path, &file_data, &file_size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    int64_t t1 = esp_timer_get_time();
+    stage_record(STAGE_LOAD, t1 - t0);
+
+    ret = image_decoder_decode(file_data, file_size, file_info->format, &decoded);
+    image_buffer_free(file_data);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    int64_t t2 = esp_timer_get_time();
+    stage_record(STAGE_DECODE, t2 - t1);
+
+    if (decoded.width != SCREEN_WIDTH || decoded.height != SCREEN_HEIGHT) {
+        process_params_t params;
+        scale_mode_t mode = image_processor_select_display_mode(decoded.width, decoded.height,
+                                                                SCREEN_WIDTH, SCREEN_HEIGHT);
+        ret = image_processor_calculate_params(decoded.width, decoded.height,
+                                               SCREEN_WIDTH, SCREEN_HEIGHT, mode, &params);
+        if (ret == ESP_OK) {
+            ret = image_processor_process(&decoded, &processed, &params);
+        }
+        if (ret != ESP_OK) {
+            image_decoder_free_image(&decoded);
+            return ret;
+        }
+        display_image = &processed;
+    }
+    int64_t t3 = esp_timer_get_time();
+    stage_record(STAGE_PROCESS, t3 - t2);
+
+    ret = present_image(display_image, out_dir, index);
+    stage_record(STAGE_PRESENT, esp_timer_get_time() - t3);
+
+    ESP_LOGI(TAG, "%s: %" PRIu32 "x%" PRIu32 " -> %" PRIu32 "x%" PRIu32 ", load %" PRId64 " us, decode %" PRId64 " us, process %" PRId64 " us",
+             file_info->filename, decoded.width, decoded.height, display_image->width, display_image->height,
+             t1 - t0, t2 - t1, t3 - t2);
+
+    image_decoder_free_image(&processed);
+    image_decoder_free_image(&decoded);
+    return ret;
+}
+
+static void print_report(int slides, int failed, int64_t wall_us)
+{
+    printf("\n%-8s %8s %12s %12s %12s\n", "stage", "count", "avg_us", "min_us", "max_us");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const stage_stats_t *st = &s_stages[i];
+        printf("%-8s %8" PRIu32 " %12" PRId64 " %12" PRId64 " %12" PRId64 "\n", s_stage_names[i], st->count,
+               st->count ? st->total_us / st->count : 0, st->min_us, st->max_us);
+    }
+
+    image_buffer_stats_t buf_stats;
+    image_buffer_get_stats(&buf_stats);
+    printf("\nslides %d, failed %d, wall %" PRId64 " us (%.1f slides/s)\n", slides, failed, wall_us,
+           wall_us > 0 ? slides * 1e6 / wall_us : 0.0);
+    printf("buffers: %" PRIu32 " allocated, %" PRIu32 " unaligned DMA inputs, %" PRIu32 " unaligned syncs\n",
+           buf_stats.allocations, buf_stats.unaligned_inputs, buf_stats.unaligned_syncs);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-n loops] [-o out_dir] [-r] [-v] <photo_dir>\n"
+                    "  -n loops    run the whole directory this many times (default 1)\n"
+                    "  -o out_dir  write every displayed frame as PPM\n"
+                    "  -r          scan subdirectories\n"
+                    "  -v          debug logging\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    int loops = 1;
+    const char *out_dir = NULL;
+    bool recursive = false;
+    int opt;
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    while ((opt = getopt(argc, argv, "n:o:rvh")) != -1) {
+        switch (opt) {
+            case 'n': loops = atoi(optarg); break;
+            case 'o': out_dir = optarg; break;
+            case 'r': recursive = true; break;
+            case 'v': esp_log_level_set("*", ESP_LOG_DEBUG); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind >= argc || loops <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    photo_collection_t collection = {0};
+    collection.scan_subdirs = recursive;
+    collection.files = calloc(MAX_FILES_COUNT, sizeof(image_file_info_t));
+    if (!collection.files) {
+        return 1;
+    }
+
+    decoder_config_t decoder_config = {
+        .max_width = MAX_DECODE_WIDTH,
+        .max_height = MAX_DECODE_HEIGHT,
+        .use_psram = true
+    };
+    if (file_manager_init() != ESP_OK || image_decoder_init(&decoder_config) != ESP_OK ||
+        image_processor_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Pipeline init failed");
+        return 1;
+    }
+
+    if (file_manager_scan_images(argv[optind], &collection) != ESP_OK) {
+        return 1;
+    }
+    printf("%d media files in %s, display %dx%d\n", collection.total_count, argv[optind],
+           SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    int slides = 0;
+    int failed = 0;
+    int64_t start_us = esp_timer_get_time();
+    for (int loop = 0; loop < loops; loop++) {
+        for (int i = 0; i < collection.total_count; i++) {
+            const image_file_info_t *file_info = &collection.files[i];
+            if (file_manager_get_media_type(file_info->full_path) != MEDIA_TYPE_IMAGE) {
+                continue;
+            }
+            if (run_slide(file_info, loop == 0 ? out_dir : NULL, i) == ESP_OK) {
+                slides++;
+            } else {
+                failed++;
+            }
+        }
+    }
+    print_report(slides, failed, esp_timer_get_time() - start_us);
+
+    image_processor_deinit();
+    image_decoder_deinit();
+    file_manager_deinit();
+    free(collection.files);
+    return failed ? 2 : 0;
+}
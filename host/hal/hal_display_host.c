@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Stand-in panel: three off-screen frame buffers and a thread that "refreshes"
+// at 60 Hz, latching flips and calling the vsync callback like the DPI ISR.
+
+#include "hal_display.h"
+#include "image_buffer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "hal_display_host";
+
+#define HOST_REFRESH_HZ         60
+#define HOST_FB_COUNT           3
+
+static pthread_mutex_t s_display_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct {
+    bool started;
+    uint8_t *fbs[HAL_DISPLAY_MAX_FBS];
+    _Atomic uint32_t scanout;
+    _Atomic bool scanout_taken;
+    _Atomic(hal_display_vsync_cb_t) vsync_cb;
+    void *_Atomic vsync_user_data;
+    pthread_t refresh_thread;
+} s_disp;
+
+static void *refresh_thread(void *arg)
+{
+    const long period_ns = 1000000000L / HOST_REFRESH_HZ;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (;;) {
+        next.tv_nsec += period_ns;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        hal_display_vsync_cb_t cb = atomic_load(&s_disp.vsync_cb);
+        if (cb) {
+            cb(atomic_load(&s_disp.scanout), esp_timer_get_time(), atomic_load(&s_disp.vsync_user_data));
+        }
+    }
+    return NULL;
+}
+
+esp_err_t hal_display_start(void)
+{
+    if (s_disp.started) {
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < HOST_FB_COUNT; i++) {
+        s_disp.fbs[i] = image_buffer_alloc(hal_display_fb_size(), NULL);
+        if (!s_disp.fbs[i]) {
+            return ESP_ERR_NO_MEM;
+        }
+        memset(s_disp.fbs[i], 0, hal_display_fb_size());
+    }
+
+    if (pthread_create(&s_disp.refresh_thread, NULL, refresh_thread, NULL) != 0) {
+        return ESP_FAIL;
+    }
+    pthread_detach(s_disp.refresh_thread);
+
+    s_disp.started = true;
+    ESP_LOGI(TAG, "Stand-in display %dx%d, %d frame buffers at %d Hz", HAL_DISPLAY_H_RES, HAL_DISPLAY_V_RES,
+             HOST_FB_COUNT, HOST_REFRESH_HZ);
+    return ESP_OK;
+}
+
+bool hal_display_lock(uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+    return pthread_mutex_lock(&s_display_lock) == 0;
+}
+
+void hal_display_unlock(void)
+{
+    pthread_mutex_unlock(&s_display_lock);
+}
+
+uint32_t hal_display_fb_count(void)
+{
+    return s_disp.started ? HOST_FB_COUNT : 0;
+}
+
+uint8_t *hal_display_fb_get(uint32_t index)
+{
+    return index < hal_display_fb_count() ? s_disp.fbs[index] : NULL;
+}
+
+size_t hal_display_fb_size(void)
+{
+    return (size_t)HAL_DISPLAY_H_RES * HAL_DISPLAY_V_RES * 2;
+}
+
+void hal_display_set_vsync_cb(hal_display_vsync_cb_t cb, void *user_data)
+{
+    atomic_store(&s_disp.vsync_user_data, user_data);
+    atomic_store(&s_disp.vsync_cb, cb);
+}
+
+void hal_display_take_scanout(bool take)
+{
+    atomic_store(&s_disp.scanout_taken, take);
+}
+
+esp_err_t hal_display_fb_flip(uint32_t index)
+{
+    if (!atomic_load(&s_disp.scanout_taken) || index >= hal_display_fb_count()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    atomic_store(&s_disp.scanout, index);
+    return ESP_OK;
+}
+
+uint32_t hal_display_fb_scanout(void)
+{
+    return atomic_load(&s_disp.scanout);
+}
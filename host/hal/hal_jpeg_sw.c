@@ -0,0 +1,154 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Software JPEG engine on libjpeg, output layout matches the hardware decoder
+
+#include "hal_jpeg.h"
+#include "jpeg_sched.h"
+#include "esp_log.h"
+#include <jpeglib.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *TAG = "hal_jpeg_sw";
+
+#define JPEG_SW_BLOCK_ALIGN     16
+
+struct hal_jpeg_engine_t {
+    int unused;
+};
+
+static struct hal_jpeg_engine_t s_engine;
+
+typedef struct {
+    struct jpeg_error_mgr pub;
+    jmp_buf jump;
+} jpeg_sw_error_t;
+
+static void jpeg_sw_error_exit(j_common_ptr cinfo)
+{
+    jpeg_sw_error_t *err = (jpeg_sw_error_t *)cinfo->err;
+    longjmp(err->jump, 1);
+}
+
+// Warnings (e.g. truncated header buffers) are expected during validation
+static void jpeg_sw_output_message(j_common_ptr cinfo)
+{
+    char buffer[JMSG_LENGTH_MAX];
+    cinfo->err->format_message(cinfo, buffer);
+    ESP_LOGD(TAG, "libjpeg: %s", buffer);
+}
+
+esp_err_t hal_jpeg_get_info(const uint8_t *data, size_t data_size, hal_jpeg_info_t *info)
+{
+    if (!data || !info || data_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct jpeg_decompress_struct cinfo;
+    jpeg_sw_error_t jerr;
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = jpeg_sw_error_exit;
+    jerr.pub.output_message = jpeg_sw_output_message;
+
+    if (setjmp(jerr.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, (unsigned long)data_size);
+    jpeg_read_header(&cinfo, TRUE);
+
+    info->width = cinfo.image_width;
+    info->height = cinfo.image_height;
+    jpeg_destroy_decompress(&cinfo);
+    return ESP_OK;
+}
+
+esp_err_t hal_jpeg_acquire(hal_jpeg_handle_t *ret_handle)
+{
+    if (!ret_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Decodes are scheduled as on target, so the scheduler runs against this engine on Linux
+    esp_err_t ret = jpeg_sched_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    *ret_handle = &s_engine;
+    return ESP_OK;
+}
+
+void hal_jpeg_release(hal_jpeg_handle_t handle)
+{
+    (void)handle;
+}
+
+esp_err_t hal_jpeg_decode_rgb565(hal_jpeg_handle_t handle,
+                                 const uint8_t *data, size_t data_size,
+                                 uint8_t *out, size_t out_size, uint32_t *out_len)
+{
+    if (!handle || !data || !out || !out_len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct jpeg_decompress_struct cinfo;
+    jpeg_sw_error_t jerr;
+    uint8_t *row = NULL;
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = jpeg_sw_error_exit;
+    jerr.pub.output_message = jpeg_sw_output_message;
+
+    if (setjmp(jerr.jump)) {
+        ESP_LOGE(TAG, "Corrupted JPEG data");
+        free(row);
+        jpeg_destroy_decompress(&cinfo);
+        return ESP_FAIL;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, (unsigned long)data_size);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+
+    // The hardware writes whole 16x16 blocks, rows use the padded stride
+    uint32_t stride = (cinfo.output_width + JPEG_SW_BLOCK_ALIGN - 1) & ~(JPEG_SW_BLOCK_ALIGN - 1);
+    uint32_t padded_h = (cinfo.output_height + JPEG_SW_BLOCK_ALIGN - 1) & ~(JPEG_SW_BLOCK_ALIGN - 1);
+    size_t needed = (size_t)stride * padded_h * sizeof(uint16_t);
+    if (out_size < needed) {
+        ESP_LOGE(TAG, "Output buffer too small: %zu < %zu", out_size, needed);
+        jpeg_destroy_decompress(&cinfo);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    row = malloc((size_t)cinfo.output_width * 3);
+    if (!row) {
+        jpeg_destroy_decompress(&cinfo);
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint16_t *dst = (uint16_t *)out;
+    while (cinfo.output_scanline < cinfo.output_height) {
+        uint16_t *dst_row = dst + (size_t)cinfo.output_scanline * stride;
+        JSAMPROW rows[1] = { row };
+        jpeg_read_scanlines(&cinfo, rows, 1);
+        for (uint32_t x = 0; x < cinfo.output_width; x++) {
+            uint8_t r = row[x * 3 + 0];
+            uint8_t g = row[x * 3 + 1];
+            uint8_t b = row[x * 3 + 2];
+            dst_row[x] = (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+        }
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    free(row);
+
+    *out_len = (uint32_t)needed;
+    return ESP_OK;
+}
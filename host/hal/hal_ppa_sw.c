@@ -0,0 +1,219 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Software PPA: a worker thread per client runs queued SRM operations with
+// nearest-neighbour sampling, so submit/wait overlap like on the target.
+// Rotation and mirroring follow the PPA: scale, rotate counter-clockwise, mirror.
+
+#include "hal_ppa.h"
+#include "esp_log.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "hal_ppa_sw";
+
+struct hal_ppa_client_t {
+    hal_ppa_done_cb_t done_cb;
+    hal_ppa_srm_op_t *queue;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+    bool stop;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t worker;
+};
+
+// Source pixel of every scaled column/row, so the per-pixel loop only does lookups
+static uint32_t *srm_map(uint32_t count, uint32_t offset, uint32_t limit, float scale)
+{
+    uint32_t *map = malloc(count * sizeof(uint32_t));
+    if (!map) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t src = offset + (uint32_t)(i / scale);
+        map[i] = src < offset + limit ? src : offset + limit - 1;
+    }
+    return map;
+}
+
+// Scale, then rotate counter-clockwise, then mirror the output block, like the PPA
+static void srm_run(const hal_ppa_srm_op_t *op)
+{
+    const uint16_t *src = (const uint16_t *)op->in_buffer;
+    uint16_t *dst = (uint16_t *)op->out_buffer;
+    bool transposed = (op->rotation == HAL_PPA_ROTATION_90 || op->rotation == HAL_PPA_ROTATION_270);
+
+    // Scaled block, before rotation
+    uint32_t scaled_w = (uint32_t)(op->in_block_w * op->scale_x);
+    uint32_t scaled_h = (uint32_t)(op->in_block_h * op->scale_y);
+    uint32_t block_w = transposed ? scaled_h : scaled_w;
+    uint32_t block_h = transposed ? scaled_w : scaled_h;
+
+    uint32_t out_w = block_w;
+    uint32_t out_h = block_h;
+    if (op->out_block_offset_x + out_w > op->out_pic_w) {
+        out_w = op->out_pic_w - op->out_block_offset_x;
+    }
+    if (op->out_block_offset_y + out_h > op->out_pic_h) {
+        out_h = op->out_pic_h - op->out_block_offset_y;
+    }
+
+    uint32_t *x_map = srm_map(scaled_w, op->in_block_offset_x, op->in_block_w, op->scale_x);
+    uint32_t *y_map = srm_map(scaled_h, op->in_block_offset_y, op->in_block_h, op->scale_y);
+    if (!x_map || !y_map) {
+        ESP_LOGE(TAG, "Out of memory for SRM maps");
+        free(x_map);
+        free(y_map);
+        return;
+    }
+
+    for (uint32_t y = 0; y < out_h; y++) {
+        uint32_t by = op->mirror_y ? block_h - 1 - y : y;
+        uint16_t *dst_row = dst + (size_t)(op->out_block_offset_y + y) * op->out_pic_w + op->out_block_offset_x;
+
+        for (uint32_t x = 0; x < out_w; x++) {
+            uint32_t bx = op->mirror_x ? block_w - 1 - x : x;
+
+            // Undo the rotation to find the scaled pixel this output pixel shows
+            uint32_t sx, sy;
+            switch (op->rotation) {
+            case HAL_PPA_ROTATION_90:
+                sx = scaled_w - 1 - by;
+                sy = bx;
+                break;
+            case HAL_PPA_ROTATION_180:
+                sx = scaled_w - 1 - bx;
+                sy = scaled_h - 1 - by;
+                break;
+            case HAL_PPA_ROTATION_270:
+                sx = by;
+                sy = scaled_h - 1 - bx;
+                break;
+            default:
+                sx = bx;
+                sy = by;
+                break;
+            }
+            dst_row[x] = src[(size_t)y_map[sy] * op->in_pic_w + x_map[sx]];
+        }
+    }
+
+    free(x_map);
+    free(y_map);
+}
+
+static void *srm_worker(void *arg)
+{
+    struct hal_ppa_client_t *client = (struct hal_ppa_client_t *)arg;
+
+    pthread_mutex_lock(&client->lock);
+    while (true) {
+        while (client->count == 0 && !client->stop) {
+            pthread_cond_wait(&client->cond, &client->lock);
+        }
+        if (client->count == 0 && client->stop) {
+            break;
+        }
+
+        hal_ppa_srm_op_t op = client->queue[client->head];
+        pthread_mutex_unlock(&client->lock);
+
+        srm_run(&op);
+
+        // The slot stays occupied until done, like a pending hardware transaction
+        pthread_mutex_lock(&client->lock);
+        client->head = (client->head + 1) % client->capacity;
+        client->count--;
+        pthread_mutex_unlock(&client->lock);
+
+        if (client->done_cb) {
+            client->done_cb(op.user_data);
+        }
+        pthread_mutex_lock(&client->lock);
+    }
+    pthread_mutex_unlock(&client->lock);
+    return NULL;
+}
+
+esp_err_t hal_ppa_client_create(const hal_ppa_client_config_t *config, hal_ppa_client_handle_t *ret_client)
+{
+    if (!config || !ret_client || config->max_pending == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct hal_ppa_client_t *client = calloc(1, sizeof(*client));
+    if (!client) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    client->queue = calloc(config->max_pending, sizeof(hal_ppa_srm_op_t));
+    if (!client->queue) {
+        free(client);
+        return ESP_ERR_NO_MEM;
+    }
+    client->capacity = config->max_pending;
+    client->done_cb = config->done_cb;
+    pthread_mutex_init(&client->lock, NULL);
+    pthread_cond_init(&client->cond, NULL);
+
+    if (pthread_create(&client->worker, NULL, srm_worker, client) != 0) {
+        ESP_LOGE(TAG, "Failed to start SRM worker");
+        free(client->queue);
+        free(client);
+        return ESP_FAIL;
+    }
+
+    *ret_client = client;
+    return ESP_OK;
+}
+
+esp_err_t hal_ppa_client_delete(hal_ppa_client_handle_t client)
+{
+    if (!client) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&client->lock);
+    client->stop = true;
+    pthread_cond_signal(&client->cond);
+    pthread_mutex_unlock(&client->lock);
+    pthread_join(client->worker, NULL);
+
+    pthread_cond_destroy(&client->cond);
+    pthread_mutex_destroy(&client->lock);
+    free(client->queue);
+    free(client);
+    return ESP_OK;
+}
+
+esp_err_t hal_ppa_srm_submit(hal_ppa_client_handle_t client, const hal_ppa_srm_op_t *op)
+{
+    if (!client || !op || !op->in_buffer || !op->out_buffer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t needed = (size_t)op->out_pic_w * op->out_pic_h * sizeof(uint16_t);
+    if (op->out_buffer_size < needed || op->scale_x <= 0 || op->scale_y <= 0 ||
+        op->rotation > HAL_PPA_ROTATION_270 ||
+        op->in_block_offset_x + op->in_block_w > op->in_pic_w ||
+        op->in_block_offset_y + op->in_block_h > op->in_pic_h) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&client->lock);
+    if (client->count == client->capacity) {
+        pthread_mutex_unlock(&client->lock);
+        ESP_LOGE(TAG, "Exceeded max pending transactions");
+        return ESP_ERR_INVALID_STATE;
+    }
+    client->queue[(client->head + client->count) % client->capacity] = *op;
+    client->count++;
+    pthread_cond_signal(&client->cond);
+    pthread_mutex_unlock(&client->lock);
+    return ESP_OK;
+}
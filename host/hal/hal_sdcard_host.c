@@ -0,0 +1,18 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Photos are read straight from the host file system, nothing to mount
+
+#include "hal_sdcard.h"
+
+esp_err_t hal_sdcard_mount(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t hal_sdcard_unmount(void)
+{
+    return ESP_OK;
+}
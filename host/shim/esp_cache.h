@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for esp_cache.h. Host memory is coherent, syncs are no-ops.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define ESP_CACHE_MSYNC_FLAG_INVALIDATE     (1 << 0)
+#define ESP_CACHE_MSYNC_FLAG_UNALIGNED      (1 << 1)
+#define ESP_CACHE_MSYNC_FLAG_DIR_C2M        (1 << 2)
+#define ESP_CACHE_MSYNC_FLAG_DIR_M2C        (1 << 3)
+
+#define HOST_CACHE_LINE_SIZE                64
+
+static inline esp_err_t esp_cache_msync(void *addr, size_t size, int flags)
+{
+    (void)addr;
+    (void)size;
+    (void)flags;
+    return ESP_OK;
+}
+
+static inline esp_err_t esp_cache_get_alignment(uint32_t heap_caps, size_t *out_alignment)
+{
+    (void)heap_caps;
+    *out_alignment = HOST_CACHE_LINE_SIZE;
+    return ESP_OK;
+}
@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the esp_h264 decoder API, see esp_h264_shim.c
+
+#pragma once
+
+#include "esp_h264_types.h"
+
+typedef struct esp_h264_dec_t *esp_h264_dec_handle_t;
+typedef struct esp_h264_dec_param_t *esp_h264_dec_param_handle_t;
+
+typedef struct {
+    uint32_t dts;
+    uint32_t pts;
+    esp_h264_pkt_t raw_data;
+    uint32_t consume;               // Bytes of raw_data used by the call
+} esp_h264_dec_in_frame_t;
+
+typedef struct {
+    uint32_t dts;
+    uint32_t pts;
+    uint8_t *outbuf;                // Held by the decoder
+    uint32_t out_size;              // 0 when no picture came out
+} esp_h264_dec_out_frame_t;
+
+esp_h264_err_t esp_h264_dec_open(esp_h264_dec_handle_t dec);
+esp_h264_err_t esp_h264_dec_process(esp_h264_dec_handle_t dec, esp_h264_dec_in_frame_t *in_frame,
+                                    esp_h264_dec_out_frame_t *out_frame);
+esp_h264_err_t esp_h264_dec_close(esp_h264_dec_handle_t dec);
+esp_h264_err_t esp_h264_dec_del(esp_h264_dec_handle_t dec);
+esp_h264_err_t esp_h264_dec_get_resolution(esp_h264_dec_param_handle_t param, esp_h264_resolution_t *res);
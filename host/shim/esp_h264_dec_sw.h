@@ -0,0 +1,19 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the esp_h264 software decoder constructor, see esp_h264_shim.c
+
+#pragma once
+
+#include "esp_h264_dec.h"
+
+typedef struct {
+    esp_h264_raw_format_t pic_type;
+} esp_h264_dec_cfg_sw_t;
+
+typedef esp_h264_dec_param_handle_t esp_h264_dec_param_sw_handle_t;
+
+esp_h264_err_t esp_h264_dec_sw_new(const esp_h264_dec_cfg_sw_t *cfg, esp_h264_dec_handle_t *out_dec);
+esp_h264_err_t esp_h264_dec_sw_get_param_hd(esp_h264_dec_handle_t dec, esp_h264_dec_param_sw_handle_t *out_param);
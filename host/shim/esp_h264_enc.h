@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the esp_h264 encoder API, see esp_h264_shim.c
+
+#pragma once
+
+#include "esp_h264_types.h"
+
+typedef struct esp_h264_enc_t *esp_h264_enc_handle_t;
+
+typedef struct {
+    uint32_t bitrate;
+    uint8_t qp_min;
+    uint8_t qp_max;
+} esp_h264_enc_rc_t;
+
+typedef struct {
+    esp_h264_pkt_t raw_data;
+    uint32_t pts;
+} esp_h264_enc_in_frame_t;
+
+typedef struct {
+    esp_h264_frame_type_t frame_type;
+    esp_h264_pkt_t raw_data;        // Output space, filled from the start
+    uint32_t length;                // Bytes written
+    uint32_t pts;
+    uint32_t dts;
+} esp_h264_enc_out_frame_t;
+
+esp_h264_err_t esp_h264_enc_open(esp_h264_enc_handle_t enc);
+esp_h264_err_t esp_h264_enc_process(esp_h264_enc_handle_t enc, esp_h264_enc_in_frame_t *in_frame,
+                                    esp_h264_enc_out_frame_t *out_frame);
+esp_h264_err_t esp_h264_enc_close(esp_h264_enc_handle_t enc);
+esp_h264_err_t esp_h264_enc_del(esp_h264_enc_handle_t enc);
@@ -0,0 +1,20 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the esp_h264 software encoder constructor, see esp_h264_shim.c
+
+#pragma once
+
+#include "esp_h264_enc.h"
+
+typedef struct {
+    esp_h264_raw_format_t pic_type;
+    uint8_t gop;
+    uint8_t fps;
+    esp_h264_resolution_t res;
+    esp_h264_enc_rc_t rc;
+} esp_h264_enc_cfg_sw_t;
+
+esp_h264_err_t esp_h264_enc_sw_new(const esp_h264_enc_cfg_sw_t *cfg, esp_h264_enc_handle_t *out_enc);
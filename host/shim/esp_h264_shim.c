@@ -0,0 +1,1082 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the esp_h264 software codec. Both sides speak baseline
+// H.264, but only the tools this encoder writes: I_PCM macroblocks, and in P
+// slices P_L0_16x16 or P_Skip macroblocks with whole-pixel motion and no
+// residual, deblocking disabled. Pictures pass through losslessly, so decoded
+// frames can be checked bit for bit against the encoder input. The decoder
+// refuses any other tool (residual coding, CABAC, sub-pixel luma motion,
+// deblocking), so clips from a real encoder still need the target.
+
+#include "esp_h264_dec_sw.h"
+#include "esp_h264_enc_sw.h"
+#include "esp_log.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "esp_h264_sw";
+
+#define MB_SIZE                 16
+#define MB_PCM_BYTES            384     // 256 luma and 2 x 64 chroma samples
+#define NAL_SLICE               1
+#define NAL_IDR                 5
+#define NAL_SPS                 7
+#define NAL_PPS                 8
+#define SLICE_P                 0
+#define SLICE_I                 2
+#define MB_TYPE_I_PCM           25      // In I slices, 5 + 25 in P slices
+#define MB_TYPE_P_L0_16X16      0
+#define PROFILE_BASELINE        66
+#define ENC_LOG2_MAX_FRAME_NUM  4
+#define ENC_MV_RANGE            16      // Whole pixels searched either way for the global motion
+
+// Motion of a decoded macroblock, for motion vector prediction
+typedef struct {
+    bool available;                 // Decoded and in the current slice
+    int ref_idx;                    // -1 for intra
+    int mv_x;                       // Quarter pixels
+    int mv_y;
+} mb_motion_t;
+
+// Whole 4:2:0 picture in one buffer, the layout esp_h264 outputs
+typedef struct {
+    uint8_t *data;
+    uint32_t width;
+    uint32_t height;
+} picture_t;
+
+static uint8_t *plane(const picture_t *pic, int c)
+{
+    size_t luma = (size_t)pic->width * pic->height;
+    return c == 0 ? pic->data : pic->data + luma + (c == 2 ? luma / 4 : 0);
+}
+
+static int clampi(int v, int lo, int hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static int median3(int a, int b, int c)
+{
+    int hi = a > b ? a : b;
+    int lo = a < b ? a : b;
+    return c > hi ? hi : (c < lo ? lo : c);
+}
+
+// Motion vector prediction for a 16x16 partition with ref_idx 0 (8.4.1.3)
+static void predict_mv(const mb_motion_t *mbs, uint32_t mb_w, uint32_t addr, uint32_t first_mb,
+                       int *mvp_x, int *mvp_y, bool skip)
+{
+    uint32_t x = addr % mb_w;
+    const mb_motion_t unavailable = { .available = false, .ref_idx = -1 };
+    // Neighbours decoded earlier in the same slice
+#define NEIGHBOUR(cond, a) ((cond) && (a) >= first_mb ? &mbs[(a)] : &unavailable)
+    const mb_motion_t *a = NEIGHBOUR(x > 0, addr - 1);
+    const mb_motion_t *b = NEIGHBOUR(addr >= mb_w, addr - mb_w);
+    const mb_motion_t *c = NEIGHBOUR(addr >= mb_w && x + 1 < mb_w, addr - mb_w + 1);
+    if (!c->available) {
+        c = NEIGHBOUR(addr >= mb_w && x > 0, addr - mb_w - 1);
+    }
+#undef NEIGHBOUR
+
+    if (skip && (!a->available || !b->available ||
+                 (a->ref_idx == 0 && a->mv_x == 0 && a->mv_y == 0) ||
+                 (b->ref_idx == 0 && b->mv_x == 0 && b->mv_y == 0))) {
+        *mvp_x = 0;
+        *mvp_y = 0;
+        return;
+    }
+    if (!b->available && !c->available && a->available) {
+        b = a;
+        c = a;
+    }
+
+    int matches = (a->ref_idx == 0) + (b->ref_idx == 0) + (c->ref_idx == 0);
+    if (matches == 1) {
+        const mb_motion_t *m = a->ref_idx == 0 ? a : (b->ref_idx == 0 ? b : c);
+        *mvp_x = m->mv_x;
+        *mvp_y = m->mv_y;
+        return;
+    }
+    *mvp_x = median3(a->available ? a->mv_x : 0, b->available ? b->mv_x : 0, c->available ? c->mv_x : 0);
+    *mvp_y = median3(a->available ? a->mv_y : 0, b->available ? b->mv_y : 0, c->available ? c->mv_y : 0);
+}
+
+// Predict one macroblock from ref with a whole-pixel luma vector; chroma may land
+// on half pixels and is interpolated as the standard does
+static void motion_compensate(const picture_t *ref, const picture_t *cur, uint32_t mb_x, uint32_t mb_y,
+                              int mv_x, int mv_y)
+{
+    int w = (int)ref->width;
+    int h = (int)ref->height;
+    const uint8_t *src = plane(ref, 0);
+    uint8_t *dst = plane(cur, 0);
+    for (int y = 0; y < MB_SIZE; y++) {
+        int sy = clampi((int)mb_y * MB_SIZE + y + mv_y / 4, 0, h - 1);
+        for (int x = 0; x < MB_SIZE; x++) {
+            int sx = clampi((int)mb_x * MB_SIZE + x + mv_x / 4, 0, w - 1);
+            dst[((size_t)mb_y * MB_SIZE + y) * w + mb_x * MB_SIZE + x] = src[(size_t)sy * w + sx];
+        }
+    }
+
+    int cw = w / 2;
+    int ch = h / 2;
+    int fx = mv_x & 7;
+    int fy = mv_y & 7;
+    for (int c = 1; c <= 2; c++) {
+        src = plane(ref, c);
+        dst = plane(cur, c);
+        for (int y = 0; y < MB_SIZE / 2; y++) {
+            int y0 = (int)mb_y * MB_SIZE / 2 + y + (mv_y >> 3);
+            int ya = clampi(y0, 0, ch - 1);
+            int yb = clampi(y0 + 1, 0, ch - 1);
+            for (int x = 0; x < MB_SIZE / 2; x++) {
+                int x0 = (int)mb_x * MB_SIZE / 2 + x + (mv_x >> 3);
+                int xa = clampi(x0, 0, cw - 1);
+                int xb = clampi(x0 + 1, 0, cw - 1);
+                int v = (8 - fx) * (8 - fy) * src[(size_t)ya * cw + xa] + fx * (8 - fy) * src[(size_t)ya * cw + xb] +
+                        (8 - fx) * fy * src[(size_t)yb * cw + xa] + fx * fy * src[(size_t)yb * cw + xb];
+                dst[((size_t)mb_y * MB_SIZE / 2 + y) * cw + mb_x * MB_SIZE / 2 + x] = (uint8_t)((v + 32) >> 6);
+            }
+        }
+    }
+}
+
+// ---- Bitstream -------------------------------------------------------------
+
+typedef struct {
+    uint8_t *buf;
+    size_t capacity;
+    size_t pos;                     // Whole bytes written
+    int bits;                       // Bits used in buf[pos]
+    bool overflow;
+} bit_writer_t;
+
+static void put_bit(bit_writer_t *w, uint32_t bit)
+{
+    if (w->pos >= w->capacity) {
+        w->overflow = true;
+        return;
+    }
+    if (w->bits == 0) {
+        w->buf[w->pos] = 0;
+    }
+    w->buf[w->pos] |= (uint8_t)((bit & 1) << (7 - w->bits));
+    if (++w->bits == 8) {
+        w->bits = 0;
+        w->pos++;
+    }
+}
+
+static void put_bits(bit_writer_t *w, uint32_t value, int n)
+{
+    while (n-- > 0) {
+        put_bit(w, value >> n);
+    }
+}
+
+static void put_ue(bit_writer_t *w, uint32_t value)
+{
+    uint32_t v = value + 1;
+    int len = 0;
+    while ((v >> len) > 1) {
+        len++;
+    }
+    put_bits(w, 0, len);
+    put_bits(w, v, len + 1);
+}
+
+static void put_se(bit_writer_t *w, int value)
+{
+    put_ue(w, value > 0 ? 2 * (uint32_t)value - 1 : 2 * (uint32_t)-value);
+}
+
+static void put_align_zero(bit_writer_t *w)
+{
+    while (w->bits != 0) {
+        put_bit(w, 0);
+    }
+}
+
+static void put_bytes(bit_writer_t *w, const uint8_t *data, size_t n)
+{
+    if (w->pos + n > w->capacity) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->pos, data, n);
+    w->pos += n;
+}
+
+static void put_trailing_bits(bit_writer_t *w)
+{
+    put_bit(w, 1);
+    put_align_zero(w);
+}
+
+typedef struct {
+    const uint8_t *buf;
+    size_t bit_pos;
+    size_t end_bit;                 // Position of the rbsp_stop_one_bit
+    bool overrun;
+} bit_reader_t;
+
+static void reader_init(bit_reader_t *r, const uint8_t *rbsp, size_t size)
+{
+    r->buf = rbsp;
+    r->bit_pos = 0;
+    r->end_bit = 0;
+    r->overrun = false;
+    while (size > 0 && rbsp[size - 1] == 0) {
+        size--;
+    }
+    if (size > 0) {
+        uint8_t last = rbsp[size - 1];
+        int trailing = 0;
+        while (!(last & (1 << trailing))) {
+            trailing++;
+        }
+        r->end_bit = size * 8 - 1 - trailing;
+    }
+}
+
+static uint32_t get_bit(bit_reader_t *r)
+{
+    if (r->bit_pos >= r->end_bit) {
+        r->overrun = true;
+        return 0;
+    }
+    uint32_t bit = (r->buf[r->bit_pos / 8] >> (7 - r->bit_pos % 8)) & 1;
+    r->bit_pos++;
+    return bit;
+}
+
+static uint32_t get_bits(bit_reader_t *r, int n)
+{
+    uint32_t v = 0;
+    while (n-- > 0) {
+        v = (v << 1) | get_bit(r);
+    }
+    return v;
+}
+
+static uint32_t get_ue(bit_reader_t *r)
+{
+    int zeros = 0;
+    while (get_bit(r) == 0 && !r->overrun && zeros < 32) {
+        zeros++;
+    }
+    if (zeros >= 32) {
+        r->overrun = true;
+        return 0;
+    }
+    return (1U << zeros) - 1 + get_bits(r, zeros);
+}
+
+static int get_se(bit_reader_t *r)
+{
+    uint32_t k = get_ue(r);
+    return (k & 1) ? (int)((k + 1) / 2) : -(int)(k / 2);
+}
+
+static bool more_rbsp_data(const bit_reader_t *r)
+{
+    return r->bit_pos < r->end_bit;
+}
+
+static void get_align(bit_reader_t *r)
+{
+    r->bit_pos = (r->bit_pos + 7) & ~(size_t)7;
+}
+
+// Start code, NAL header and the RBSP with emulation prevention bytes
+static bool write_nal(esp_h264_pkt_t *out, uint32_t *length, uint8_t header, const bit_writer_t *rbsp)
+{
+    uint32_t pos = *length;
+    if (pos + 5 > out->len) {
+        return false;
+    }
+    memcpy(out->buffer + pos, "\0\0\0\1", 4);
+    out->buffer[pos + 4] = header;
+    pos += 5;
+
+    int zeros = 0;
+    for (size_t i = 0; i < rbsp->pos; i++) {
+        uint8_t byte = rbsp->buf[i];
+        if (zeros >= 2 && byte <= 3) {
+            if (pos >= out->len) {
+                return false;
+            }
+            out->buffer[pos++] = 3;
+            zeros = 0;
+        }
+        if (pos >= out->len) {
+            return false;
+        }
+        out->buffer[pos++] = byte;
+        zeros = byte == 0 ? zeros + 1 : 0;
+    }
+    *length = pos;
+    return true;
+}
+
+// ---- Decoder ---------------------------------------------------------------
+
+struct esp_h264_dec_t {
+    bool open;
+    // Active sequence, from the last SPS
+    bool have_sps;
+    uint32_t mb_w;
+    uint32_t mb_h;
+    uint32_t log2_max_frame_num;
+    uint32_t poc_type;
+    uint32_t log2_max_poc_lsb;
+    // Active picture parameters, from the last PPS
+    bool have_pps;
+    bool bottom_field_pic_order;
+    bool redundant_pic_cnt_present;
+    bool deblocking_control_present;
+    uint32_t num_ref_idx_default;
+    // Pictures
+    picture_t cur;
+    picture_t ref;
+    bool have_ref;
+    uint32_t mbs_decoded;           // Of the picture in cur
+    mb_motion_t *motion;
+    uint8_t *rbsp;
+    size_t rbsp_capacity;
+    esp_h264_resolution_t res;
+};
+
+static esp_h264_err_t dec_parse_sps(esp_h264_dec_handle_t dec, bit_reader_t *r)
+{
+    uint32_t profile = get_bits(r, 8);
+    get_bits(r, 16);                // Constraint flags, level
+    get_ue(r);                      // seq_parameter_set_id
+    if (profile != PROFILE_BASELINE) {
+        ESP_LOGE(TAG, "Profile %u not supported by the stand-in", profile);
+        return ESP_H264_ERR_UNSUPPORTED;
+    }
+    uint32_t log2_max_frame_num = get_ue(r) + 4;
+    uint32_t poc_type = get_ue(r);
+    uint32_t log2_max_poc_lsb = 0;
+    if (poc_type == 0) {
+        log2_max_poc_lsb = get_ue(r) + 4;
+    } else if (poc_type == 1) {
+        ESP_LOGE(TAG, "Picture order count type 1 not supported by the stand-in");
+        return ESP_H264_ERR_UNSUPPORTED;
+    }
+    get_ue(r);                      // max_num_ref_frames
+    get_bit(r);                     // gaps_in_frame_num_value_allowed_flag
+    uint32_t mb_w = get_ue(r) + 1;
+    uint32_t mb_h = get_ue(r) + 1;
+    bool frame_mbs_only = get_bit(r);
+    get_bit(r);                     // direct_8x8_inference_flag
+    bool cropping = get_bit(r);
+    if (r->overrun || !frame_mbs_only || cropping || mb_w > 256 || mb_h > 256) {
+        ESP_LOGE(TAG, "Sequence not supported by the stand-in");
+        return ESP_H264_ERR_UNSUPPORTED;
+    }
+
+    if (!dec->have_sps || mb_w != dec->mb_w || mb_h != dec->mb_h) {
+        size_t luma = (size_t)mb_w * mb_h * MB_SIZE * MB_SIZE;
+        uint8_t *cur = realloc(dec->cur.data, luma * 3 / 2);
+        if (cur) {
+            dec->cur.data = cur;
+        }
+        uint8_t *ref = realloc(dec->ref.data, luma * 3 / 2);
+        if (ref) {
+            dec->ref.data = ref;
+        }
+        mb_motion_t *motion = realloc(dec->motion, (size_t)mb_w * mb_h * sizeof(*motion));
+        if (motion) {
+            dec->motion = motion;
+        }
+        if (!cur || !ref || !motion) {
+            dec->have_sps = false;
+            return ESP_H264_ERR_MEM;
+        }
+        dec->cur.width = dec->ref.width = mb_w * MB_SIZE;
+        dec->cur.height = dec->ref.height = mb_h * MB_SIZE;
+        dec->have_ref = false;
+        dec->mbs_decoded = 0;
+    }
+    dec->have_sps = true;
+    dec->mb_w = mb_w;
+    dec->mb_h = mb_h;
+    dec->log2_max_frame_num = log2_max_frame_num;
+    dec->poc_type = poc_type;
+    dec->log2_max_poc_lsb = log2_max_poc_lsb;
+    dec->res.width = (uint16_t)(mb_w * MB_SIZE);
+    dec->res.height = (uint16_t)(mb_h * MB_SIZE);
+    return ESP_H264_ERR_OK;
+}
+
+static esp_h264_err_t dec_parse_pps(esp_h264_dec_handle_t dec, bit_reader_t *r)
+{
+    get_ue(r);                      // pic_parameter_set_id
+    get_ue(r);                      // seq_parameter_set_id
+    bool cabac = get_bit(r);
+    dec->bottom_field_pic_order = get_bit(r);
+    uint32_t slice_groups = get_ue(r) + 1;
+    dec->num_ref_idx_default = get_ue(r) + 1;
+    get_ue(r);                      // num_ref_idx_l1_default_active_minus1
+    bool weighted = get_bit(r);
+    get_bits(r, 2);                 // weighted_bipred_idc
+    get_se(r);                      // pic_init_qp_minus26
+    get_se(r);                      // pic_init_qs_minus26
+    get_se(r);                      // chroma_qp_index_offset
+    dec->deblocking_control_present = get_bit(r);
+    get_bit(r);                     // constrained_intra_pred_flag
+    dec->redundant_pic_cnt_present = get_bit(r);
+    if (r->overrun || cabac || slice_groups != 1 || weighted) {
+        ESP_LOGE(TAG, "Picture parameters not supported by the stand-in");
+        dec->have_pps = false;
+        return ESP_H264_ERR_UNSUPPORTED;
+    }
+    dec->have_pps = true;
+    return ESP_H264_ERR_OK;
+}
+
+static void dec_skip_ref_pic_marking(bit_reader_t *r, bool idr)
+{
+    if (idr) {
+        get_bits(r, 2);             // no_output_of_prior_pics_flag, long_term_reference_flag
+        return;
+    }
+    if (!get_bit(r)) {
+        return;
+    }
+    // One reference is all the stand-in keeps, so the operations only need parsing
+    uint32_t op;
+    while ((op = get_ue(r)) != 0 && !r->overrun) {
+        if (op == 1 || op == 3) {
+            get_ue(r);
+        }
+        if (op == 2 || op == 3 || op == 4 || op == 6) {
+            get_ue(r);
+        }
+    }
+}
+
+static esp_h264_err_t dec_parse_slice(esp_h264_dec_handle_t dec, bit_reader_t *r, uint8_t nal_header, bool *done)
+{
+    bool idr = (nal_header & 0x1F) == NAL_IDR;
+    if (!dec->have_sps || !dec->have_pps) {
+        ESP_LOGE(TAG, "Slice before its parameter sets");
+        return ESP_H264_ERR_FAIL;
+    }
+
+    uint32_t first_mb = get_ue(r);
+    uint32_t slice_type = get_ue(r) % 5;
+    get_ue(r);                      // pic_parameter_set_id
+    get_bits(r, dec->log2_max_frame_num);
+    if (idr) {
+        get_ue(r);                  // idr_pic_id
+    }
+    if (dec->poc_type == 0) {
+        get_bits(r, dec->log2_max_poc_lsb);
+        if (dec->bottom_field_pic_order) {
+            get_se(r);
+        }
+    }
+    if (dec->redundant_pic_cnt_present) {
+        get_ue(r);
+    }
+    if (slice_type == SLICE_P) {
+        uint32_t refs = dec->num_ref_idx_default;
+        if (get_bit(r)) {
+            refs = get_ue(r) + 1;
+        }
+        if (refs != 1 || get_bit(r)) {
+            ESP_LOGE(TAG, "Multiple references not supported by the stand-in");
+            return ESP_H264_ERR_UNSUPPORTED;
+        }
+    } else if (slice_type != SLICE_I) {
+        ESP_LOGE(TAG, "Slice type %u not supported by the stand-in", slice_type);
+        return ESP_H264_ERR_UNSUPPORTED;
+    }
+    if (nal_header & 0x60) {
+        dec_skip_ref_pic_marking(r, idr);
+    }
+    get_se(r);                      // slice_qp_delta
+    uint32_t deblocking = 0;
+    if (dec->deblocking_control_present) {
+        deblocking = get_ue(r);
+        if (deblocking != 1) {
+            get_se(r);
+            get_se(r);
+        }
+    }
+    if (r->overrun || deblocking != 1) {
+        ESP_LOGE(TAG, "Deblocked slices not supported by the stand-in");
+        return ESP_H264_ERR_UNSUPPORTED;
+    }
+    uint32_t mb_count = dec->mb_w * dec->mb_h;
+    if (first_mb >= mb_count || (slice_type == SLICE_P && !dec->have_ref)) {
+        return ESP_H264_ERR_FAIL;
+    }
+    if (first_mb == 0) {
+        dec->mbs_decoded = 0;
+    }
+
+    uint32_t addr = first_mb;
+    bool more = true;
+    while (more && addr < mb_count) {
+        uint32_t mb_x = addr % dec->mb_w;
+        uint32_t mb_y = addr / dec->mb_w;
+        mb_motion_t *m = &dec->motion[addr];
+
+        if (slice_type == SLICE_P) {
+            uint32_t skip_run = get_ue(r);
+            for (; skip_run > 0 && addr < mb_count; skip_run--, addr++) {
+                m = &dec->motion[addr];
+                predict_mv(dec->motion, dec->mb_w, addr, first_mb, &m->mv_x, &m->mv_y, true);
+                m->available = true;
+                m->ref_idx = 0;
+                motion_compensate(&dec->ref, &dec->cur, addr % dec->mb_w, addr / dec->mb_w, m->mv_x, m->mv_y);
+                dec->mbs_decoded++;
+            }
+            if (addr >= mb_count || !more_rbsp_data(r)) {
+                break;
+            }
+            mb_x = addr % dec->mb_w;
+            mb_y = addr / dec->mb_w;
+            m = &dec->motion[addr];
+        }
+
+        uint32_t mb_type = get_ue(r);
+        if (slice_type == SLICE_P && mb_type == MB_TYPE_P_L0_16X16) {
+            int mvd_x = get_se(r);
+            int mvd_y = get_se(r);
+            uint32_t cbp = get_ue(r);
+            int mvp_x, mvp_y;
+            predict_mv(dec->motion, dec->mb_w, addr, first_mb, &mvp_x, &mvp_y, false);
+            m->mv_x = mvp_x + mvd_x;
+            m->mv_y = mvp_y + mvd_y;
+            if (cbp != 0 || (m->mv_x & 3) || (m->mv_y & 3)) {
+                ESP_LOGE(TAG, "Residuals and sub-pixel motion not supported by the stand-in");
+                return ESP_H264_ERR_UNSUPPORTED;
+            }
+            m->available = true;
+            m->ref_idx = 0;
+            motion_compensate(&dec->ref, &dec->cur, mb_x, mb_y, m->mv_x, m->mv_y);
+        } else if (mb_type == (slice_type == SLICE_P ? 5 + MB_TYPE_I_PCM : MB_TYPE_I_PCM)) {
+            get_align(r);
+            if (r->bit_pos / 8 + MB_PCM_BYTES > r->end_bit / 8) {
+                return ESP_H264_ERR_FAIL;
+            }
+            const uint8_t *pcm = r->buf + r->bit_pos / 8;
+            for (int y = 0; y < MB_SIZE; y++, pcm += MB_SIZE) {
+                memcpy(dec->cur.data + ((size_t)mb_y * MB_SIZE + y) * dec->cur.width + mb_x * MB_SIZE, pcm, MB_SIZE);
+            }
+            for (int c = 1; c <= 2; c++) {
+                uint8_t *chroma = plane(&dec->cur, c);
+                for (int y = 0; y < MB_SIZE / 2; y++, pcm += MB_SIZE / 2) {
+                    memcpy(chroma + ((size_t)mb_y * MB_SIZE / 2 + y) * (dec->cur.width / 2) + mb_x * MB_SIZE / 2,
+                           pcm, MB_SIZE / 2);
+                }
+            }
+            r->bit_pos += MB_PCM_BYTES * 8;
+            m->available = true;
+            m->ref_idx = -1;
+            m->mv_x = 0;
+            m->mv_y = 0;
+        } else {
+            ESP_LOGE(TAG, "Macroblock type %u not supported by the stand-in", mb_type);
+            return ESP_H264_ERR_UNSUPPORTED;
+        }
+        if (r->overrun) {
+            return ESP_H264_ERR_FAIL;
+        }
+        dec->mbs_decoded++;
+        addr++;
+        more = more_rbsp_data(r);
+    }
+
+    if (dec->mbs_decoded >= mb_count) {
+        // The finished picture is output and becomes the reference of the next one
+        picture_t done_pic = dec->cur;
+        dec->cur = dec->ref;
+        dec->ref = done_pic;
+        dec->have_ref = true;
+        dec->mbs_decoded = 0;
+        *done = true;
+    }
+    return ESP_H264_ERR_OK;
+}
+
+// Offset of the next 00 00 01, or size
+static uint32_t find_start_code(const uint8_t *data, uint32_t size, uint32_t from)
+{
+    for (uint32_t i = from; i + 2 < size; i++) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            return i;
+        }
+    }
+    return size;
+}
+
+esp_h264_err_t esp_h264_dec_sw_new(const esp_h264_dec_cfg_sw_t *cfg, esp_h264_dec_handle_t *out_dec)
+{
+    if (!cfg || !out_dec) {
+        return ESP_H264_ERR_ARG;
+    }
+    if (cfg->pic_type != ESP_H264_RAW_FMT_I420) {
+        return ESP_H264_ERR_UNSUPPORTED;
+    }
+    *out_dec = calloc(1, sizeof(struct esp_h264_dec_t));
+    return *out_dec ? ESP_H264_ERR_OK : ESP_H264_ERR_MEM;
+}
+
+esp_h264_err_t esp_h264_dec_open(esp_h264_dec_handle_t dec)
+{
+    if (!dec) {
+        return ESP_H264_ERR_ARG;
+    }
+    dec->open = true;
+    return ESP_H264_ERR_OK;
+}
+
+// One NAL unit per call; a picture comes out with its last macroblock
+esp_h264_err_t esp_h264_dec_process(esp_h264_dec_handle_t dec, esp_h264_dec_in_frame_t *in_frame,
+                                    esp_h264_dec_out_frame_t *out_frame)
+{
+    if (!dec || !dec->open || !in_frame || !out_frame || !in_frame->raw_data.buffer) {
+        return ESP_H264_ERR_ARG;
+    }
+    const uint8_t *data = in_frame->raw_data.buffer;
+    uint32_t size = in_frame->raw_data.len;
+    out_frame->outbuf = NULL;
+    out_frame->out_size = 0;
+    out_frame->pts = in_frame->pts;
+    out_frame->dts = in_frame->dts;
+
+    uint32_t start = find_start_code(data, size, 0);
+    if (start == size) {
+        in_frame->consume = size;
+        return ESP_H264_ERR_OK;
+    }
+    uint32_t nal = start + 3;
+    uint32_t end = find_start_code(data, size, nal);
+    in_frame->consume = end;
+    if (end < size && end > nal && data[end - 1] == 0) {
+        end--;                      // Leading zero of a 4-byte start code
+    }
+    if (end <= nal) {
+        return ESP_H264_ERR_OK;
+    }
+
+    uint8_t header = data[nal];
+    uint32_t type = header & 0x1F;
+    if (type != NAL_SPS && type != NAL_PPS && type != NAL_SLICE && type != NAL_IDR) {
+        return ESP_H264_ERR_OK;
+    }
+
+    // Strip emulation prevention bytes
+    size_t payload = end - nal - 1;
+    if (payload > dec->rbsp_capacity) {
+        uint8_t *rbsp = realloc(dec->rbsp, payload);
+        if (!rbsp) {
+            return ESP_H264_ERR_MEM;
+        }
+        dec->rbsp = rbsp;
+        dec->rbsp_capacity = payload;
+    }
+    size_t rbsp_len = 0;
+    int zeros = 0;
+    for (uint32_t i = nal + 1; i < end; i++) {
+        if (zeros >= 2 && data[i] == 3) {
+            zeros = 0;
+            continue;
+        }
+        dec->rbsp[rbsp_len++] = data[i];
+        zeros = data[i] == 0 ? zeros + 1 : 0;
+    }
+
+    bit_reader_t r;
+    reader_init(&r, dec->rbsp, rbsp_len);
+    if (type == NAL_SPS) {
+        return dec_parse_sps(dec, &r);
+    }
+    if (type == NAL_PPS) {
+        return dec_parse_pps(dec, &r);
+    }
+
+    bool done = false;
+    esp_h264_err_t err = dec_parse_slice(dec, &r, header, &done);
+    if (err != ESP_H264_ERR_OK) {
+        dec->mbs_decoded = 0;
+        return err;
+    }
+    if (done) {
+        out_frame->outbuf = dec->ref.data;
+        out_frame->out_size = dec->ref.width * dec->ref.height * 3 / 2;
+    }
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_dec_close(esp_h264_dec_handle_t dec)
+{
+    if (!dec) {
+        return ESP_H264_ERR_ARG;
+    }
+    dec->open = false;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_dec_del(esp_h264_dec_handle_t dec)
+{
+    if (!dec) {
+        return ESP_H264_ERR_ARG;
+    }
+    free(dec->cur.data);
+    free(dec->ref.data);
+    free(dec->motion);
+    free(dec->rbsp);
+    free(dec);
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_dec_sw_get_param_hd(esp_h264_dec_handle_t dec, esp_h264_dec_param_sw_handle_t *out_param)
+{
+    if (!dec || !out_param) {
+        return ESP_H264_ERR_ARG;
+    }
+    *out_param = (esp_h264_dec_param_sw_handle_t)dec;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_dec_get_resolution(esp_h264_dec_param_handle_t param, esp_h264_resolution_t *res)
+{
+    esp_h264_dec_handle_t dec = (esp_h264_dec_handle_t)param;
+    if (!dec || !res || !dec->have_sps) {
+        return ESP_H264_ERR_ARG;
+    }
+    *res = dec->res;
+    return ESP_H264_ERR_OK;
+}
+
+// ---- Encoder ---------------------------------------------------------------
+
+struct esp_h264_enc_t {
+    esp_h264_enc_cfg_sw_t cfg;
+    bool open;
+    uint32_t mb_w;
+    uint32_t mb_h;
+    picture_t ref;                  // Previous input, identical to what the decoder holds
+    picture_t cur;
+    mb_motion_t *motion;
+    uint8_t *rbsp;
+    size_t rbsp_capacity;
+    uint32_t frame_index;           // Since the last IDR
+    uint32_t idr_pic_id;
+};
+
+static bool mb_matches(const picture_t *ref, const picture_t *cur, uint32_t mb_x, uint32_t mb_y, int dx, int dy)
+{
+    int w = (int)cur->width;
+    int h = (int)cur->height;
+    int x0 = (int)mb_x * MB_SIZE;
+    int y0 = (int)mb_y * MB_SIZE;
+    bool inside = x0 + dx >= 0 && x0 + dx + MB_SIZE <= w && y0 + dy >= 0 && y0 + dy + MB_SIZE <= h;
+
+    for (int c = 0; c < 3; c++) {
+        int shift = c ? 1 : 0;
+        int pw = w >> shift;
+        int ph = h >> shift;
+        int size = MB_SIZE >> shift;
+        const uint8_t *src = plane(ref, c);
+        const uint8_t *dst = plane(cur, c);
+        for (int y = 0; y < size; y++) {
+            int cy = (y0 >> shift) + y;
+            if (inside) {
+                if (memcmp(dst + (size_t)cy * pw + (x0 >> shift),
+                           src + (size_t)(cy + (dy >> shift)) * pw + (x0 >> shift) + (dx >> shift), size) != 0) {
+                    return false;
+                }
+                continue;
+            }
+            int sy = clampi(cy + (dy >> shift), 0, ph - 1);
+            for (int x = 0; x < size; x++) {
+                int sx = clampi((x0 >> shift) + x + (dx >> shift), 0, pw - 1);
+                if (dst[(size_t)cy * pw + (x0 >> shift) + x] != src[(size_t)sy * pw + sx]) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Whole-picture motion with the most macroblocks matching exactly, in even
+// pixels so chroma stays on whole samples; every 4th macroblock row is scored
+static void enc_global_motion(esp_h264_enc_handle_t enc, int *dx, int *dy)
+{
+    int best = -1;
+    *dx = 0;
+    *dy = 0;
+    for (int axis = 0; axis < 2; axis++) {
+        for (int d = -ENC_MV_RANGE; d <= ENC_MV_RANGE; d += 2) {
+            int cx = axis == 0 ? d : 0;
+            int cy = axis == 0 ? 0 : d;
+            if (axis == 1 && d == 0) {
+                continue;
+            }
+            int score = 0;
+            for (uint32_t y = 0; y < enc->mb_h; y += 4) {
+                for (uint32_t x = 0; x < enc->mb_w; x++) {
+                    score += mb_matches(&enc->ref, &enc->cur, x, y, cx, cy);
+                }
+            }
+            if (score > best) {
+                best = score;
+                *dx = cx;
+                *dy = cy;
+            }
+        }
+    }
+}
+
+static void enc_write_pcm(bit_writer_t *w, const picture_t *pic, uint32_t mb_x, uint32_t mb_y)
+{
+    put_align_zero(w);
+    for (int y = 0; y < MB_SIZE; y++) {
+        put_bytes(w, pic->data + ((size_t)mb_y * MB_SIZE + y) * pic->width + mb_x * MB_SIZE, MB_SIZE);
+    }
+    for (int c = 1; c <= 2; c++) {
+        const uint8_t *chroma = plane(pic, c);
+        for (int y = 0; y < MB_SIZE / 2; y++) {
+            put_bytes(w, chroma + ((size_t)mb_y * MB_SIZE / 2 + y) * (pic->width / 2) + mb_x * MB_SIZE / 2,
+                      MB_SIZE / 2);
+        }
+    }
+}
+
+static void enc_write_parameter_sets(esp_h264_enc_handle_t enc, bit_writer_t *w, bool sps)
+{
+    w->pos = 0;
+    w->bits = 0;
+    if (sps) {
+        put_bits(w, PROFILE_BASELINE, 8);
+        put_bits(w, 0xC0, 8);       // Constrained baseline
+        put_bits(w, 40, 8);         // Level 4.0
+        put_ue(w, 0);               // seq_parameter_set_id
+        put_ue(w, ENC_LOG2_MAX_FRAME_NUM - 4);
+        put_ue(w, 2);               // pic_order_cnt_type, output order is decode order
+        put_ue(w, 1);               // max_num_ref_frames
+        put_bit(w, 0);              // gaps_in_frame_num_value_allowed_flag
+        put_ue(w, enc->mb_w - 1);
+        put_ue(w, enc->mb_h - 1);
+        put_bit(w, 1);              // frame_mbs_only_flag
+        put_bit(w, 1);              // direct_8x8_inference_flag
+        put_bit(w, 0);              // frame_cropping_flag
+        put_bit(w, 0);              // vui_parameters_present_flag
+    } else {
+        put_ue(w, 0);               // pic_parameter_set_id
+        put_ue(w, 0);               // seq_parameter_set_id
+        put_bit(w, 0);              // entropy_coding_mode_flag, CAVLC
+        put_bit(w, 0);              // bottom_field_pic_order_in_frame_present_flag
+        put_ue(w, 0);               // num_slice_groups_minus1
+        put_ue(w, 0);               // num_ref_idx_l0_default_active_minus1
+        put_ue(w, 0);               // num_ref_idx_l1_default_active_minus1
+        put_bit(w, 0);              // weighted_pred_flag
+        put_bits(w, 0, 2);          // weighted_bipred_idc
+        put_se(w, 0);               // pic_init_qp_minus26
+        put_se(w, 0);               // pic_init_qs_minus26
+        put_se(w, 0);               // chroma_qp_index_offset
+        put_bit(w, 1);              // deblocking_filter_control_present_flag
+        put_bit(w, 0);              // constrained_intra_pred_flag
+        put_bit(w, 0);              // redundant_pic_cnt_present_flag
+    }
+    put_trailing_bits(w);
+}
+
+static void enc_write_slice(esp_h264_enc_handle_t enc, bit_writer_t *w, bool idr)
+{
+    w->pos = 0;
+    w->bits = 0;
+    put_ue(w, 0);                   // first_mb_in_slice
+    put_ue(w, (idr ? SLICE_I : SLICE_P) + 5);
+    put_ue(w, 0);                   // pic_parameter_set_id
+    put_bits(w, enc->frame_index % (1U << ENC_LOG2_MAX_FRAME_NUM), ENC_LOG2_MAX_FRAME_NUM);
+    if (idr) {
+        put_ue(w, enc->idr_pic_id);
+        put_bits(w, 0, 2);          // no_output_of_prior_pics_flag, long_term_reference_flag
+    } else {
+        put_bit(w, 0);              // num_ref_idx_active_override_flag
+        put_bit(w, 0);              // ref_pic_list_modification_flag_l0
+        put_bit(w, 0);              // adaptive_ref_pic_marking_mode_flag
+    }
+    put_se(w, 0);                   // slice_qp_delta
+    put_ue(w, 1);                   // disable_deblocking_filter_idc
+
+    uint32_t mb_count = enc->mb_w * enc->mb_h;
+    if (idr) {
+        for (uint32_t addr = 0; addr < mb_count; addr++) {
+            put_ue(w, MB_TYPE_I_PCM);
+            enc_write_pcm(w, &enc->cur, addr % enc->mb_w, addr / enc->mb_w);
+        }
+        put_trailing_bits(w);
+        return;
+    }
+
+    int dx, dy;
+    enc_global_motion(enc, &dx, &dy);
+    uint32_t skip_run = 0;
+    for (uint32_t addr = 0; addr < mb_count; addr++) {
+        uint32_t mb_x = addr % enc->mb_w;
+        uint32_t mb_y = addr / enc->mb_w;
+        mb_motion_t *m = &enc->motion[addr];
+        m->available = true;
+
+        if (!mb_matches(&enc->ref, &enc->cur, mb_x, mb_y, dx, dy)) {
+            put_ue(w, skip_run);
+            skip_run = 0;
+            put_ue(w, 5 + MB_TYPE_I_PCM);
+            enc_write_pcm(w, &enc->cur, mb_x, mb_y);
+            m->ref_idx = -1;
+            m->mv_x = 0;
+            m->mv_y = 0;
+            continue;
+        }
+
+        m->ref_idx = 0;
+        int skip_x, skip_y;
+        predict_mv(enc->motion, enc->mb_w, addr, 0, &skip_x, &skip_y, true);
+        if (skip_x == dx * 4 && skip_y == dy * 4) {
+            m->mv_x = skip_x;
+            m->mv_y = skip_y;
+            skip_run++;
+            continue;
+        }
+        int mvp_x, mvp_y;
+        predict_mv(enc->motion, enc->mb_w, addr, 0, &mvp_x, &mvp_y, false);
+        m->mv_x = dx * 4;
+        m->mv_y = dy * 4;
+        put_ue(w, skip_run);
+        skip_run = 0;
+        put_ue(w, MB_TYPE_P_L0_16X16);
+        put_se(w, m->mv_x - mvp_x);
+        put_se(w, m->mv_y - mvp_y);
+        put_ue(w, 0);               // coded_block_pattern 0, no residual
+    }
+    if (skip_run > 0) {
+        put_ue(w, skip_run);
+    }
+    put_trailing_bits(w);
+}
+
+esp_h264_err_t esp_h264_enc_sw_new(const esp_h264_enc_cfg_sw_t *cfg, esp_h264_enc_handle_t *out_enc)
+{
+    if (!cfg || !out_enc || cfg->gop == 0 || cfg->res.width == 0 || cfg->res.height == 0) {
+        return ESP_H264_ERR_ARG;
+    }
+    if (cfg->pic_type != ESP_H264_RAW_FMT_I420 || (cfg->res.width % MB_SIZE) || (cfg->res.height % MB_SIZE)) {
+        ESP_LOGE(TAG, "The stand-in encodes I420 in whole macroblocks only");
+        return ESP_H264_ERR_UNSUPPORTED;
+    }
+
+    esp_h264_enc_handle_t enc = calloc(1, sizeof(*enc));
+    if (!enc) {
+        return ESP_H264_ERR_MEM;
+    }
+    enc->cfg = *cfg;
+    enc->mb_w = cfg->res.width / MB_SIZE;
+    enc->mb_h = cfg->res.height / MB_SIZE;
+    size_t luma = (size_t)cfg->res.width * cfg->res.height;
+    enc->ref = (picture_t){ .data = malloc(luma * 3 / 2), .width = cfg->res.width, .height = cfg->res.height };
+    enc->cur = (picture_t){ .data = malloc(luma * 3 / 2), .width = cfg->res.width, .height = cfg->res.height };
+    enc->motion = calloc((size_t)enc->mb_w * enc->mb_h, sizeof(*enc->motion));
+    // Every macroblock as I_PCM, with its mb_type and alignment, plus the slice header
+    enc->rbsp_capacity = (size_t)enc->mb_w * enc->mb_h * (MB_PCM_BYTES + 8) + 64;
+    enc->rbsp = malloc(enc->rbsp_capacity);
+    if (!enc->ref.data || !enc->cur.data || !enc->motion || !enc->rbsp) {
+        esp_h264_enc_del(enc);
+        return ESP_H264_ERR_MEM;
+    }
+    *out_enc = enc;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_open(esp_h264_enc_handle_t enc)
+{
+    if (!enc) {
+        return ESP_H264_ERR_ARG;
+    }
+    enc->open = true;
+    enc->frame_index = 0;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_process(esp_h264_enc_handle_t enc, esp_h264_enc_in_frame_t *in_frame,
+                                    esp_h264_enc_out_frame_t *out_frame)
+{
+    if (!enc || !enc->open || !in_frame || !out_frame || !in_frame->raw_data.buffer || !out_frame->raw_data.buffer) {
+        return ESP_H264_ERR_ARG;
+    }
+    size_t frame_size = (size_t)enc->cur.width * enc->cur.height * 3 / 2;
+    if (in_frame->raw_data.len < frame_size) {
+        return ESP_H264_ERR_ARG;
+    }
+    memcpy(enc->cur.data, in_frame->raw_data.buffer, frame_size);
+
+    bool idr = enc->frame_index % enc->cfg.gop == 0;
+    if (idr) {
+        enc->frame_index = 0;
+    }
+    bit_writer_t w = { .buf = enc->rbsp, .capacity = enc->rbsp_capacity };
+    uint32_t length = 0;
+    bool ok = true;
+    if (idr) {
+        enc_write_parameter_sets(enc, &w, true);
+        ok = ok && !w.overflow && write_nal(&out_frame->raw_data, &length, 0x60 | NAL_SPS, &w);
+        enc_write_parameter_sets(enc, &w, false);
+        ok = ok && !w.overflow && write_nal(&out_frame->raw_data, &length, 0x60 | NAL_PPS, &w);
+    }
+    enc_write_slice(enc, &w, idr);
+    ok = ok && !w.overflow && write_nal(&out_frame->raw_data, &length, 0x60 | (idr ? NAL_IDR : NAL_SLICE), &w);
+    if (!ok) {
+        return ESP_H264_ERR_OVERFLOW;
+    }
+
+    out_frame->length = length;
+    out_frame->frame_type = idr ? ESP_H264_FRAME_TYPE_IDR : ESP_H264_FRAME_TYPE_P;
+    out_frame->pts = in_frame->pts;
+    out_frame->dts = in_frame->pts;
+
+    picture_t coded = enc->cur;
+    enc->cur = enc->ref;
+    enc->ref = coded;
+    if (idr) {
+        enc->idr_pic_id = (enc->idr_pic_id + 1) % 16;
+    }
+    enc->frame_index++;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_close(esp_h264_enc_handle_t enc)
+{
+    if (!enc) {
+        return ESP_H264_ERR_ARG;
+    }
+    enc->open = false;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_del(esp_h264_enc_handle_t enc)
+{
+    if (!enc) {
+        return ESP_H264_ERR_ARG;
+    }
+    free(enc->ref.data);
+    free(enc->cur.data);
+    free(enc->motion);
+    free(enc->rbsp);
+    free(enc);
+    return ESP_H264_ERR_OK;
+}
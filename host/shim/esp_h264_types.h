@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the esp_h264 component types, see esp_h264_shim.c
+
+#pragma once
+
+#include <stdint.h>
+
+typedef enum {
+    ESP_H264_ERR_OK = 0,
+    ESP_H264_ERR_FAIL = -1,
+    ESP_H264_ERR_ARG = -2,
+    ESP_H264_ERR_MEM = -3,
+    ESP_H264_ERR_UNSUPPORTED = -4,
+    ESP_H264_ERR_TIMEOUT = -5,
+    ESP_H264_ERR_OVERFLOW = -6,
+} esp_h264_err_t;
+
+typedef enum {
+    ESP_H264_RAW_FMT_YUYV,
+    ESP_H264_RAW_FMT_I420,
+    ESP_H264_RAW_FMT_O_UYY_E_VYY,
+} esp_h264_raw_format_t;
+
+typedef enum {
+    ESP_H264_FRAME_TYPE_INVALID = -1,
+    ESP_H264_FRAME_TYPE_IDR = 0,
+    ESP_H264_FRAME_TYPE_I = 1,
+    ESP_H264_FRAME_TYPE_P = 2,
+} esp_h264_frame_type_t;
+
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+} esp_h264_resolution_t;
+
+typedef struct {
+    uint8_t *buffer;
+    uint32_t len;
+} esp_h264_pkt_t;
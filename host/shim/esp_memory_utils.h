@@ -0,0 +1,22 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for esp_memory_utils.h. No host memory needs a cache sync.
+
+#pragma once
+
+#include <stdbool.h>
+
+static inline bool esp_ptr_in_dram(const void *p)
+{
+    (void)p;
+    return false;
+}
+
+static inline bool esp_ptr_external_ram(const void *p)
+{
+    (void)p;
+    return false;
+}
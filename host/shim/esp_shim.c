@@ -0,0 +1,82 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <time.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <string.h>
+
+#define HOST_LOG_MAX_TAGS       16
+
+typedef struct {
+    const char *tag;
+    esp_log_level_t level;
+} host_log_tag_t;
+
+static esp_log_level_t s_log_level = ESP_LOG_INFO;
+static host_log_tag_t s_log_tags[HOST_LOG_MAX_TAGS];
+static int s_log_tag_count = 0;
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                    return "ESP_OK";
+        case ESP_FAIL:                  return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:       return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:     return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:      return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:         return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:     return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:           return "ESP_ERR_TIMEOUT";
+        default:                        return "UNKNOWN ERROR";
+    }
+}
+
+// Tags are compared by content, callers pass string literals
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    if (strcmp(tag, "*") == 0) {
+        s_log_level = level;
+        s_log_tag_count = 0;
+        return;
+    }
+
+    for (int i = 0; i < s_log_tag_count; i++) {
+        if (strcmp(s_log_tags[i].tag, tag) == 0) {
+            s_log_tags[i].level = level;
+            return;
+        }
+    }
+    if (s_log_tag_count < HOST_LOG_MAX_TAGS) {
+        s_log_tags[s_log_tag_count].tag = tag;
+        s_log_tags[s_log_tag_count].level = level;
+        s_log_tag_count++;
+    }
+}
+
+esp_log_level_t esp_log_level_get(const char *tag)
+{
+    for (int i = 0; i < s_log_tag_count; i++) {
+        if (strcmp(s_log_tags[i].tag, tag) == 0) {
+            return s_log_tags[i].level;
+        }
+    }
+    return s_log_level;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
@@ -0,0 +1,14 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for esp_timer.h, only the monotonic clock is provided
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct esp_timer *esp_timer_handle_t;
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "image_buffer.h"
+#include "esp_log.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_cache.h"
+#include "esp_memory_utils.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "img_buf";
+
+#define IMAGE_BUFFER_DEFAULT_ALIGNMENT  128     // ESP32-P4 L2 cache line, used if the query fails
+
+static size_t s_alignment = 0;
+static image_buffer_stats_t s_stats;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+size_t image_buffer_get_alignment(void)
+{
+    if (s_alignment == 0) {
+        size_t psram_align = 0;
+        size_t internal_align = 0;
+
+        if (esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &psram_align) != ESP_OK) {
+            psram_align = 0;
+        }
+        if (esp_cache_get_alignment(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL, &internal_align) != ESP_OK) {
+            internal_align = 0;
+        }
+
+        size_t alignment = (psram_align > internal_align) ? psram_align : internal_align;
+        if (alignment == 0) {
+            alignment = IMAGE_BUFFER_DEFAULT_ALIGNMENT;
+        }
+        s_alignment = alignment;
+        ESP_LOGI(TAG, "Buffer alignment: %zu bytes (PSRAM %zu, internal %zu)",
+                 alignment, psram_align, internal_align);
+    }
+    return s_alignment;
+}
+
+size_t image_buffer_align_size(size_t size)
+{
+    size_t align = image_buffer_get_alignment();
+    return (size + align - 1) & ~(align - 1);
+}
+
+void *image_buffer_alloc(size_t size, size_t *allocated_size)
+{
+    if (size == 0) {
+        return NULL;
+    }
+
+    size_t align = image_buffer_get_alignment();
+    size_t aligned_size = image_buffer_align_size(size);
+
+    void *buffer = heap_caps_aligned_alloc(align, aligned_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buffer) {
+        buffer = heap_caps_aligned_alloc(align, aligned_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    }
+
+    if (!buffer) {
+        ESP_LOGE(TAG, "Failed to allocate %zu aligned bytes", aligned_size);
+        return NULL;
+    }
+
+    if (allocated_size) {
+        *allocated_size = aligned_size;
+    }
+
+    size_t block_size = heap_caps_get_allocated_size(buffer);
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.allocations++;
+    s_stats.bytes_in_use += block_size;
+    if (s_stats.bytes_in_use > s_stats.peak_bytes) {
+        s_stats.peak_bytes = s_stats.bytes_in_use;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+    return buffer;
+}
+
+void image_buffer_free(void *buffer)
+{
+    if (!buffer) {
+        return;
+    }
+
+    size_t block_size = heap_caps_get_allocated_size(buffer);
+    heap_caps_free(buffer);
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.frees++;
+    s_stats.bytes_in_use -= (block_size < s_stats.bytes_in_use) ? block_size : s_stats.bytes_in_use;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+bool image_buffer_is_aligned(const void *buffer, size_t size)
+{
+    size_t align = image_buffer_get_alignment();
+    return ((uintptr_t)buffer % align) == 0 && (size % align) == 0;
+}
+
+int image_buffer_cache_sync(void *buffer, size_t size, int flags)
+{
+    if (!buffer || size == 0) {
+        return ESP_OK;
+    }
+
+    // Only cacheable memory needs sync
+    if (!esp_ptr_in_dram(buffer) && !esp_ptr_external_ram(buffer)) {
+        return ESP_OK;
+    }
+
+    if (image_buffer_is_aligned(buffer, size)) {
+        return esp_cache_msync(buffer, size, flags);
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.unaligned_syncs++;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    if (flags & ESP_CACHE_MSYNC_FLAG_DIR_C2M) {
+        // Writeback of a partial line is safe
+        return esp_cache_msync(buffer, size, flags | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
+    }
+
+    // Invalidating a partial line could drop neighbouring data, refuse instead
+    ESP_LOGW(TAG, "Unaligned M2C sync refused: %p + %zu", buffer, size);
+    return ESP_ERR_INVALID_ARG;
+}
+
+bool image_buffer_check_dma_input(const void *buffer, size_t size)
+{
+    size_t align = image_buffer_get_alignment();
+    if (buffer && ((uintptr_t)buffer % align) == 0) {
+        return true;
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.unaligned_inputs++;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    ESP_LOGE(TAG, "Unaligned DMA input %p (%zu bytes), allocate it with image_buffer_alloc", buffer, size);
+    return false;
+}
+
+void image_buffer_get_stats(image_buffer_stats_t *stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void image_buffer_reset_peak(void)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.peak_bytes = s_stats.bytes_in_use;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
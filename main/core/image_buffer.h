@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Aligned buffer statistics
+typedef struct {
+    uint32_t allocations;
+    uint32_t frees;
+    uint32_t unaligned_inputs;      // Unaligned buffers handed to a DMA stage (expected 0)
+    uint32_t unaligned_syncs;       // Cache syncs requested on unaligned regions (expected 0)
+    size_t bytes_in_use;
+    size_t peak_bytes;              // Highest bytes_in_use since start or image_buffer_reset_peak()
+} image_buffer_stats_t;
+
+// Shared allocator for every buffer touched by DMA in the image pipeline
+// (file data, JPEG/PNG output, PPA output). Start address and size are
+// rounded to the largest data cache line of PSRAM and internal RAM, so
+// cache sync never needs the UNALIGNED flag and no stage has to realign.
+
+// Cache line alignment used for all buffers (queried via esp_cache_get_alignment)
+size_t image_buffer_get_alignment(void);
+
+// Round size up to the buffer alignment
+size_t image_buffer_align_size(size_t size);
+
+// Allocate an aligned buffer, PSRAM first. allocated_size may be NULL.
+void *image_buffer_alloc(size_t size, size_t *allocated_size);
+void image_buffer_free(void *buffer);
+
+// True if both address and size are multiples of the buffer alignment
+bool image_buffer_is_aligned(const void *buffer, size_t size);
+
+// Cache sync that requires an aligned region; unaligned requests are counted and skipped for M2C
+int image_buffer_cache_sync(void *buffer, size_t size, int flags);
+
+// Check a buffer about to be handed to DMA; unaligned buffers are counted and rejected
+bool image_buffer_check_dma_input(const void *buffer, size_t size);
+
+void image_buffer_get_stats(image_buffer_stats_t *stats);
+
+// Restart peak tracking from the current usage
+void image_buffer_reset_peak(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,6 +8,7 @@
 #include "file_manager.h"
 #include "image_decoder.h"
 #include "image_processor.h"
+#include "image_buffer.h"
 #include "ui_manager.h"
 #include "slideshow_ctrl.h"
 #include "video_player.h"
@@ -24,6 +25,27 @@ static photo_album_t s_album;
 static decoded_image_t s_current_image = {0};
 static decoded_image_t s_processed_image = {0};
 
+// Next slide decoded by the preload task while the PPA scales the current one.
+// s_prefetch_mutex guards the image and index and is held for a whole decode.
+static decoded_image_t s_prefetch_image = {0};
+static int s_prefetch_index = INVALID_INDEX;
+static SemaphoreHandle_t s_prefetch_mutex;
+static TaskHandle_t s_preload_task;
+static volatile int s_preload_request = INVALID_INDEX;
+static volatile int64_t s_preload_start_us;
+static volatile int64_t s_preload_end_us;
+
+// PPA / JPEG overlap accounting for the slide pipeline
+static struct {
+    uint32_t slides;
+    int64_t ppa_busy_us;        // Time the PPA spent on slide scaling
+    int64_t overlap_us;         // Part of it during which the next JPEG decode ran
+} s_pipeline_stats;
+static volatile int64_t s_ppa_done_us;
+
+// Moves on from a video that reached its end, off the adapter's pipeline tasks
+static TaskHandle_t s_album_worker;
+
 // Pause reason tracking
 static enum {
     PAUSE_REASON_NONE,
@@ -37,6 +59,13 @@ static void slideshow_next_callback(void);
 static esp_err_t load_and_display_media(int index);
 static esp_err_t load_and_display_image(int index);
 
+static bool ppa_done_callback(image_processor_job_handle_t job, void *user_data)
+{
+    // Runs in PPA ISR context
+    s_ppa_done_us = esp_timer_get_time();
+    return false;
+}
+
 // MEMORY POOL IMPLEMENTATION
 
 static esp_err_t memory_pool_init(memory_pool_t *pool)
@@ -151,18 +180,12 @@ static bool image_needs_processing(uint32_t width, uint32_t height)
     return (width > SCREEN_WIDTH || height > SCREEN_HEIGHT);
 }
 
-static esp_err_t process_image_for_display(const decoded_image_t *input, decoded_image_t *output)
+static esp_err_t submit_image_for_display(const decoded_image_t *input, decoded_image_t *output,
+                                          image_processor_job_handle_t *ret_job)
 {
     process_params_t params;
-    scale_mode_t mode;
-    
-    if (input->width >= input->height) {
-        mode = (input->width <= SCREEN_WIDTH && input->height <= SCREEN_HEIGHT) ? 
-               SCALE_MODE_CENTER : SCALE_MODE_CROP_ONLY;
-    } else {
-        mode = (input->width <= SCREEN_WIDTH && input->height <= SCREEN_HEIGHT) ? 
-               SCALE_MODE_CENTER : SCALE_MODE_FIT;
-    }
+    scale_mode_t mode = image_processor_select_display_mode(input->width, input->height,
+                                                            SCREEN_WIDTH, SCREEN_HEIGHT);
     
     esp_err_t ret = image_processor_calculate_params(input->width, input->height,
                                                     SCREEN_WIDTH, SCREEN_HEIGHT,
@@ -172,7 +195,162 @@ static esp_err_t process_image_for_display(const decoded_image_t *input, decoded
         return ret;
     }
     
-    return image_processor_process(input, output, &params);
+    return image_processor_submit(input, output, &params, ppa_done_callback, NULL, ret_job);
+}
+
+// PREFETCH FUNCTIONS
+
+// Caller holds s_prefetch_mutex
+static void prefetch_discard(void)
+{
+    if (s_prefetch_image.rgb_data) {
+        image_decoder_free_image(&s_prefetch_image);
+    }
+    memset(&s_prefetch_image, 0, sizeof(s_prefetch_image));
+    s_prefetch_index = INVALID_INDEX;
+}
+
+// Load and decode the slide after index; runs on the preload task with s_prefetch_mutex held
+static void prefetch_next_image(int index)
+{
+    if (!s_album.collection || index < 0 || index >= s_album.collection->total_count) {
+        return;
+    }
+
+    int next_index = (index + 1) % s_album.collection->total_count;
+    if (next_index == index || next_index == s_prefetch_index) {
+        return;
+    }
+
+    const image_file_info_t *file_info = &s_album.collection->files[next_index];
+    if (file_manager_get_media_type(file_info->full_path) != MEDIA_TYPE_IMAGE ||
+        !validate_file_for_decoding(file_info)) {
+        return;
+    }
+
+    prefetch_discard();
+
+    uint8_t *file_data = NULL;
+    size_t file_size = 0;
+    if (file_manager_load_image(file_info->full_path, &file_data, &file_size) != ESP_OK) {
+        return;
+    }
+
+    s_preload_start_us = esp_timer_get_time();
+    esp_err_t ret = image_decoder_decode_background(file_data, file_size, file_info->format, &s_prefetch_image);
+    s_preload_end_us = esp_timer_get_time();
+    image_buffer_free(file_data);
+
+    if (ret == ESP_OK) {
+        s_prefetch_index = next_index;
+        ESP_LOGD(TAG, "Prefetched %s", file_info->filename);
+    } else {
+        prefetch_discard();
+    }
+}
+
+// Decodes the slide after the one being shown so the JPEG engine works while the PPA is busy
+static void preload_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xSemaphoreTake(s_prefetch_mutex, portMAX_DELAY);
+        int index = s_preload_request;
+        s_preload_request = INVALID_INDEX;
+        if (index != INVALID_INDEX) {
+            prefetch_next_image(index);
+        }
+        xSemaphoreGive(s_prefetch_mutex);
+    }
+}
+
+// Ask the preload task to decode the slide after index, without waiting for it
+static void prefetch_request(int index)
+{
+    if (!s_preload_task) {
+        return;
+    }
+    s_preload_start_us = 0;
+    s_preload_end_us = 0;
+    s_preload_request = index;
+    xTaskNotifyGive(s_preload_task);
+}
+
+static bool media_is_video(int index)
+{
+    return file_manager_get_media_type(s_album.collection->files[index].full_path) == MEDIA_TYPE_VIDEO;
+}
+
+// Stop the playing video before switching to index, unless index is a video
+// too: then the prepared slot takes over in place without a blank gap
+static void stop_video_before(int index)
+{
+    video_state_t video_state = video_player_get_state();
+    if ((video_state == VIDEO_STATE_PLAYING || video_state == VIDEO_STATE_PAUSED) && !media_is_video(index)) {
+        ui_manager_show_loading();
+        ui_manager_switch_mode(UI_MODE_IMAGE);
+        video_player_stop();
+    }
+}
+
+// A lone clip, or every clip with VIDEO_LOOP, wraps around in place at its end
+// instead of being reopened as the next item
+static bool video_loops(void)
+{
+#if CONFIG_VIDEO_LOOP
+    return true;
+#else
+    return s_album.collection->total_count == 1;
+#endif
+}
+
+// Open the video after index in the background so switching to it does not stall
+static void prepare_next_video(int index)
+{
+    int next_index = (index + 1) % s_album.collection->total_count;
+    if (next_index != index && media_is_video(next_index)) {
+        video_player_prepare_next(s_album.collection->files[next_index].full_path);
+    }
+}
+
+// Queue every video of the collection to have its container parsed ahead when
+// its moov sits at the end; clips already parsed cost a header check
+static void parse_videos_ahead(void)
+{
+    for (int i = 0; i < s_album.collection->total_count; i++) {
+        if (media_is_video(i) &&
+                video_player_parse_ahead(s_album.collection->files[i].full_path) == ESP_ERR_NOT_SUPPORTED) {
+            return;
+        }
+    }
+}
+
+static void record_pipeline_overlap(int64_t ppa_submit_us, int64_t decode_start_us, int64_t decode_end_us)
+{
+    int64_t ppa_done_us = s_ppa_done_us;
+    int64_t busy_us = ppa_done_us - ppa_submit_us;
+    if (busy_us <= 0) {
+        return;
+    }
+
+    int64_t overlap_start = (decode_start_us > ppa_submit_us) ? decode_start_us : ppa_submit_us;
+    int64_t overlap_end = (decode_end_us < ppa_done_us) ? decode_end_us : ppa_done_us;
+    int64_t overlap_us = (overlap_end > overlap_start) ? overlap_end - overlap_start : 0;
+
+    s_pipeline_stats.slides++;
+    s_pipeline_stats.ppa_busy_us += busy_us;
+    s_pipeline_stats.overlap_us += overlap_us;
+
+    ESP_LOGI(TAG, "Pipeline: PPA %lld us, overlapped with decode %lld us (%.0f%%, avg %.0f%% over %"PRIu32" slides)",
+             busy_us, overlap_us, overlap_us * PERCENTAGE_MULTIPLIER / busy_us,
+             s_pipeline_stats.overlap_us * PERCENTAGE_MULTIPLIER / s_pipeline_stats.ppa_busy_us,
+             s_pipeline_stats.slides);
+
+    image_buffer_stats_t buf_stats;
+    image_buffer_get_stats(&buf_stats);
+    ESP_LOGI(TAG, "Buffers: %"PRIu32" allocated, %"PRIu32" unaligned DMA inputs, %"PRIu32" unaligned syncs",
+             buf_stats.allocations, buf_stats.unaligned_inputs, buf_stats.unaligned_syncs);
 }
 
 // MAIN IMAGE LOADING FUNCTION
@@ -210,24 +388,39 @@ static esp_err_t load_and_display_image(int index)
     uint8_t *file_data = NULL;
     size_t file_size = 0;
 
-    // Load file data
-    ret = file_manager_load_image(file_info->full_path, &file_data, &file_size);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to load file: %s", esp_err_to_name(ret));
-        goto cleanup;
+    // Waits only while the preload task is still decoding, most likely this very slide
+    xSemaphoreTake(s_prefetch_mutex, portMAX_DELAY);
+    bool prefetched = (s_prefetch_index == index && s_prefetch_image.is_valid);
+    if (prefetched) {
+        // Already decoded while the previous slide was being scaled
+        s_current_image = s_prefetch_image;
+        memset(&s_prefetch_image, 0, sizeof(s_prefetch_image));
+        s_prefetch_index = INVALID_INDEX;
+    } else {
+        prefetch_discard();
     }
-    
-    // Feed watchdog after file loading
-    vTaskDelay(pdMS_TO_TICKS(10));
+    xSemaphoreGive(s_prefetch_mutex);
 
-    // Decode image directly (no caching)
-    ret = image_decoder_decode(file_data, file_size, file_info->format, &s_current_image);
-    free(file_data);
-    file_data = NULL;
-    
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to decode image %s: %s", file_info->filename, esp_err_to_name(ret));
-        goto cleanup;
+    if (!prefetched) {
+
+        // Load file data
+        ret = file_manager_load_image(file_info->full_path, &file_data, &file_size);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to load file: %s", esp_err_to_name(ret));
+            goto cleanup;
+        }
+        
+        // Feed watchdog after file loading
+        vTaskDelay(pdMS_TO_TICKS(10));
+
+        ret = image_decoder_decode(file_data, file_size, file_info->format, &s_current_image);
+        image_buffer_free(file_data);
+        file_data = NULL;
+        
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to decode image %s: %s", file_info->filename, esp_err_to_name(ret));
+            goto cleanup;
+        }
     }
 
     ESP_LOGD(TAG, "Image decoded: %dx%d, size: %zu B", s_current_image.width, s_current_image.height, s_current_image.data_size);
@@ -238,13 +431,34 @@ static esp_err_t load_and_display_image(int index)
         // Feed watchdog before heavy processing
         vTaskDelay(pdMS_TO_TICKS(10));
         
-        ret = process_image_for_display(&s_current_image, &s_processed_image);
+        image_processor_job_handle_t job = NULL;
+        int64_t ppa_submit_us = esp_timer_get_time();
+        ret = submit_image_for_display(&s_current_image, &s_processed_image, &job);
+        if (ret == ESP_OK) {
+            // The preload task decodes the next slide on the JPEG engine while the PPA scales this one
+            prefetch_request(index);
+
+            ret = image_processor_wait(job, IMAGE_PROCESSOR_TIMEOUT_MS);
+            if (ret == ESP_OK) {
+                // A decode still running counts as overlapping until the PPA finished
+                int64_t decode_start_us = s_preload_start_us;
+                int64_t decode_end_us = s_preload_end_us;
+                if (decode_start_us > 0) {
+                    record_pipeline_overlap(ppa_submit_us, decode_start_us,
+                                            decode_end_us >= decode_start_us ? decode_end_us : esp_timer_get_time());
+                }
+                // Only the scaled copy is shown, keep a single full-size decode in memory
+                image_decoder_free_image(&s_current_image);
+            } else if (ret == ESP_ERR_TIMEOUT) {
+                // The PPA may still be reading the decoded slide, hand it to the job
+                image_processor_cancel(job, &s_current_image);
+            }
+        }
         if (ret == ESP_OK) {
             display_image = &s_processed_image;
             // Feed watchdog after processing
             vTaskDelay(pdMS_TO_TICKS(10));
-            ESP_LOGD(TAG, "Image processed: %dx%d -> %dx%d", 
-                     s_current_image.width, s_current_image.height,
+            ESP_LOGD(TAG, "Image processed: -> %dx%d",
                      s_processed_image.width, s_processed_image.height);
         } else {
             ESP_LOGE(TAG, "Failed to process image: %s", esp_err_to_name(ret));
@@ -258,6 +472,10 @@ static esp_err_t load_and_display_image(int index)
         ESP_LOGE(TAG, "Failed to display image: %s", esp_err_to_name(ret));
         goto cleanup;
     }
+    if (display_image == &s_current_image) {
+        // Nothing to overlap with, decode the next slide while this one is shown
+        prefetch_request(index);
+    }
 
     // Ensure slideshow timer is running (may have been stopped for video)
     if (!slideshow_ctrl_is_running() && s_pause_reason == PAUSE_REASON_NONE) {
@@ -273,7 +491,7 @@ static esp_err_t load_and_display_image(int index)
 
 cleanup:
     if (file_data) {
-        free(file_data);
+        image_buffer_free(file_data);
     }
     
     ui_manager_hide_loading();
@@ -341,11 +559,19 @@ static void ui_event_handler(ui_event_t event, void *user_data)
                 if (state == VIDEO_STATE_PLAYING) {
                     video_player_pause();
                     slideshow_ctrl_pause();
+                    ui_manager_set_video_scrub(true);
                 } else if (state == VIDEO_STATE_PAUSED) {
+                    ui_manager_set_video_scrub(false);
                     video_player_resume();
                 }
             }
             break;
+
+        case UI_EVENT_SCRUB:
+            if (current_media_type == MEDIA_TYPE_VIDEO) {
+                video_player_scrub(ui_manager_get_scrub_position());
+            }
+            break;
             
         case UI_EVENT_SETTINGS_CLOSE:
             if (ui_manager_get_selected_interval() != s_album.slideshow.interval_ms) {
@@ -375,6 +601,20 @@ static void slideshow_next_callback(void)
     photo_album_next();
 }
 
+static void album_worker_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // A pause, stop or manual switch since the end of stream leaves the album where it is
+        if (video_player_get_state() != VIDEO_STATE_PLAYING || !video_player_is_finished()) {
+            continue;
+        }
+        slideshow_ctrl_start();
+        photo_album_next();
+    }
+}
+
 static esp_err_t load_and_display_media(int index)
 {
     if (!s_album.collection || index < 0 || index >= s_album.collection->total_count) {
@@ -386,6 +626,9 @@ static esp_err_t load_and_display_media(int index)
     int retry_count = 0;
     int current_index = index;
     
+    // A paused video being left can no longer be scrubbed
+    ui_manager_set_video_scrub(false);
+
     // Check current state to optimize transitions
     video_state_t video_state = video_player_get_state();
     bool is_currently_playing_video = (video_state == VIDEO_STATE_PLAYING || video_state == VIDEO_STATE_PAUSED);
@@ -400,9 +643,12 @@ static esp_err_t load_and_display_media(int index)
             // Feed watchdog before video operations
             vTaskDelay(pdMS_TO_TICKS(10));
             esp_err_t ret;
+            video_player_set_loop(video_loops());
             
             if (is_currently_playing_video) {
-                // Video → Video: Use soft switch (no UI mode change, no loading screen)
+                // Video → Video: Use soft switch (no UI mode change, no loading screen).
+                // The album worker restarts the slideshow when the clip ends.
+                slideshow_ctrl_stop();
                 ret = video_player_switch_file(s_album.collection->files[current_index].full_path);
                 ESP_LOGI(TAG, "Soft video switch to: %s", s_album.collection->files[current_index].filename);
             } else {
@@ -420,6 +666,7 @@ static esp_err_t load_and_display_media(int index)
             if (ret == ESP_OK) {
                 s_album.collection->current_index = current_index;
                 ui_manager_update_progress(current_index, s_album.collection->total_count);
+                prepare_next_video(current_index);
                 ESP_LOGD(TAG, "Video started: %s (%d/%d)", 
                          s_album.collection->files[current_index].filename, 
                          current_index + 1, s_album.collection->total_count);
@@ -531,6 +778,20 @@ esp_err_t photo_album_init(void)
     if (ret != ESP_OK) {
         goto cleanup;
     }
+
+    if (xTaskCreate(album_worker_task, "album_worker", ALBUM_WORKER_TASK_STACK_SIZE, NULL,
+                    ALBUM_WORKER_TASK_PRIORITY, &s_album_worker) != pdPASS) {
+        ret = ESP_ERR_NO_MEM;
+        goto cleanup;
+    }
+
+    s_prefetch_mutex = xSemaphoreCreateMutex();
+    if (!s_prefetch_mutex ||
+            xTaskCreate(preload_task, "preload", PRELOAD_TASK_STACK_SIZE, NULL,
+                        PRELOAD_TASK_PRIORITY, &s_preload_task) != pdPASS) {
+        ret = ESP_ERR_NO_MEM;
+        goto cleanup;
+    }
     
     // Initialize audio codec for MP4 playback
     ESP_LOGI(TAG, "Initializing audio codec...");
@@ -568,6 +829,18 @@ esp_err_t photo_album_init(void)
     return ESP_OK;
 
 cleanup:
+    if (s_album_worker) {
+        vTaskDelete(s_album_worker);
+        s_album_worker = NULL;
+    }
+    if (s_preload_task) {
+        vTaskDelete(s_preload_task);
+        s_preload_task = NULL;
+    }
+    if (s_prefetch_mutex) {
+        vSemaphoreDelete(s_prefetch_mutex);
+        s_prefetch_mutex = NULL;
+    }
     if (s_album.collection) {
         if (s_album.collection->files) {
         free(s_album.collection->files);
@@ -600,6 +873,7 @@ esp_err_t photo_album_start(void)
     vTaskDelay(pdMS_TO_TICKS(10));
     
     ESP_LOGI(TAG, "Found %d media files", s_album.collection->total_count);
+    parse_videos_ahead();
     esp_err_t ret2 = load_and_display_media(0);
     if (ret2 == ESP_OK) {
         slideshow_ctrl_start();
@@ -614,6 +888,15 @@ esp_err_t photo_album_deinit(void)
     }
 
     slideshow_ctrl_stop();
+    if (s_album_worker) {
+        vTaskDelete(s_album_worker);
+        s_album_worker = NULL;
+    }
+
+    // Stop the preload task between decodes
+    xSemaphoreTake(s_prefetch_mutex, portMAX_DELAY);
+    vTaskDelete(s_preload_task);
+    s_preload_task = NULL;
     
     xSemaphoreTake(s_album.mutex, portMAX_DELAY);
     
@@ -624,6 +907,9 @@ esp_err_t photo_album_deinit(void)
     if (s_processed_image.rgb_data) {
         image_decoder_free_image(&s_processed_image);
     }
+    prefetch_discard();
+    vSemaphoreDelete(s_prefetch_mutex);
+    s_prefetch_mutex = NULL;
     
     // Clean up collection memory
     if (s_album.collection) {
@@ -667,8 +953,15 @@ esp_err_t photo_album_refresh(void)
                  s_album.collection->files[old_index].filename);
     }
     
+    // Indexes change on rescan, drop the decoded-ahead slide and keep the
+    // preload task off the collection until it is rebuilt
+    xSemaphoreTake(s_prefetch_mutex, portMAX_DELAY);
+    prefetch_discard();
+    s_preload_request = INVALID_INDEX;
+
     // Rescan directory into existing collection structure
     esp_err_t ret = file_manager_scan_images(PHOTO_BASE_PATH, s_album.collection);
+    xSemaphoreGive(s_prefetch_mutex);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to rescan directory after refresh: %s", esp_err_to_name(ret));
         xSemaphoreGive(s_album.mutex);
@@ -694,6 +987,7 @@ esp_err_t photo_album_refresh(void)
     }
     
     ESP_LOGI(TAG, "Photo album refreshed: %d files found", s_album.collection->total_count);
+    parse_videos_ahead();
     ESP_LOGI(TAG, "Current index updated from %d to %d", old_index, s_album.collection->current_index);
     
     xSemaphoreGive(s_album.mutex);
@@ -712,36 +1006,33 @@ esp_err_t photo_album_next(void)
         return ESP_ERR_INVALID_STATE;
     }
     
-    // Check if we need to stop video before switching
-    video_state_t video_state = video_player_get_state();
-    if (video_state == VIDEO_STATE_PLAYING || video_state == VIDEO_STATE_PAUSED) {
-        ui_manager_show_loading();
-        ui_manager_switch_mode(UI_MODE_IMAGE);
-        video_player_stop();
-    }
-    
     int next_index = (s_album.collection->current_index + 1) % s_album.collection->total_count;
+    stop_video_before(next_index);
+    
     return load_and_display_media(next_index);
 }
 
-esp_err_t photo_album_prev(void)
+esp_err_t photo_album_video_ended(void)
 {
-    if (!s_album.initialized || !s_album.collection || s_album.collection->total_count == 0) {
+    if (!s_album_worker) {
         return ESP_ERR_INVALID_STATE;
     }
+    // Repeated notifications before the worker runs collapse into one
+    xTaskNotifyGive(s_album_worker);
+    return ESP_OK;
+}
 
-    // Check if we need to stop video before switching
-    video_state_t video_state = video_player_get_state();
-    if (video_state == VIDEO_STATE_PLAYING || video_state == VIDEO_STATE_PAUSED) {
-        ui_manager_show_loading();
-        ui_manager_switch_mode(UI_MODE_IMAGE);
-        video_player_stop();
+esp_err_t photo_album_prev(void)
+{
+    if (!s_album.initialized || !s_album.collection || s_album.collection->total_count == 0) {
+        return ESP_ERR_INVALID_STATE;
     }
 
     // Add retry protection for previous navigation as well
     int max_retries = s_album.collection->total_count;
     int retry_count = 0;
     int prev_index = (s_album.collection->current_index - 1 + s_album.collection->total_count) % s_album.collection->total_count;
+    stop_video_before(prev_index);
     
     while (retry_count < max_retries) {
         esp_err_t ret = load_and_display_media(prev_index);
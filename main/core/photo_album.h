@@ -10,7 +10,7 @@
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
-#include "bsp/esp-bsp.h"
+#include "hal_display.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,8 +20,8 @@ extern "C" {
 #define PHOTO_BASE_PATH         "/sdcard/photos"
 #define MAX_FILENAME_LEN        256
 #define MAX_FILES_COUNT         1000
-#define SCREEN_WIDTH            BSP_LCD_H_RES
-#define SCREEN_HEIGHT           BSP_LCD_V_RES
+#define SCREEN_WIDTH            HAL_DISPLAY_H_RES
+#define SCREEN_HEIGHT           HAL_DISPLAY_V_RES
 #define DEFAULT_SLIDESHOW_MS    5000
 #define IDLE_TIMEOUT_MS         10000
 
@@ -114,6 +114,7 @@ esp_err_t photo_album_start(void);
 esp_err_t photo_album_deinit(void);
 esp_err_t photo_album_refresh(void);
 esp_err_t photo_album_next(void);
+esp_err_t photo_album_video_ended(void);  // Any task: move on from the video that reached its end
 esp_err_t photo_album_prev(void);
 esp_err_t photo_album_goto(int index);
 esp_err_t photo_album_set_interval(uint32_t interval_ms);
@@ -74,6 +74,8 @@ extern "C" {
 #define PRELOAD_TASK_STACK_SIZE             8192    // Preload task stack size (increased for large image decoding)
 #define PRELOAD_TASK_PRIORITY               5       // Preload task priority
 #define PRELOAD_TASK_DELAY_MS               10      // Preload task delay
+#define ALBUM_WORKER_TASK_STACK_SIZE        8192    // Album worker stack, loads the next media after a video ends
+#define ALBUM_WORKER_TASK_PRIORITY          5       // Album worker priority
 
 // Collection management  
 #define INVALID_INDEX                       -1      // Invalid index identifier
@@ -97,8 +99,8 @@ extern "C" {
 // Video player buffer settings
 #define MAX_VIDEO_WIDTH                     MAX_DECODE_WIDTH    // Maximum video width  
 #define MAX_VIDEO_HEIGHT                    MAX_DECODE_HEIGHT   // Maximum video height
-#define VIDEO_BUFFER_SIZE                   (MAX_VIDEO_WIDTH * MAX_VIDEO_HEIGHT * BYTES_PER_PIXEL_RGB565)
 #define DEFAULT_AUDIO_VOLUME                50      // Default audio volume (0-100)
+#define VIDEO_CACHE_DIR                     PHOTO_BASE_PATH "/.cache"   // Frame indexes and resume points, hidden from the scan
 
 // ========================================
 // UI AND DISPLAY CONSTANTS
@@ -128,7 +130,8 @@ extern "C" {
 #define PNG_HEIGHT_OFFSET_END               23      // PNG height info end offset
 
 // Image processor constants
-#define PPA_MAX_PENDING_TRANSACTIONS        1       // PPA max pending transactions
+#define PPA_MAX_PENDING_TRANSACTIONS        4       // PPA max pending (queued) transactions
+#define IMAGE_PROCESSOR_TIMEOUT_MS          5000    // Wait limit for a queued PPA operation
 #define MEMORY_ALIGNMENT_BYTES              64      // Memory alignment bytes
 
 // ========================================
@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "spsc_byte_ring.h"
+
+#include <string.h>
+#include "esp_heap_caps.h"
+
+#define RECORD_ALIGN        8
+#define RECORD_PAD_MARKER   UINT32_MAX
+
+typedef struct {
+    uint32_t size;
+    uint32_t tag;
+} record_header_t;
+
+_Static_assert(sizeof(record_header_t) == RECORD_ALIGN, "record header must fill one alignment unit");
+
+static inline uint32_t record_span(uint32_t size)
+{
+    return sizeof(record_header_t) + ((size + RECORD_ALIGN - 1) & ~(uint32_t)(RECORD_ALIGN - 1));
+}
+
+bool spsc_byte_ring_init(spsc_byte_ring_t *ring, size_t min_capacity, uint32_t caps)
+{
+    uint32_t capacity = RECORD_ALIGN * 4;
+    while (capacity < min_capacity) {
+        capacity <<= 1;
+    }
+
+    ring->buffer = heap_caps_malloc(capacity, caps);
+    if (ring->buffer == NULL) {
+        ring->capacity = 0;
+        return false;
+    }
+    ring->capacity = capacity;
+    spsc_byte_ring_reset(ring);
+    return true;
+}
+
+void spsc_byte_ring_deinit(spsc_byte_ring_t *ring)
+{
+    heap_caps_free(ring->buffer);
+    ring->buffer = NULL;
+    ring->capacity = 0;
+}
+
+void spsc_byte_ring_reset(spsc_byte_ring_t *ring)
+{
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+}
+
+uint32_t spsc_byte_ring_max_record(const spsc_byte_ring_t *ring)
+{
+    // Worst case the record needs padding nearly as large as itself before the wrap
+    return ring->capacity / 2 - sizeof(record_header_t);
+}
+
+uint32_t spsc_byte_ring_used(const spsc_byte_ring_t *ring)
+{
+    uint32_t head = atomic_load_explicit(&((spsc_byte_ring_t *)ring)->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&((spsc_byte_ring_t *)ring)->tail, memory_order_acquire);
+    return head - tail;
+}
+
+bool spsc_byte_ring_write(spsc_byte_ring_t *ring, const void *data, uint32_t size, uint32_t tag)
+{
+    if (ring->buffer == NULL || size >= RECORD_PAD_MARKER) {
+        return false;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t free_bytes = ring->capacity - (head - tail);
+    uint32_t span = record_span(size);
+    uint32_t offset = head & (ring->capacity - 1);
+    uint32_t contiguous = ring->capacity - offset;
+    uint32_t pad = contiguous < span ? contiguous : 0;
+
+    if (span + pad > free_bytes) {
+        return false;
+    }
+
+    // Offsets stay RECORD_ALIGN aligned, so the padding always has room for a marker
+    if (pad > 0) {
+        record_header_t marker = { .size = RECORD_PAD_MARKER, .tag = 0 };
+        memcpy(ring->buffer + offset, &marker, sizeof(marker));
+        offset = 0;
+    }
+
+    record_header_t header = { .size = size, .tag = tag };
+    memcpy(ring->buffer + offset, &header, sizeof(header));
+    memcpy(ring->buffer + offset + sizeof(header), data, size);
+
+    atomic_store_explicit(&ring->head, head + pad + span, memory_order_release);
+    return true;
+}
+
+uint8_t *spsc_byte_ring_peek(spsc_byte_ring_t *ring, uint32_t *size, uint32_t *tag)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (head == tail) {
+        return NULL;
+    }
+
+    uint32_t offset = tail & (ring->capacity - 1);
+    record_header_t header;
+    memcpy(&header, ring->buffer + offset, sizeof(header));
+
+    if (header.size == RECORD_PAD_MARKER) {
+        // Skip the padding; the producer always writes the record itself at offset 0
+        tail += ring->capacity - offset;
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+        offset = 0;
+        memcpy(&header, ring->buffer, sizeof(header));
+    }
+
+    *size = header.size;
+    if (tag) {
+        *tag = header.tag;
+    }
+    return ring->buffer + offset + sizeof(header);
+}
+
+void spsc_byte_ring_pop(spsc_byte_ring_t *ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    record_header_t header;
+    memcpy(&header, ring->buffer + (tail & (ring->capacity - 1)), sizeof(header));
+    atomic_store_explicit(&ring->tail, tail + record_span(header.size), memory_order_release);
+}
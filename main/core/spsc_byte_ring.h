@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Lock-free single-producer/single-consumer ring of variable-size records.
+//
+// Each record is a small header (size, tag) followed by its payload, stored
+// contiguously so the consumer can use it in place. A record that does not fit
+// before the end of the buffer is preceded by a padding marker and starts again
+// at offset 0. Capacity is a power of two and head/tail are free-running byte
+// counters, each written by one side only.
+typedef struct {
+    uint8_t *buffer;
+    uint32_t capacity;
+    _Atomic uint32_t head;      // Written by the producer
+    _Atomic uint32_t tail;      // Written by the consumer
+} spsc_byte_ring_t;
+
+// Allocate a ring holding at least min_capacity bytes (rounded up to a power of two)
+bool spsc_byte_ring_init(spsc_byte_ring_t *ring, size_t min_capacity, uint32_t caps);
+void spsc_byte_ring_deinit(spsc_byte_ring_t *ring);
+
+// Drop all records. Only while neither side is running.
+void spsc_byte_ring_reset(spsc_byte_ring_t *ring);
+
+// Largest payload that is guaranteed to fit into an empty ring
+uint32_t spsc_byte_ring_max_record(const spsc_byte_ring_t *ring);
+
+// Bytes currently occupied, including headers and padding
+uint32_t spsc_byte_ring_used(const spsc_byte_ring_t *ring);
+
+// Producer: append a record; false if there is not enough free space right now
+bool spsc_byte_ring_write(spsc_byte_ring_t *ring, const void *data, uint32_t size, uint32_t tag);
+
+// Consumer: oldest record, or NULL if empty. Valid until spsc_byte_ring_pop().
+uint8_t *spsc_byte_ring_peek(spsc_byte_ring_t *ring, uint32_t *size, uint32_t *tag);
+
+// Consumer: release the record returned by spsc_byte_ring_peek()
+void spsc_byte_ring_pop(spsc_byte_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,77 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Lock-free single-producer/single-consumer slot ring.
+//
+// The ring only hands out slot indices; the caller owns the slot storage
+// (an array of capacity entries). The producer fills the slot returned by
+// spsc_ring_head_slot() and publishes it with spsc_ring_push(); the consumer
+// reads spsc_ring_tail_slot() and frees it with spsc_ring_pop(). head and
+// tail are free-running counters, each written by one side only, so no lock
+// is needed. Reset only while neither side is running.
+typedef struct {
+    _Atomic uint32_t head;      // Written by the producer
+    _Atomic uint32_t tail;      // Written by the consumer
+    uint32_t capacity;
+} spsc_ring_t;
+
+static inline void spsc_ring_init(spsc_ring_t *ring, uint32_t capacity)
+{
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+    ring->capacity = capacity;
+}
+
+static inline uint32_t spsc_ring_count(const spsc_ring_t *ring)
+{
+    uint32_t head = atomic_load_explicit(&((spsc_ring_t *)ring)->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&((spsc_ring_t *)ring)->tail, memory_order_acquire);
+    return head - tail;
+}
+
+static inline bool spsc_ring_full(const spsc_ring_t *ring)
+{
+    return spsc_ring_count(ring) >= ring->capacity;
+}
+
+// Producer: slot to fill next (only valid while the ring is not full)
+static inline uint32_t spsc_ring_head_slot(const spsc_ring_t *ring)
+{
+    return atomic_load_explicit(&((spsc_ring_t *)ring)->head, memory_order_relaxed) % ring->capacity;
+}
+
+// Producer: publish the slot filled at spsc_ring_head_slot()
+static inline void spsc_ring_push(spsc_ring_t *ring)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// Consumer: slot of the offset-th oldest entry (offset < spsc_ring_count())
+static inline uint32_t spsc_ring_tail_slot(const spsc_ring_t *ring, uint32_t offset)
+{
+    return (atomic_load_explicit(&((spsc_ring_t *)ring)->tail, memory_order_relaxed) + offset) % ring->capacity;
+}
+
+// Consumer: release the oldest entry back to the producer
+static inline void spsc_ring_pop(spsc_ring_t *ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+#ifdef __cplusplus
+}
+#endif
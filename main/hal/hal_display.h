@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef PHOTO_ALBUM_HOST_BUILD
+// Host build renders off-screen at the default panel resolution
+#define HAL_DISPLAY_H_RES       1024
+#define HAL_DISPLAY_V_RES       600
+#else
+#include "bsp/esp-bsp.h"
+#include "bsp/display.h"
+#define HAL_DISPLAY_H_RES       BSP_LCD_H_RES
+#define HAL_DISPLAY_V_RES       BSP_LCD_V_RES
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Display access. Drawing goes through LVGL (ui_manager), except video that
+// video_output writes straight into the panel frame buffers. The HAL exposes
+// the panel resolution, the lock that serialises access to it and the frame
+// buffers with their vsync.
+
+#define HAL_DISPLAY_MAX_FBS     3
+
+// Called each time the panel finishes a refresh, with the frame buffer it scans
+// out from then on; a buffer flipped away from is no longer read after this.
+// May run in ISR context: keep it short and only use FromISR APIs.
+// Return true if a higher priority task was woken.
+typedef bool (*hal_display_vsync_cb_t)(uint32_t scanout, int64_t time_us, void *user_data);
+
+// Bring up the panel, LVGL and touch. Frame buffers are exposed when the panel
+// has at least two (BSP num_fbs); LVGL draws into the first two.
+esp_err_t hal_display_start(void);
+
+// Take the display lock, timeout 0 waits forever
+bool hal_display_lock(uint32_t timeout_ms);
+void hal_display_unlock(void);
+
+// Full screen RGB565 frame buffers, 0 when they are not exposed
+uint32_t hal_display_fb_count(void);
+uint8_t *hal_display_fb_get(uint32_t index);
+size_t hal_display_fb_size(void);
+
+void hal_display_set_vsync_cb(hal_display_vsync_cb_t cb, void *user_data);
+
+// Give scanout to the caller: LVGL keeps running but no longer flips, so it
+// must have nothing to redraw. Call with the display lock held.
+void hal_display_take_scanout(bool take);
+
+// Show a frame buffer from the next refresh on. Only while scanout is taken.
+esp_err_t hal_display_fb_flip(uint32_t index);
+
+// Frame buffer being scanned out
+uint32_t hal_display_fb_scanout(void);
+
+#ifdef __cplusplus
+}
+#endif
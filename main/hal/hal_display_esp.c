@@ -0,0 +1,222 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// MIPI DSI display. With two or more DPI frame buffers the HAL registers the
+// LVGL display itself, in direct mode on the first two buffers, so it owns the
+// vsync callback and can lend scanout to video_output. With one buffer the
+// BSP's LVGL port drives the panel and no frame buffers are exposed.
+
+#include "hal_display.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_lcd_mipi_dsi.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lvgl_port.h"
+#include "bsp/touch.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "hal_display";
+
+#define HAL_DISPLAY_FB_COUNT    (CONFIG_BSP_LCD_DPI_BUFFER_NUMS < HAL_DISPLAY_MAX_FBS ? \
+                                 CONFIG_BSP_LCD_DPI_BUFFER_NUMS : HAL_DISPLAY_MAX_FBS)
+#define LVGL_VSYNC_TIMEOUT_MS   100
+
+static struct {
+    bool started;
+    esp_lcd_panel_handle_t panel;
+    uint8_t *fbs[HAL_DISPLAY_MAX_FBS];
+    uint32_t fb_count;
+    volatile uint32_t scanout;
+    SemaphoreHandle_t lvgl_vsync;   // Given when a refresh finishes, LVGL waits for it after a flip
+    volatile bool scanout_taken;
+    hal_display_vsync_cb_t vsync_cb;
+    void *vsync_user_data;
+} s_disp;
+
+#if CONFIG_BSP_LCD_DPI_BUFFER_NUMS > 1
+static bool dpi_refresh_done(esp_lcd_panel_handle_t panel, esp_lcd_dpi_panel_event_data_t *edata,
+                             void *user_ctx)
+{
+    BaseType_t high_task_woken = pdFALSE;
+    bool woken = false;
+
+    xSemaphoreGiveFromISR(s_disp.lvgl_vsync, &high_task_woken);
+    if (s_disp.vsync_cb) {
+        woken = s_disp.vsync_cb(s_disp.scanout, esp_timer_get_time(), s_disp.vsync_user_data);
+    }
+    return woken || high_task_woken == pdTRUE;
+}
+
+// Direct mode: LVGL renders straight into a frame buffer, flip to it once the
+// last area is done and wait until the panel scans it out
+static void lvgl_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
+{
+    if (lv_display_flush_is_last(disp) && !s_disp.scanout_taken) {
+        for (uint32_t i = 0; i < s_disp.fb_count; i++) {
+            if (s_disp.fbs[i] == px_map) {
+                xSemaphoreTake(s_disp.lvgl_vsync, 0);
+                s_disp.scanout = i;
+                esp_lcd_panel_draw_bitmap(s_disp.panel, 0, 0, HAL_DISPLAY_H_RES, HAL_DISPLAY_V_RES, px_map);
+                xSemaphoreTake(s_disp.lvgl_vsync, pdMS_TO_TICKS(LVGL_VSYNC_TIMEOUT_MS));
+                break;
+            }
+        }
+    }
+    lv_display_flush_ready(disp);
+}
+
+static esp_err_t start_direct(void)
+{
+    lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
+    esp_err_t ret = lvgl_port_init(&port_cfg);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    bsp_lcd_handles_t handles;
+    ret = bsp_display_new_with_handles(NULL, &handles);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    s_disp.panel = handles.panel;
+
+    void *fbs[HAL_DISPLAY_MAX_FBS] = {0};
+    ret = esp_lcd_dpi_panel_get_frame_buffer(s_disp.panel, HAL_DISPLAY_FB_COUNT, &fbs[0], &fbs[1], &fbs[2]);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    for (uint32_t i = 0; i < HAL_DISPLAY_FB_COUNT; i++) {
+        s_disp.fbs[i] = fbs[i];
+    }
+
+    s_disp.lvgl_vsync = xSemaphoreCreateBinary();
+    if (!s_disp.lvgl_vsync) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_lcd_dpi_panel_event_callbacks_t cbs = {
+        .on_refresh_done = dpi_refresh_done,
+    };
+    ret = esp_lcd_dpi_panel_register_event_callbacks(s_disp.panel, &cbs, NULL);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    lvgl_port_lock(0);
+    lv_display_t *disp = lv_display_create(HAL_DISPLAY_H_RES, HAL_DISPLAY_V_RES);
+    if (disp) {
+        lv_display_set_color_format(disp, LV_COLOR_FORMAT_RGB565);
+        lv_display_set_buffers(disp, s_disp.fbs[0], s_disp.fbs[1], hal_display_fb_size(),
+                               LV_DISPLAY_RENDER_MODE_DIRECT);
+        lv_display_set_flush_cb(disp, lvgl_flush_cb);
+    }
+    lvgl_port_unlock();
+    if (!disp) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_lcd_touch_handle_t touch = NULL;
+    if (bsp_touch_new(NULL, &touch) == ESP_OK) {
+        const lvgl_port_touch_cfg_t touch_cfg = {
+            .disp = disp,
+            .handle = touch,
+        };
+        lvgl_port_add_touch(&touch_cfg);
+    } else {
+        ESP_LOGW(TAG, "Touch controller not found");
+    }
+
+    s_disp.fb_count = HAL_DISPLAY_FB_COUNT;
+    return ESP_OK;
+}
+#endif
+
+esp_err_t hal_display_start(void)
+{
+    if (s_disp.started) {
+        return ESP_OK;
+    }
+
+#if CONFIG_BSP_LCD_DPI_BUFFER_NUMS > 1
+    esp_err_t ret = start_direct();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Display start failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+#else
+    bsp_display_cfg_t cfg = {
+        .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
+        .buffer_size = BSP_LCD_DRAW_BUFF_SIZE,
+        .double_buffer = BSP_LCD_DRAW_BUFF_DOUBLE,
+        .flags = {
+            .buff_dma = false,
+            .buff_spiram = true,
+            .sw_rotate = false,
+        }
+    };
+    if (!bsp_display_start_with_config(&cfg)) {
+        return ESP_FAIL;
+    }
+#endif
+
+    bsp_display_backlight_on();
+    s_disp.started = true;
+    ESP_LOGI(TAG, "Display %dx%d, %u frame buffers exposed", HAL_DISPLAY_H_RES, HAL_DISPLAY_V_RES,
+             s_disp.fb_count);
+    return ESP_OK;
+}
+
+bool hal_display_lock(uint32_t timeout_ms)
+{
+    return bsp_display_lock(timeout_ms);
+}
+
+void hal_display_unlock(void)
+{
+    bsp_display_unlock();
+}
+
+uint32_t hal_display_fb_count(void)
+{
+    return s_disp.fb_count;
+}
+
+uint8_t *hal_display_fb_get(uint32_t index)
+{
+    return index < s_disp.fb_count ? s_disp.fbs[index] : NULL;
+}
+
+size_t hal_display_fb_size(void)
+{
+    return (size_t)HAL_DISPLAY_H_RES * HAL_DISPLAY_V_RES * 2;
+}
+
+void hal_display_set_vsync_cb(hal_display_vsync_cb_t cb, void *user_data)
+{
+    // Data first, the refresh ISR may fire between the two stores
+    s_disp.vsync_user_data = user_data;
+    s_disp.vsync_cb = cb;
+}
+
+void hal_display_take_scanout(bool take)
+{
+    s_disp.scanout_taken = take;
+}
+
+esp_err_t hal_display_fb_flip(uint32_t index)
+{
+    if (!s_disp.scanout_taken || index >= s_disp.fb_count) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // A DPI panel switches to one of its own frame buffers instead of copying it
+    s_disp.scanout = index;
+    return esp_lcd_panel_draw_bitmap(s_disp.panel, 0, 0, HAL_DISPLAY_H_RES, HAL_DISPLAY_V_RES,
+                                     s_disp.fbs[index]);
+}
+
+uint32_t hal_display_fb_scanout(void)
+{
+    return s_disp.scanout;
+}
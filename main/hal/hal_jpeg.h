@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// JPEG decode engine. On target this is the hardware decoder shared with the
+// video path; the host build decodes in software with the same output layout.
+
+typedef struct hal_jpeg_engine_t *hal_jpeg_handle_t;
+
+// JPEG header information
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+} hal_jpeg_info_t;
+
+// Parse the JPEG header, no engine needed
+esp_err_t hal_jpeg_get_info(const uint8_t *data, size_t data_size, hal_jpeg_info_t *info);
+
+// Acquire/release the decode engine
+esp_err_t hal_jpeg_acquire(hal_jpeg_handle_t *ret_handle);
+void hal_jpeg_release(hal_jpeg_handle_t handle);
+
+// Decode to RGB565 (native 16-bit pixels). Width and height are padded to a
+// multiple of 16 like the hardware decoder, out_size must cover the padded
+// frame and out must come from image_buffer_alloc.
+esp_err_t hal_jpeg_decode_rgb565(hal_jpeg_handle_t handle,
+                                 const uint8_t *data, size_t data_size,
+                                 uint8_t *out, size_t out_size, uint32_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
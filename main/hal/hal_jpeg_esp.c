@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "hal_jpeg.h"
+#include "app_stream_adapter.h"
+#include "esp_log.h"
+#include "driver/jpeg_decode.h"
+
+static const char *TAG = "hal_jpeg";
+
+esp_err_t hal_jpeg_get_info(const uint8_t *data, size_t data_size, hal_jpeg_info_t *info)
+{
+    if (!data || !info || data_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    jpeg_decode_picture_info_t pic_info;
+    esp_err_t ret = jpeg_decoder_get_info(data, (uint32_t)data_size, &pic_info);
+    if (ret == ESP_OK) {
+        info->width = pic_info.width;
+        info->height = pic_info.height;
+    }
+    return ret;
+}
+
+esp_err_t hal_jpeg_acquire(hal_jpeg_handle_t *ret_handle)
+{
+    if (!ret_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = shared_jpeg_decoder_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize shared JPEG decoder: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    jpeg_decoder_handle_t decoder = NULL;
+    ret = shared_jpeg_decoder_acquire(&decoder);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to acquire shared JPEG decoder: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    *ret_handle = (hal_jpeg_handle_t)decoder;
+    return ESP_OK;
+}
+
+void hal_jpeg_release(hal_jpeg_handle_t handle)
+{
+    if (handle) {
+        shared_jpeg_decoder_release();
+    }
+}
+
+esp_err_t hal_jpeg_decode_rgb565(hal_jpeg_handle_t handle,
+                                 const uint8_t *data, size_t data_size,
+                                 uint8_t *out, size_t out_size, uint32_t *out_len)
+{
+    if (!handle || !data || !out || !out_len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    jpeg_decode_cfg_t decode_cfg = {
+        .output_format = JPEG_DECODE_OUT_FORMAT_RGB565,
+        .rgb_order = JPEG_DEC_RGB_ELEMENT_ORDER_BGR,
+        .conv_std = JPEG_YUV_RGB_CONV_STD_BT601,
+    };
+
+    return jpeg_decoder_process((jpeg_decoder_handle_t)handle, &decode_cfg, data, (uint32_t)data_size,
+                                out, (uint32_t)out_size, out_len);
+}
@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pixel processing accelerator, scale-rotate-mirror (SRM) operations only.
+// On target this is the PPA; the host build scales in a worker thread.
+
+typedef struct hal_ppa_client_t *hal_ppa_client_handle_t;
+
+// Completion callback. May run in ISR context: keep it short and only use
+// FromISR APIs. Return true if a higher priority task was woken.
+typedef bool (*hal_ppa_done_cb_t)(void *user_data);
+
+// Client configuration
+typedef struct {
+    uint32_t max_pending;           // Operations that may be queued at once
+    hal_ppa_done_cb_t done_cb;      // Called once per finished operation
+} hal_ppa_client_config_t;
+
+// Rotation applied after scaling, counter-clockwise like the PPA
+typedef enum {
+    HAL_PPA_ROTATION_0 = 0,
+    HAL_PPA_ROTATION_90,
+    HAL_PPA_ROTATION_180,
+    HAL_PPA_ROTATION_270,
+} hal_ppa_rotation_t;
+
+// Scale, rotate and mirror a block of an RGB565 picture into an RGB565 output
+// picture. With 90/270 rotation the output block is in_block_h x in_block_w.
+typedef struct {
+    const void *in_buffer;
+    uint32_t in_pic_w;              // Input row stride in pixels
+    uint32_t in_pic_h;
+    uint32_t in_block_w;
+    uint32_t in_block_h;
+    uint32_t in_block_offset_x;
+    uint32_t in_block_offset_y;
+
+    void *out_buffer;
+    size_t out_buffer_size;
+    uint32_t out_pic_w;
+    uint32_t out_pic_h;
+    uint32_t out_block_offset_x;
+    uint32_t out_block_offset_y;
+
+    float scale_x;                  // Multiples of 1/16, the PPA's scale precision
+    float scale_y;
+    hal_ppa_rotation_t rotation;    // Zero-initialised ops neither rotate nor mirror
+    bool mirror_x;
+    bool mirror_y;
+    void *user_data;                // Passed to done_cb
+} hal_ppa_srm_op_t;
+
+esp_err_t hal_ppa_client_create(const hal_ppa_client_config_t *config, hal_ppa_client_handle_t *ret_client);
+esp_err_t hal_ppa_client_delete(hal_ppa_client_handle_t client);
+
+// Queue an operation and return immediately, done_cb reports completion.
+// Buffers must stay valid until then and come from image_buffer_alloc.
+esp_err_t hal_ppa_srm_submit(hal_ppa_client_handle_t client, const hal_ppa_srm_op_t *op);
+
+#ifdef __cplusplus
+}
+#endif
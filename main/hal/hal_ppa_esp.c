@@ -0,0 +1,182 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "hal_ppa.h"
+#include "esp_log.h"
+#include "driver/ppa.h"
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h>
+
+static const char *TAG = "hal_ppa";
+
+static const ppa_srm_rotation_angle_t s_rotation_angles[] = {
+    [HAL_PPA_ROTATION_0] = PPA_SRM_ROTATION_ANGLE_0,
+    [HAL_PPA_ROTATION_90] = PPA_SRM_ROTATION_ANGLE_90,
+    [HAL_PPA_ROTATION_180] = PPA_SRM_ROTATION_ANGLE_180,
+    [HAL_PPA_ROTATION_270] = PPA_SRM_ROTATION_ANGLE_270,
+};
+
+// Driver user_data of one queued transaction: routes completion back to its client
+typedef struct {
+    struct hal_ppa_client_t *client;
+    void *user_data;
+    bool in_use;
+} hal_ppa_trans_t;
+
+struct hal_ppa_client_t {
+    ppa_client_handle_t ppa_client;
+    hal_ppa_done_cb_t done_cb;
+    hal_ppa_trans_t *trans;         // One context per pending transaction
+    uint32_t max_pending;
+    portMUX_TYPE lock;
+};
+
+// PPA transaction done callback (ISR context)
+static bool ppa_trans_done_cb(ppa_client_handle_t ppa_client, ppa_event_data_t *event_data, void *user_data)
+{
+    hal_ppa_trans_t *trans = (hal_ppa_trans_t *)user_data;
+    struct hal_ppa_client_t *client = trans->client;
+
+    void *op_user_data = trans->user_data;
+
+    taskENTER_CRITICAL_ISR(&client->lock);
+    trans->in_use = false;
+    taskEXIT_CRITICAL_ISR(&client->lock);
+
+    return client->done_cb ? client->done_cb(op_user_data) : false;
+}
+
+esp_err_t hal_ppa_client_create(const hal_ppa_client_config_t *config, hal_ppa_client_handle_t *ret_client)
+{
+    if (!config || !ret_client || config->max_pending == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct hal_ppa_client_t *client = calloc(1, sizeof(*client));
+    if (!client) {
+        return ESP_ERR_NO_MEM;
+    }
+    client->trans = calloc(config->max_pending, sizeof(*client->trans));
+    if (!client->trans) {
+        free(client);
+        return ESP_ERR_NO_MEM;
+    }
+    client->done_cb = config->done_cb;
+    client->max_pending = config->max_pending;
+    portMUX_INITIALIZE(&client->lock);
+
+    ppa_client_config_t ppa_config = {
+        .oper_type = PPA_OPERATION_SRM,
+        .max_pending_trans_num = config->max_pending,
+        .data_burst_length = PPA_DATA_BURST_LENGTH_128,
+    };
+
+    esp_err_t ret = ppa_register_client(&ppa_config, &client->ppa_client);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register PPA client: %s", esp_err_to_name(ret));
+        free(client->trans);
+        free(client);
+        return ret;
+    }
+
+    ppa_event_callbacks_t cbs = {
+        .on_trans_done = ppa_trans_done_cb,
+    };
+    ret = ppa_client_register_event_callbacks(client->ppa_client, &cbs);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register PPA callbacks: %s", esp_err_to_name(ret));
+        ppa_unregister_client(client->ppa_client);
+        free(client->trans);
+        free(client);
+        return ret;
+    }
+
+    *ret_client = client;
+    return ESP_OK;
+}
+
+esp_err_t hal_ppa_client_delete(hal_ppa_client_handle_t client)
+{
+    if (!client) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ppa_unregister_client(client->ppa_client);
+    if (ret != ESP_OK) {
+        // Transactions still queued would complete into freed contexts
+        ESP_LOGE(TAG, "Failed to unregister PPA client: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    free(client->trans);
+    free(client);
+    return ESP_OK;
+}
+
+esp_err_t hal_ppa_srm_submit(hal_ppa_client_handle_t client, const hal_ppa_srm_op_t *op)
+{
+    if (!client || !op || !op->in_buffer || !op->out_buffer || op->rotation > HAL_PPA_ROTATION_270) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ppa_srm_oper_config_t srm_config = {
+        .in = {
+            .buffer = op->in_buffer,
+            .pic_w = op->in_pic_w,
+            .pic_h = op->in_pic_h,
+            .block_w = op->in_block_w,
+            .block_h = op->in_block_h,
+            .block_offset_x = op->in_block_offset_x,
+            .block_offset_y = op->in_block_offset_y,
+            .srm_cm = PPA_SRM_COLOR_MODE_RGB565,
+        },
+        .out = {
+            .buffer = op->out_buffer,
+            .buffer_size = op->out_buffer_size,
+            .pic_w = op->out_pic_w,
+            .pic_h = op->out_pic_h,
+            .block_offset_x = op->out_block_offset_x,
+            .block_offset_y = op->out_block_offset_y,
+            .srm_cm = PPA_SRM_COLOR_MODE_RGB565,
+        },
+        .rotation_angle = s_rotation_angles[op->rotation],
+        .scale_x = op->scale_x,
+        .scale_y = op->scale_y,
+        .mirror_x = op->mirror_x,
+        .mirror_y = op->mirror_y,
+        .rgb_swap = false,
+        .byte_swap = false,
+        .alpha_update_mode = PPA_ALPHA_NO_CHANGE,
+        .mode = PPA_TRANS_MODE_NON_BLOCKING,
+    };
+
+    hal_ppa_trans_t *trans = NULL;
+    taskENTER_CRITICAL(&client->lock);
+    for (uint32_t i = 0; i < client->max_pending; i++) {
+        if (!client->trans[i].in_use) {
+            trans = &client->trans[i];
+            trans->in_use = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&client->lock);
+
+    if (!trans) {
+        ESP_LOGE(TAG, "PPA client already has %"PRIu32" operations pending, the most it was created for",
+                 client->max_pending);
+        return ESP_ERR_INVALID_STATE;
+    }
+    trans->client = client;
+    trans->user_data = op->user_data;
+    srm_config.user_data = trans;
+
+    esp_err_t ret = ppa_do_scale_rotate_mirror(client->ppa_client, &srm_config);
+    if (ret != ESP_OK) {
+        taskENTER_CRITICAL(&client->lock);
+        trans->in_use = false;
+        taskEXIT_CRITICAL(&client->lock);
+    }
+    return ret;
+}
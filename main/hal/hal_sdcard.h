@@ -0,0 +1,22 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Photo storage. On target this mounts the SD card through the BSP; on the
+// host the local file system is used as is.
+
+esp_err_t hal_sdcard_mount(void);
+esp_err_t hal_sdcard_unmount(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,17 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "hal_sdcard.h"
+#include "bsp/esp-bsp.h"
+
+esp_err_t hal_sdcard_mount(void)
+{
+    return bsp_sdcard_mount();
+}
+
+esp_err_t hal_sdcard_unmount(void)
+{
+    return bsp_sdcard_unmount();
+}
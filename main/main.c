@@ -6,39 +6,44 @@
 
 #include "esp_log.h"
 #include "esp_err.h"
-#include "esp_lvgl_port.h"
-#include "bsp/display.h"
-#include "bsp/esp-bsp.h"
 #include "photo_album.h"
 #include "usb_manager.h"
 #include "video_player.h"
 #include "file_manager.h"
 #include "ui_manager.h"
+#include "hal_display.h"
 #include "network_manager.h"
+#if CONFIG_PHOTO_ALBUM_BENCH
+#include "bench_suite.h"
+#endif
 
 static const char *TAG = "main";
 
 void app_main(void)
 {
+#if CONFIG_PHOTO_ALBUM_BENCH
+    bench_config_t bench_config = {
+        .iterations = CONFIG_PHOTO_ALBUM_BENCH_ITERATIONS,
+        .filter = NULL,
+        .json_markers = true,
+    };
+    esp_err_t bench_ret = bench_run(&bench_config, stdout);
+    ESP_LOGI(TAG, "Benchmark finished: %s", esp_err_to_name(bench_ret));
+    return;
+#endif
+
     ESP_LOGI(TAG, "Starting digital photo album with HTTP upload");
 
     // Initialize display
-    bsp_display_cfg_t cfg = {
-        .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
-        .buffer_size = BSP_LCD_DRAW_BUFF_SIZE,
-        .double_buffer = BSP_LCD_DRAW_BUFF_DOUBLE,
-        .flags = {
-            .buff_dma = false,
-            .buff_spiram = true,
-            .sw_rotate = false,
-        }
-    };
-    bsp_display_start_with_config(&cfg);
-    bsp_display_backlight_on();
+    esp_err_t ret = hal_display_start();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start display: %s", esp_err_to_name(ret));
+        return;
+    }
     ESP_LOGI(TAG, "Display initialized");
 
     // Initialize photo album (mounts SD card)
-    esp_err_t ret = photo_album_init();
+    ret = photo_album_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize photo album: %s", esp_err_to_name(ret));
         return;
@@ -10,6 +10,7 @@
 #include <fcntl.h>      // Add support for open, O_RDONLY, etc.
 #include <unistd.h>     // Add support for read, close, etc.
 #include <sys/types.h>  // Add support for lseek, etc.
+#include <sys/stat.h>
 #include <math.h>
 #include <errno.h>
 #include "esp_log.h"
@@ -32,6 +33,9 @@
 #include "esp_audio_es_extractor.h"
 #include "esp_ogg_extractor.h"
 #include "mem_pool.h"
+#include "image_buffer.h"
+#include "spsc_byte_ring.h"
+#include "audio_pacer.h"
 
 // Include correct audio codec headers
 #include "simple_dec/esp_audio_simple_dec.h"
@@ -73,13 +77,6 @@ static const char *TAG = "app_extractor";
     } \
 } while (0)
 
-/* Audio frame item for queue */
-typedef struct {
-    uint8_t *buffer;
-    uint32_t size;
-    uint32_t pts;
-} audio_frame_item_t;
-
 /**
  * @brief App extractor context structure
  */
@@ -87,6 +84,11 @@ typedef struct app_extractor_t {
     esp_extractor_handle_t  extractor;
     int                     file;
     app_extractor_frame_cb_t frame_cb;
+    char                    *url;               // File opened by app_extractor_prepare()
+    bool                    prepared;           // Opened but not started yet
+    esp_extractor_resume_info_t *resume_info;   // Applied by the next prepare instead of a full parse
+    bool                    resumed;            // The open file was set up from resume info
+    uint32_t                max_frame_size;     // Sizes the output pool of the next open, 0 when unknown
     bool                    extract_video;
     bool                    extract_audio;
     bool                    has_video;
@@ -102,14 +104,23 @@ typedef struct app_extractor_t {
     uint32_t                last_video_pts;
     uint32_t                last_audio_pts;
     extractor_video_format_t video_format;
+    uint8_t                *video_spec_info;    // Codec record of the video track (avcC for H.264), NULL for none
+    uint32_t                video_spec_info_len;
     extractor_audio_format_t audio_format;
     bool                    eos_reached;
+    app_extractor_read_stats_t read_stats;  // Written by the reading task only
+
+    // Looping, see app_extractor_set_loop()
+    volatile bool           loop;
+    uint32_t                loop_offset_ms;     // Added to the PTS of every frame of the current pass
+    uint32_t                loop_frames;        // Frames read in the current pass
 
     // A/V sync support (Kconfig controlled)
     bool                   sync_enabled;
     uint32_t               sync_threshold_ms;
     SemaphoreHandle_t      sync_mutex;
-    int64_t                base_time;
+    uint32_t               audio_clock_ms;      // PTS at the end of the last samples written to the codec
+    int64_t                audio_clock_us;      // esp_timer time of that write, 0 until audio has played
 
     // Audio decoder
     esp_audio_simple_dec_handle_t audio_decoder;
@@ -117,27 +128,80 @@ typedef struct app_extractor_t {
     uint8_t                *audio_buffer;
     uint32_t               audio_buffer_size;
     esp_codec_dev_handle_t audio_dev;
+    audio_pacer_t          audio_pacer;         // I2S DMA fill level, paces codec writes; audio task only
+    volatile bool          audio_pacer_reset;   // Reset the pacer before the next audio frame
 
     // Audio task and queue
     TaskHandle_t           audio_task_handle;
-    QueueHandle_t          audio_queue;
+    spsc_byte_ring_t       audio_ring;          // Compressed audio frames, demux -> audio task
+    volatile TaskHandle_t  audio_ring_writer;   // Demux task while it waits for ring space
     bool                   audio_task_running;
+    volatile bool          audio_muted;         // Drop audio instead of playing it, see app_extractor_set_audio_muted()
+    uint32_t               audio_max_frame_size;
+    uint32_t               audio_underruns;
+    uint32_t               audio_overflows;
+    uint32_t               audio_ring_peak;
+    uint32_t               audio_bitrate;
 
-    // Frame rate control
-    uint32_t               frame_interval_ms;
-    int64_t                last_frame_time;
-    
     // Audio device state flags (replace static variables)
     bool                   audio_dev_opened;
     bool                   audio_decoder_configured;
 } app_extractor_t;
 
+// Extractor and audio decoder registries are global, shared by every app extractor
+static int s_extractor_users;
+
 /* Forward declarations */
 static esp_err_t process_audio_frame(app_extractor_t *extractor, uint8_t *buffer, uint32_t buffer_size, uint32_t pts);
 
 /**
  * @brief File I/O wrapper functions for ESP Extractor
  */
+#if CONFIG_VIDEO_READ_AHEAD
+static void *_file_open(char *url, void *ctx)
+{
+    app_extractor_t *extractor = (app_extractor_t *)ctx;
+    read_ahead_config_t config = {
+        .block_size = READ_AHEAD_DEFAULT_BLOCK_SIZE,
+        .block_count = READ_AHEAD_DEFAULT_BLOCK_COUNT,
+        .task_priority = READ_AHEAD_DEFAULT_TASK_PRIO,
+        .task_stack_size = READ_AHEAD_DEFAULT_TASK_STACK,
+        .stats = &extractor->read_stats.card,
+    };
+    read_ahead_handle_t reader = NULL;
+    if (read_ahead_open(url, &config, &reader) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open file: %s", url);
+        return NULL;
+    }
+    return reader;
+}
+
+static int _file_read(void *data, uint32_t size, void *ctx)
+{
+    int bytes_read = read_ahead_read((read_ahead_handle_t)ctx, data, size);
+    if (bytes_read < 0) {
+        ESP_LOGE(TAG, "File read error");
+        return 0;
+    }
+    return bytes_read;
+}
+
+static int _file_seek(uint32_t position, void *ctx)
+{
+    return read_ahead_seek((read_ahead_handle_t)ctx, position) == ESP_OK ? 0 : -1;
+}
+
+static int _file_close(void *ctx)
+{
+    read_ahead_close((read_ahead_handle_t)ctx);
+    return 0;
+}
+
+static uint32_t _file_size(void *ctx)
+{
+    return read_ahead_size((read_ahead_handle_t)ctx);
+}
+#else
 static void *_file_open(char *url, void *ctx)
 {
     int fd = open(url, O_RDONLY);
@@ -183,47 +247,181 @@ static int _file_close(void *ctx)
 
 static uint32_t _file_size(void *ctx)
 {
+    // fstat reads the directory entry FATFS keeps open, no seeks on the card
+    struct stat st;
     int fd = (int)(intptr_t)ctx;
-    off_t current = lseek(fd, 0, SEEK_CUR);
-    off_t end = lseek(fd, 0, SEEK_END);
-    lseek(fd, current, SEEK_SET);
-    return end <= 0 ? 0 : (uint32_t)end;
+    return fstat(fd, &st) != 0 ? 0 : (uint32_t)st.st_size;
+}
+#endif
+
+/**
+ * @brief Output pool for a clip whose largest video frame is max_frame_size
+ *
+ * Each frame is rounded up to the output alignment. Never above the default,
+ * which already bounds any single frame.
+ */
+static uint32_t output_pool_size_for(uint32_t max_frame_size)
+{
+    if (max_frame_size == 0) {
+        return EXTRACTOR_OUTPUT_POOL_SIZE;
+    }
+    uint64_t size = (uint64_t)image_buffer_align_size(max_frame_size) * EXTRACTOR_OUTPUT_POOL_FRAMES +
+                    EXTRACTOR_OUTPUT_POOL_AUDIO;
+    return size < EXTRACTOR_OUTPUT_POOL_SIZE ? (uint32_t)size : EXTRACTOR_OUTPUT_POOL_SIZE;
+}
+
+/**
+ * @brief Worst-case compressed frame size of the current audio stream
+ */
+static uint32_t audio_max_frame_size(app_extractor_t *extractor)
+{
+    uint32_t channels = extractor->audio_channels > 0 ? extractor->audio_channels : 2;
+
+    switch (extractor->audio_format) {
+    case EXTRACTOR_AUDIO_FORMAT_AAC:
+        // 6144 bits per channel per raw data block, plus ADTS header
+        return 768 * channels + 16;
+    case EXTRACTOR_AUDIO_FORMAT_MP3:
+        // Largest layer III frame (320 kbps at 32 kHz) with margin for free format
+        return 2881;
+    default: {
+        // PCM and other formats: 100 ms at the stream rate, or the bitrate if that is all we know
+        uint32_t bytes_per_second = extractor->audio_sample_rate * channels * (extractor->audio_bits / 8);
+        if (bytes_per_second == 0) {
+            bytes_per_second = extractor->audio_bitrate / 8;
+        }
+        uint32_t size = bytes_per_second / 10;
+        return size > 4096 ? size : 4096;
+    }
+    }
+}
+
+/**
+ * @brief Queue a compressed audio frame for the audio task
+ *
+ * Waits up to AUDIO_QUEUE_TIMEOUT_MS for space; the audio task drains the ring
+ * in real time, so this only blocks when demux runs far ahead of playback.
+ */
+static void queue_audio_frame(app_extractor_t *extractor, const uint8_t *buffer, uint32_t size, uint32_t pts)
+{
+    if (size > spsc_byte_ring_max_record(&extractor->audio_ring)) {
+        extractor->audio_overflows++;
+        ESP_LOGW(TAG, "Audio frame of %u bytes exceeds ring record limit %u", size,
+                 spsc_byte_ring_max_record(&extractor->audio_ring));
+        return;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    extractor->audio_ring_writer = xTaskGetCurrentTaskHandle();
+    while (!spsc_byte_ring_write(&extractor->audio_ring, buffer, size, pts)) {
+        if (!extractor->audio_task_running ||
+                xTaskGetTickCount() - start >= pdMS_TO_TICKS(AUDIO_QUEUE_TIMEOUT_MS)) {
+            extractor->audio_ring_writer = NULL;
+            extractor->audio_overflows++;
+            return;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(AUDIO_QUEUE_TIMEOUT_MS));
+    }
+    extractor->audio_ring_writer = NULL;
+
+    uint32_t used = spsc_byte_ring_used(&extractor->audio_ring);
+    if (used > extractor->audio_ring_peak) {
+        extractor->audio_ring_peak = used;
+    }
+
+    if (extractor->audio_task_handle != NULL) {
+        xTaskNotifyGive(extractor->audio_task_handle);
+    }
 }
 
 /**
- * @brief Audio processing task with optimized queue handling
+ * @brief Audio processing task, blocks until demux queues a frame
  */
 static void audio_task(void *arg)
 {
     app_extractor_t *extractor = (app_extractor_t *)arg;
-    audio_frame_item_t *frame_item;
     uint32_t processed_frames = 0;
+    bool playing = false;
 
     while (extractor->audio_task_running) {
-        if (xQueueReceive(extractor->audio_queue, &frame_item,
-                          pdMS_TO_TICKS(AUDIO_QUEUE_TIMEOUT_MS))) {
+        uint32_t size = 0;
+        uint32_t pts = 0;
+        uint8_t *buffer = spsc_byte_ring_peek(&extractor->audio_ring, &size, &pts);
+
+        if (buffer == NULL) {
+            // Running dry mid-stream means the codec is starved until demux catches up
+            if (playing && !extractor->eos_reached) {
+                extractor->audio_underruns++;
+            }
+            playing = false;
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        if (extractor->audio_pacer_reset) {
+            extractor->audio_pacer_reset = false;
+            audio_pacer_reset(&extractor->audio_pacer, extractor->audio_sample_rate,
+                              extractor->audio_channels, extractor->audio_bits);
+        }
 
-            esp_err_t ret = process_audio_frame(extractor, frame_item->buffer,
-                                                frame_item->size, frame_item->pts);
+        // Muted frames queued before the mute are dropped, not played late
+        if (!extractor->audio_muted) {
+            esp_err_t ret = process_audio_frame(extractor, buffer, size, pts);
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "Failed to process audio frame: %d", ret);
             }
+        }
 
-            free(frame_item);  // Free entire structure
-            processed_frames++;
+        spsc_byte_ring_pop(&extractor->audio_ring);
+        playing = !extractor->audio_muted;
+        processed_frames++;
 
-            // Log every 100 frames to reduce overhead
-            if (processed_frames % 100 == 0) {
-                ESP_LOGD(TAG, "Audio processed %u frames", processed_frames);
-            }
+        TaskHandle_t writer = extractor->audio_ring_writer;
+        if (writer != NULL) {
+            xTaskNotifyGive(writer);
+        }
+
+        // Log every 100 frames to reduce overhead
+        if (processed_frames % 100 == 0) {
+            ESP_LOGD(TAG, "Audio processed %u frames", processed_frames);
         }
     }
 
-    ESP_LOGI(TAG, "Audio task stopped, processed %u frames", processed_frames);
+    ESP_LOGI(TAG, "Audio task stopped, processed %u frames, %u underruns, %u overflows, %u xruns",
+             processed_frames, extractor->audio_underruns, extractor->audio_overflows,
+             extractor->audio_pacer.xruns);
     extractor->audio_task_handle = NULL;
     vTaskDelete(NULL);
 }
 
+/**
+ * @brief Allocate the compressed audio ring for the current stream
+ *
+ * Done when the file is prepared, so audio demuxed before playback starts is kept.
+ */
+static esp_err_t alloc_audio_ring(app_extractor_t *extractor)
+{
+    if (extractor->audio_ring.buffer != NULL) {
+        return ESP_OK;
+    }
+
+    // Room for AUDIO_RING_FRAMES worst-case frames of this stream
+    extractor->audio_max_frame_size = audio_max_frame_size(extractor);
+    size_t ring_size = (size_t)AUDIO_RING_FRAMES * (extractor->audio_max_frame_size + 16);
+    if (!spsc_byte_ring_init(&extractor->audio_ring, ring_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) &&
+            !spsc_byte_ring_init(&extractor->audio_ring, ring_size, MALLOC_CAP_8BIT)) {
+        ESP_LOGE(TAG, "Failed to allocate %zu byte audio ring", ring_size);
+        return ESP_ERR_NO_MEM;
+    }
+    extractor->audio_ring_writer = NULL;
+    extractor->audio_underruns = 0;
+    extractor->audio_overflows = 0;
+    extractor->audio_ring_peak = 0;
+    ESP_LOGI(TAG, "Audio ring: %u bytes for frames up to %u bytes",
+             extractor->audio_ring.capacity, extractor->audio_max_frame_size);
+    return ESP_OK;
+}
+
 /**
  * @brief Start audio processing task
  */
@@ -233,6 +431,11 @@ static esp_err_t start_audio_task(app_extractor_t *extractor)
         return ESP_OK;
     }
 
+    esp_err_t err = alloc_audio_ring(extractor);
+    if (err != ESP_OK) {
+        return err;
+    }
+
     extractor->audio_task_running = true;
 
     BaseType_t ret = xTaskCreate(audio_task, "audio_task",
@@ -243,6 +446,7 @@ static esp_err_t start_audio_task(app_extractor_t *extractor)
     if (ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create audio task");
         extractor->audio_task_running = false;
+        spsc_byte_ring_deinit(&extractor->audio_ring);
         return ESP_FAIL;
     }
 
@@ -250,46 +454,25 @@ static esp_err_t start_audio_task(app_extractor_t *extractor)
 }
 
 /**
- * @brief Stop audio processing task and clean up queue
+ * @brief Stop audio processing task and release the audio ring
  */
 static void stop_audio_task(app_extractor_t *extractor)
 {
-    if (!extractor->audio_task_running) {
-        return;
-    }
-
-    extractor->audio_task_running = false;
-
-    // Wait for task to exit
-    while (extractor->audio_task_handle != NULL) {
-        vTaskDelay(pdMS_TO_TICKS(10));
-    }
-
-    // Clean up remaining audio frames in queue
-    audio_frame_item_t *frame_item;
-    while (xQueueReceive(extractor->audio_queue, &frame_item, 0)) {
-        free(frame_item);
-    }
-}
-
-/**
- * @brief Control frame rate for proper playback timing
- */
-static void control_frame_rate(app_extractor_t *extractor)
-{
-    int64_t current_time = esp_timer_get_time() / 1000;
-
-    // Calculate target time for this frame
-    int64_t target_time = extractor->last_frame_time + extractor->frame_interval_ms;
+    if (extractor->audio_task_running) {
+        extractor->audio_task_running = false;
 
-    if (current_time < target_time) {
-        uint32_t delay = target_time - current_time;
-        if (delay > 0 && delay < 1000) { // Sanity check: delay should be reasonable
-            vTaskDelay(pdMS_TO_TICKS(delay));
+        // Wake the task if it is waiting for data, then wait for it to exit
+        TaskHandle_t task = extractor->audio_task_handle;
+        if (task != NULL) {
+            xTaskNotifyGive(task);
+        }
+        while (extractor->audio_task_handle != NULL) {
+            vTaskDelay(pdMS_TO_TICKS(10));
         }
     }
 
-    extractor->last_frame_time = esp_timer_get_time() / 1000;
+    // A prepared file has a ring without a task
+    spsc_byte_ring_deinit(&extractor->audio_ring);
 }
 
 /**
@@ -501,7 +684,52 @@ static esp_err_t init_audio_decoder(app_extractor_t *extractor)
 }
 
 /**
- * @brief Process audio frame with optimized timing control
+ * @brief Advance the audio master clock after samples were accepted by the codec
+ *
+ * The clock is the PTS leaving the speaker, i.e. the end of the written samples
+ * minus what is still queued in the I2S DMA.
+ *
+ * @param pts PTS of the compressed frame the samples belong to
+ * @param bytes_written PCM bytes of that frame written so far
+ */
+static void update_audio_clock(app_extractor_t *extractor, uint32_t pts, uint32_t bytes_written)
+{
+    if (!extractor->sync_enabled || extractor->sync_mutex == NULL) {
+        return;
+    }
+
+    uint32_t bytes_per_second = extractor->audio_sample_rate * extractor->audio_channels * (extractor->audio_bits / 8);
+    if (bytes_per_second == 0) {
+        return;
+    }
+
+    uint32_t clock_ms = pts + (uint32_t)((uint64_t)bytes_written * 1000 / bytes_per_second);
+    uint32_t queued_ms = extractor->audio_pacer.buffered_ms;
+    clock_ms = clock_ms > queued_ms ? clock_ms - queued_ms : 0;
+
+    xSemaphoreTake(extractor->sync_mutex, portMAX_DELAY);
+    extractor->audio_clock_ms = clock_ms;
+    extractor->audio_clock_us = esp_timer_get_time();
+    xSemaphoreGive(extractor->sync_mutex);
+}
+
+static void reset_audio_clock(app_extractor_t *extractor)
+{
+    // Callers run beside the audio task, which may be writing through the pacer
+    extractor->audio_pacer_reset = true;
+
+    if (extractor->sync_mutex == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(extractor->sync_mutex, portMAX_DELAY);
+    extractor->audio_clock_ms = 0;
+    extractor->audio_clock_us = 0;
+    xSemaphoreGive(extractor->sync_mutex);
+}
+
+/**
+ * @brief Decode (if needed) and write one audio frame to the codec
  */
 static esp_err_t process_audio_frame(app_extractor_t *extractor, uint8_t *buffer, uint32_t buffer_size, uint32_t pts)
 {
@@ -523,21 +751,16 @@ static esp_err_t process_audio_frame(app_extractor_t *extractor, uint8_t *buffer
                 return ret;
             }
             extractor->audio_dev_opened = true;
+            audio_pacer_reset(&extractor->audio_pacer, extractor->audio_sample_rate,
+                              extractor->audio_channels, extractor->audio_bits);
             ESP_LOGI(TAG, "Audio device opened for PCM: %dHz, %dch, %dbit", 
                      extractor->audio_sample_rate, extractor->audio_channels, extractor->audio_bits);
         }
 
-        esp_err_t ret = esp_codec_dev_write(extractor->audio_dev, buffer, buffer_size);
-
-        // Precise timing control based on audio frame duration
+        // Blocks while the I2S DMA is full, which paces playback
+        esp_err_t ret = audio_pacer_write(&extractor->audio_pacer, extractor->audio_dev, buffer, buffer_size);
         if (ret == ESP_OK) {
-            uint32_t bytes_per_sample = extractor->audio_channels * (extractor->audio_bits / 8);
-            uint32_t frame_duration_ms = (buffer_size * 1000) / (extractor->audio_sample_rate * bytes_per_sample);
-
-            // Use 60% of frame duration to prevent audio buffer underrun while maintaining timing
-            if (frame_duration_ms > 0 && frame_duration_ms < 50) {
-                vTaskDelay(pdMS_TO_TICKS(frame_duration_ms * 6 / 10));
-            }
+            update_audio_clock(extractor, pts, buffer_size);
         }
         return ret;
     }
@@ -608,22 +831,17 @@ static esp_err_t process_audio_frame(app_extractor_t *extractor, uint8_t *buffer
                     return open_ret;
                 }
                 extractor->audio_dev_opened = true;
+                audio_pacer_reset(&extractor->audio_pacer, extractor->audio_sample_rate,
+                                  extractor->audio_channels, extractor->audio_bits);
                 ESP_LOGI(TAG, "Audio device opened for decoded audio: %dHz, %dch, %dbit", 
                          extractor->audio_sample_rate, extractor->audio_channels, extractor->audio_bits);
             }
 
-            esp_err_t write_ret = esp_codec_dev_write(extractor->audio_dev, out_frame.buffer, out_frame.decoded_size);
+            esp_err_t write_ret = audio_pacer_write(&extractor->audio_pacer, extractor->audio_dev,
+                                                    out_frame.buffer, out_frame.decoded_size);
             total_decoded += out_frame.decoded_size;
-
-            // Optimized timing control for decoded audio
             if (write_ret == ESP_OK) {
-                uint32_t bytes_per_sample = extractor->audio_channels * (extractor->audio_bits / 8);
-                uint32_t decoded_duration_ms = (out_frame.decoded_size * 1000) / (extractor->audio_sample_rate * bytes_per_sample);
-
-                // Use 40% delay for decoded audio to balance timing and responsiveness
-                if (decoded_duration_ms > 0 && decoded_duration_ms < 50) {
-                    vTaskDelay(pdMS_TO_TICKS(decoded_duration_ms * 4 / 10));
-                }
+                update_audio_clock(extractor, pts, total_decoded);
             }
         }
 
@@ -650,6 +868,7 @@ static esp_err_t process_frame(extractor_frame_info_t *frame, app_extractor_t *e
     }
 
     esp_err_t ret = ESP_OK;
+    bool retained = false;
 
     switch (frame->stream_type) {
     case EXTRACTOR_STREAM_TYPE_VIDEO:
@@ -659,9 +878,10 @@ static esp_err_t process_frame(extractor_frame_info_t *frame, app_extractor_t *e
 
         if (extractor->extract_video && frame->frame_buffer &&
                 frame->frame_size > 0 && extractor->frame_cb) {
-
-            control_frame_rate(extractor);
+            // Pacing happens downstream in the stream adapter's present stage.
+            // On success the callback keeps the pool buffer until it has been decoded.
             ret = extractor->frame_cb(frame->frame_buffer, frame->frame_size, true, frame->pts);
+            retained = (ret == ESP_OK);
         }
         break;
 
@@ -670,23 +890,10 @@ static esp_err_t process_frame(extractor_frame_info_t *frame, app_extractor_t *e
             extractor->last_audio_pts = frame->pts;
         }
 
-        if (extractor->extract_audio && extractor->audio_dev &&
+        if (extractor->extract_audio && extractor->audio_dev && !extractor->audio_muted &&
                 frame->frame_buffer && frame->frame_size > 0) {
 
-            // Optimized audio frame queuing
-            audio_frame_item_t *frame_item = malloc(sizeof(audio_frame_item_t) + frame->frame_size);
-            if (frame_item) {
-                frame_item->buffer = (uint8_t*)(frame_item + 1);  // Buffer follows struct
-                frame_item->size = frame->frame_size;
-                frame_item->pts = frame->pts;
-                memcpy(frame_item->buffer, frame->frame_buffer, frame->frame_size);
-
-                if (xQueueSend(extractor->audio_queue, &frame_item, 0) != pdTRUE) {
-                    free(frame_item);  // Drop frame if queue full
-                }
-            } else {
-                ESP_LOGW(TAG, "Audio frame memory allocation failed");
-            }
+            queue_audio_frame(extractor, frame->frame_buffer, frame->frame_size, frame->pts);
         }
         break;
 
@@ -695,7 +902,7 @@ static esp_err_t process_frame(extractor_frame_info_t *frame, app_extractor_t *e
     }
 
     // Release frame buffer
-    if (frame->frame_buffer) {
+    if (frame->frame_buffer && !retained) {
         mem_pool_free(esp_extractor_get_output_pool(extractor->extractor), frame->frame_buffer);
     }
 
@@ -706,7 +913,8 @@ static esp_err_t process_frame(extractor_frame_info_t *frame, app_extractor_t *e
  * @brief Validate MPEG format compatibility for ESP32-P4
  *
  * This function ensures that only MPEG-compatible formats are processed:
- * - Video: MJPEG only (ESP32-P4 hardware JPEG decoder limitation)
+ * - Video: MJPEG (hardware JPEG decoder), and H.264 within the software decoder's
+ *   size limit when CONFIG_VIDEO_H264_DECODE is set
  * - Audio: MPEG-related formats (AAC, MP3, etc.)
  *
  * @param extractor App extractor handle
@@ -720,8 +928,20 @@ static esp_err_t validate_mpeg_compatibility(app_extractor_t *extractor)
             break;
 
         case EXTRACTOR_VIDEO_FORMAT_H264:
+#if CONFIG_VIDEO_H264_DECODE
+            // Decoded in software: larger pictures would only play late
+            if (extractor->video_width > CONFIG_VIDEO_H264_MAX_WIDTH ||
+                    extractor->video_height > CONFIG_VIDEO_H264_MAX_HEIGHT) {
+                ESP_LOGE(TAG, "H.264 at %ux%u exceeds the %ux%u limit - scale it down or use MJPEG",
+                         extractor->video_width, extractor->video_height,
+                         CONFIG_VIDEO_H264_MAX_WIDTH, CONFIG_VIDEO_H264_MAX_HEIGHT);
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            break;
+#else
             ESP_LOGE(TAG, "H.264 format not supported - use MJPEG instead");
             return ESP_ERR_NOT_SUPPORTED;
+#endif
 
         default:
             ESP_LOGE(TAG, "Unsupported video format %d", extractor->video_format);
@@ -783,6 +1003,7 @@ static esp_err_t get_stream_info(app_extractor_t *extractor)
             extractor->audio_channels = audio_info->channel;
             extractor->audio_bits = audio_info->bits_per_sample;
             extractor->audio_duration = stream_info.duration;
+            extractor->audio_bitrate = stream_info.bitrate;
         }
     } else {
         extractor->has_audio = false;
@@ -799,6 +1020,17 @@ static esp_err_t get_stream_info(app_extractor_t *extractor)
         extractor_video_stream_info_t *video_info = &stream_info.stream_info.video_info;
         extractor->has_video = true;
         extractor->video_format = video_info->format;
+        free(extractor->video_spec_info);
+        extractor->video_spec_info = NULL;
+        extractor->video_spec_info_len = 0;
+        if (stream_info.spec_info != NULL && stream_info.spec_info_len > 0) {
+            extractor->video_spec_info = malloc(stream_info.spec_info_len);
+            if (extractor->video_spec_info == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
+            memcpy(extractor->video_spec_info, stream_info.spec_info, stream_info.spec_info_len);
+            extractor->video_spec_info_len = stream_info.spec_info_len;
+        }
         extractor->video_width = video_info->width;
         extractor->video_height = video_info->height;
         extractor->video_fps = video_info->fps;
@@ -836,7 +1068,8 @@ esp_err_t app_extractor_init(app_extractor_frame_cb_t frame_cb,
 #if CONFIG_HDMI_VIDEO_SYNC_ENABLED
     extractor->sync_enabled = true;
     extractor->sync_threshold_ms = HDMI_SYNC_THRESHOLD_MS;
-    extractor->base_time = esp_timer_get_time() / 1000;
+    extractor->audio_clock_ms = 0;
+    extractor->audio_clock_us = 0;
     extractor->sync_mutex = xSemaphoreCreateMutex();
 #else
     extractor->sync_enabled = false;
@@ -851,37 +1084,14 @@ esp_err_t app_extractor_init(app_extractor_frame_cb_t frame_cb,
     // Initialize audio task variables
     extractor->audio_task_handle = NULL;
     extractor->audio_task_running = false;
-    extractor->audio_queue = NULL;
-
-    // Frame rate control initialization
-    extractor->frame_interval_ms = 33;  // Default ~30 FPS
-    extractor->last_frame_time = 0;
 
     // Initialize audio state flags
     extractor->audio_dev_opened = false;
     extractor->audio_decoder_configured = false;
 
-    // Create audio queue if audio device is provided
-    if (audio_dev) {
-        extractor->audio_queue = xQueueCreate(AUDIO_QUEUE_SIZE, sizeof(audio_frame_item_t*));
-        if (extractor->audio_queue == NULL) {
-            ESP_LOGE(TAG, "Failed to create audio queue");
-#if CONFIG_HDMI_VIDEO_SYNC_ENABLED
-            if (extractor->sync_mutex) {
-                vSemaphoreDelete(extractor->sync_mutex);
-            }
-#endif
-            free(extractor);
-            return ESP_ERR_NO_MEM;
-        }
-    }
-
-    esp_err_t ret = register_all_extractors();
+    esp_err_t ret = s_extractor_users > 0 ? ESP_OK : register_all_extractors();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to register extractors: %d", ret);
-        if (extractor->audio_queue) {
-            vQueueDelete(extractor->audio_queue);
-        }
 #if CONFIG_HDMI_VIDEO_SYNC_ENABLED
         if (extractor->sync_mutex) {
             vSemaphoreDelete(extractor->sync_mutex);
@@ -891,13 +1101,10 @@ esp_err_t app_extractor_init(app_extractor_frame_cb_t frame_cb,
         return ret;
     }
 
-    if (audio_dev != NULL) {
+    if (audio_dev != NULL && s_extractor_users == 0) {
         ret = register_audio_decoders();
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "Failed to register audio decoders: %d", ret);
-            if (extractor->audio_queue) {
-                vQueueDelete(extractor->audio_queue);
-            }
 #if CONFIG_HDMI_VIDEO_SYNC_ENABLED
             if (extractor->sync_mutex) {
                 vSemaphoreDelete(extractor->sync_mutex);
@@ -908,16 +1115,17 @@ esp_err_t app_extractor_init(app_extractor_frame_cb_t frame_cb,
         }
     }
 
+    s_extractor_users++;
     ESP_LOGI(TAG, "App extractor initialized with %s audio support",
              audio_dev ? "hardware" : "no");
     *ret_extractor = extractor;
     return ESP_OK;
 }
 
-esp_err_t app_extractor_start(app_extractor_handle_t handle,
-                              const char *filename,
-                              bool extract_video,
-                              bool extract_audio)
+esp_err_t app_extractor_prepare(app_extractor_handle_t handle,
+                                const char *filename,
+                                bool extract_video,
+                                bool extract_audio)
 {
     if (handle == NULL || filename == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -926,7 +1134,16 @@ esp_err_t app_extractor_start(app_extractor_handle_t handle,
     app_extractor_t *extractor = (app_extractor_t *)handle;
     esp_err_t ret;
 
+    // Only good for this open, whatever its outcome
+    esp_extractor_resume_info_t *resume_info = extractor->resume_info;
+    extractor->resume_info = NULL;
+    extractor->resumed = false;
+    uint32_t max_frame_size = extractor->max_frame_size;
+    uint32_t output_pool_size = output_pool_size_for(max_frame_size);
+    extractor->max_frame_size = 0;
+
     // Close any existing extractor
+    extractor->prepared = false;
     if (extractor->extractor != NULL) {
         esp_extractor_close(extractor->extractor);
         extractor->extractor = NULL;
@@ -947,9 +1164,13 @@ esp_err_t app_extractor_start(app_extractor_handle_t handle,
     extractor->extract_video = extract_video;
     extractor->extract_audio = extract_audio && (extractor->audio_dev != NULL);
     extractor->eos_reached = false;
+    extractor->audio_muted = false;
+    extractor->loop_offset_ms = 0;
+    extractor->loop_frames = 0;
     extractor->last_video_pts = 0;
     extractor->last_audio_pts = 0;
-    extractor->last_frame_time = esp_timer_get_time() / 1000;
+    memset(&extractor->read_stats, 0, sizeof(extractor->read_stats));
+    reset_audio_clock(extractor);
 
     // Reset audio state flags for new file
     extractor->audio_dev_opened = false;
@@ -974,7 +1195,9 @@ esp_err_t app_extractor_start(app_extractor_handle_t handle,
         .extract_mask = extract_mask,
         .url = (char *)filename,  // Cast to match the API
         .input_ctx = extractor,
-        .output_pool_size = EXTRACTOR_POOL_SIZE,     // Set output pool size
+        .output_pool_size = output_pool_size,
+        .output_align = image_buffer_get_alignment(),  // Frames are decoded in place by the JPEG engine
+        .wait_for_output = true,                     // Block demux until decode returns a frame
         .cache_block_num = EXTRACTOR_POOL_BLOCKS,    // Set number of cache blocks
         .cache_block_size = EXTRACTOR_POOL_SIZE / EXTRACTOR_POOL_BLOCKS  // Set cache block size
     };
@@ -986,8 +1209,21 @@ esp_err_t app_extractor_start(app_extractor_handle_t handle,
         return ret;
     }
 
+    // Resume info restores the streams and sample tables of an earlier open, the
+    // parse then has nothing left to do
+    if (resume_info != NULL) {
+        ret = esp_extractor_set_resume_info(extractor->extractor, resume_info);
+        extractor->resumed = ret == ESP_EXTR_ERR_OK;
+        if (!extractor->resumed) {
+            ESP_LOGW(TAG, "Resume info rejected (%d), parsing %s", ret, filename);
+        }
+    }
+
     // Parse stream information
     ret = esp_extractor_parse_stream_info(extractor->extractor);
+    if (ret == ESP_EXTR_ERR_ALREADY_PARSED) {
+        ret = ESP_OK;
+    }
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to parse stream info: %d", ret);
         return ret;
@@ -1007,12 +1243,56 @@ esp_err_t app_extractor_start(app_extractor_handle_t handle,
         return ret;
     }
 
-    // Calculate optimal frame interval based on video fps
-    if (extractor->has_video && extractor->video_fps > 0) {
-        extractor->frame_interval_ms = 1000 / extractor->video_fps;
-    } else {
-        extractor->frame_interval_ms = 1000 / DEFAULT_VIDEO_FPS;
+    if (extractor->extract_audio) {
+        ret = alloc_audio_ring(extractor);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        // Probe the decoder now rather than on the first audio frame; a failure
+        // only costs the audio, as it would during playback
+        if (extractor->audio_format != EXTRACTOR_AUDIO_FORMAT_PCM && init_audio_decoder(extractor) != ESP_OK) {
+            ESP_LOGW(TAG, "No decoder for audio format %d", extractor->audio_format);
+        }
+    }
+
+    if (output_pool_size < EXTRACTOR_OUTPUT_POOL_SIZE) {
+        ESP_LOGI(TAG, "Output pool %u KB for frames up to %u KB, %u KB below the default",
+                 output_pool_size / 1024, max_frame_size / 1024,
+                 (EXTRACTOR_OUTPUT_POOL_SIZE - output_pool_size) / 1024);
+    }
+
+    free(extractor->url);
+    extractor->url = strdup(filename);
+    extractor->prepared = extractor->url != NULL;
+    ESP_LOGI(TAG, "Prepared %s%s: fps=%u, audio=%s", filename, extractor->resumed ? " from resume info" : "",
+             extractor->video_fps, extractor->extract_audio ? "yes" : "no");
+    return ESP_OK;
+}
+
+esp_err_t app_extractor_start(app_extractor_handle_t handle,
+                              const char *filename,
+                              bool extract_video,
+                              bool extract_audio)
+{
+    if (handle == NULL || filename == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_extractor_t *extractor = (app_extractor_t *)handle;
+    esp_err_t ret;
+
+    // Reuse a prepared open of the same file, frames read since stay queued
+    bool prepared = extractor->prepared && strcmp(extractor->url, filename) == 0 &&
+                    extractor->extract_video == extract_video &&
+                    extractor->extract_audio == (extract_audio && extractor->audio_dev != NULL);
+    if (!prepared) {
+        ret = app_extractor_prepare(handle, filename, extract_video, extract_audio);
+        if (ret != ESP_OK) {
+            return ret;
+        }
     }
+    extractor->prepared = false;
+    extractor->resume_info = NULL;
 
     // Start audio processing if needed
     if (extractor->extract_audio) {
@@ -1023,8 +1303,68 @@ esp_err_t app_extractor_start(app_extractor_handle_t handle,
         }
     }
 
-    ESP_LOGI(TAG, "Extraction started: fps=%dms, audio=%s",
-             extractor->frame_interval_ms, extractor->extract_audio ? "yes" : "no");
+    ESP_LOGI(TAG, "Extraction started%s: fps=%u, audio=%s", prepared ? " from prepared file" : "",
+             extractor->video_fps, extractor->extract_audio ? "yes" : "no");
+    return ESP_OK;
+}
+
+void app_extractor_set_frame_cb(app_extractor_handle_t handle, app_extractor_frame_cb_t frame_cb)
+{
+    if (handle != NULL) {
+        ((app_extractor_t *)handle)->frame_cb = frame_cb;
+    }
+}
+
+static esp_err_t read_next_frame(app_extractor_t *extractor)
+{
+    extractor_frame_info_t frame = {0};
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = esp_extractor_read_frame(extractor->extractor, &frame);
+
+    if (ret == ESP_OK) {
+        uint32_t read_us = (uint32_t)(esp_timer_get_time() - start_us);
+        app_extractor_read_stats_t *stats = &extractor->read_stats;
+        stats->frames++;
+        stats->bytes += frame.frame_size;
+        stats->read_us += read_us;
+        if (read_us > stats->read_us_max) {
+            stats->read_us_max = read_us;
+        }
+        if (!frame.eos) {
+            frame.pts += extractor->loop_offset_ms;
+            extractor->loop_frames++;
+        }
+        ret = process_frame(&frame, extractor);
+    } else {
+        extractor->eos_reached = true;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Start the next pass of a looping file from its first frame
+ *
+ * The parsed streams, pools, audio decoder and device all stay as they are, and
+ * the audio queued from the end of the pass plays out. Later frames carry PTS
+ * offset by the length of the passes before, so clocks downstream keep running.
+ */
+static esp_err_t restart_loop(app_extractor_t *extractor)
+{
+    uint32_t interval_ms = 1000 / (extractor->video_fps > 0 ? extractor->video_fps : DEFAULT_VIDEO_FPS);
+    uint32_t end_ms = extractor->last_video_pts + interval_ms;
+    if (extractor->last_audio_pts > end_ms) {
+        end_ms = extractor->last_audio_pts;
+    }
+
+    esp_err_t ret = esp_extractor_seek(extractor->extractor, 0);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to loop back to the start: %d", ret);
+        return ret;
+    }
+    extractor->loop_offset_ms = end_ms;
+    extractor->loop_frames = 0;
+    extractor->eos_reached = false;
     return ESP_OK;
 }
 
@@ -1044,16 +1384,91 @@ esp_err_t app_extractor_read_frame(app_extractor_handle_t handle)
         return ESP_ERR_INVALID_STATE;
     }
 
-    extractor_frame_info_t frame = {0};
-    esp_err_t ret = esp_extractor_read_frame(extractor->extractor, &frame);
+    esp_err_t ret = read_next_frame(extractor);
+    // A pass without a single frame means the file cannot be read, not that it ended
+    if (extractor->eos_reached && extractor->loop && extractor->loop_frames > 0 &&
+            restart_loop(extractor) == ESP_OK) {
+        ret = read_next_frame(extractor);
+    }
+    return ret;
+}
 
-    if (ret == ESP_OK) {
-        ret = process_frame(&frame, extractor);
-    } else {
-        extractor->eos_reached = true;
+void app_extractor_release_frame(app_extractor_handle_t handle, uint8_t *buffer)
+{
+    if (handle == NULL || buffer == NULL) {
+        return;
     }
 
-    return ret;
+    app_extractor_t *extractor = (app_extractor_t *)handle;
+    if (extractor->extractor == NULL) {
+        ESP_LOGW(TAG, "Frame released after extractor close");
+        return;
+    }
+
+    mem_pool_free(esp_extractor_get_output_pool(extractor->extractor), buffer);
+}
+
+esp_err_t app_extractor_get_audio_clock(app_extractor_handle_t handle, uint32_t *pts_ms, int64_t *updated_us)
+{
+    if (handle == NULL || pts_ms == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_extractor_t *extractor = (app_extractor_t *)handle;
+
+    if (!extractor->sync_enabled || extractor->sync_mutex == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    xSemaphoreTake(extractor->sync_mutex, portMAX_DELAY);
+    uint32_t clock_ms = extractor->audio_clock_ms;
+    int64_t clock_us = extractor->audio_clock_us;
+    xSemaphoreGive(extractor->sync_mutex);
+
+    if (clock_us == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *pts_ms = clock_ms;
+    if (updated_us) {
+        *updated_us = clock_us;
+    }
+    return ESP_OK;
+}
+
+esp_err_t app_extractor_get_read_stats(app_extractor_handle_t handle, app_extractor_read_stats_t *stats)
+{
+    if (handle == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_extractor_t *extractor = (app_extractor_t *)handle;
+    *stats = extractor->read_stats;
+    return ESP_OK;
+}
+
+esp_err_t app_extractor_get_audio_stats(app_extractor_handle_t handle, app_extractor_audio_stats_t *stats)
+{
+    if (handle == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_extractor_t *extractor = (app_extractor_t *)handle;
+
+    memset(stats, 0, sizeof(*stats));
+    if (extractor->audio_ring.buffer != NULL) {
+        stats->ring_size = extractor->audio_ring.capacity;
+        stats->ring_used = spsc_byte_ring_used(&extractor->audio_ring);
+    }
+    stats->ring_peak = extractor->audio_ring_peak;
+    stats->max_frame_size = extractor->audio_max_frame_size;
+    stats->underruns = extractor->audio_underruns;
+    stats->overflows = extractor->audio_overflows;
+    stats->buffered_ms = audio_pacer_buffered_ms(&extractor->audio_pacer);
+    stats->min_buffered_ms = extractor->audio_pacer.min_buffered_ms == UINT32_MAX ?
+                             0 : extractor->audio_pacer.min_buffered_ms;
+    stats->xruns = extractor->audio_pacer.xruns;
+    return ESP_OK;
 }
 
 esp_err_t app_extractor_get_video_info(app_extractor_handle_t handle,
@@ -1088,6 +1503,34 @@ esp_err_t app_extractor_get_video_info(app_extractor_handle_t handle,
     return ESP_OK;
 }
 
+esp_err_t app_extractor_get_video_codec(app_extractor_handle_t handle,
+                                        extractor_video_format_t *format,
+                                        const uint8_t **spec_info,
+                                        uint32_t *spec_info_len)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_extractor_t *extractor = (app_extractor_t *)handle;
+
+    if (!extractor->has_video) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (format) {
+        *format = extractor->video_format;
+    }
+    if (spec_info) {
+        *spec_info = extractor->video_spec_info;
+    }
+    if (spec_info_len) {
+        *spec_info_len = extractor->video_spec_info_len;
+    }
+
+    return ESP_OK;
+}
+
 esp_err_t app_extractor_get_audio_info(app_extractor_handle_t handle,
                                        uint32_t *sample_rate,
                                        uint8_t *channels,
@@ -1132,13 +1575,82 @@ esp_err_t app_extractor_seek(app_extractor_handle_t handle, uint32_t position)
         return ESP_ERR_INVALID_STATE;
     }
 
-    // Reset EOS flag when seeking
+    // Reset EOS flag, the loop pass and the audio clock when seeking
     extractor->eos_reached = false;
+    extractor->loop_offset_ms = 0;
+    extractor->loop_frames = 0;
+    reset_audio_clock(extractor);
 
     // Seek to the specified position (in milliseconds)
     return esp_extractor_seek(extractor->extractor, position);
 }
 
+void app_extractor_set_resume_info(app_extractor_handle_t handle, esp_extractor_resume_info_t *info)
+{
+    if (handle != NULL) {
+        ((app_extractor_t *)handle)->resume_info = info;
+    }
+}
+
+void app_extractor_set_max_frame_size(app_extractor_handle_t handle, uint32_t max_frame_size)
+{
+    if (handle != NULL) {
+        ((app_extractor_t *)handle)->max_frame_size = max_frame_size;
+    }
+}
+
+void app_extractor_set_audio_muted(app_extractor_handle_t handle, bool muted)
+{
+    if (handle == NULL) {
+        return;
+    }
+
+    app_extractor_t *extractor = (app_extractor_t *)handle;
+    extractor->audio_muted = muted;
+    // Let the audio task empty the ring now instead of on the next queued frame
+    TaskHandle_t task = extractor->audio_task_handle;
+    if (muted && task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void app_extractor_set_loop(app_extractor_handle_t handle, bool loop)
+{
+    if (handle != NULL) {
+        ((app_extractor_t *)handle)->loop = loop;
+    }
+}
+
+uint32_t app_extractor_get_loop_offset(app_extractor_handle_t handle)
+{
+    return handle != NULL ? ((app_extractor_t *)handle)->loop_offset_ms : 0;
+}
+
+bool app_extractor_is_resumed(app_extractor_handle_t handle)
+{
+    return handle != NULL && ((app_extractor_t *)handle)->resumed;
+}
+
+esp_err_t app_extractor_get_resume_info(app_extractor_handle_t handle, esp_extractor_resume_info_t *info)
+{
+    if (handle == NULL || info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_extractor_t *extractor = (app_extractor_t *)handle;
+    if (extractor->extractor == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memset(info, 0, sizeof(*info));
+    esp_extr_err_t ret = esp_extractor_get_resume_info(extractor->extractor, info);
+    if (ret != ESP_EXTR_ERR_OK) {
+        ESP_LOGW(TAG, "Failed to get resume info: %d", ret);
+        return ret == ESP_EXTR_ERR_NO_MEM ? ESP_ERR_NO_MEM : ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
 esp_err_t app_extractor_stop(app_extractor_handle_t handle)
 {
     if (handle == NULL) {
@@ -1167,6 +1679,13 @@ esp_err_t app_extractor_stop(app_extractor_handle_t handle)
     }
 
     extractor->eos_reached = true;
+    extractor->prepared = false;
+    extractor->resume_info = NULL;
+    free(extractor->video_spec_info);
+    extractor->video_spec_info = NULL;
+    extractor->video_spec_info_len = 0;
+    extractor->resumed = false;
+    reset_audio_clock(extractor);
 
     // Close the audio decoder to release resources and avoid format mismatch
     if (extractor->audio_decoder_open) {
@@ -1204,12 +1723,6 @@ esp_err_t app_extractor_deinit(app_extractor_handle_t handle)
         extractor->audio_buffer = NULL;
     }
 
-    // Delete audio queue
-    if (extractor->audio_queue != NULL) {
-        vQueueDelete(extractor->audio_queue);
-        extractor->audio_queue = NULL;
-    }
-
     // Delete sync mutex
 #if CONFIG_HDMI_VIDEO_SYNC_ENABLED
     if (extractor->sync_mutex != NULL) {
@@ -1218,10 +1731,13 @@ esp_err_t app_extractor_deinit(app_extractor_handle_t handle)
     }
 #endif
 
-    // Unregister all extractors
-    esp_extractor_unregister_all();
+    // Unregister all extractors once the last user is gone
+    if (--s_extractor_users == 0) {
+        esp_extractor_unregister_all();
+    }
 
     // Free context
+    free(extractor->url);
     free(extractor);
 
     ESP_LOGI(TAG, "App extractor deinitialized");
@@ -9,6 +9,7 @@
 #include "esp_err.h"
 #include "esp_extractor.h"
 #include "esp_codec_dev.h"
+#include "read_ahead.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,16 +20,30 @@ extern "C" {
 
 /* A/V Sync Configuration */
 #define HDMI_SYNC_THRESHOLD_MS          (50)
+#define AUDIO_CLOCK_STALE_MS            (200)   // Audio clock older than this no longer drives video
 
 /* Memory pool configuration */
 #define EXTRACTOR_POOL_SIZE             (512 * 1024)
 #define EXTRACTOR_POOL_BLOCKS           (3)
 
+/* Output pool holding compressed frames until the JPEG engine has consumed them.
+ * Sized for several in-flight 1080p MJPEG frames; it is also the frame size limit. */
+#define EXTRACTOR_OUTPUT_POOL_SIZE      (1536 * 1024)
+
+/* With the largest frame of a clip known, its pool holds this many of them: the
+ * stream adapter's demux ring, the frame being read and the one being decoded,
+ * plus room for the audio read in between. */
+#define EXTRACTOR_OUTPUT_POOL_FRAMES    (5)
+#define EXTRACTOR_OUTPUT_POOL_AUDIO     (64 * 1024)
+
 /* Audio Task Configuration  */
 #define AUDIO_TASK_PRIORITY             (7)
 #define AUDIO_TASK_STACK_SIZE           (4 * 1024)
-#define AUDIO_QUEUE_SIZE                (6)
-#define AUDIO_QUEUE_TIMEOUT_MS          (50)
+// Video is paced by the stream adapter's present stage, so demux may run a few
+// video frames ahead; the audio ring holds this many worst-case compressed frames
+// to absorb the audio interleaved with them
+#define AUDIO_RING_FRAMES               (16)
+#define AUDIO_QUEUE_TIMEOUT_MS          (50)    // Longest demux waits for audio ring space
 
 /* Frame Rate Control */
 #define DEFAULT_VIDEO_FPS               (25)
@@ -38,8 +53,42 @@ extern "C" {
  */
 typedef struct app_extractor_t* app_extractor_handle_t;
 
+/**
+ * @brief Audio path statistics: compressed ring and I2S output
+ */
+typedef struct {
+    uint32_t ring_size;          /*!< Ring capacity in bytes (0 when audio is not running) */
+    uint32_t ring_used;          /*!< Bytes currently queued */
+    uint32_t ring_peak;          /*!< Highest ring_used since start */
+    uint32_t max_frame_size;     /*!< Worst-case frame size the ring was sized for */
+    uint32_t underruns;          /*!< Times the audio task ran out of frames mid-stream */
+    uint32_t overflows;          /*!< Frames dropped because the ring stayed full */
+    uint32_t buffered_ms;        /*!< PCM queued in the I2S DMA ahead of the speaker */
+    uint32_t min_buffered_ms;    /*!< Lowest I2S fill level seen before a write */
+    uint32_t xruns;              /*!< Times the I2S DMA ran dry and played silence */
+} app_extractor_audio_stats_t;
+
+/**
+ * @brief Demux read statistics since the file was opened
+ *
+ * Reads cover the whole esp_extractor_read_frame() call, card I/O and container
+ * parsing included, for audio and video frames alike.
+ */
+typedef struct {
+    uint32_t frames;             /*!< Frames read */
+    uint64_t bytes;              /*!< Compressed payload of those frames */
+    uint64_t read_us;            /*!< Total time spent reading them */
+    uint32_t read_us_max;        /*!< Slowest single read */
+    read_ahead_stats_t card;     /*!< Card loads behind those reads, zero without read-ahead */
+} app_extractor_read_stats_t;
+
 /**
  * @brief Frame callback function
+ *
+ * Video buffers come straight from the extractor output pool, aligned for the
+ * JPEG engine. Returning ESP_OK for a video frame hands the buffer over to the
+ * callee, which must give it back with app_extractor_release_frame(); on error
+ * the extractor frees it. Audio is not delivered through this callback.
  */
 typedef esp_err_t (*app_extractor_frame_cb_t)(uint8_t *buffer, uint32_t buffer_size,
                                               bool is_video, uint32_t pts);
@@ -51,19 +100,74 @@ esp_err_t app_extractor_init(app_extractor_frame_cb_t frame_cb,
                              esp_codec_dev_handle_t audio_dev,
                              app_extractor_handle_t *ret_extractor);
 
+/**
+ * @brief Open a media file without starting playback
+ *
+ * Parses the container and stream info, probes the audio decoder and allocates
+ * the audio ring, so frames may be read ahead; audio read this way is played
+ * once app_extractor_start() is called for the same file. The audio device is
+ * left alone, another extractor may be playing through it.
+ */
+esp_err_t app_extractor_prepare(app_extractor_handle_t extractor,
+                                const char *filename,
+                                bool extract_video,
+                                bool extract_audio);
+
 /**
  * @brief Start extracting from media file
+ *
+ * Picks up where app_extractor_prepare() left off if it opened the same file,
+ * otherwise opens it first.
  */
 esp_err_t app_extractor_start(app_extractor_handle_t extractor,
                               const char *filename,
                               bool extract_video,
                               bool extract_audio);
 
+/**
+ * @brief Change the callback frames are delivered to
+ *
+ * Only call while no other task reads frames from this extractor.
+ */
+void app_extractor_set_frame_cb(app_extractor_handle_t extractor, app_extractor_frame_cb_t frame_cb);
+
 /**
  * @brief Read next frame
  */
 esp_err_t app_extractor_read_frame(app_extractor_handle_t extractor);
 
+/**
+ * @brief Return a video frame buffer taken over by the frame callback
+ *
+ * Safe to call from another task than the one reading frames. Must be called
+ * for every retained buffer before app_extractor_stop().
+ */
+void app_extractor_release_frame(app_extractor_handle_t extractor, uint8_t *buffer);
+
+/**
+ * @brief Get the audio master clock
+ *
+ * The clock is the PTS at the end of the last audio samples accepted by the
+ * codec, and updated_us the esp_timer time they were written.
+ *
+ * @return ESP_ERR_NOT_SUPPORTED if A/V sync is disabled,
+ *         ESP_ERR_INVALID_STATE until audio has been written since start or seek
+ */
+esp_err_t app_extractor_get_audio_clock(app_extractor_handle_t extractor,
+                                        uint32_t *pts_ms, int64_t *updated_us);
+
+/**
+ * @brief Get audio ring and I2S output statistics
+ */
+esp_err_t app_extractor_get_audio_stats(app_extractor_handle_t extractor,
+                                        app_extractor_audio_stats_t *stats);
+
+/**
+ * @brief Get demux read statistics
+ */
+esp_err_t app_extractor_get_read_stats(app_extractor_handle_t extractor,
+                                       app_extractor_read_stats_t *stats);
+
 /**
  * @brief Get video stream info
  */
@@ -71,6 +175,17 @@ esp_err_t app_extractor_get_video_info(app_extractor_handle_t extractor,
                                        uint32_t *width, uint32_t *height,
                                        uint32_t *fps, uint32_t *duration);
 
+/**
+ * @brief Get the video codec and its codec record (avcC for H.264 in MP4)
+ *
+ * spec_info is NULL when the track has no record; it stays valid until the
+ * file is stopped.
+ */
+esp_err_t app_extractor_get_video_codec(app_extractor_handle_t extractor,
+                                        extractor_video_format_t *format,
+                                        const uint8_t **spec_info,
+                                        uint32_t *spec_info_len);
+
 /**
  * @brief Get audio stream info
  */
@@ -83,6 +198,65 @@ esp_err_t app_extractor_get_audio_info(app_extractor_handle_t extractor,
  */
 esp_err_t app_extractor_seek(app_extractor_handle_t extractor, uint32_t position);
 
+/**
+ * @brief Drop audio instead of playing it, for playback away from normal speed
+ *
+ * While muted, demux discards audio frames and the audio task drops what was
+ * already queued, so the audio clock goes stale. Unmuting plays audio again
+ * from the demux position. Opening a file unmutes.
+ */
+void app_extractor_set_audio_muted(app_extractor_handle_t extractor, bool muted);
+
+/**
+ * @brief Wrap around to the first frame at the end of the file instead of ending
+ *
+ * Reading carries on from the start without reopening anything: the parsed
+ * streams, output pool, audio decoder and device stay as they are. Frames of
+ * each new pass carry PTS offset by the length of the passes before, so the
+ * stream looks endless and its clocks only move forward. Takes effect at the
+ * next end of the file.
+ */
+void app_extractor_set_loop(app_extractor_handle_t extractor, bool loop);
+
+/**
+ * @brief PTS offset of the pass being read, 0 before the first wrap and after a seek
+ *
+ * Call from the task reading frames to match it to the frames read.
+ */
+uint32_t app_extractor_get_loop_offset(app_extractor_handle_t extractor);
+
+/**
+ * @brief Set up the next file opened from saved resume info
+ *
+ * The next app_extractor_prepare() or app_extractor_start() that opens a file
+ * restores its streams and sample tables from info instead of parsing the
+ * container, and starts wherever info was taken. info must stay valid until
+ * that call returns; a rejected info falls back to a full parse.
+ */
+void app_extractor_set_resume_info(app_extractor_handle_t extractor, esp_extractor_resume_info_t *info);
+
+/**
+ * @brief Size the output pool of the next file opened to its largest video frame
+ *
+ * Applies to the next app_extractor_prepare() or app_extractor_start() that
+ * opens a file, like app_extractor_set_resume_info(). Without it, or with 0,
+ * the pool is EXTRACTOR_OUTPUT_POOL_SIZE, the limit for any frame.
+ */
+void app_extractor_set_max_frame_size(app_extractor_handle_t extractor, uint32_t max_frame_size);
+
+/**
+ * @brief Check whether the open file was set up from resume info
+ */
+bool app_extractor_is_resumed(app_extractor_handle_t extractor);
+
+/**
+ * @brief Take the resume info of the open file
+ *
+ * Release it with esp_extractor_free_resume_info().
+ */
+esp_err_t app_extractor_get_resume_info(app_extractor_handle_t extractor,
+                                        esp_extractor_resume_info_t *info);
+
 /**
  * @brief Stop extraction
  */
@@ -19,7 +19,18 @@
 
 #include "app_stream_adapter.h"
 #include "app_extractor.h"
+#include "frame_index.h"
+#include "resume_store.h"
+#include "mp4_layout.h"
+#include "spsc_ring.h"
+#include "frame_pool.h"
+#include "jpeg_sched.h"
+#include "frame_hash.h"
+#include "h264_decoder.h"
+#include "yuv_convert.h"
+#include "image_buffer.h"
 #include "driver/jpeg_decode.h"
+#include "esp_cache.h"
 
 static const char *TAG = "stream_adapter";
 
@@ -49,6 +60,12 @@ esp_err_t shared_jpeg_decoder_init(void)
         return ESP_OK;
     }
 
+    // Decodes on the engine are scheduled by class, whoever holds a reference
+    esp_err_t ret = jpeg_sched_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
     // Create mutex for thread safety
     g_shared_jpeg.mutex = xSemaphoreCreateMutex();
     if (g_shared_jpeg.mutex == NULL) {
@@ -62,7 +79,7 @@ esp_err_t shared_jpeg_decoder_init(void)
         .timeout_ms = 1000,
     };
 
-    esp_err_t ret = jpeg_new_decoder_engine(&decode_eng_cfg, &g_shared_jpeg.handle);
+    ret = jpeg_new_decoder_engine(&decode_eng_cfg, &g_shared_jpeg.handle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to create shared JPEG decoder: %d", ret);
         vSemaphoreDelete(g_shared_jpeg.mutex);
@@ -190,30 +207,151 @@ void shared_jpeg_free_buffer(void *ptr)
 }
 
 /* Task parameters */
-#define EXTRACT_TASK_STACK_SIZE (4 * 1024)
-#define EXTRACT_TASK_PRIORITY 6
+#define DEMUX_TASK_STACK_SIZE   (4 * 1024)
+#define DEMUX_TASK_PRIORITY     6
+#define DECODE_TASK_STACK_SIZE  (4 * 1024)
+#define DECODE_TASK_PRIORITY    6
+#define PRESENT_TASK_STACK_SIZE (4 * 1024)
+#define PRESENT_TASK_PRIORITY   6
+#define PREPARE_TASK_STACK_SIZE (4 * 1024)
+#define PREPARE_TASK_PRIORITY   4           /* Below the pipeline of the clip playing */
+#define INDEX_TASK_STACK_SIZE   (4 * 1024)
+#define INDEX_TASK_PRIORITY     3
+#define PARSE_AHEAD_STACK_SIZE  (4 * 1024)
+#define PARSE_AHEAD_PRIORITY    2           /* Below everything a clip playing now needs */
+
+/* Clips queued for app_stream_adapter_parse_ahead() at most; a scan queues the rest again */
+#define PARSE_AHEAD_QUEUE_DEPTH 64
+
+/* Longest a stage sleeps before re-checking for stop while waiting on a peer */
+#define STAGE_WAIT_MS           50
+
+/* Longest the present stage sleeps between master clock reads */
+#define PRESENT_POLL_MS         5
+
+/* End of stream waits no longer than this for audio that stopped draining */
+#define AUDIO_DRAIN_STALL_MS    500
+
+/* Window the presented frame rate is averaged over */
+#define FPS_WINDOW_MS           1000
+
+/* Share of wall time a stage must be busy for the stats dump to call it the bottleneck */
+#define BOUND_LOAD_PERCENT      70
+
+/* Late frames dropped in a row before one is decoded anyway */
+#define MAX_CONSECUTIVE_DROPS   4
+
+/* Frames read while priming a prepared clip before giving up on finding video */
+#define PREPARE_MAX_READS       64
+
+/* Longest start waits for a prepare still in progress, and priming for a buffer */
+#define PREPARE_WAIT_MS         2000
+
+/* Longest a decode waits for the JPEG engine; a slide decode takes well under this */
+#define JPEG_ENGINE_WAIT_MS     1000
+
+/* Longest a scrub waits for a frame buffer the display still holds */
+#define SCRUB_WAIT_MS           200
+
+/* Clips stopped this close to either end start from the beginning next time */
+#define RESUME_MIN_POSITION_MS  5000
+#define RESUME_END_MARGIN_MS    3000
 
 /* Event group bits for task control */
-#define EXTRACT_TASK_START_BIT      (1 << 0)  /*!< Start extraction task */
-#define EXTRACT_TASK_STOP_BIT       (1 << 1)  /*!< Stop extraction task */
-#define EXTRACT_TASK_STOPPED_BIT    (1 << 2)  /*!< Task has stopped */
-#define EXTRACT_TASK_PAUSE_BIT      (1 << 3)  /*!< Pause extraction task */
-#define EXTRACT_TASK_RESUME_BIT     (1 << 4)  /*!< Resume extraction task */
+#define EXTRACT_TASK_START_BIT      (1 << 0)  /*!< Start demux task */
+#define EXTRACT_TASK_STOP_BIT       (1 << 1)  /*!< Stop demux task */
+#define EXTRACT_TASK_STOPPED_BIT    (1 << 2)  /*!< Demux task has stopped */
+#define EXTRACT_TASK_PAUSE_BIT      (1 << 3)  /*!< Pause demux task */
+#define EXTRACT_TASK_RESUME_BIT     (1 << 4)  /*!< Resume demux task */
+#define DECODE_TASK_STOPPED_BIT     (1 << 5)  /*!< Decode task has stopped */
+#define PRESENT_TASK_STOPPED_BIT    (1 << 6)  /*!< Present task has stopped */
+#define PREPARE_TASK_DONE_BIT       (1 << 7)  /*!< Prepare task has finished, not a pipeline bit */
+#define INDEX_TASK_DONE_BIT         (1 << 8)  /*!< Index task has finished, not a pipeline bit */
+#define PARSE_AHEAD_DONE_BIT        (1 << 9)  /*!< Parse ahead task has exited, not a pipeline bit */
+
+#define PIPELINE_STOPPED_BITS       (EXTRACT_TASK_STOPPED_BIT | DECODE_TASK_STOPPED_BIT | PRESENT_TASK_STOPPED_BIT)
+#define PIPELINE_ALL_BITS           (EXTRACT_TASK_START_BIT | EXTRACT_TASK_STOP_BIT | EXTRACT_TASK_PAUSE_BIT | \
+                                     EXTRACT_TASK_RESUME_BIT | PIPELINE_STOPPED_BITS)
+
+/**
+ * @brief Compressed frame slot filled by the demux stage
+ *
+ * data is an extractor output pool buffer owned by the pipeline until the
+ * decode stage has consumed it, see app_extractor_release_frame().
+ */
+typedef struct {
+    uint8_t *data;                            /*!< JPEG bitstream */
+    uint32_t size;                            /*!< Valid bytes in data */
+    uint32_t pts;                             /*!< Presentation time in ms */
+    uint32_t hash;                            /*!< frame_hash() of data, 0 without duplicate skipping */
+    uint32_t loop_offset;                     /*!< PTS offset of the loop pass it was read in */
+} stream_packet_t;
+
+/**
+ * @brief Decoded frame queued for the present stage
+ */
+typedef struct {
+    uint8_t *buffer;                          /*!< Buffer to present: decode or SRM output */
+    frame_pool_handle_t pool;                 /*!< Pool the buffer is released to */
+    uint32_t size;                            /*!< Valid bytes in buffer */
+    uint32_t width;                           /*!< Frame width as presented */
+    uint32_t height;                          /*!< Frame height as presented */
+    uint32_t pts;                             /*!< Presentation time in ms */
+    bool held;                                /*!< Identical to the frame before: no buffer, the screen keeps that one */
+    uint32_t loop_offset;                     /*!< PTS offset of the loop pass it belongs to */
+} stream_frame_t;
+
+typedef enum {
+    PREPARE_IDLE,                             /*!< Slot empty */
+    PREPARE_BUSY,                             /*!< Prepare task running */
+    PREPARE_READY,                            /*!< Clip open with its first frame decoded */
+    PREPARE_FAILED,                           /*!< Prepare task gave up, start opens the clip itself */
+} prepare_state_t;
+
+/**
+ * @brief Next clip, opened ahead by app_stream_adapter_prepare()
+ *
+ * The prepare task opens it on a second extractor, reads up to its first video
+ * frame and decodes that into prepared_pool. Starting the same clip then swaps
+ * extractors and queues the primed frame, instead of parsing the container and
+ * waiting for the first decode with the screen stalled.
+ */
+typedef struct {
+    char filename[APP_STREAM_PATH_MAX];       /*!< Clip in the slot, written under the adapter's clip_lock */
+    bool extract_audio;
+    app_extractor_handle_t extractor;         /*!< Idle extractor the clip is opened on */
+    volatile prepare_state_t state;
+    volatile bool cancel;                     /*!< Stop priming, the slot is being discarded */
+    stream_packet_t packet;                   /*!< First video frame, held by prepare_frame_callback() */
+    stream_frame_t frame;                     /*!< Primed first frame, buffer from prepared_pool */
+    uint32_t prepare_ms;                      /*!< Time the prepare task took */
+    bool resumed;                             /*!< Opened from the clip's stored resume info */
+    uint32_t resume_ms;                       /*!< Position the clip was reopened at */
+} stream_prepared_t;
 
 /**
  * @brief Stream adapter context structure
+ *
+ * Playback runs as three tasks connected by SPSC rings:
+ * demux (extractor read) -> packet_ring -> decode (JPEG engine, then PPA SRM) -> frame_ring -> present (frame_cb).
+ * Frame buffers come from decode_pool and present_pool. Each one is acquired by the
+ * decode task and only reused after it has been released: by the display once the
+ * frame is off screen, or by the present task when the next frame is shown. So
+ * neither the decoder nor the SRM stage writes into a buffer being displayed.
  */
 typedef struct app_stream_adapter_t {
     /* Common parameters */
     app_stream_frame_cb_t frame_cb;           /*!< Frame callback function */
-    void *user_data;                          /*!< User data to be passed to frame callback */
-    void **decode_buffers;                    /*!< Array of frame buffer pointers */
-    uint32_t buffer_count;                    /*!< Number of frame buffers */
-    uint32_t buffer_size;                     /*!< Size of each frame buffer */
-    const char *filename;                     /*!< Current media filename */
+    app_stream_eos_cb_t eos_cb;               /*!< End of stream callback, run by the present task */
+    void *user_data;                          /*!< User data to be passed to the callbacks */
+    uint32_t frame_buffer_count;              /*!< Depth of each frame pool */
+    uint32_t max_width;                       /*!< Decode size when the stream reports none */
+    uint32_t max_height;
+    bool display_releases_frames;             /*!< Display calls app_stream_adapter_release_frame() */
+    char filename[APP_STREAM_PATH_MAX];       /*!< Current media filename, written under clip_lock */
+    portMUX_TYPE clip_lock;                   /*!< Protects filename and prepared.filename for the parse ahead task */
     bool running;                             /*!< Running state flag */
-    uint32_t current_buffer;                  /*!< Current buffer index */
-    uint32_t frame_count;                     /*!< Number of frames processed */
+    uint32_t frame_count;                     /*!< Number of frames presented */
     bool has_info;                            /*!< Flag indicating if stream info is available */
     uint32_t width;                           /*!< Frame width */
     uint32_t height;                          /*!< Frame height */
@@ -222,16 +360,96 @@ typedef struct app_stream_adapter_t {
 
     /* Extractor specific members */
     app_extractor_handle_t extractor_handle;  /*!< Extractor handle */
-    uint8_t *jpeg_buffer;                     /*!< Buffer for JPEG frames from extractor */
-    uint32_t jpeg_buffer_size;                /*!< Size of JPEG buffer */
     jpeg_decoder_handle_t jpeg_handle;        /*!< JPEG hardware decoder handle */
-    TaskHandle_t extract_task_handle;         /*!< Handle for extraction task */
+    h264_decoder_handle_t h264;               /*!< Software decoder of an H.264 clip, NULL for MJPEG */
+    TaskHandle_t extract_task_handle;         /*!< Handle for demux task */
     EventGroupHandle_t extract_event_group;   /*!< Event group for task control */
-    SemaphoreHandle_t frame_mutex;            /*!< Mutex to protect frame buffer access */
+
+    /* Pipeline stages */
+    stream_packet_t packets[APP_STREAM_DEMUX_RING_DEPTH]; /*!< Compressed frame slots */
+    spsc_ring_t packet_ring;                  /*!< demux -> decode */
+    stream_frame_t *frames;                   /*!< Decoded frame slots (frame_buffer_count entries) */
+    spsc_ring_t frame_ring;                   /*!< decode -> present */
+    TaskHandle_t decode_task_handle;          /*!< Handle for decode task */
+    TaskHandle_t present_task_handle;         /*!< Handle for present task */
+    volatile bool pipeline_stop;              /*!< Set to make every stage exit */
+    volatile bool paused;                     /*!< Present stage holds the current frame */
+    volatile bool demux_eos;                  /*!< Demux has read the last packet */
+    volatile bool decode_eos;                 /*!< Decode has emptied the packet ring after demux_eos */
+    bool eos_reported;                        /*!< eos_cb has run for this pipeline start */
+    app_stream_stage_stats_t demux_stats;     /*!< Written by the demux task only, decode just pops the ring */
+    app_stream_stage_stats_t decode_stats;    /*!< Written by the decode task only, present just pops the ring */
+    app_stream_stage_stats_t present_stats;   /*!< Written by the present task only */
+    app_stream_decode_time_t decode_time;     /*!< Written by the decode task only */
+    bool skip_duplicates;                     /*!< Hold the current frame for byte-identical packets */
+    app_stream_duplicate_stats_t duplicate_stats; /*!< frames by the decode task, hash_us by demux */
+    float current_fps;                        /*!< Rate over the last completed FPS window */
+    int64_t fps_window_us;                    /*!< Start of the current FPS window, 0 before the first frame */
+    uint32_t fps_window_frames;               /*!< Frames presented in it */
+
+    /* Master clock, see stream_clock_now() */
+    portMUX_TYPE clock_lock;                  /*!< Protects the clock fields */
+    bool clock_started;                       /*!< Set by audio or the first presented frame */
+    int64_t clock_base_us;                    /*!< Wall time of stream pts 0, at the current speed */
+    uint32_t speed;                           /*!< Percent the clock runs at, changed by the present task */
+    app_stream_sync_stats_t sync_stats;       /*!< Drops by decode, the rest by present */
+
+    /* Playback speed, see app_stream_adapter_set_speed() */
+    volatile uint32_t target_speed;           /*!< Speed asked for, the clock follows at the next frame */
+    uint32_t skim_credit;                     /*!< Demux only: percent gathered towards the next frame passed on */
+    uint32_t frames_skimmed;                  /*!< Written by the demux task only */
 
     /* JPEG decoder configuration */
     app_stream_jpeg_config_t jpeg_config;     /*!< JPEG decoder configuration */
 
+    /* Frame buffers */
+    frame_pool_handle_t decode_pool;          /*!< JPEG output, sized for the stream */
+    frame_pool_handle_t present_pool;         /*!< SRM output, sized for the fitted frame */
+    size_t present_size;                      /*!< Current present_pool buffer size */
+    uint8_t *on_screen;                       /*!< Frame the present task holds without display releases */
+    frame_pool_handle_t on_screen_pool;
+
+    /* Scale/rotate/mirror stage, run by the decode task */
+    video_transform_handle_t transform;       /*!< NULL to present decoded frames as-is */
+
+    /* Next clip and start latency */
+    stream_prepared_t prepared;               /*!< Slot filled by app_stream_adapter_prepare() */
+    frame_pool_handle_t prepared_pool;        /*!< Primed first frames, one at a time */
+    stream_frame_t primed;                    /*!< Primed frame taken from the slot, queued on start */
+    int64_t start_us;                         /*!< When app_stream_adapter_start() was called */
+    int64_t stop_us;                          /*!< When the clip was stopped, 0 while it plays */
+    uint32_t first_frame_ms;                  /*!< Start to first frame on screen, 0 until shown */
+    bool started_prepared;                    /*!< Current clip came from the prepared slot */
+    uint32_t prepare_ms;                      /*!< Background prepare time of the current clip */
+    uint32_t presented_pts;                   /*!< PTS of the frame last handed to frame_cb */
+
+    /* Looping, see app_stream_adapter_set_loop() */
+    bool loop;                                /*!< Wrap clips around instead of ending them */
+    uint32_t presented_offset;                /*!< Loop offset of the frame last shown, held ones included */
+    int64_t presented_us;                     /*!< When that frame was shown */
+    app_stream_loop_stats_t loop_stats;       /*!< Written by the present task only */
+
+    /* Resume points, kept in cache_dir between plays */
+    bool resume_playback;                     /*!< Reopen clips where they were stopped */
+    bool resumed;                             /*!< Current clip was opened from its resume info */
+    uint32_t resume_ms;                       /*!< Position the current clip started at */
+
+    /* Frame index of the current clip, for exact seeks and scrubbing */
+    bool build_frame_index;                   /*!< Index each clip in the background once it plays */
+    const char *cache_dir;                    /*!< Where indexes and resume points are kept, NULL for nowhere */
+    char index_path[APP_STREAM_PATH_MAX];     /*!< Clip the index task works on */
+    volatile bool index_busy;                 /*!< Index task running */
+    frame_index_handle_t index;               /*!< NULL until built, and for clips without one */
+    uint8_t *scrub_input;                     /*!< JPEG engine input for frames read through the index */
+    size_t scrub_input_size;
+    bool scrubbed;                            /*!< Pipeline stopped on a scrubbed frame, resume seeks to it */
+    uint32_t scrub_pts;                       /*!< Frame shown by the last scrub */
+
+    /* Container parses ahead of the first play, see app_stream_adapter_parse_ahead() */
+    QueueHandle_t parse_ahead_queue;          /*!< Clip paths, strdup()ed, NULL without resume points */
+    TaskHandle_t parse_ahead_task_handle;     /*!< Started by the first clip queued */
+    volatile bool parse_ahead_stop;           /*!< Deinit is waiting for the task to exit */
+
     // Audio support
     bool extract_audio;                       /*!< Flag to extract audio */
     esp_codec_dev_handle_t audio_dev;         /*!< Audio device handle */
@@ -242,9 +460,6 @@ typedef struct app_stream_adapter_t {
  */
 static app_stream_adapter_t *g_adapter_instance = NULL;
 
-// Global variable to control callback counter reset
-static bool g_reset_callback_counter = false;
-
 /**
  * @brief Initialize JPEG hardware decoder using shared decoder
  *
@@ -270,15 +485,23 @@ static esp_err_t jpeg_hw_init(app_stream_adapter_t *adapter)
  * @param adapter Stream adapter
  * @param input_buffer JPEG data buffer
  * @param input_size JPEG data size
+ * @param output_buffer Decode buffer to write into
+ * @param output_size Size of output_buffer
  * @param out_width Pointer to store width
  * @param out_height Pointer to store height
  * @param out_size Pointer to store decoded size
+ * @param job_class Scheduling class of the decode on the shared engine
+ * @param decode_us Pointer to store the time the engine took, without the wait for it (may be NULL)
  * @return ESP_OK on success, or an error code
  */
 static esp_err_t decode_jpeg_frame(
     app_stream_adapter_t *adapter,
+    jpeg_sched_class_t job_class,
+    uint32_t *decode_us,
     const uint8_t *input_buffer,
     uint32_t input_size,
+    void *output_buffer,
+    size_t output_size,
     uint32_t *out_width,
     uint32_t *out_height,
     uint32_t *out_size)
@@ -295,11 +518,7 @@ static esp_err_t decode_jpeg_frame(
     *out_width = pic_info.width;
     *out_height = pic_info.height;
 
-    // Select next buffer in round-robin fashion
-    adapter->current_buffer = (adapter->current_buffer + 1) % adapter->buffer_count;
-    void *current_decode_buffer = adapter->decode_buffers[adapter->current_buffer];
-
-    if (current_decode_buffer == NULL) {
+    if (output_buffer == NULL) {
         ESP_LOGE(TAG, "JPEG decode buffer is NULL!");
         return ESP_ERR_INVALID_ARG;
     }
@@ -325,10 +544,20 @@ static esp_err_t decode_jpeg_frame(
                            JPEG_DEC_RGB_ELEMENT_ORDER_BGR :
                            JPEG_DEC_RGB_ELEMENT_ORDER_RGB;
 
+    ret = jpeg_sched_begin(job_class, JPEG_ENGINE_WAIT_MS);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "JPEG engine busy for %d ms", JPEG_ENGINE_WAIT_MS);
+        return ret;
+    }
+    int64_t start_us = esp_timer_get_time();
     ret = jpeg_decoder_process(adapter->jpeg_handle, &decode_cfg,
                                input_buffer, input_size,
-                               current_decode_buffer, adapter->buffer_size,
+                               output_buffer, output_size,
                                out_size);
+    if (decode_us != NULL) {
+        *decode_us = (uint32_t)(esp_timer_get_time() - start_us);
+    }
+    jpeg_sched_end(job_class);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "JPEG decoding failed: %d", ret);
         return ret;
@@ -337,22 +566,137 @@ static esp_err_t decode_jpeg_frame(
     return ESP_OK;
 }
 
-// Extractor frame callback function
+/**
+ * @brief Decode an H.264 access unit in software and convert it into a decode buffer
+ *
+ * Every access unit goes through the decoder, the later ones reference it; a late
+ * picture only skips the colour conversion and returns ESP_ERR_NOT_FINISHED, as
+ * does an access unit that produced no picture.
+ *
+ * @param adapter Stream adapter, with its H.264 decoder open
+ * @param late Skip the conversion, the picture would be dropped
+ * @param decode_us Pointer to store the decode and conversion time (may be NULL)
+ * @param input_buffer Access unit, rewritten in place to Annex-B
+ * @param input_size Access unit size
+ * @param output_buffer Decode buffer to write into
+ * @param output_size Size of output_buffer
+ * @param out_width Pointer to store width
+ * @param out_height Pointer to store height
+ * @param out_size Pointer to store converted size, rows unpadded
+ * @return ESP_OK on success, or an error code
+ */
+static esp_err_t decode_h264_frame(
+    app_stream_adapter_t *adapter,
+    bool late,
+    uint32_t *decode_us,
+    uint8_t *input_buffer,
+    uint32_t input_size,
+    void *output_buffer,
+    size_t output_size,
+    uint32_t *out_width,
+    uint32_t *out_height,
+    uint32_t *out_size)
+{
+    int64_t start_us = esp_timer_get_time();
+    yuv_i420_t picture;
+    esp_err_t ret = h264_decoder_decode(adapter->h264, input_buffer, input_size, &picture);
+    if (ret != ESP_OK || late) {
+        return ret == ESP_OK ? ESP_ERR_NOT_FINISHED : ret;
+    }
+
+    bool rgb888 = adapter->jpeg_config.output_format == APP_STREAM_JPEG_OUTPUT_RGB888;
+    size_t size = (size_t)picture.width * picture.height * (rgb888 ? 3 : 2);
+    if (output_buffer == NULL || size > output_size) {
+        ESP_LOGE(TAG, "H.264 picture %ux%u does not fit the decode buffer", picture.width, picture.height);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (rgb888) {
+        yuv_i420_to_rgb888(&picture, output_buffer, picture.width, adapter->jpeg_config.bgr_order);
+    } else {
+        yuv_i420_to_rgb565(&picture, output_buffer, picture.width, adapter->jpeg_config.bgr_order);
+    }
+    // The display and PPA read the buffer through DMA. Pool buffers are padded to
+    // whole cache lines, so the sync stays on the aligned path.
+    size_t sync_size = image_buffer_align_size(size);
+    image_buffer_cache_sync(output_buffer, sync_size < output_size ? sync_size : output_size,
+                            ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+
+    *out_width = picture.width;
+    *out_height = picture.height;
+    *out_size = size;
+    if (decode_us != NULL) {
+        *decode_us = (uint32_t)(esp_timer_get_time() - start_us);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Wake a pipeline stage blocked in one of the wait helpers
+ */
+static inline void stage_signal(TaskHandle_t task)
+{
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+/**
+ * @brief Block the calling stage until its output ring has a free slot
+ *
+ * @return false if the pipeline is stopping
+ */
+static bool stage_wait_for_space(app_stream_adapter_t *adapter, spsc_ring_t *ring,
+                                 app_stream_stage_stats_t *stats)
+{
+    if (spsc_ring_full(ring)) {
+        int64_t start_us = esp_timer_get_time();
+        stats->stalls++;
+        while (spsc_ring_full(ring) && !adapter->pipeline_stop) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STAGE_WAIT_MS));
+        }
+        stats->stall_time_ms += (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    }
+    return !adapter->pipeline_stop;
+}
+
+/**
+ * @brief Block the calling stage until its input ring holds at least count entries
+ *
+ * upstream_eos is set by the stage feeding the ring once it has pushed its last entry.
+ *
+ * @return false if the pipeline is stopping, or the ring ran dry at end of stream
+ */
+static bool stage_wait_for_data(app_stream_adapter_t *adapter, spsc_ring_t *ring, uint32_t count,
+                                const volatile bool *upstream_eos, app_stream_stage_stats_t *stats)
+{
+    if (spsc_ring_count(ring) < count && !*upstream_eos) {
+        stats->starved++;
+        while (spsc_ring_count(ring) < count && !*upstream_eos && !adapter->pipeline_stop) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STAGE_WAIT_MS));
+        }
+    }
+    // Upstream pushes before it flags the end, so count again
+    return !adapter->pipeline_stop && spsc_ring_count(ring) >= count;
+}
+
+// Producer side only, after a push: the stats belong to the stage feeding the ring
+static void stage_update_depth(app_stream_stage_stats_t *stats, const spsc_ring_t *ring)
+{
+    uint32_t depth = spsc_ring_count(ring);
+    stats->queue_depth = depth;
+    if (depth > stats->queue_depth_max) {
+        stats->queue_depth_max = depth;
+    }
+}
+
+// Extractor frame callback, runs on the demux task: queue the compressed frame for decode.
+// The pool buffer is decoded in place, so it stays with the pipeline until decode is done.
 static esp_err_t extractor_frame_callback(uint8_t *buffer,
                                           uint32_t buffer_size,
                                           bool is_video,
                                           uint32_t pts)
 {
     app_stream_adapter_t *adapter = g_adapter_instance;
-    esp_err_t ret = ESP_OK;
-    static uint32_t callback_count = 0;
-    
-    if (g_reset_callback_counter) {
-        callback_count = 0;
-        g_reset_callback_counter = false;
-    }
-    
-    callback_count++;
 
     if (adapter == NULL) {
         ESP_LOGE(TAG, "Adapter not set for extractor callback");
@@ -363,47 +707,70 @@ static esp_err_t extractor_frame_callback(uint8_t *buffer,
         return ESP_OK;
     }
 
-    if (buffer_size > adapter->jpeg_buffer_size) {
-        ESP_LOGE(TAG, "JPEG frame too large: %u > %u", buffer_size, adapter->jpeg_buffer_size);
-        return ESP_ERR_NO_MEM;
+    // Above normal speed only every speed/100th frame is shown at the stream's
+    // frame rate; the rest never reach the ring or the JPEG engine
+    // H.264 frames are all needed by the ones after them, they are never skimmed
+    uint32_t speed = adapter->target_speed;
+    if (speed > APP_STREAM_SPEED_NORMAL && adapter->h264 == NULL) {
+        adapter->skim_credit += APP_STREAM_SPEED_NORMAL;
+        if (adapter->skim_credit < speed) {
+            app_extractor_release_frame(adapter->extractor_handle, buffer);
+            adapter->frames_skimmed++;
+            return ESP_OK;
+        }
+        adapter->skim_credit -= speed;
+        // Left over from a higher speed
+        if (adapter->skim_credit >= speed) {
+            adapter->skim_credit = 0;
+        }
     }
 
-    memcpy(adapter->jpeg_buffer, buffer, buffer_size);
-
-    uint32_t width = 0, height = 0, decoded_size = 0;
-
-    if (xSemaphoreTake(adapter->frame_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-        ESP_LOGE(TAG, "Failed to acquire frame mutex within 100ms");
-        return ESP_ERR_TIMEOUT;
+    if (!stage_wait_for_space(adapter, &adapter->packet_ring, &adapter->demux_stats)) {
+        return ESP_ERR_INVALID_STATE;
     }
 
-    ret = decode_jpeg_frame(adapter, adapter->jpeg_buffer, buffer_size,
-                            &width, &height, &decoded_size);
-
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to decode frame: %d", ret);
-        xSemaphoreGive(adapter->frame_mutex);
-        return ret;
+    stream_packet_t *packet = &adapter->packets[spsc_ring_head_slot(&adapter->packet_ring)];
+    packet->data = buffer;
+    packet->size = buffer_size;
+    packet->pts = pts;
+    packet->loop_offset = app_extractor_get_loop_offset(adapter->extractor_handle);
+    packet->hash = 0;
+    if (adapter->skip_duplicates && adapter->h264 == NULL) {
+        int64_t start_us = esp_timer_get_time();
+        packet->hash = frame_hash(buffer, buffer_size);
+        adapter->duplicate_stats.hash_us += esp_timer_get_time() - start_us;
     }
 
-    if (!adapter->has_info) {
-        adapter->width = width;
-        adapter->height = height;
-        adapter->has_info = true;
-    }
+    spsc_ring_push(&adapter->packet_ring);
+    stage_update_depth(&adapter->demux_stats, &adapter->packet_ring);
+    stage_signal(adapter->decode_task_handle);
 
-    adapter->frame_count++;
+    return ESP_OK;
+}
 
-    if (adapter->frame_cb) {
-        void *current_buffer = adapter->decode_buffers[adapter->current_buffer];
-        ret = adapter->frame_cb(current_buffer, decoded_size, width, height, adapter->frame_count - 1, adapter->user_data);
+// Frame callback of the prepared clip's extractor, runs on the prepare task:
+// keep the first video frame for priming
+static esp_err_t prepare_frame_callback(uint8_t *buffer,
+                                        uint32_t buffer_size,
+                                        bool is_video,
+                                        uint32_t pts)
+{
+    app_stream_adapter_t *adapter = g_adapter_instance;
+
+    if (adapter == NULL || !is_video) {
+        return ESP_OK;
+    }
+    if (adapter->prepared.packet.data != NULL) {
+        return ESP_ERR_INVALID_STATE;
     }
 
-    xSemaphoreGive(adapter->frame_mutex);
-    return ret;
+    adapter->prepared.packet.data = buffer;
+    adapter->prepared.packet.size = buffer_size;
+    adapter->prepared.packet.pts = pts;
+    return ESP_OK;
 }
 
-// Task that extracts and processes frames
+// Demux task: reads frames from the extractor into the packet ring
 static void extract_task(void *arg)
 {
     app_stream_adapter_t *adapter = (app_stream_adapter_t *)arg;
@@ -444,15 +811,20 @@ static void extract_task(void *arg)
                 }
 
                 if (!paused) {
-                ret = app_extractor_read_frame(adapter->extractor_handle);
+                    ret = app_extractor_read_frame(adapter->extractor_handle);
                     frame_read_count++;
 
-                if (ret != ESP_OK) {
-                        if (ret != ESP_ERR_NOT_FOUND) {
+                    if (ret != ESP_OK) {
+                        if (ret != ESP_ERR_NOT_FOUND && !adapter->pipeline_stop) {
                             ESP_LOGE(TAG, "Failed to read frame %u: %s", frame_read_count, esp_err_to_name(ret));
+                        }
+                        // A read error ends the clip the same way, with what was demuxed so far
+                        if (!adapter->pipeline_stop) {
+                            adapter->demux_eos = true;
+                            stage_signal(adapter->decode_task_handle);
+                        }
+                        break;
                     }
-                    break;
-                }
                 } else {
                     vTaskDelay(pdMS_TO_TICKS(10));
                 }
@@ -462,191 +834,1374 @@ static void extract_task(void *arg)
         }
     }
 
-    xEventGroupSetBits(adapter->extract_event_group, EXTRACT_TASK_STOPPED_BIT);
     adapter->extract_task_handle = NULL;
+    xEventGroupSetBits(adapter->extract_event_group, EXTRACT_TASK_STOPPED_BIT);
     vTaskDelete(NULL);
 }
 
-// Stop extraction task
-static void stop_extract_task(app_stream_adapter_t *adapter)
+// Return every queued compressed frame to the extractor pool. Only the packet ring
+// consumer may call this: the decode task on exit, or stop once all tasks are gone.
+static void drain_packet_ring(app_stream_adapter_t *adapter)
 {
-    if (adapter->extract_task_handle == NULL) {
-        return;
+    while (spsc_ring_count(&adapter->packet_ring) > 0) {
+        stream_packet_t *packet = &adapter->packets[spsc_ring_tail_slot(&adapter->packet_ring, 0)];
+        app_extractor_release_frame(adapter->extractor_handle, packet->data);
+        packet->data = NULL;
+        spsc_ring_pop(&adapter->packet_ring);
+    }
+}
+
+// Current master clock in stream ms: the audio clock while audio is playing,
+// wall time otherwise. The wall base follows the audio clock, so falling back
+// (audio ended, underrun, pause) continues from where audio left off. Away from
+// normal speed audio is muted and wall time runs scaled by the speed.
+// Returns false until the clock has been started.
+static bool stream_clock_now(app_stream_adapter_t *adapter, uint32_t *clock_ms, bool *from_audio)
+{
+    int64_t now_us = esp_timer_get_time();
+    uint32_t audio_ms = 0;
+    int64_t audio_us = 0;
+    bool audio = adapter->extract_audio && adapter->speed == APP_STREAM_SPEED_NORMAL &&
+                 app_extractor_get_audio_clock(adapter->extractor_handle, &audio_ms, &audio_us) == ESP_OK &&
+                 now_us - audio_us < (int64_t)AUDIO_CLOCK_STALE_MS * 1000;
+
+    portENTER_CRITICAL(&adapter->clock_lock);
+    if (audio) {
+        // Codec writes block on the DMA queue, so extrapolate in real time between writes
+        adapter->clock_base_us = now_us - ((int64_t)audio_ms * 1000 + (now_us - audio_us));
+        adapter->clock_started = true;
+    }
+    bool started = adapter->clock_started;
+    int64_t base_us = adapter->clock_base_us;
+    uint32_t speed = adapter->speed;
+    portEXIT_CRITICAL(&adapter->clock_lock);
+
+    if (from_audio) {
+        *from_audio = audio;
+    }
+    if (!started) {
+        return false;
+    }
+    *clock_ms = (uint32_t)((now_us - base_us) * speed / APP_STREAM_SPEED_NORMAL / 1000);
+    return true;
+}
+
+// Start the wall clock at pts if neither audio nor an earlier frame has started it
+static void stream_clock_start(app_stream_adapter_t *adapter, uint32_t pts)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&adapter->clock_lock);
+    if (!adapter->clock_started) {
+        adapter->clock_base_us = now_us - (int64_t)pts * 1000 * APP_STREAM_SPEED_NORMAL / adapter->speed;
+        adapter->clock_started = true;
     }
+    portEXIT_CRITICAL(&adapter->clock_lock);
+}
 
-    xEventGroupSetBits(adapter->extract_event_group, EXTRACT_TASK_STOP_BIT);
+// Run the clock at the speed asked for from where it is now. Only the present task
+// calls this once the pipeline runs, never inside a pause, so a pause shift always
+// applies at the speed it was measured at.
+static void stream_clock_apply_speed(app_stream_adapter_t *adapter)
+{
+    uint32_t speed = adapter->target_speed;
+    if (speed == adapter->speed) {
+        return;
+    }
 
-    EventBits_t bits = xEventGroupWaitBits(adapter->extract_event_group,
-                                           EXTRACT_TASK_STOPPED_BIT,
-                                           pdTRUE, pdFALSE,
-                                           pdMS_TO_TICKS(1000));
+    // Picks up the latest audio clock before leaving it
+    uint32_t clock_ms;
+    stream_clock_now(adapter, &clock_ms, NULL);
 
-    if (!(bits & EXTRACT_TASK_STOPPED_BIT)) {
-        ESP_LOGW(TAG, "Extract task did not stop within 1000ms timeout, forcing cleanup");
-        
-        if (adapter->frame_mutex != NULL) {
-            vSemaphoreDelete(adapter->frame_mutex);
-            adapter->frame_mutex = xSemaphoreCreateMutex();
-            if (adapter->frame_mutex == NULL) {
-                ESP_LOGE(TAG, "Failed to recreate frame_mutex");
-            }
-        }
-        
-        if (adapter->extract_task_handle != NULL) {
-            vTaskDelete(adapter->extract_task_handle);
-            adapter->extract_task_handle = NULL;
-        }
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&adapter->clock_lock);
+    if (adapter->clock_started) {
+        int64_t stream_us = (now_us - adapter->clock_base_us) * adapter->speed / APP_STREAM_SPEED_NORMAL;
+        adapter->clock_base_us = now_us - stream_us * APP_STREAM_SPEED_NORMAL / speed;
     }
+    adapter->speed = speed;
+    portEXIT_CRITICAL(&adapter->clock_lock);
+}
 
-    xEventGroupClearBits(adapter->extract_event_group,
-                         EXTRACT_TASK_START_BIT | EXTRACT_TASK_STOP_BIT | 
-                         EXTRACT_TASK_STOPPED_BIT | EXTRACT_TASK_PAUSE_BIT | 
-                         EXTRACT_TASK_RESUME_BIT);
+static void stream_clock_shift(app_stream_adapter_t *adapter, int64_t delta_us)
+{
+    portENTER_CRITICAL(&adapter->clock_lock);
+    adapter->clock_base_us += delta_us;
+    portEXIT_CRITICAL(&adapter->clock_lock);
 }
 
-// Start extraction task
-static esp_err_t start_extract_task(app_stream_adapter_t *adapter)
+// Take a buffer from a frame pool, waiting for the display or present stage to
+// release one. Returns NULL if the pipeline is stopping.
+static uint8_t *stage_acquire_buffer(app_stream_adapter_t *adapter, frame_pool_handle_t pool,
+                                     size_t *size, app_stream_stage_stats_t *stats)
 {
-    if (adapter->extract_task_handle != NULL) {
-        stop_extract_task(adapter);
+    uint8_t *buffer = frame_pool_acquire(pool, 0, size);
+    if (buffer == NULL) {
+        int64_t start_us = esp_timer_get_time();
+        stats->stalls++;
+        while (buffer == NULL && !adapter->pipeline_stop) {
+            buffer = frame_pool_acquire(pool, STAGE_WAIT_MS, size);
+        }
+        stats->stall_time_ms += (uint32_t)((esp_timer_get_time() - start_us) / 1000);
     }
-
-    if (adapter->frame_mutex == NULL) {
-        ESP_LOGE(TAG, "Frame mutex is NULL, cannot start extract task");
-        return ESP_ERR_INVALID_STATE;
+    if (buffer != NULL && adapter->pipeline_stop) {
+        frame_pool_release(pool, buffer);
+        buffer = NULL;
     }
+    return buffer;
+}
 
-    xEventGroupClearBits(adapter->extract_event_group,
-                         EXTRACT_TASK_START_BIT | EXTRACT_TASK_STOP_BIT | 
-                         EXTRACT_TASK_STOPPED_BIT | EXTRACT_TASK_PAUSE_BIT | 
-                         EXTRACT_TASK_RESUME_BIT);
+// SRM stage: fit a decoded frame into a presentation buffer and give the decode
+// buffer back. Frames that already fit upright are presented from the decode buffer.
+// Pipeline stages wait for a buffer until pipeline_stop; with the pipeline stopped,
+// as for a scrubbed frame, the wait is bounded by SCRUB_WAIT_MS instead.
+static void transform_frame(app_stream_adapter_t *adapter, stream_frame_t *frame, bool in_pipeline)
+{
+    video_transform_plan_t plan;
+    if (video_transform_plan(adapter->transform, frame->width, frame->height, frame->size, &plan) != ESP_OK) {
+        return;
+    }
+    if (plan.passthrough) {
+        video_transform_count_passthrough(adapter->transform);
+        return;
+    }
 
-    BaseType_t ret = xTaskCreate(extract_task,
-                                 "extract_task",
-                                 EXTRACT_TASK_STACK_SIZE,
-                                 adapter,
-                                 EXTRACT_TASK_PRIORITY,
-                                 &adapter->extract_task_handle);
+    // The pool was sized from the container; grow it if the frames disagree
+    size_t needed = (size_t)plan.out_width * plan.out_height * 2;
+    if (needed > adapter->present_size) {
+        frame_pool_set_buffer_size(adapter->present_pool, needed);
+        adapter->present_size = needed;
+    }
 
-    if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create extract task");
-        return ESP_FAIL;
+    size_t out_size = 0;
+    uint8_t *out = in_pipeline ?
+                   stage_acquire_buffer(adapter, adapter->present_pool, &out_size, &adapter->decode_stats) :
+                   frame_pool_acquire(adapter->present_pool, SCRUB_WAIT_MS, &out_size);
+    if (out == NULL) {
+        return;
     }
 
-    xEventGroupSetBits(adapter->extract_event_group, EXTRACT_TASK_START_BIT);
+    // On failure the frame is still shown, unscaled
+    if (video_transform_run(adapter->transform, &plan, frame->buffer, frame->size, out, out_size) != ESP_OK) {
+        frame_pool_release(adapter->present_pool, out);
+        return;
+    }
 
-    return ESP_OK;
+    frame_pool_release(frame->pool, frame->buffer);
+    frame->buffer = out;
+    frame->pool = adapter->present_pool;
+    frame->width = plan.out_width;
+    frame->height = plan.out_height;
+    frame->size = plan.out_width * plan.out_height * 2;
 }
 
-esp_err_t app_stream_adapter_init(const app_stream_adapter_config_t *config,
-                                  app_stream_adapter_handle_t *ret_adapter)
+static void record_decode_time(app_stream_decode_time_t *stats, uint32_t decode_us)
 {
-    if (config == NULL || ret_adapter == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    uint32_t bin = decode_us / (APP_STREAM_DECODE_HIST_BIN_MS * 1000);
+    stats->hist[bin < APP_STREAM_DECODE_HIST_BINS ? bin : APP_STREAM_DECODE_HIST_BINS - 1]++;
+    stats->frames++;
+    stats->total_us += decode_us;
+    if (decode_us > stats->max_us) {
+        stats->max_us = decode_us;
     }
+}
 
-    app_stream_adapter_t *adapter = (app_stream_adapter_t *)calloc(1, sizeof(app_stream_adapter_t));
-    if (adapter == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate adapter context");
-        return ESP_ERR_NO_MEM;
-    }
+// Decode task: drives the JPEG engine from the packet ring into the frame ring,
+// dropping frames that are already late against the master clock and holding
+// ones identical to the frame last queued
+static void decode_task(void *arg)
+{
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)arg;
+    uint32_t interval_ms = 1000 / (adapter->fps > 0 ? adapter->fps : DEFAULT_VIDEO_FPS);
+    uint32_t packets = 0;
+    uint32_t last_pts = 0;
+    uint32_t consecutive_drops = 0;
+    bool queued_valid = false;                // queued_* describe the frame the screen shows last
+    uint32_t queued_hash = 0;
+    uint32_t queued_size = 0;
+
+    // The pipeline restarts after every seek, the decoder has to wait for an IDR
+    if (adapter->h264 != NULL) {
+        h264_decoder_flush(adapter->h264);
+    }
+
+    while (!adapter->pipeline_stop) {
+        if (!stage_wait_for_data(adapter, &adapter->packet_ring, 1, &adapter->demux_eos, &adapter->decode_stats)) {
+            if (adapter->pipeline_stop) {
+                break;
+            }
+            // Everything demuxed is decoded; idle until a seek or stop restarts the pipeline
+            adapter->decode_eos = true;
+            stage_signal(adapter->present_task_handle);
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STAGE_WAIT_MS));
+            continue;
+        }
+        if (!stage_wait_for_space(adapter, &adapter->frame_ring, &adapter->decode_stats)) {
+            break;
+        }
 
-    adapter->frame_cb = config->frame_cb;
-    adapter->user_data = config->user_data;
-    adapter->decode_buffers = config->decode_buffers;
-    adapter->buffer_count = config->buffer_count;
-    adapter->buffer_size = config->buffer_size;
-    adapter->running = false;
-    adapter->current_buffer = config->buffer_count - 1;
-    adapter->frame_count = 0;
-    adapter->has_info = false;
+        stream_packet_t *packet = &adapter->packets[spsc_ring_tail_slot(&adapter->packet_ring, 0)];
+        stream_frame_t *frame = &adapter->frames[spsc_ring_head_slot(&adapter->frame_ring)];
 
-    adapter->jpeg_config = config->jpeg_config;
-    adapter->audio_dev = config->audio_dev;
-    adapter->extract_audio = (config->audio_dev != NULL);
+        // Streams without usable timestamps fall back to the nominal frame interval
+        uint32_t pts = packet->pts;
+        if (packets > 0 && pts <= last_pts) {
+            pts = last_pts + interval_ms;
+        }
+        packets++;
+        last_pts = pts;
+        frame->loop_offset = packet->loop_offset;
+
+        // A repeat of the picture queued last only has to keep it up for one more
+        // interval. The present stage still schedules it, for sync and end of stream.
+        if (adapter->skip_duplicates && adapter->h264 == NULL && queued_valid &&
+                packet->size == queued_size && packet->hash == queued_hash) {
+            frame->buffer = NULL;
+            frame->pts = pts;
+            frame->held = true;
+            adapter->duplicate_stats.frames++;
+            consecutive_drops = 0;
+
+            app_extractor_release_frame(adapter->extractor_handle, packet->data);
+            packet->data = NULL;
+            spsc_ring_pop(&adapter->packet_ring);
+            stage_signal(adapter->extract_task_handle);
+
+            spsc_ring_push(&adapter->frame_ring);
+            stage_update_depth(&adapter->decode_stats, &adapter->frame_ring);
+            stage_signal(adapter->present_task_handle);
+            continue;
+        }
 
-    adapter->jpeg_buffer_size = APP_STREAM_JPEG_BUFFER_SIZE;
-    adapter->jpeg_buffer = heap_caps_malloc(adapter->jpeg_buffer_size, MALLOC_CAP_SPIRAM);
-    if (adapter->jpeg_buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate JPEG buffer");
-        free(adapter);
-        return ESP_ERR_NO_MEM;
-    }
+        // Every MJPEG frame is a key frame, so a late one can be skipped without
+        // touching the JPEG engine. A few are always decoded to keep the picture moving.
+        // H.264 frames reference the ones before, so late ones are decoded all the
+        // same and only skip the colour conversion and SRM.
+        bool drop = false;
+#if CONFIG_HDMI_VIDEO_SYNC_ENABLED
+        uint32_t clock_ms;
+        drop = consecutive_drops < MAX_CONSECUTIVE_DROPS &&
+               stream_clock_now(adapter, &clock_ms, NULL) &&
+               (int32_t)(clock_ms - pts) > (int32_t)(HDMI_SYNC_THRESHOLD_MS * adapter->speed / APP_STREAM_SPEED_NORMAL);
+#endif
+
+        esp_err_t ret = ESP_OK;
+        frame->buffer = NULL;
+        frame->held = false;
+        if (drop) {
+            adapter->sync_stats.frames_dropped++;
+            consecutive_drops++;
+        } else {
+            consecutive_drops = 0;
+        }
+        if (drop && adapter->h264 != NULL) {
+            ret = decode_h264_frame(adapter, true, NULL, packet->data, packet->size,
+                                    NULL, 0, &frame->width, &frame->height, &frame->size);
+        } else if (!drop) {
+            size_t buffer_size = 0;
+            frame->buffer = stage_acquire_buffer(adapter, adapter->decode_pool, &buffer_size, &adapter->decode_stats);
+            frame->pool = adapter->decode_pool;
+            if (frame->buffer == NULL) {
+                ret = adapter->pipeline_stop ? ESP_ERR_INVALID_STATE : ESP_ERR_NO_MEM;
+            } else {
+                uint32_t decode_us = 0;
+                if (adapter->h264 != NULL) {
+                    ret = decode_h264_frame(adapter, false, &decode_us, packet->data, packet->size,
+                                            frame->buffer, buffer_size, &frame->width, &frame->height, &frame->size);
+                } else {
+                    ret = decode_jpeg_frame(adapter, JPEG_SCHED_VIDEO, &decode_us, packet->data, packet->size,
+                                            frame->buffer, buffer_size, &frame->width, &frame->height, &frame->size);
+                }
+                if (ret == ESP_OK) {
+                    record_decode_time(&adapter->decode_time, decode_us);
+                }
+            }
+            frame->pts = pts;
+        }
 
-    adapter->frame_mutex = xSemaphoreCreateMutex();
-    if (adapter->frame_mutex == NULL) {
-        ESP_LOGE(TAG, "Failed to create frame mutex");
-        heap_caps_free(adapter->jpeg_buffer);
-        free(adapter);
-        return ESP_ERR_NO_MEM;
-    }
+        // The packet is consumed either way; return its buffer to the pool and the slot to demux
+        uint32_t packet_hash = packet->hash;
+        uint32_t packet_size = packet->size;
+        app_extractor_release_frame(adapter->extractor_handle, packet->data);
+        packet->data = NULL;
+        spsc_ring_pop(&adapter->packet_ring);
+        stage_signal(adapter->extract_task_handle);
+
+        if (drop) {
+            if (ret != ESP_OK && ret != ESP_ERR_NOT_FINISHED) {
+                ESP_LOGE(TAG, "Failed to decode frame: %d", ret);
+            }
+            continue;
+        }
 
-    // Create event group for task control
-    adapter->extract_event_group = xEventGroupCreate();
-    if (adapter->extract_event_group == NULL) {
-        ESP_LOGE(TAG, "Failed to create extract event group");
-        vSemaphoreDelete(adapter->frame_mutex);
-        heap_caps_free(adapter->jpeg_buffer);
-        free(adapter);
-        return ESP_ERR_NO_MEM;
-    }
+        if (ret != ESP_OK) {
+            if (frame->buffer != NULL) {
+                frame_pool_release(frame->pool, frame->buffer);
+                frame->buffer = NULL;
+            }
+            // An H.264 access unit without a picture to show is no error
+            if (!adapter->pipeline_stop && ret != ESP_ERR_NOT_FINISHED) {
+                ESP_LOGE(TAG, "Failed to decode frame: %d", ret);
+            }
+            continue;
+        }
+        queued_valid = true;
+        queued_hash = packet_hash;
+        queued_size = packet_size;
+
+        if (!adapter->has_info) {
+            adapter->width = frame->width;
+            adapter->height = frame->height;
+            adapter->has_info = true;
+        }
 
-    esp_err_t ret = jpeg_hw_init(adapter);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize JPEG decoder: %d", ret);
-        vEventGroupDelete(adapter->extract_event_group);
-        vSemaphoreDelete(adapter->frame_mutex);
-        heap_caps_free(adapter->jpeg_buffer);
-        free(adapter);
-        return ret;
+        if (adapter->transform) {
+            transform_frame(adapter, frame, true);
+        }
+
+        spsc_ring_push(&adapter->frame_ring);
+        stage_update_depth(&adapter->decode_stats, &adapter->frame_ring);
+        stage_signal(adapter->present_task_handle);
     }
 
-    g_adapter_instance = adapter;
+    // Demux may be blocked waiting for pool memory; free it so it can observe the stop
+    drain_packet_ring(adapter);
+    stage_signal(adapter->extract_task_handle);
 
-    if (config->audio_dev) {
-        ret = app_extractor_init(extractor_frame_callback, config->audio_dev, &adapter->extractor_handle);
-    } else {
-        ret = app_extractor_init(extractor_frame_callback, NULL, &adapter->extractor_handle);
+    adapter->decode_task_handle = NULL;
+    xEventGroupSetBits(adapter->extract_event_group, DECODE_TASK_STOPPED_BIT);
+    vTaskDelete(NULL);
+}
+
+// Hand a frame to the display. Its buffer comes back through app_stream_adapter_release_frame(),
+// or without display releases once the next frame is presented.
+static esp_err_t present_frame(app_stream_adapter_t *adapter, stream_frame_t *frame)
+{
+    frame_pool_mark_presented(frame->pool, frame->buffer);
+    adapter->presented_pts = frame->pts;
+    esp_err_t ret = ESP_FAIL;
+    if (adapter->frame_cb) {
+        ret = adapter->frame_cb(frame->buffer, frame->size, frame->width, frame->height,
+                                adapter->frame_count, adapter->user_data);
     }
+    adapter->frame_count++;
 
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize extractor: %d", ret);
-        g_adapter_instance = NULL;
-        jpeg_del_decoder_engine(adapter->jpeg_handle);
-        vEventGroupDelete(adapter->extract_event_group);
-        vSemaphoreDelete(adapter->frame_mutex);
-        heap_caps_free(adapter->jpeg_buffer);
-        free(adapter);
-        return ret;
+        // Never shown, so nobody else will release it
+        frame_pool_release(frame->pool, frame->buffer);
+    } else if (!adapter->display_releases_frames) {
+        // The previous frame is off screen now
+        if (adapter->on_screen != NULL) {
+            frame_pool_release(adapter->on_screen_pool, adapter->on_screen);
+        }
+        adapter->on_screen = frame->buffer;
+        adapter->on_screen_pool = frame->pool;
     }
-
-    ESP_LOGI(TAG, "Stream adapter initialized%s with event group control", config->audio_dev ? " with audio" : "");
-    *ret_adapter = adapter;
-    return ESP_OK;
+    frame->buffer = NULL;
+    return ret;
 }
 
-esp_err_t app_stream_adapter_set_file(app_stream_adapter_handle_t handle,
-                                      const char *filename,
-                                      bool extract_audio)
+// The frame ring ran dry after the last decoded frame. Once that frame has had its
+// interval on screen and the audio queued behind it has played out, report the end
+// of the clip through eos_cb, once per pipeline start. Returns early on pause or stop.
+static void present_end_of_stream(app_stream_adapter_t *adapter, uint32_t interval_ms)
 {
-    if (handle == NULL || filename == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    if (adapter->eos_reported) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STAGE_WAIT_MS));
+        return;
     }
 
-    app_stream_adapter_t *adapter = (app_stream_adapter_t *)handle;
+    int64_t start_us = esp_timer_get_time();
+    int64_t progress_us = start_us;
+    uint32_t ring_used = UINT32_MAX;
+    uint32_t end_ms = adapter->presented_pts + interval_ms;
+
+    while (!adapter->pipeline_stop && !adapter->paused) {
+        uint32_t clock_ms = end_ms;
+        bool video_done = adapter->frame_count == 0 || !stream_clock_now(adapter, &clock_ms, NULL) ||
+                          (int32_t)(end_ms - clock_ms) <= 0;
+
+        // The demux task no longer feeds the audio ring, so it only empties.
+        // Give up if it stops doing so, the audio task may have failed.
+        bool audio_done = true;
+        app_extractor_audio_stats_t audio;
+        if (adapter->extract_audio &&
+                app_extractor_get_audio_stats(adapter->extractor_handle, &audio) == ESP_OK &&
+                (audio.ring_used > 0 || audio.buffered_ms > 0)) {
+            int64_t now_us = esp_timer_get_time();
+            if (audio.ring_used != ring_used || audio.buffered_ms > 0) {
+                ring_used = audio.ring_used;
+                progress_us = now_us;
+                audio_done = false;
+            } else if (now_us - progress_us < (int64_t)AUDIO_DRAIN_STALL_MS * 1000) {
+                audio_done = false;
+            } else {
+                ESP_LOGW(TAG, "Audio stopped draining with %u bytes queued", audio.ring_used);
+            }
+        }
 
-    if (adapter->running) {
-        app_stream_adapter_stop(handle);
+        if (video_done && audio_done) {
+            break;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PRESENT_POLL_MS));
+    }
+    if (adapter->pipeline_stop || adapter->paused) {
+        return;
+    }
+
+    adapter->eos_reported = true;
+    ESP_LOGI(TAG, "End of stream: %u frames presented, last at %u ms, drained in %lld ms",
+             adapter->frame_count, adapter->presented_pts, (esp_timer_get_time() - start_us) / 1000);
+    if (adapter->eos_cb) {
+        adapter->eos_cb(adapter->user_data);
+    }
+}
+
+// Count a presented frame towards the rolling frame rate
+static void update_fps(app_stream_adapter_t *adapter)
+{
+    int64_t now_us = esp_timer_get_time();
+    if (adapter->fps_window_us == 0) {
+        adapter->fps_window_us = now_us;
+        return;
+    }
+    adapter->fps_window_frames++;
+    int64_t window_us = now_us - adapter->fps_window_us;
+    if (window_us >= (int64_t)FPS_WINDOW_MS * 1000) {
+        adapter->current_fps = adapter->fps_window_frames * 1000000.0f / window_us;
+        adapter->fps_window_us = now_us;
+        adapter->fps_window_frames = 0;
+    }
+}
+
+// Present task: shows each decoded frame once the master clock reaches its PTS
+static void present_task(void *arg)
+{
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)arg;
+    uint32_t interval_ms = 1000 / (adapter->fps > 0 ? adapter->fps : DEFAULT_VIDEO_FPS);
+    uint32_t presented = 0;
+
+    while (!adapter->pipeline_stop) {
+        if (adapter->paused) {
+            // Shift the clock by the pause length so playback resumes where it stopped
+            int64_t pause_start_us = esp_timer_get_time();
+            while (adapter->paused && !adapter->pipeline_stop) {
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STAGE_WAIT_MS));
+            }
+            stream_clock_shift(adapter, esp_timer_get_time() - pause_start_us);
+            continue;
+        }
+        stream_clock_apply_speed(adapter);
+
+        if (!stage_wait_for_data(adapter, &adapter->frame_ring, 1, &adapter->decode_eos, &adapter->present_stats)) {
+            if (adapter->pipeline_stop) {
+                break;
+            }
+            present_end_of_stream(adapter, interval_ms);
+            continue;
+        }
+
+        stream_frame_t *frame = &adapter->frames[spsc_ring_tail_slot(&adapter->frame_ring, 0)];
+
+        stream_clock_start(adapter, frame->pts);
+
+        uint32_t clock_ms = frame->pts;
+        bool from_audio = false;
+        while (!adapter->pipeline_stop && !adapter->paused) {
+            stream_clock_now(adapter, &clock_ms, &from_audio);
+            int32_t ahead_ms = (int32_t)(frame->pts - clock_ms);
+            if (ahead_ms <= 0) {
+                break;
+            }
+            // Poll in short steps, the audio clock advances in codec-write sized jumps
+            TickType_t ticks = pdMS_TO_TICKS(ahead_ms < PRESENT_POLL_MS ? ahead_ms : PRESENT_POLL_MS);
+            ulTaskNotifyTake(pdTRUE, ticks > 0 ? ticks : 1);
+            stream_clock_apply_speed(adapter);
+        }
+        if (adapter->pipeline_stop) {
+            break;
+        }
+        if (adapter->paused) {
+            continue;
+        }
+
+        int32_t drift_ms = (int32_t)(frame->pts - clock_ms);
+        uint32_t abs_drift_ms = drift_ms < 0 ? (uint32_t)-drift_ms : (uint32_t)drift_ms;
+        adapter->sync_stats.audio_master = from_audio;
+        adapter->sync_stats.drift_ms = drift_ms;
+        if (abs_drift_ms > adapter->sync_stats.max_drift_ms) {
+            adapter->sync_stats.max_drift_ms = abs_drift_ms;
+        }
+        // A late frame means the previous one stayed up for extra frame intervals
+        if (presented > 0 && drift_ms < -(int32_t)interval_ms) {
+            adapter->sync_stats.frames_late++;
+            adapter->sync_stats.frames_repeated += abs_drift_ms / interval_ms;
+        }
+
+        esp_err_t ret = ESP_OK;
+        if (frame->held) {
+            // The screen already shows this picture, it only stays up another interval
+            adapter->presented_pts = frame->pts;
+        } else {
+            ret = present_frame(adapter, frame);
+        }
+
+        int64_t now_us = esp_timer_get_time();
+        if (presented > 0 && frame->loop_offset != adapter->presented_offset) {
+            app_stream_loop_stats_t *loop = &adapter->loop_stats;
+            loop->loops++;
+            loop->gap_us = (uint32_t)(now_us - adapter->presented_us);
+            if (loop->gap_us > loop->gap_max_us) {
+                loop->gap_max_us = loop->gap_us;
+            }
+            ESP_LOGD(TAG, "Loop %u: %u us from the last frame to the first, frame interval %u ms",
+                     loop->loops, loop->gap_us, interval_ms);
+        }
+        adapter->presented_offset = frame->loop_offset;
+        adapter->presented_us = now_us;
+        presented++;
+        update_fps(adapter);
+
+        if (ret == ESP_OK && adapter->first_frame_ms == 0) {
+            adapter->first_frame_ms = (uint32_t)((esp_timer_get_time() - adapter->start_us) / 1000);
+            ESP_LOGI(TAG, "First frame on screen %u ms after start (%s%s)", adapter->first_frame_ms,
+                     adapter->started_prepared ? "prepared" : "cold", adapter->resumed ? ", resumed" : "");
+        }
+
+        spsc_ring_pop(&adapter->frame_ring);
+        stage_signal(adapter->decode_task_handle);
+    }
+
+    adapter->present_task_handle = NULL;
+    xEventGroupSetBits(adapter->extract_event_group, PRESENT_TASK_STOPPED_BIT);
+    vTaskDelete(NULL);
+}
+
+// Release decoded frames that were never presented. Only call once all tasks are gone.
+static void drain_frame_ring(app_stream_adapter_t *adapter)
+{
+    while (spsc_ring_count(&adapter->frame_ring) > 0) {
+        stream_frame_t *frame = &adapter->frames[spsc_ring_tail_slot(&adapter->frame_ring, 0)];
+        if (frame->buffer != NULL) {
+            frame_pool_release(frame->pool, frame->buffer);
+            frame->buffer = NULL;
+        }
+        spsc_ring_pop(&adapter->frame_ring);
+    }
+}
+
+// Stop all pipeline tasks
+static void stop_extract_task(app_stream_adapter_t *adapter)
+{
+    if (adapter->extract_task_handle == NULL && adapter->decode_task_handle == NULL &&
+            adapter->present_task_handle == NULL) {
+        return;
+    }
+
+    // Tasks that never started count as stopped
+    EventBits_t not_running = 0;
+    if (adapter->extract_task_handle == NULL) {
+        not_running |= EXTRACT_TASK_STOPPED_BIT;
+    }
+    if (adapter->decode_task_handle == NULL) {
+        not_running |= DECODE_TASK_STOPPED_BIT;
+    }
+    if (adapter->present_task_handle == NULL) {
+        not_running |= PRESENT_TASK_STOPPED_BIT;
+    }
+
+    adapter->pipeline_stop = true;
+    xEventGroupSetBits(adapter->extract_event_group, EXTRACT_TASK_STOP_BIT | not_running);
+    stage_signal(adapter->extract_task_handle);
+    stage_signal(adapter->decode_task_handle);
+    stage_signal(adapter->present_task_handle);
+
+    EventBits_t bits = xEventGroupWaitBits(adapter->extract_event_group,
+                                           PIPELINE_STOPPED_BITS,
+                                           pdTRUE, pdTRUE,
+                                           pdMS_TO_TICKS(1000));
+
+    if ((bits & PIPELINE_STOPPED_BITS) != PIPELINE_STOPPED_BITS) {
+        ESP_LOGW(TAG, "Pipeline tasks did not stop within 1000ms timeout, forcing cleanup");
+
+        if (adapter->extract_task_handle != NULL) {
+            vTaskDelete(adapter->extract_task_handle);
+            adapter->extract_task_handle = NULL;
+        }
+        if (adapter->decode_task_handle != NULL) {
+            vTaskDelete(adapter->decode_task_handle);
+            adapter->decode_task_handle = NULL;
+        }
+        if (adapter->present_task_handle != NULL) {
+            vTaskDelete(adapter->present_task_handle);
+            adapter->present_task_handle = NULL;
+        }
+    }
+
+    xEventGroupClearBits(adapter->extract_event_group, PIPELINE_ALL_BITS);
+
+    // Frames demux queued after decode exited still hold pool memory
+    drain_packet_ring(adapter);
+    drain_frame_ring(adapter);
+
+    ESP_LOGI(TAG, "Pipeline stopped: demux stalls %u (%u ms, max depth %u), decode stalls %u (%u ms) starved %u, "
+             "present starved %u",
+             adapter->demux_stats.stalls, adapter->demux_stats.stall_time_ms, adapter->demux_stats.queue_depth_max,
+             adapter->decode_stats.stalls, adapter->decode_stats.stall_time_ms, adapter->decode_stats.starved,
+             adapter->present_stats.starved);
+    ESP_LOGI(TAG, "A/V sync: %s clock, drift %d ms (max %u), dropped %u, repeated %u",
+             adapter->sync_stats.audio_master ? "audio" : "wall", adapter->sync_stats.drift_ms,
+             adapter->sync_stats.max_drift_ms, adapter->sync_stats.frames_dropped,
+             adapter->sync_stats.frames_repeated);
+
+    video_transform_stats_t srm_stats;
+    if (video_transform_get_stats(adapter->transform, &srm_stats) == ESP_OK) {
+        ESP_LOGI(TAG, "SRM: %u frames, %u passed through, %u failed, last %u us, avg %u us, max %u us",
+                 srm_stats.frames, srm_stats.passthrough, srm_stats.failures, srm_stats.last_us,
+                 srm_stats.frames ? (uint32_t)(srm_stats.total_us / srm_stats.frames) : 0, srm_stats.max_us);
+    }
+
+    frame_pool_stats_t pool_stats;
+    frame_pool_get_stats(adapter->decode_pool, &pool_stats);
+    ESP_LOGI(TAG, "Decode buffers: %u/%u allocated (%zu bytes), peak in use %u, waits %u",
+             pool_stats.allocated, pool_stats.depth, pool_stats.allocated_bytes,
+             pool_stats.in_use_peak, pool_stats.acquire_waits);
+}
+
+// Put the primed first frame of a prepared clip at the head of the frame ring,
+// through the SRM stage like any decoded frame. No task runs yet, so the only
+// present buffer not free is the one the display shows.
+static void queue_primed_frame(app_stream_adapter_t *adapter)
+{
+    if (adapter->primed.buffer == NULL) {
+        return;
+    }
+
+    stream_frame_t *frame = &adapter->frames[spsc_ring_head_slot(&adapter->frame_ring)];
+    *frame = adapter->primed;
+    adapter->primed.buffer = NULL;
+
+    if (adapter->transform) {
+        transform_frame(adapter, frame, true);
+    }
+    spsc_ring_push(&adapter->frame_ring);
+}
+
+// Start demux, decode and present tasks
+static esp_err_t start_extract_task(app_stream_adapter_t *adapter)
+{
+    stop_extract_task(adapter);
+
+    xEventGroupClearBits(adapter->extract_event_group, PIPELINE_ALL_BITS);
+
+    // Rings are only touched by stopped tasks here, so a plain reset is safe
+    spsc_ring_init(&adapter->packet_ring, APP_STREAM_DEMUX_RING_DEPTH);
+    spsc_ring_init(&adapter->frame_ring, adapter->frame_buffer_count);
+    adapter->demux_stats.queue_depth = 0;
+    adapter->decode_stats.queue_depth = 0;
+    adapter->pipeline_stop = false;
+    adapter->paused = false;
+    adapter->fps_window_us = 0;
+    adapter->fps_window_frames = 0;
+    adapter->demux_eos = false;
+    adapter->decode_eos = false;
+    adapter->eos_reported = false;
+    adapter->clock_started = false;
+    adapter->speed = adapter->target_speed;
+    adapter->skim_credit = APP_STREAM_SPEED_MAX;      // Passes the first frame on at any speed
+    video_transform_reset_stats(adapter->transform);
+    queue_primed_frame(adapter);
+
+    BaseType_t ret = xTaskCreate(present_task, "present_task",
+                                 PRESENT_TASK_STACK_SIZE, adapter,
+                                 PRESENT_TASK_PRIORITY,
+                                 &adapter->present_task_handle);
+    if (ret == pdPASS) {
+        ret = xTaskCreate(decode_task, "decode_task",
+                          DECODE_TASK_STACK_SIZE, adapter,
+                          DECODE_TASK_PRIORITY,
+                          &adapter->decode_task_handle);
+    }
+    if (ret == pdPASS) {
+        ret = xTaskCreate(extract_task, "extract_task",
+                          DEMUX_TASK_STACK_SIZE, adapter,
+                          DEMUX_TASK_PRIORITY,
+                          &adapter->extract_task_handle);
+    }
+
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create pipeline tasks");
+        stop_extract_task(adapter);
+        return ESP_FAIL;
+    }
+
+    xEventGroupSetBits(adapter->extract_event_group, EXTRACT_TASK_START_BIT);
+
+    return ESP_OK;
+}
+
+// The JPEG engine writes whole 16x16 MCU blocks
+static size_t decode_buffer_size(const app_stream_adapter_t *adapter, uint32_t width, uint32_t height)
+{
+    uint32_t bpp = adapter->jpeg_config.output_format == APP_STREAM_JPEG_OUTPUT_RGB888 ? 3 : 2;
+    return (size_t)((width + 15) & ~15U) * ((height + 15) & ~15U) * bpp;
+}
+
+// Size the frame pools for the stream about to play. Buffers of another size are
+// freed once idle, so a 600p clip does not keep 1080p buffers around.
+static esp_err_t size_frame_pools(app_stream_adapter_t *adapter)
+{
+    uint32_t width = adapter->has_info ? adapter->width : adapter->max_width;
+    uint32_t height = adapter->has_info ? adapter->height : adapter->max_height;
+    if (width == 0 || height == 0) {
+        ESP_LOGE(TAG, "Unknown frame size");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    size_t decode_size = decode_buffer_size(adapter, width, height);
+    esp_err_t ret = frame_pool_set_buffer_size(adapter->decode_pool, decode_size);
+    if (ret != ESP_OK || adapter->present_pool == NULL) {
+        return ret;
+    }
+
+    video_transform_plan_t plan;
+    size_t present_size = 0;
+    if (video_transform_plan(adapter->transform, width, height, decode_size, &plan) == ESP_OK &&
+            !plan.passthrough) {
+        present_size = (size_t)plan.out_width * plan.out_height * 2;
+    }
+    adapter->present_size = present_size;
+    return frame_pool_set_buffer_size(adapter->present_pool, present_size);
+}
+
+// A clip indexed before has its largest frame in the index cache; its extractor
+// then gets an output pool of that size instead of the 1080p worst case
+static void size_output_pool(app_stream_adapter_t *adapter, app_extractor_handle_t extractor,
+                             const char *filename)
+{
+    uint32_t max_frame_size = 0;
+    if (adapter->build_frame_index && adapter->cache_dir != NULL &&
+            frame_index_peek_max_size(filename, adapter->cache_dir, &max_frame_size) == ESP_OK) {
+        app_extractor_set_max_frame_size(extractor, max_frame_size);
+    }
+}
+
+// Hand the stored resume info of filename to the extractor about to open it, so
+// the open skips the container parse. Returns the position playback stopped at.
+static uint32_t resume_load(app_stream_adapter_t *adapter, app_extractor_handle_t extractor,
+                            const char *filename, esp_extractor_resume_info_t *info)
+{
+    uint32_t position_ms = 0;
+    if (!adapter->resume_playback || adapter->cache_dir == NULL ||
+            resume_store_load(adapter->cache_dir, filename, info, &position_ms) != ESP_OK) {
+        return 0;
+    }
+    app_extractor_set_resume_info(extractor, info);
+    return position_ms;
+}
+
+// A restored extractor carries on from where its resume info was taken, a few
+// frames past the one that was on screen; go back to that frame. Returns the
+// position playback starts at.
+static uint32_t resume_seek(app_extractor_handle_t extractor, const esp_extractor_resume_info_t *info,
+                            uint32_t position_ms)
+{
+    bool resumed = app_extractor_is_resumed(extractor);
+    if ((!resumed && position_ms == 0) || (resumed && info->time == position_ms)) {
+        return position_ms;
+    }
+    if (app_extractor_seek(extractor, position_ms) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to seek to resume position %u ms", position_ms);
+        return resumed ? info->time : 0;
+    }
+    return position_ms;
+}
+
+// Remember where the current clip stopped. Its extractor state is only written
+// the first time, later stops rewrite just the position.
+static void resume_save(app_stream_adapter_t *adapter)
+{
+    if (!adapter->resume_playback || adapter->cache_dir == NULL) {
+        return;
+    }
+
+    uint32_t position_ms = adapter->scrubbed ? adapter->scrub_pts :
+                           adapter->frame_count > 0 ? adapter->presented_pts - adapter->presented_offset :
+                           adapter->resume_ms;
+    // Near either end the clip starts over, the entry still saves it the parse
+    if (position_ms < RESUME_MIN_POSITION_MS ||
+            (adapter->duration > 0 && position_ms + RESUME_END_MARGIN_MS >= adapter->duration)) {
+        position_ms = 0;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = resume_store_set_position(adapter->cache_dir, adapter->filename, position_ms);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        esp_extractor_resume_info_t info;
+        ret = app_extractor_get_resume_info(adapter->extractor_handle, &info);
+        if (ret == ESP_OK) {
+            ret = resume_store_save(adapter->cache_dir, adapter->filename, &info, position_ms);
+            esp_extractor_free_resume_info(&info);
+        }
+    }
+    if (ret == ESP_OK) {
+        ESP_LOGD(TAG, "Resume point of %s at %u ms, stored in %lld ms", adapter->filename, position_ms,
+                 (esp_timer_get_time() - start_us) / 1000);
+    }
+}
+
+// Read the prepared clip up to its first video frame and decode it. Audio read on
+// the way waits in the extractor's audio ring until the clip starts.
+static esp_err_t prime_first_frame(app_stream_adapter_t *adapter)
+{
+    stream_prepared_t *prepared = &adapter->prepared;
+    esp_err_t ret = ESP_OK;
+
+    // The H.264 decoder belongs to the clip playing, H.264 clips open on start
+    extractor_video_format_t format = EXTRACTOR_VIDEO_FORMAT_MJPEG;
+    app_extractor_get_video_codec(prepared->extractor, &format, NULL, NULL);
+    if (format != EXTRACTOR_VIDEO_FORMAT_MJPEG) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    for (uint32_t reads = 0; prepared->packet.data == NULL; reads++) {
+        if (prepared->cancel || reads == PREPARE_MAX_READS) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        ret = app_extractor_read_frame(prepared->extractor);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    uint32_t width = adapter->max_width;
+    uint32_t height = adapter->max_height;
+    app_extractor_get_video_info(prepared->extractor, &width, &height, NULL, NULL);
+    frame_pool_set_buffer_size(adapter->prepared_pool, decode_buffer_size(adapter, width, height));
+
+    // The display may still hold the frame primed for the clip playing now
+    size_t buffer_size = 0;
+    stream_frame_t *frame = &prepared->frame;
+    frame->buffer = frame_pool_acquire(adapter->prepared_pool, PREPARE_WAIT_MS, &buffer_size);
+    frame->pool = adapter->prepared_pool;
+    frame->pts = prepared->packet.pts;
+    if (frame->buffer == NULL) {
+        ret = ESP_ERR_TIMEOUT;
+    } else {
+        // The clip playing keeps the engine first
+        ret = decode_jpeg_frame(adapter, JPEG_SCHED_BACKGROUND, NULL, prepared->packet.data,
+                                prepared->packet.size, frame->buffer, buffer_size,
+                                &frame->width, &frame->height, &frame->size);
+    }
+
+    app_extractor_release_frame(prepared->extractor, prepared->packet.data);
+    prepared->packet.data = NULL;
+    if (ret != ESP_OK && frame->buffer != NULL) {
+        frame_pool_release(frame->pool, frame->buffer);
+        frame->buffer = NULL;
+    }
+    return ret;
+}
+
+static void prepare_task(void *arg)
+{
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)arg;
+    stream_prepared_t *prepared = &adapter->prepared;
+    int64_t start_us = esp_timer_get_time();
+
+    app_extractor_set_frame_cb(prepared->extractor, prepare_frame_callback);
+    esp_extractor_resume_info_t resume_info = {0};
+    uint32_t resume_ms = resume_load(adapter, prepared->extractor, prepared->filename, &resume_info);
+    size_output_pool(adapter, prepared->extractor, prepared->filename);
+    esp_err_t ret = app_extractor_prepare(prepared->extractor, prepared->filename, true,
+                                          prepared->extract_audio);
+    if (ret == ESP_OK) {
+        prepared->resumed = app_extractor_is_resumed(prepared->extractor);
+        prepared->resume_ms = resume_seek(prepared->extractor, &resume_info, resume_ms);
+        ret = prime_first_frame(adapter);
+    }
+    resume_store_free(&resume_info);
+
+    prepared->prepare_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Prepared %s in %u ms", prepared->filename, prepared->prepare_ms);
+    } else if (!prepared->cancel && ret != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGW(TAG, "Failed to prepare %s: %s", prepared->filename, esp_err_to_name(ret));
+    }
+    prepared->state = ret == ESP_OK ? PREPARE_READY : PREPARE_FAILED;
+
+    xEventGroupSetBits(adapter->extract_event_group, PREPARE_TASK_DONE_BIT);
+    vTaskDelete(NULL);
+}
+
+// Wait for a running prepare task. Returns false if it did not finish in time.
+static bool prepare_wait(app_stream_adapter_t *adapter)
+{
+    if (adapter->prepared.state != PREPARE_BUSY) {
+        return true;
+    }
+    xEventGroupWaitBits(adapter->extract_event_group, PREPARE_TASK_DONE_BIT,
+                        pdFALSE, pdTRUE, pdMS_TO_TICKS(PREPARE_WAIT_MS));
+    return adapter->prepared.state != PREPARE_BUSY;
+}
+
+// Empty the prepared slot, closing its clip
+static void prepare_discard(app_stream_adapter_t *adapter)
+{
+    stream_prepared_t *prepared = &adapter->prepared;
+    if (prepared->state == PREPARE_IDLE) {
+        return;
+    }
+
+    prepared->cancel = true;
+    if (!prepare_wait(adapter)) {
+        // Still parsing; the task owns the extractor until it is done
+        xEventGroupWaitBits(adapter->extract_event_group, PREPARE_TASK_DONE_BIT,
+                            pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+
+    if (prepared->frame.buffer != NULL) {
+        frame_pool_release(prepared->frame.pool, prepared->frame.buffer);
+        prepared->frame.buffer = NULL;
+    }
+    app_extractor_stop(prepared->extractor);
+    prepared->cancel = false;
+    prepared->state = PREPARE_IDLE;
+}
+
+// Switch to the prepared clip if it is the one set. Returns true with the
+// prepared extractor in place and its first frame in adapter->primed.
+static bool prepare_take(app_stream_adapter_t *adapter)
+{
+    stream_prepared_t *prepared = &adapter->prepared;
+    if (prepared->state == PREPARE_IDLE) {
+        return false;
+    }
+    if (strcmp(prepared->filename, adapter->filename) != 0 || prepared->extract_audio != adapter->extract_audio ||
+            !prepare_wait(adapter) || prepared->state != PREPARE_READY) {
+        prepare_discard(adapter);
+        return false;
+    }
+
+    // The finished clip's extractor becomes the idle one
+    app_extractor_handle_t idle = adapter->extractor_handle;
+    adapter->extractor_handle = prepared->extractor;
+    prepared->extractor = idle;
+    app_extractor_set_frame_cb(adapter->extractor_handle, extractor_frame_callback);
+
+    adapter->primed = prepared->frame;
+    prepared->frame.buffer = NULL;
+    adapter->prepare_ms = prepared->prepare_ms;
+    adapter->resumed = prepared->resumed;
+    adapter->resume_ms = prepared->resume_ms;
+    prepared->state = PREPARE_IDLE;
+    return true;
+}
+
+static void release_primed_frame(app_stream_adapter_t *adapter)
+{
+    if (adapter->primed.buffer != NULL) {
+        frame_pool_release(adapter->primed.pool, adapter->primed.buffer);
+        adapter->primed.buffer = NULL;
+    }
+}
+
+// Load or build the frame index of the clip that just started. Runs below the
+// pipeline; the cached index of a clip played before loads in a few ms.
+static void index_task(void *arg)
+{
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)arg;
+    frame_index_handle_t index = NULL;
+
+    if (frame_index_open(adapter->index_path, adapter->cache_dir, &index) == ESP_OK) {
+        adapter->index = index;
+    }
+    adapter->index_busy = false;
+
+    xEventGroupSetBits(adapter->extract_event_group, INDEX_TASK_DONE_BIT);
+    vTaskDelete(NULL);
+}
+
+static void index_start(app_stream_adapter_t *adapter)
+{
+    // Only MJPEG frames can be decoded on their own
+    if (!adapter->build_frame_index || adapter->h264 != NULL || strlen(adapter->filename) >= APP_STREAM_PATH_MAX) {
+        return;
+    }
+
+    strcpy(adapter->index_path, adapter->filename);
+    adapter->index_busy = true;
+    xEventGroupClearBits(adapter->extract_event_group, INDEX_TASK_DONE_BIT);
+    if (xTaskCreate(index_task, "index_task", INDEX_TASK_STACK_SIZE, adapter,
+                    INDEX_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGW(TAG, "Failed to create index task, seeking without a frame index");
+        adapter->index_busy = false;
+    }
+}
+
+// Drop the index of the previous clip, waiting for its task if still building
+static void index_release(app_stream_adapter_t *adapter)
+{
+    if (adapter->index_busy) {
+        xEventGroupWaitBits(adapter->extract_event_group, INDEX_TASK_DONE_BIT,
+                            pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+    frame_index_close(adapter->index);
+    adapter->index = NULL;
+}
+
+// Store the sample tables of a clip whose moov follows its media data, as a
+// resume entry at position 0. Its first start then restores them instead of
+// reading through to the end of the file. Fast-start clips open quickly anyway
+// and get their entry when first stopped.
+static void parse_ahead_clip(app_stream_adapter_t *adapter, app_extractor_handle_t extractor, const char *filename)
+{
+    // The clip playing or prepared stores its own entry when it stops. Both names
+    // change under the control task, so compare against a consistent snapshot.
+    portENTER_CRITICAL(&adapter->clip_lock);
+    bool in_use = strcmp(filename, adapter->filename) == 0 ||
+                  (adapter->prepared.state != PREPARE_IDLE && strcmp(filename, adapter->prepared.filename) == 0);
+    portEXIT_CRITICAL(&adapter->clip_lock);
+    if (in_use) {
+        return;
+    }
+    mp4_layout_t layout;
+    if (resume_store_contains(adapter->cache_dir, filename) ||
+            mp4_layout_probe(filename, &layout) != ESP_OK || !layout.moov_at_end) {
+        return;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    // The streams playback opens, or start would reject the entry and parse again
+    esp_err_t ret = app_extractor_prepare(extractor, filename, true, adapter->audio_dev != NULL);
+    if (ret == ESP_OK) {
+        esp_extractor_resume_info_t info;
+        ret = app_extractor_get_resume_info(extractor, &info);
+        if (ret == ESP_OK) {
+            ret = resume_store_save(adapter->cache_dir, filename, &info, 0);
+            esp_extractor_free_resume_info(&info);
+        }
+    }
+    app_extractor_stop(extractor);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Parsed %s ahead (moov at %u KB) in %lld ms", filename, layout.moov_offset / 1024,
+                 (esp_timer_get_time() - start_us) / 1000);
+    } else {
+        ESP_LOGW(TAG, "Failed to parse %s ahead: %s", filename, esp_err_to_name(ret));
+    }
+}
+
+// Work through the clips app_stream_adapter_parse_ahead() queued. Runs below the
+// pipeline and the prepare task; its extractor only exists while clips wait.
+static void parse_ahead_task(void *arg)
+{
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)arg;
+    app_extractor_handle_t extractor = NULL;
+    char *filename = NULL;
+
+    while (!adapter->parse_ahead_stop) {
+        filename = NULL;
+        if (xQueueReceive(adapter->parse_ahead_queue, &filename, 0) != pdTRUE) {
+            if (extractor != NULL) {
+                app_extractor_deinit(extractor);
+                extractor = NULL;
+            }
+            xQueueReceive(adapter->parse_ahead_queue, &filename, portMAX_DELAY);
+        }
+        // NULL is deinit waking the task to exit
+        if (filename == NULL || adapter->parse_ahead_stop) {
+            free(filename);
+            break;
+        }
+        if (extractor == NULL && app_extractor_init(NULL, adapter->audio_dev, &extractor) != ESP_OK) {
+            ESP_LOGW(TAG, "No extractor to parse %s ahead with", filename);
+            extractor = NULL;
+        }
+        if (extractor != NULL) {
+            parse_ahead_clip(adapter, extractor, filename);
+        }
+        free(filename);
+    }
+
+    if (extractor != NULL) {
+        app_extractor_deinit(extractor);
+    }
+    xEventGroupSetBits(adapter->extract_event_group, PARSE_AHEAD_DONE_BIT);
+    vTaskDelete(NULL);
+}
+
+// Stop the parse ahead task and drop the clips still queued
+static void parse_ahead_release(app_stream_adapter_t *adapter)
+{
+    if (adapter->parse_ahead_queue == NULL) {
+        return;
+    }
+    if (adapter->parse_ahead_task_handle != NULL) {
+        adapter->parse_ahead_stop = true;
+        // A full queue means the task is not blocked on it and sees parse_ahead_stop next
+        char *wake = NULL;
+        xQueueSendToFront(adapter->parse_ahead_queue, &wake, 0);
+        xEventGroupWaitBits(adapter->extract_event_group, PARSE_AHEAD_DONE_BIT,
+                            pdFALSE, pdTRUE, portMAX_DELAY);
+        adapter->parse_ahead_task_handle = NULL;
+    }
+
+    char *filename = NULL;
+    while (xQueueReceive(adapter->parse_ahead_queue, &filename, 0) == pdTRUE) {
+        free(filename);
+    }
+    vQueueDelete(adapter->parse_ahead_queue);
+    adapter->parse_ahead_queue = NULL;
+}
+
+// Free the H.264 decoder and its reference pictures between clips
+static void video_codec_close(app_stream_adapter_t *adapter)
+{
+    h264_decoder_delete(adapter->h264);
+    adapter->h264 = NULL;
+}
+
+// Open the software decoder when the clip started is H.264; MJPEG clips go to the JPEG engine
+static esp_err_t video_codec_open(app_stream_adapter_t *adapter)
+{
+    extractor_video_format_t format = EXTRACTOR_VIDEO_FORMAT_MJPEG;
+    const uint8_t *spec_info = NULL;
+    uint32_t spec_info_len = 0;
+    app_extractor_get_video_codec(adapter->extractor_handle, &format, &spec_info, &spec_info_len);
+    if (format != EXTRACTOR_VIDEO_FORMAT_H264) {
+        return ESP_OK;
+    }
+
+#if CONFIG_VIDEO_H264_DECODE
+    esp_err_t ret = h264_decoder_create(CONFIG_VIDEO_H264_MAX_WIDTH, CONFIG_VIDEO_H264_MAX_HEIGHT, &adapter->h264);
+    if (ret == ESP_OK) {
+        ret = h264_decoder_set_config(adapter->h264, spec_info, spec_info_len);
+    }
+    if (ret != ESP_OK) {
+        video_codec_close(adapter);
+    }
+    return ret;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+// Read, decode and show one frame through the index, with the pipeline stopped
+static esp_err_t show_indexed_frame(app_stream_adapter_t *adapter, uint32_t frame_number)
+{
+    const frame_index_entry_t *entry = frame_index_get(adapter->index, frame_number);
+    if (entry == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Sized once for the largest frame of the clip
+    if (adapter->scrub_input_size < frame_index_max_size(adapter->index)) {
+        free(adapter->scrub_input);
+        jpeg_decode_memory_alloc_cfg_t mem_cfg = {
+            .buffer_direction = JPEG_DEC_ALLOC_INPUT_BUFFER,
+        };
+        adapter->scrub_input = jpeg_alloc_decoder_mem(frame_index_max_size(adapter->index), &mem_cfg,
+                                                      &adapter->scrub_input_size);
+        if (adapter->scrub_input == NULL) {
+            adapter->scrub_input_size = 0;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    esp_err_t ret = frame_index_read(adapter->index, frame_number, adapter->scrub_input, adapter->scrub_input_size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    size_t buffer_size = 0;
+    stream_frame_t frame = {
+        .buffer = frame_pool_acquire(adapter->decode_pool, SCRUB_WAIT_MS, &buffer_size),
+        .pool = adapter->decode_pool,
+        .pts = entry->pts_ms,
+    };
+    if (frame.buffer == NULL) {
+        return ESP_ERR_TIMEOUT;
+    }
+    ret = decode_jpeg_frame(adapter, JPEG_SCHED_VIDEO, NULL, adapter->scrub_input, entry->size,
+                            frame.buffer, buffer_size, &frame.width, &frame.height, &frame.size);
+    if (ret != ESP_OK) {
+        frame_pool_release(frame.pool, frame.buffer);
+        return ret;
+    }
+
+    if (adapter->transform) {
+        transform_frame(adapter, &frame, false);
+    }
+    return present_frame(adapter, &frame);
+}
+
+esp_err_t app_stream_adapter_init(const app_stream_adapter_config_t *config,
+                                  app_stream_adapter_handle_t *ret_adapter)
+{
+    if (config == NULL || ret_adapter == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // One buffer is always on screen, so decode needs at least one more
+    if (config->frame_buffer_count < 2) {
+        ESP_LOGE(TAG, "At least 2 frame buffers are required");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)calloc(1, sizeof(app_stream_adapter_t));
+    if (adapter == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate adapter context");
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = ESP_OK;
+
+    adapter->frame_cb = config->frame_cb;
+    adapter->eos_cb = config->eos_cb;
+    adapter->user_data = config->user_data;
+    adapter->frame_buffer_count = config->frame_buffer_count;
+    adapter->max_width = config->max_width;
+    adapter->max_height = config->max_height;
+    adapter->display_releases_frames = config->display_releases_frames;
+    adapter->running = false;
+    adapter->frame_count = 0;
+    adapter->has_info = false;
+    portMUX_INITIALIZE(&adapter->clock_lock);
+    portMUX_INITIALIZE(&adapter->clip_lock);
+    adapter->speed = APP_STREAM_SPEED_NORMAL;
+    adapter->target_speed = APP_STREAM_SPEED_NORMAL;
+
+    adapter->jpeg_config = config->jpeg_config;
+    adapter->transform = config->transform;
+    adapter->build_frame_index = config->frame_index;
+    adapter->resume_playback = config->resume_playback;
+    adapter->skip_duplicates = config->skip_duplicate_frames;
+    adapter->cache_dir = config->cache_dir;
+    adapter->audio_dev = config->audio_dev;
+    adapter->extract_audio = (config->audio_dev != NULL);
+
+    adapter->frames = calloc(adapter->frame_buffer_count, sizeof(stream_frame_t));
+    if (adapter->frames == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate frame slots");
+        ret = ESP_ERR_NO_MEM;
+        goto cleanup;
+    }
+
+    // Buffers are allocated on first use, sized for the stream in app_stream_adapter_start()
+    frame_pool_config_t pool_config = {
+        .name = "decode",
+        .depth = adapter->frame_buffer_count,
+    };
+    ret = frame_pool_create(&pool_config, &adapter->decode_pool);
+    if (ret == ESP_OK && adapter->transform != NULL) {
+        pool_config.name = "present";
+        ret = frame_pool_create(&pool_config, &adapter->present_pool);
+    }
+    if (ret == ESP_OK) {
+        pool_config.name = "prepared";
+        pool_config.depth = 1;
+        ret = frame_pool_create(&pool_config, &adapter->prepared_pool);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create frame pools: %d", ret);
+        goto cleanup;
+    }
+
+    // Create event group for task control
+    adapter->extract_event_group = xEventGroupCreate();
+    if (adapter->extract_event_group == NULL) {
+        ESP_LOGE(TAG, "Failed to create extract event group");
+        ret = ESP_ERR_NO_MEM;
+        goto cleanup;
+    }
+
+    // Clips are only parsed ahead into resume entries
+    if (adapter->resume_playback && adapter->cache_dir != NULL) {
+        adapter->parse_ahead_queue = xQueueCreate(PARSE_AHEAD_QUEUE_DEPTH, sizeof(char *));
+        if (adapter->parse_ahead_queue == NULL) {
+            ESP_LOGE(TAG, "Failed to create parse ahead queue");
+            ret = ESP_ERR_NO_MEM;
+            goto cleanup;
+        }
+    }
+
+    ret = jpeg_hw_init(adapter);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize JPEG decoder: %d", ret);
+        goto cleanup;
+    }
+
+    g_adapter_instance = adapter;
+
+    if (config->audio_dev) {
+        ret = app_extractor_init(extractor_frame_callback, config->audio_dev, &adapter->extractor_handle);
+    } else {
+        ret = app_extractor_init(extractor_frame_callback, NULL, &adapter->extractor_handle);
+    }
+    if (ret == ESP_OK) {
+        // Only opens a file when a clip is prepared
+        ret = app_extractor_init(prepare_frame_callback, config->audio_dev, &adapter->prepared.extractor);
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize extractor: %d", ret);
+        g_adapter_instance = NULL;
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "Stream adapter initialized%s: %d compressed slots, %u frame buffers per pool",
+             config->audio_dev ? " with audio" : "", APP_STREAM_DEMUX_RING_DEPTH, adapter->frame_buffer_count);
+    *ret_adapter = adapter;
+    return ESP_OK;
+
+cleanup:
+    if (adapter->extractor_handle != NULL) {
+        app_extractor_deinit(adapter->extractor_handle);
+    }
+    if (adapter->jpeg_handle != NULL) {
+        shared_jpeg_decoder_release();
+    }
+    if (adapter->parse_ahead_queue != NULL) {
+        vQueueDelete(adapter->parse_ahead_queue);
+    }
+    if (adapter->extract_event_group != NULL) {
+        vEventGroupDelete(adapter->extract_event_group);
+    }
+    frame_pool_delete(adapter->prepared_pool);
+    frame_pool_delete(adapter->present_pool);
+    frame_pool_delete(adapter->decode_pool);
+    free(adapter->frames);
+    free(adapter);
+    return ret;
+}
+
+esp_err_t app_stream_adapter_set_file(app_stream_adapter_handle_t handle,
+                                      const char *filename,
+                                      bool extract_audio)
+{
+    if (handle == NULL || filename == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (strlen(filename) >= APP_STREAM_PATH_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)handle;
+
+    if (adapter->running) {
+        app_stream_adapter_stop(handle);
     }
 
-    adapter->filename = filename;
+    portENTER_CRITICAL(&adapter->clip_lock);
+    strcpy(adapter->filename, filename);
+    portEXIT_CRITICAL(&adapter->clip_lock);
     adapter->frame_count = 0;
     adapter->has_info = false;
     adapter->width = 0;
     adapter->height = 0;
     adapter->fps = 0;
     adapter->duration = 0;
-    adapter->current_buffer = adapter->buffer_count - 1;  // Reset buffer index
     adapter->extract_audio = extract_audio && (adapter->audio_dev != NULL);
 
     ESP_LOGI(TAG, "Set media file: %s, extract_audio: %d",
@@ -667,23 +2222,60 @@ esp_err_t app_stream_adapter_start(app_stream_adapter_handle_t handle)
         return ESP_OK;
     }
 
-    if (adapter->filename == NULL) {
+    if (adapter->filename[0] == '\0') {
         return ESP_ERR_INVALID_STATE;
     }
 
-    g_reset_callback_counter = true;
     g_adapter_instance = adapter;
-    
+    index_release(adapter);
+    adapter->scrubbed = false;
+
+    adapter->start_us = esp_timer_get_time();
+    adapter->stop_us = 0;
+    adapter->first_frame_ms = 0;
+    adapter->prepare_ms = 0;
+    adapter->presented_pts = 0;
+    adapter->resumed = false;
+    adapter->resume_ms = 0;
+    adapter->started_prepared = prepare_take(adapter);
+
     adapter->frame_count = 0;
     adapter->has_info = false;
-    adapter->current_buffer = adapter->buffer_count - 1;
+    memset(&adapter->demux_stats, 0, sizeof(adapter->demux_stats));
+    memset(&adapter->decode_stats, 0, sizeof(adapter->decode_stats));
+    memset(&adapter->present_stats, 0, sizeof(adapter->present_stats));
+    memset(&adapter->sync_stats, 0, sizeof(adapter->sync_stats));
+    memset(&adapter->decode_time, 0, sizeof(adapter->decode_time));
+    memset(&adapter->duplicate_stats, 0, sizeof(adapter->duplicate_stats));
+    adapter->current_fps = 0;
+    adapter->frames_skimmed = 0;
+    adapter->target_speed = APP_STREAM_SPEED_NORMAL;
+    adapter->presented_offset = 0;
+    memset(&adapter->loop_stats, 0, sizeof(adapter->loop_stats));
+
+    // A prepared clip was reopened at its resume point by the prepare task
+    esp_extractor_resume_info_t resume_info = {0};
+    uint32_t resume_ms = 0;
+    if (!adapter->started_prepared) {
+        resume_ms = resume_load(adapter, adapter->extractor_handle, adapter->filename, &resume_info);
+        size_output_pool(adapter, adapter->extractor_handle, adapter->filename);
+    }
 
     ret = app_extractor_start(adapter->extractor_handle, adapter->filename,
                               true, adapter->extract_audio);
+    if (ret == ESP_OK && !adapter->started_prepared) {
+        adapter->resumed = app_extractor_is_resumed(adapter->extractor_handle);
+        adapter->resume_ms = resume_seek(adapter->extractor_handle, &resume_info, resume_ms);
+    }
+    resume_store_free(&resume_info);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to start extractor: %d", ret);
+        release_primed_frame(adapter);
         return ret;
     }
+    if (adapter->resume_ms > 0) {
+        ESP_LOGI(TAG, "Resuming %s at %u ms", adapter->filename, adapter->resume_ms);
+    }
 
     uint32_t width, height, fps, duration;
     ret = app_extractor_get_video_info(adapter->extractor_handle,
@@ -696,6 +2288,17 @@ esp_err_t app_stream_adapter_start(app_stream_adapter_handle_t handle)
         adapter->has_info = true;
     }
 
+    ret = video_codec_open(adapter);
+    if (ret == ESP_OK) {
+        ret = size_frame_pools(adapter);
+    }
+    if (ret != ESP_OK) {
+        video_codec_close(adapter);
+        release_primed_frame(adapter);
+        app_extractor_stop(adapter->extractor_handle);
+        return ret;
+    }
+
     if (adapter->extract_audio) {
         uint32_t sample_rate, duration;
         uint8_t channels, bits;
@@ -703,14 +2306,92 @@ esp_err_t app_stream_adapter_start(app_stream_adapter_handle_t handle)
                                            &sample_rate, &channels, &bits, &duration);
     }
 
+    app_extractor_set_loop(adapter->extractor_handle, adapter->loop);
     ret = start_extract_task(adapter);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to start extract task: %d", ret);
+        drain_frame_ring(adapter);
+        video_codec_close(adapter);
         app_extractor_stop(adapter->extractor_handle);
         return ret;
     }
 
     adapter->running = true;
+    index_start(adapter);
+    return ESP_OK;
+}
+
+esp_err_t app_stream_adapter_prepare(app_stream_adapter_handle_t handle,
+                                     const char *filename,
+                                     bool extract_audio)
+{
+    if (handle == NULL || filename == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (strlen(filename) >= APP_STREAM_PATH_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)handle;
+    stream_prepared_t *prepared = &adapter->prepared;
+    extract_audio = extract_audio && (adapter->audio_dev != NULL);
+
+    if (prepared->state != PREPARE_IDLE && prepared->state != PREPARE_FAILED &&
+            strcmp(prepared->filename, filename) == 0 && prepared->extract_audio == extract_audio) {
+        return ESP_OK;
+    }
+    prepare_discard(adapter);
+
+    portENTER_CRITICAL(&adapter->clip_lock);
+    strcpy(prepared->filename, filename);
+    prepared->state = PREPARE_BUSY;
+    portEXIT_CRITICAL(&adapter->clip_lock);
+    prepared->extract_audio = extract_audio;
+    prepared->resumed = false;
+    prepared->resume_ms = 0;
+    xEventGroupClearBits(adapter->extract_event_group, PREPARE_TASK_DONE_BIT);
+
+    BaseType_t ret = xTaskCreate(prepare_task, "prepare_task",
+                                 PREPARE_TASK_STACK_SIZE, adapter,
+                                 PREPARE_TASK_PRIORITY, NULL);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create prepare task");
+        prepared->state = PREPARE_IDLE;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t app_stream_adapter_parse_ahead(app_stream_adapter_handle_t handle, const char *filename)
+{
+    if (handle == NULL || filename == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)handle;
+    if (adapter->parse_ahead_queue == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    char *queued = strdup(filename);
+    if (queued == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xQueueSend(adapter->parse_ahead_queue, &queued, 0) != pdTRUE) {
+        free(queued);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (adapter->parse_ahead_task_handle == NULL) {
+        xEventGroupClearBits(adapter->extract_event_group, PARSE_AHEAD_DONE_BIT);
+        if (xTaskCreate(parse_ahead_task, "parse_ahead", PARSE_AHEAD_STACK_SIZE, adapter,
+                        PARSE_AHEAD_PRIORITY, &adapter->parse_ahead_task_handle) != pdPASS) {
+            // Left queued; the next call tries the task again
+            ESP_LOGW(TAG, "Failed to create parse ahead task");
+            adapter->parse_ahead_task_handle = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+    }
     return ESP_OK;
 }
 
@@ -727,12 +2408,54 @@ esp_err_t app_stream_adapter_stop(app_stream_adapter_handle_t handle)
     }
 
     stop_extract_task(adapter);
+    video_codec_close(adapter);
+    resume_save(adapter);
     app_extractor_stop(adapter->extractor_handle);
+    adapter->scrubbed = false;
+    adapter->stop_us = esp_timer_get_time();
 
+    // Without display releases the last frame stays on screen until the next clip replaces it
     adapter->running = false;
     return ESP_OK;
 }
 
+esp_err_t app_stream_adapter_release_buffers(app_stream_adapter_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)handle;
+    if (adapter->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    prepare_discard(adapter);
+    release_primed_frame(adapter);
+    index_release(adapter);
+
+    frame_pool_handle_t pools[] = { adapter->decode_pool, adapter->present_pool, adapter->prepared_pool };
+    size_t released = adapter->scrub_input_size;
+    size_t on_screen = 0;
+    for (size_t i = 0; i < sizeof(pools) / sizeof(pools[0]); i++) {
+        frame_pool_stats_t before = {0};
+        frame_pool_stats_t after = {0};
+        frame_pool_get_stats(pools[i], &before);
+        // Buffers the display still reads go when it releases them
+        frame_pool_set_buffer_size(pools[i], 0);
+        frame_pool_get_stats(pools[i], &after);
+        released += before.allocated_bytes - after.allocated_bytes;
+        on_screen += after.allocated_bytes;
+    }
+    free(adapter->scrub_input);
+    adapter->scrub_input = NULL;
+    adapter->scrub_input_size = 0;
+
+    ESP_LOGI(TAG, "Released %zu KB of video buffers, %zu KB more once off screen", released / 1024,
+             on_screen / 1024);
+    return ESP_OK;
+}
+
 esp_err_t app_stream_adapter_pause(app_stream_adapter_handle_t handle)
 {
     if (handle == NULL) {
@@ -745,6 +2468,7 @@ esp_err_t app_stream_adapter_pause(app_stream_adapter_handle_t handle)
         return ESP_ERR_INVALID_STATE;
     }
 
+    adapter->paused = true;
     xEventGroupSetBits(adapter->extract_event_group, EXTRACT_TASK_PAUSE_BIT);
     return ESP_OK;
 }
@@ -761,7 +2485,19 @@ esp_err_t app_stream_adapter_resume(app_stream_adapter_handle_t handle)
         return ESP_ERR_INVALID_STATE;
     }
 
+    if (adapter->scrubbed) {
+        // Scrubbing stopped the pipeline; carry on from the frame left on screen
+        adapter->scrubbed = false;
+        esp_err_t ret = app_extractor_seek(adapter->extractor_handle, adapter->scrub_pts);
+        if (ret == ESP_OK) {
+            ret = start_extract_task(adapter);
+        }
+        return ret;
+    }
+
+    adapter->paused = false;
     xEventGroupSetBits(adapter->extract_event_group, EXTRACT_TASK_RESUME_BIT);
+    stage_signal(adapter->present_task_handle);
     return ESP_OK;
 }
 
@@ -774,12 +2510,23 @@ esp_err_t app_stream_adapter_seek(app_stream_adapter_handle_t handle, uint32_t p
     app_stream_adapter_t *adapter = (app_stream_adapter_t *)handle;
     esp_err_t ret = ESP_OK;
 
+    // Every MJPEG frame is a key frame: with an index the seek lands exactly on
+    // the frame shown at position instead of wherever the extractor rounds to.
+    // An empty index has no entry, the extractor then seeks by time.
+    if (adapter->index != NULL) {
+        const frame_index_entry_t *entry = frame_index_get(adapter->index,
+                                                           frame_index_find(adapter->index, position));
+        if (entry != NULL) {
+            position = entry->pts_ms;
+        }
+    }
     ESP_LOGI(TAG, "Seeking to position %u ms", position);
 
-    bool was_running = adapter->extract_task_handle != NULL;
+    bool was_running = adapter->extract_task_handle != NULL || adapter->scrubbed;
     if (was_running) {
         stop_extract_task(adapter);
     }
+    adapter->scrubbed = false;
 
     ret = app_extractor_seek(adapter->extractor_handle, position);
 
@@ -790,6 +2537,83 @@ esp_err_t app_stream_adapter_seek(app_stream_adapter_handle_t handle, uint32_t p
     return ret;
 }
 
+esp_err_t app_stream_adapter_scrub(app_stream_adapter_handle_t handle, uint32_t position)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)handle;
+
+    if (!adapter->running || !adapter->paused) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (adapter->index == NULL) {
+        return adapter->index_busy ? ESP_ERR_NOT_FINISHED : ESP_ERR_NOT_SUPPORTED;
+    }
+
+    uint32_t frame_number = frame_index_find(adapter->index, position);
+    const frame_index_entry_t *entry = frame_index_get(adapter->index, frame_number);
+    if (entry == NULL) {
+        // Nothing indexed to show; seeking by time is left to resume
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (adapter->scrubbed && entry->pts_ms == adapter->scrub_pts) {
+        return ESP_OK;
+    }
+
+    // The first scrub stops the pipeline; frames it had queued belong to the old position
+    if (!adapter->scrubbed) {
+        stop_extract_task(adapter);
+        adapter->scrubbed = true;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = show_indexed_frame(adapter, frame_number);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to show frame %u: %s", frame_number, esp_err_to_name(ret));
+        return ret;
+    }
+    adapter->scrub_pts = entry->pts_ms;
+    ESP_LOGD(TAG, "Scrubbed to frame %u (%u ms) in %lld us", frame_number, entry->pts_ms,
+             esp_timer_get_time() - start_us);
+    return ESP_OK;
+}
+
+esp_err_t app_stream_adapter_set_loop(app_stream_adapter_handle_t handle, bool loop)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)handle;
+    adapter->loop = loop;
+    if (adapter->extractor_handle) {
+        app_extractor_set_loop(adapter->extractor_handle, loop);
+    }
+    return ESP_OK;
+}
+
+esp_err_t app_stream_adapter_set_speed(app_stream_adapter_handle_t handle, uint32_t speed)
+{
+    if (handle == NULL || speed < APP_STREAM_SPEED_MIN || speed > APP_STREAM_SPEED_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)handle;
+    if (speed == adapter->target_speed) {
+        return ESP_OK;
+    }
+
+    adapter->target_speed = speed;
+    if (adapter->extract_audio && adapter->extractor_handle) {
+        app_extractor_set_audio_muted(adapter->extractor_handle, speed != APP_STREAM_SPEED_NORMAL);
+    }
+    stage_signal(adapter->present_task_handle);
+    ESP_LOGI(TAG, "Playback speed %u%%", speed);
+    return ESP_OK;
+}
+
 esp_err_t app_stream_adapter_get_info(app_stream_adapter_handle_t handle,
                                       uint32_t *width, uint32_t *height,
                                       uint32_t *fps, uint32_t *duration)
@@ -830,8 +2654,131 @@ esp_err_t app_stream_adapter_get_stats(app_stream_adapter_handle_t handle,
     app_stream_adapter_t *adapter = (app_stream_adapter_t *)handle;
 
     memset(stats, 0, sizeof(app_stream_stats_t));
+    stats->current_fps = adapter->current_fps;
     stats->frames_processed = adapter->frame_count;
+    if (adapter->start_us != 0) {
+        int64_t end_us = adapter->stop_us != 0 ? adapter->stop_us : esp_timer_get_time();
+        stats->elapsed_ms = (uint32_t)((end_us - adapter->start_us) / 1000);
+    }
+    stats->demux = adapter->demux_stats;
+    stats->decode = adapter->decode_stats;
+    // Producers only sample depth on push, read the current one from the rings
+    stats->demux.queue_depth = spsc_ring_count(&adapter->packet_ring);
+    stats->decode.queue_depth = spsc_ring_count(&adapter->frame_ring);
+    stats->present = adapter->present_stats;
+    stats->sync = adapter->sync_stats;
+    stats->decode_time = adapter->decode_time;
+    stats->duplicates = adapter->duplicate_stats;
+    if (stats->decode_time.frames > 0) {
+        stats->duplicates.saved_us = stats->duplicates.frames * stats->decode_time.total_us / stats->decode_time.frames;
+    }
+    if (adapter->extractor_handle) {
+        app_extractor_get_read_stats(adapter->extractor_handle, &stats->read);
+        app_extractor_get_audio_stats(adapter->extractor_handle, &stats->audio);
+    }
+    if (stats->elapsed_ms > 0) {
+        // With read-ahead the card bytes include what was loaded but not yet demuxed
+        uint64_t bytes = stats->read.card.bytes ? stats->read.card.bytes : stats->read.bytes;
+        stats->read_bytes_per_s = (uint32_t)(bytes * 1000 / stats->elapsed_ms);
+    }
+    video_transform_get_stats(adapter->transform, &stats->srm);
+    frame_pool_get_stats(adapter->decode_pool, &stats->decode_pool);
+    frame_pool_get_stats(adapter->present_pool, &stats->present_pool);
+    stats->first_frame_ms = adapter->first_frame_ms;
+    stats->started_prepared = adapter->started_prepared;
+    stats->prepare_ms = adapter->prepare_ms;
+    stats->resumed = adapter->resumed;
+    stats->resume_ms = adapter->resume_ms;
+    stats->speed = adapter->target_speed;
+    stats->frames_skimmed = adapter->frames_skimmed;
+    stats->loop = adapter->loop_stats;
+
+    return ESP_OK;
+}
+
+esp_err_t app_stream_adapter_dump_stats(app_stream_adapter_handle_t handle)
+{
+    app_stream_stats_t stats;
+    esp_err_t ret = app_stream_adapter_get_stats(handle, &stats);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)handle;
+    const app_stream_decode_time_t *decode = &stats.decode_time;
+    ESP_LOGI(TAG, "Stats of %s: %u frames in %u ms, %.1f fps (stream %u fps), late %u, dropped %u, repeated %u",
+             adapter->filename, stats.frames_processed, stats.elapsed_ms, stats.current_fps, adapter->fps,
+             stats.sync.frames_late, stats.sync.frames_dropped, stats.sync.frames_repeated);
+    if (stats.speed != APP_STREAM_SPEED_NORMAL || stats.frames_skimmed > 0) {
+        ESP_LOGI(TAG, "Speed: %u%%, %u frames skimmed without a decode", stats.speed, stats.frames_skimmed);
+    }
+    if (stats.loop.loops > 0) {
+        ESP_LOGI(TAG, "Loop: %u wraps, gap %u us (max %u us) against a %u ms frame interval", stats.loop.loops,
+                 stats.loop.gap_us, stats.loop.gap_max_us, 1000 / (adapter->fps > 0 ? adapter->fps : DEFAULT_VIDEO_FPS));
+    }
+
+    char hist[APP_STREAM_DECODE_HIST_BINS * 16];
+    int len = 0;
+    for (int i = 0; i < APP_STREAM_DECODE_HIST_BINS && len < (int)sizeof(hist); i++) {
+        len += snprintf(hist + len, sizeof(hist) - len, i < APP_STREAM_DECODE_HIST_BINS - 1 ? " <%d:%u" : " >=%d:%u",
+                        (i < APP_STREAM_DECODE_HIST_BINS - 1 ? i + 1 : i) * APP_STREAM_DECODE_HIST_BIN_MS,
+                        decode->hist[i]);
+    }
+    ESP_LOGI(TAG, "Decode: %u frames, avg %u us, max %u us, ms:%s", decode->frames,
+             decode->frames ? (uint32_t)(decode->total_us / decode->frames) : 0, decode->max_us, hist);
+    ESP_LOGI(TAG, "Read: %u frames, %llu bytes at %u KB/s, avg %u us, max %u us, demux stalls %u",
+             stats.read.frames, stats.read.bytes, stats.read_bytes_per_s / 1024,
+             stats.read.frames ? (uint32_t)(stats.read.read_us / stats.read.frames) : 0, stats.read.read_us_max,
+             stats.demux.stalls);
+    if (stats.read.card.bytes > 0) {
+        ESP_LOGI(TAG, "Card: %llu bytes read ahead in %llu us, max load %u us, %u waits for %llu us, %u restarts",
+                 stats.read.card.bytes, stats.read.card.io_us, stats.read.card.io_max_us,
+                 stats.read.card.waits, stats.read.card.wait_us, stats.read.card.restarts);
+    }
+    if (adapter->skip_duplicates) {
+        ESP_LOGI(TAG, "Duplicates: %u frames held, %llu us of JPEG engine time saved for %llu us spent hashing",
+                 stats.duplicates.frames, stats.duplicates.saved_us, stats.duplicates.hash_us);
+    }
+    jpeg_sched_log_stats();
+    if (stats.audio.ring_size > 0) {
+        ESP_LOGI(TAG, "Audio: ring %u/%u bytes (peak %u), %u ms in I2S (min %u), underruns %u, xruns %u",
+                 stats.audio.ring_used, stats.audio.ring_size, stats.audio.ring_peak, stats.audio.buffered_ms,
+                 stats.audio.min_buffered_ms, stats.audio.underruns, stats.audio.xruns);
+    }
+
+    // Reads and decodes each run on one task, so their share of wall time is how
+    // close each comes to limiting the frame rate
+    if (stats.elapsed_ms > 0) {
+        // Read-ahead moves the card time onto its own task, reads then only copy
+        uint64_t io_us = stats.read.card.bytes ? stats.read.card.io_us : stats.read.read_us;
+        uint32_t read_load = (uint32_t)(io_us / 10 / stats.elapsed_ms);
+        uint32_t decode_load = (uint32_t)(decode->total_us / 10 / stats.elapsed_ms);
+        const char *verdict = "keeping up";
+        if (read_load >= BOUND_LOAD_PERCENT || decode_load >= BOUND_LOAD_PERCENT) {
+            verdict = read_load > decode_load ? "I/O-bound" : "decode-bound";
+        }
+        ESP_LOGI(TAG, "Load: card reads %u%%, JPEG decode %u%% of wall time, %s", read_load, decode_load, verdict);
+    }
+    return ESP_OK;
+}
+
+esp_err_t app_stream_adapter_release_frame(app_stream_adapter_handle_t handle, const uint8_t *buffer)
+{
+    if (handle == NULL || buffer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
+    app_stream_adapter_t *adapter = (app_stream_adapter_t *)handle;
+
+    if (frame_pool_owns(adapter->decode_pool, buffer)) {
+        frame_pool_release(adapter->decode_pool, (uint8_t *)buffer);
+    } else if (frame_pool_owns(adapter->present_pool, buffer)) {
+        frame_pool_release(adapter->present_pool, (uint8_t *)buffer);
+    } else if (frame_pool_owns(adapter->prepared_pool, buffer)) {
+        frame_pool_release(adapter->prepared_pool, (uint8_t *)buffer);
+    } else {
+        return ESP_ERR_NOT_FOUND;
+    }
     return ESP_OK;
 }
 
@@ -846,11 +2793,19 @@ esp_err_t app_stream_adapter_deinit(app_stream_adapter_handle_t handle)
     if (adapter->running) {
         app_stream_adapter_stop(handle);
     }
+    parse_ahead_release(adapter);
+    prepare_discard(adapter);
+    index_release(adapter);
+    free(adapter->scrub_input);
 
     if (adapter->extractor_handle != NULL) {
         app_extractor_deinit(adapter->extractor_handle);
         adapter->extractor_handle = NULL;
     }
+    if (adapter->prepared.extractor != NULL) {
+        app_extractor_deinit(adapter->prepared.extractor);
+        adapter->prepared.extractor = NULL;
+    }
 
     if (adapter->jpeg_handle != NULL) {
         // Release shared JPEG decoder instead of deleting it
@@ -858,17 +2813,18 @@ esp_err_t app_stream_adapter_deinit(app_stream_adapter_handle_t handle)
         adapter->jpeg_handle = NULL;
     }
 
-    if (adapter->frame_mutex != NULL) {
-        vSemaphoreDelete(adapter->frame_mutex);
-    }
-
     if (adapter->extract_event_group != NULL) {
         vEventGroupDelete(adapter->extract_event_group);
     }
 
-    if (adapter->jpeg_buffer != NULL) {
-        free(adapter->jpeg_buffer);
+    if (adapter->on_screen != NULL) {
+        frame_pool_release(adapter->on_screen_pool, adapter->on_screen);
+        adapter->on_screen = NULL;
     }
+    frame_pool_delete(adapter->prepared_pool);
+    frame_pool_delete(adapter->present_pool);
+    frame_pool_delete(adapter->decode_pool);
+    free(adapter->frames);
 
     if (g_adapter_instance == adapter) {
         g_adapter_instance = NULL;
@@ -9,12 +9,21 @@
 #include "esp_err.h"
 #include "esp_codec_dev.h"  // Add for audio device support
 #include "driver/jpeg_decode.h"  // Add for JPEG decoder types
+#include "video_transform.h"
+#include "frame_pool.h"
+#include "app_extractor.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define APP_STREAM_JPEG_BUFFER_SIZE     (512 * 1024)  // 512KB JPEG buffer
+#define APP_STREAM_DEMUX_RING_DEPTH     (3)           // Compressed frames buffered between demux and decode
+#define APP_STREAM_PATH_MAX             (256)         // Longest file path app_stream_adapter_prepare() accepts
+#define APP_STREAM_DECODE_HIST_BINS     (12)          // Decode time histogram bins, the last one open-ended
+#define APP_STREAM_DECODE_HIST_BIN_MS   (4)           // Width of each bin: bin i counts [i * 4, (i + 1) * 4) ms
+#define APP_STREAM_SPEED_NORMAL         (100)         // Playback speed in percent of the stream's own rate
+#define APP_STREAM_SPEED_MIN            (50)
+#define APP_STREAM_SPEED_MAX            (800)
 
 /**
  * @brief Shared JPEG decoder manager for avoiding hardware conflicts
@@ -92,17 +101,106 @@ typedef struct {
 #define APP_STREAM_JPEG_CONFIG_DEFAULT_RGB888() \
     { .output_format = APP_STREAM_JPEG_OUTPUT_RGB888, .bgr_order = true }
 
+/**
+ * @brief Per-stage pipeline statistics
+ *
+ * Playback runs demux -> decode (+ SRM) -> present, each pair connected by a ring.
+ * queue_depth describes the ring a stage feeds: compressed frames for demux,
+ * decoded frames (including the one on screen) for decode. Present feeds no ring.
+ */
+typedef struct {
+    uint32_t queue_depth;         /*!< Entries currently in the stage's output ring */
+    uint32_t queue_depth_max;     /*!< High-water mark of queue_depth */
+    uint32_t stalls;              /*!< Times the stage waited for room in its output ring */
+    uint32_t stall_time_ms;       /*!< Total time spent in those waits */
+    uint32_t starved;             /*!< Times the stage waited for input */
+} app_stream_stage_stats_t;
+
+/**
+ * @brief A/V synchronisation statistics
+ *
+ * Video is scheduled by PTS against a master clock taken from the audio
+ * samples written to the codec, or wall time when there is no audio.
+ */
+typedef struct {
+    bool audio_master;            /*!< Last frame was scheduled against the audio clock */
+    int32_t drift_ms;             /*!< PTS minus master clock of the last presented frame */
+    uint32_t max_drift_ms;        /*!< Largest |drift_ms| since start */
+    uint32_t frames_dropped;      /*!< Late frames skipped before decode */
+    uint32_t frames_repeated;     /*!< Extra frame intervals a frame stayed up because the next was late */
+    uint32_t frames_late;         /*!< Frames presented more than a frame interval after their PTS */
+} app_stream_sync_stats_t;
+
+/**
+ * @brief JPEG engine time per decoded frame
+ */
+typedef struct {
+    uint32_t frames;                                /*!< Frames decoded */
+    uint64_t total_us;                              /*!< Time spent decoding them */
+    uint32_t max_us;                                /*!< Slowest decode */
+    uint32_t hist[APP_STREAM_DECODE_HIST_BINS];     /*!< Decodes per APP_STREAM_DECODE_HIST_BIN_MS wide bin */
+} app_stream_decode_time_t;
+
+/**
+ * @brief Frames byte-identical to the frame before them
+ *
+ * Demux hashes every compressed frame. One matching the frame on screen is not
+ * decoded or handed to frame_cb; the screen keeps what it shows for its interval.
+ */
+typedef struct {
+    uint32_t frames;              /*!< Frames held instead of decoded and presented */
+    uint64_t hash_us;             /*!< Demux time spent hashing all compressed frames */
+    uint64_t saved_us;            /*!< JPEG engine time the held frames would have taken, at the average decode */
+} app_stream_duplicate_stats_t;
+
+/**
+ * @brief Wraps of a looping clip, see app_stream_adapter_set_loop()
+ *
+ * The gap is the time from the last frame of a pass on screen to the first frame
+ * of the next; a seamless loop keeps it at one frame interval.
+ */
+typedef struct {
+    uint32_t loops;               /*!< Times playback wrapped to the start */
+    uint32_t gap_us;              /*!< Gap at the last wrap */
+    uint32_t gap_max_us;          /*!< Longest gap */
+} app_stream_loop_stats_t;
+
 /**
  * @brief Performance statistics structure
  */
 typedef struct {
-    float current_fps;            /*!< Current frames per second */
-    uint32_t frames_processed;    /*!< Total frames processed */
+    float current_fps;                /*!< Frames shown per second over the last second of playback, held duplicates included */
+    uint32_t frames_processed;        /*!< Total frames presented, held duplicates excluded */
+    uint32_t elapsed_ms;              /*!< Wall time from app_stream_adapter_start() to now or the stop, pauses included */
+    app_stream_stage_stats_t demux;   /*!< Extractor read stage */
+    app_stream_stage_stats_t decode;  /*!< JPEG decode stage */
+    app_stream_stage_stats_t present; /*!< Frame callback stage */
+    app_stream_sync_stats_t sync;     /*!< A/V sync */
+    app_stream_decode_time_t decode_time; /*!< JPEG engine time per frame */
+    app_stream_duplicate_stats_t duplicates; /*!< Frames skipped as identical to the one before */
+    app_extractor_read_stats_t read;  /*!< Extractor reads from the card */
+    uint32_t read_bytes_per_s;        /*!< Card bytes (read.card, or read without read-ahead) over elapsed_ms */
+    app_extractor_audio_stats_t audio; /*!< Compressed audio ring and I2S output */
+    video_transform_stats_t srm;      /*!< Scale/rotate/mirror stage, zero without a transform */
+    frame_pool_stats_t decode_pool;   /*!< JPEG output buffers */
+    frame_pool_stats_t present_pool;  /*!< SRM output buffers, zero without a transform */
+    uint32_t first_frame_ms;          /*!< From app_stream_adapter_start() to the first frame shown, 0 until then */
+    bool started_prepared;            /*!< The clip was opened ahead by app_stream_adapter_prepare() */
+    uint32_t prepare_ms;              /*!< Time spent preparing it in the background */
+    bool resumed;                     /*!< The clip was opened from its stored resume info, without a parse */
+    uint32_t resume_ms;               /*!< Position playback started at, 0 from the beginning */
+    uint32_t speed;                   /*!< Current playback speed, percent */
+    uint32_t frames_skimmed;          /*!< Frames demux passed over above normal speed, never decoded */
+    app_stream_loop_stats_t loop;     /*!< Wraps to the start while looping */
 } app_stream_stats_t;
 
 /**
  * @brief Media frame callback function type
  *
+ * The buffer stays valid until it is released: by app_stream_adapter_release_frame()
+ * when display_releases_frames is set, otherwise when the next frame is presented.
+ * Returning an error releases it at once.
+ *
  * @param buffer Pointer to the frame buffer
  * @param buffer_size Size of the frame buffer
  * @param width Frame width
@@ -118,17 +216,36 @@ typedef esp_err_t (*app_stream_frame_cb_t)(uint8_t *buffer,
                                            uint32_t frame_index,
                                            void *user_data);
 
+/**
+ * @brief End of stream callback function type
+ *
+ * Called once per start, from the present task, after the last frame has had its
+ * interval on screen and any audio queued behind it has played out. A seek restarts
+ * the pipeline and arms it again. The callback must not stop the adapter: hand the
+ * work to another task.
+ *
+ * @param user_data User data passed from configuration
+ */
+typedef void (*app_stream_eos_cb_t)(void *user_data);
+
 /**
  * @brief Stream adapter initialization configuration structure
  */
 typedef struct {
     app_stream_frame_cb_t frame_cb;                 /*!< Callback function for decoded frames */
-    void *user_data;                                /*!< User data to be passed to frame callback */
-    void **decode_buffers;                          /*!< Array of frame buffer pointers */
-    uint32_t buffer_count;                          /*!< Number of frame buffers */
-    uint32_t buffer_size;                           /*!< Size of each frame buffer */
+    app_stream_eos_cb_t eos_cb;                     /*!< Called when playback reaches the end of the clip (NULL for none) */
+    void *user_data;                                /*!< User data to be passed to the callbacks */
+    uint32_t frame_buffer_count;                    /*!< Frame buffers per pool, at least 2 */
+    uint32_t max_width;                             /*!< Frame size to allocate for when the stream reports none */
+    uint32_t max_height;
+    bool display_releases_frames;                   /*!< The display returns each frame with app_stream_adapter_release_frame() */
     esp_codec_dev_handle_t audio_dev;               /*!< Audio device handle (NULL to disable audio) */
     app_stream_jpeg_config_t jpeg_config;           /*!< JPEG decoder configuration */
+    video_transform_handle_t transform;             /*!< SRM stage fitting frames to the screen (NULL to present decoded frames as-is) */
+    bool frame_index;                               /*!< Index each clip's frames in the background for exact seeks and scrubbing */
+    bool resume_playback;                           /*!< Reopen each clip where it was stopped, from resume info kept in cache_dir */
+    const char *cache_dir;                          /*!< Directory frame indexes and resume points are kept in (NULL for none) */
+    bool skip_duplicate_frames;                     /*!< Hold the frame on screen instead of decoding an identical one */
 } app_stream_adapter_config_t;
 
 /**
@@ -146,14 +263,53 @@ esp_err_t app_stream_adapter_set_file(app_stream_adapter_handle_t handle,
 
 /**
  * @brief Start playback
+ *
+ * Uses the clip opened by app_stream_adapter_prepare() when it is the one set,
+ * waiting for the prepare to finish if needed, and drops it otherwise. With
+ * resume_playback a clip stopped part way starts at the frame it stopped on.
  */
 esp_err_t app_stream_adapter_start(app_stream_adapter_handle_t handle);
 
+/**
+ * @brief Open the next clip in the background while the current one plays
+ *
+ * Parses its container, probes the audio decoder and decodes its first frame on
+ * a second extractor, so the following set_file/start of the same file only
+ * swaps handles. Replaces any clip prepared before. Costs a second extractor's
+ * pools and one decoded frame until the clip starts or is replaced.
+ */
+esp_err_t app_stream_adapter_prepare(app_stream_adapter_handle_t handle,
+                                     const char *filename,
+                                     bool extract_audio);
+
+/**
+ * @brief Parse a clip's container ahead of its first play, where that saves time
+ *
+ * Queues the clip for a task running below playback. A clip whose moov, the
+ * sample tables, follows its media data is parsed there and its tables stored as
+ * a resume entry in cache_dir, so its first start restores them instead of
+ * reading through to the end of the file. Fast-start clips and clips that
+ * already have an entry cost a few header reads. Needs resume_playback and a
+ * cache_dir, ESP_ERR_NOT_SUPPORTED otherwise; ESP_ERR_NO_MEM when the queue is full.
+ */
+esp_err_t app_stream_adapter_parse_ahead(app_stream_adapter_handle_t handle, const char *filename);
+
 /**
  * @brief Stop playback
+ *
+ * With resume_playback, stores where the clip stopped before closing it.
  */
 esp_err_t app_stream_adapter_stop(app_stream_adapter_handle_t handle);
 
+/**
+ * @brief Free the memory kept between clips while no video plays
+ *
+ * Frame buffers, the prepared clip with its extractor pools, the frame index
+ * and the scrub input. The next start allocates them again at the size of its
+ * stream. Call after app_stream_adapter_stop() when leaving video playback.
+ */
+esp_err_t app_stream_adapter_release_buffers(app_stream_adapter_handle_t handle);
+
 /**
  * @brief Pause playback (keep position)
  */
@@ -166,9 +322,48 @@ esp_err_t app_stream_adapter_resume(app_stream_adapter_handle_t handle);
 
 /**
  * @brief Seek to position in milliseconds
+ *
+ * Lands on the frame shown at position once the clip's frame index is built.
  */
 esp_err_t app_stream_adapter_seek(app_stream_adapter_handle_t handle, uint32_t position);
 
+/**
+ * @brief Show the frame at position in milliseconds while paused
+ *
+ * Reads and decodes only that frame through the clip's frame index, so a drag
+ * can call it for every touch update. The first call stops the pipeline and
+ * app_stream_adapter_resume() restarts it from the last frame shown.
+ *
+ * @return ESP_ERR_INVALID_STATE unless playing and paused,
+ *         ESP_ERR_NOT_FINISHED while the index is still being built,
+ *         ESP_ERR_NOT_SUPPORTED when frame_index is off or the clip has no index
+ */
+esp_err_t app_stream_adapter_scrub(app_stream_adapter_handle_t handle, uint32_t position);
+
+/**
+ * @brief Set the playback speed, APP_STREAM_SPEED_MIN to APP_STREAM_SPEED_MAX percent
+ *
+ * Takes effect at the frame on screen, without restarting the pipeline. Away
+ * from normal speed audio is muted and video follows wall time scaled by speed.
+ * Above it, demux passes only every speed/100th frame on, so the JPEG engine
+ * decodes frames at the stream's own rate whatever the speed. H.264 frames
+ * depend on each other and are all decoded, so H.264 clips only go as fast
+ * as the software decoder. Each clip starts at normal speed.
+ *
+ * @return ESP_ERR_INVALID_ARG for a speed out of range
+ */
+esp_err_t app_stream_adapter_set_speed(app_stream_adapter_handle_t handle, uint32_t speed);
+
+/**
+ * @brief Play each clip in a loop, wrapping from its last frame to its first
+ *
+ * The demux task wraps the open extractor to the start at the end of the clip,
+ * so the container is not parsed again and the frame index, buffers and audio
+ * device stay in place. eos_cb is not called while looping. Applies to the clip
+ * playing and every clip started after, until turned off.
+ */
+esp_err_t app_stream_adapter_set_loop(app_stream_adapter_handle_t handle, bool loop);
+
 /**
  * @brief Get stream information
  */
@@ -182,6 +377,21 @@ esp_err_t app_stream_adapter_get_info(app_stream_adapter_handle_t handle,
 esp_err_t app_stream_adapter_get_stats(app_stream_adapter_handle_t handle,
                                        app_stream_stats_t *stats);
 
+/**
+ * @brief Log the statistics of the current clip, with where its time goes
+ *
+ * Compares card reads and JPEG decodes against the frame interval, to tell an
+ * I/O-bound stream from a decode-bound one. Safe to call at any time.
+ */
+esp_err_t app_stream_adapter_dump_stats(app_stream_adapter_handle_t handle);
+
+/**
+ * @brief Return a frame buffer once the display has stopped reading it
+ *
+ * @return ESP_ERR_NOT_FOUND if the buffer does not belong to this adapter
+ */
+esp_err_t app_stream_adapter_release_frame(app_stream_adapter_handle_t handle, const uint8_t *buffer);
+
 /**
  * @brief Cleanup and free resources
  */
@@ -197,9 +407,10 @@ esp_err_t app_stream_adapter_deinit(app_stream_adapter_handle_t handle);
  * // New unified initialization interface (recommended)
  * app_stream_adapter_config_t config = {
  *     .frame_cb = frame_callback,
- *     .decode_buffers = buffers,
- *     .buffer_count = buffer_count,
- *     .buffer_size = buffer_size,
+ *     .frame_buffer_count = 3,
+ *     .max_width = 1920,
+ *     .max_height = 1080,
+ *     .display_releases_frames = true,  // Call app_stream_adapter_release_frame() after each flush
  *     .audio_dev = audio_device,  // Set to NULL to disable audio
  *     .jpeg_config = {
  *         .output_format = APP_STREAM_JPEG_OUTPUT_RGB888,
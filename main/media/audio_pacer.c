@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "audio_pacer.h"
+
+#include <string.h>
+#include "esp_timer.h"
+#include "driver/i2s_common.h"
+
+// A write taking longer than this waited for the DMA ring rather than just copying
+#define WRITE_BLOCKED_US    1000
+
+// The BSP creates the speaker channel from I2S_CHANNEL_DEFAULT_CONFIG, so its
+// DMA ring has the same descriptor count and frames per descriptor
+static uint32_t speaker_dma_frames(void)
+{
+    const i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_AUTO, I2S_ROLE_MASTER);
+    return chan_cfg.dma_desc_num * chan_cfg.dma_frame_num;
+}
+
+static uint64_t played_bytes(const audio_pacer_t *pacer, int64_t now_us)
+{
+    if (!pacer->running) {
+        return pacer->written_bytes;
+    }
+    uint64_t played = pacer->anchor_bytes +
+                      (uint64_t)(now_us - pacer->anchor_us) * pacer->bytes_per_second / 1000000;
+    return played;
+}
+
+static uint32_t bytes_to_ms(const audio_pacer_t *pacer, uint64_t bytes)
+{
+    return pacer->bytes_per_second ? (uint32_t)(bytes * 1000 / pacer->bytes_per_second) : 0;
+}
+
+static uint64_t queued_bytes(const audio_pacer_t *pacer, int64_t now_us)
+{
+    uint64_t played = played_bytes(pacer, now_us);
+    return played >= pacer->written_bytes ? 0 : pacer->written_bytes - played;
+}
+
+void audio_pacer_reset(audio_pacer_t *pacer, uint32_t sample_rate, uint8_t channels, uint8_t bits)
+{
+    memset(pacer, 0, sizeof(*pacer));
+    uint32_t bytes_per_frame = channels * (bits / 8);
+    pacer->bytes_per_second = sample_rate * bytes_per_frame;
+    pacer->dma_bytes = speaker_dma_frames() * bytes_per_frame;
+    pacer->min_buffered_ms = UINT32_MAX;
+}
+
+uint32_t audio_pacer_buffered_ms(const audio_pacer_t *pacer)
+{
+    return bytes_to_ms(pacer, queued_bytes(pacer, esp_timer_get_time()));
+}
+
+esp_err_t audio_pacer_write(audio_pacer_t *pacer, esp_codec_dev_handle_t dev, void *data, uint32_t len)
+{
+    if (pacer->bytes_per_second == 0) {
+        return esp_codec_dev_write(dev, data, len);
+    }
+
+    int64_t now_us = esp_timer_get_time();
+
+    if (pacer->running) {
+        uint64_t played = played_bytes(pacer, now_us);
+        if (played > pacer->written_bytes) {
+            // The model ran past everything written: the DMA played silence
+            pacer->xruns++;
+            pacer->running = false;
+        } else {
+            uint32_t queued_ms = bytes_to_ms(pacer, pacer->written_bytes - played);
+            if (queued_ms < pacer->min_buffered_ms) {
+                pacer->min_buffered_ms = queued_ms;
+            }
+        }
+    }
+
+    if (!pacer->running) {
+        // Playout (re)starts with this write
+        pacer->anchor_bytes = pacer->written_bytes;
+        pacer->anchor_us = now_us;
+        pacer->running = true;
+    }
+
+    esp_err_t ret = esp_codec_dev_write(dev, data, len);
+    int64_t done_us = esp_timer_get_time();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    pacer->written_bytes += len;
+
+    // A blocked write returns as soon as the last chunk fits, leaving one DMA ring
+    // queued. Never model more queued than the ring holds either way.
+    uint64_t queued = queued_bytes(pacer, done_us);
+    if (done_us - now_us > WRITE_BLOCKED_US || queued > pacer->dma_bytes) {
+        uint64_t ring = pacer->written_bytes < pacer->dma_bytes ? pacer->written_bytes : pacer->dma_bytes;
+        pacer->anchor_bytes = pacer->written_bytes - ring;
+        pacer->anchor_us = done_us;
+        queued = ring;
+    }
+    pacer->buffered_ms = bytes_to_ms(pacer, queued);
+
+    return ESP_OK;
+}
@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_codec_dev.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Paces PCM output by the I2S DMA fill level instead of sleeping a guessed
+// fraction of each frame. esp_codec_dev_write() blocks only while the DMA ring
+// is full and reports nothing else, so the fill level is modelled: a write that
+// blocked leaves exactly one DMA ring queued, and the speaker drains it at the
+// sample rate. When the model runs dry before the next write, the DMA has
+// played silence (xrun). The DMA ring, sized like the BSP speaker channel,
+// is also the bound on audio queued ahead of the speaker.
+typedef struct {
+    uint32_t bytes_per_second;
+    uint32_t dma_bytes;             // DMA ring capacity in bytes
+    uint64_t written_bytes;         // Bytes accepted by the codec since reset
+    uint64_t anchor_bytes;          // Bytes played at anchor_us
+    int64_t anchor_us;
+    bool running;                   // Playout has started and not run dry
+    uint32_t xruns;                 // DMA ran dry between writes
+    uint32_t buffered_ms;           // Fill level after the last write
+    uint32_t min_buffered_ms;       // Lowest fill level seen before a write while running
+} audio_pacer_t;
+
+void audio_pacer_reset(audio_pacer_t *pacer, uint32_t sample_rate, uint8_t channels, uint8_t bits);
+
+// Write PCM to the codec, blocking while the I2S DMA ring is full
+esp_err_t audio_pacer_write(audio_pacer_t *pacer, esp_codec_dev_handle_t dev, void *data, uint32_t len);
+
+// Audio queued ahead of the speaker right now
+uint32_t audio_pacer_buffered_ms(const audio_pacer_t *pacer);
+
+#ifdef __cplusplus
+}
+#endif
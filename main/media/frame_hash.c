@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "frame_hash.h"
+#include <string.h>
+
+static inline uint32_t rotl32(uint32_t x, int r)
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+// MurmurHash3 x86_32, seeded with the size
+uint32_t frame_hash(const uint8_t *data, size_t size)
+{
+    const uint32_t c1 = 0xcc9e2d51;
+    const uint32_t c2 = 0x1b873593;
+    uint32_t h = (uint32_t)size;
+
+    size_t words = size / 4;
+    for (size_t i = 0; i < words; i++) {
+        uint32_t k;
+        memcpy(&k, data + i * 4, sizeof(k));        // Pool buffers are aligned, this stays one load
+        k *= c1;
+        k = rotl32(k, 15);
+        k *= c2;
+        h ^= k;
+        h = rotl32(h, 13);
+        h = h * 5 + 0xe6546b64;
+    }
+
+    const uint8_t *tail = data + words * 4;
+    uint32_t k = 0;
+    switch (size & 3) {
+    case 3:
+        k ^= (uint32_t)tail[2] << 16;
+    // fall through
+    case 2:
+        k ^= (uint32_t)tail[1] << 8;
+    // fall through
+    case 1:
+        k ^= tail[0];
+        k *= c1;
+        k = rotl32(k, 15);
+        k *= c2;
+        h ^= k;
+    }
+
+    h ^= (uint32_t)size;
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
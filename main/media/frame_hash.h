@@ -0,0 +1,25 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fingerprint of a compressed frame, to spot a frame identical to the one before.
+//
+// Every byte is hashed: a small change such as a moving cursor only touches a
+// few entropy coded bytes anywhere in the frame. The input is read a word at a
+// time, so a frame costs a small fraction of its JPEG decode. Not cryptographic;
+// callers compare sizes too.
+uint32_t frame_hash(const uint8_t *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,636 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "frame_index.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *TAG = "frame_index";
+
+#define INDEX_FILE_MAGIC        0x58444946u     // "FIDX"
+#define INDEX_FILE_VERSION      2
+#define INDEX_MAX_FRAMES        (1024 * 1024)   // 9.7 h at 30 fps, bounds a corrupt table
+#define MP4_MOOV_MAX_SIZE       (16 * 1024 * 1024)
+#define AVI_HDRL_MAX_SIZE       (64 * 1024)
+
+// Cache file: this header, the clip path, then count entries
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t file_size;             // Of the clip when indexed
+    int64_t mtime;
+    uint32_t count;
+    uint32_t duration_ms;
+    uint32_t max_size;              // Largest frame, readable without the entries
+    uint32_t path_len;
+} index_file_header_t;
+
+struct frame_index_t {
+    int fd;                         // Clip, kept open for frame reads
+    uint32_t count;
+    uint32_t max_size;
+    uint32_t duration_ms;
+    frame_index_entry_t *entries;
+};
+
+static inline uint32_t rd32be(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline uint64_t rd64be(const uint8_t *p)
+{
+    return ((uint64_t)rd32be(p) << 32) | rd32be(p + 4);
+}
+
+static inline uint32_t rd32le(const uint8_t *p)
+{
+    return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+}
+
+static bool read_at(int fd, uint32_t offset, void *buffer, size_t size)
+{
+    if (lseek(fd, offset, SEEK_SET) < 0) {
+        return false;
+    }
+    uint8_t *p = buffer;
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static void *alloc_table(size_t size)
+{
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+static frame_index_entry_t *alloc_entries(uint32_t count)
+{
+    if (count == 0 || count > INDEX_MAX_FRAMES) {
+        return NULL;
+    }
+    return alloc_table((size_t)count * sizeof(frame_index_entry_t));
+}
+
+// MP4: the first video track's sample tables, read from moov in one go
+
+// First child box of the given type in [p, end). Returns its payload.
+static const uint8_t *mp4_find(const uint8_t *p, const uint8_t *end, const char *type, uint32_t *payload_size)
+{
+    while (end - p >= 8) {
+        uint64_t size = rd32be(p);
+        uint32_t header = 8;
+        if (size == 1) {
+            if (end - p < 16) {
+                return NULL;
+            }
+            size = rd64be(p + 8);
+            header = 16;
+        } else if (size == 0) {
+            size = end - p;
+        }
+        if (size < header || size > (uint64_t)(end - p)) {
+            return NULL;
+        }
+        if (memcmp(p + 4, type, 4) == 0) {
+            *payload_size = (uint32_t)(size - header);
+            return p + header;
+        }
+        p += size;
+    }
+    return NULL;
+}
+
+static uint8_t *mp4_read_moov(int fd, uint32_t file_size, uint32_t *moov_size)
+{
+    uint32_t pos = 0;
+    uint8_t header[16];
+
+    while ((uint64_t)pos + 8 <= file_size) {
+        if (!read_at(fd, pos, header, 8)) {
+            return NULL;
+        }
+        uint64_t size = rd32be(header);
+        uint32_t header_size = 8;
+        if (size == 1) {
+            if (!read_at(fd, pos + 8, header + 8, 8)) {
+                return NULL;
+            }
+            size = rd64be(header + 8);
+            header_size = 16;
+        } else if (size == 0) {
+            size = file_size - pos;
+        }
+        if (size < header_size || pos + size > file_size) {
+            return NULL;
+        }
+
+        if (memcmp(header + 4, "moov", 4) == 0) {
+            if (size - header_size > MP4_MOOV_MAX_SIZE) {
+                ESP_LOGW(TAG, "moov of %" PRIu64 " bytes is too large", size);
+                return NULL;
+            }
+            *moov_size = (uint32_t)(size - header_size);
+            uint8_t *moov = alloc_table(*moov_size);
+            if (moov && !read_at(fd, pos + header_size, moov, *moov_size)) {
+                heap_caps_free(moov);
+                moov = NULL;
+            }
+            return moov;
+        }
+        pos += (uint32_t)size;
+    }
+    return NULL;
+}
+
+// Expand stts/stsc/stsz/stco of one track into frame entries
+static esp_err_t mp4_expand_stbl(const uint8_t *stbl, uint32_t stbl_size, uint32_t timescale,
+                                 struct frame_index_t *index)
+{
+    const uint8_t *end = stbl + stbl_size;
+    uint32_t stts_size, stsc_size, stsz_size, stco_size;
+    const uint8_t *stts = mp4_find(stbl, end, "stts", &stts_size);
+    const uint8_t *stsc = mp4_find(stbl, end, "stsc", &stsc_size);
+    const uint8_t *stsz = mp4_find(stbl, end, "stsz", &stsz_size);
+    bool co64 = false;
+    const uint8_t *stco = mp4_find(stbl, end, "stco", &stco_size);
+    if (!stco) {
+        stco = mp4_find(stbl, end, "co64", &stco_size);
+        co64 = true;
+    }
+    if (!stts || !stsc || !stsz || !stco || stts_size < 8 || stsc_size < 8 || stsz_size < 12 || stco_size < 8) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint32_t uniform_size = rd32be(stsz + 4);
+    uint32_t count = rd32be(stsz + 8);
+    uint32_t stsc_count = rd32be(stsc + 4);
+    uint32_t chunk_count = rd32be(stco + 4);
+    uint32_t stts_count = rd32be(stts + 4);
+    uint32_t offset_bytes = co64 ? 8 : 4;
+    if ((uniform_size == 0 && (stsz_size - 12) / 4 < count) || (stsc_size - 8) / 12 < stsc_count ||
+            (stco_size - 8) / offset_bytes < chunk_count || (stts_size - 8) / 8 < stts_count ||
+            stsc_count == 0 || timescale == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    frame_index_entry_t *entries = alloc_entries(count);
+    if (!entries) {
+        return count == 0 ? ESP_ERR_NOT_FOUND : ESP_ERR_NO_MEM;
+    }
+
+    // Samples of a chunk are stored back to back from the chunk offset
+    uint32_t sample = 0;
+    uint32_t run = 0;
+    for (uint32_t chunk = 0; chunk < chunk_count && sample < count; chunk++) {
+        while (run + 1 < stsc_count && rd32be(stsc + 8 + (run + 1) * 12) <= chunk + 1) {
+            run++;
+        }
+        uint32_t per_chunk = rd32be(stsc + 8 + run * 12 + 4);
+        uint64_t offset = co64 ? rd64be(stco + 8 + chunk * 8) : rd32be(stco + 8 + chunk * 4);
+        for (uint32_t i = 0; i < per_chunk && sample < count; i++, sample++) {
+            uint32_t size = uniform_size ? uniform_size : rd32be(stsz + 12 + sample * 4);
+            entries[sample].offset = offset > UINT32_MAX ? UINT32_MAX : (uint32_t)offset;
+            entries[sample].size = size;
+            offset += size;
+        }
+    }
+    count = sample;
+
+    // MJPEG has no reordering, decode times are presentation times
+    uint64_t dts = 0;
+    uint32_t delta = 0;
+    sample = 0;
+    for (uint32_t i = 0; i < stts_count && sample < count; i++) {
+        uint32_t run_count = rd32be(stts + 8 + i * 8);
+        delta = rd32be(stts + 8 + i * 8 + 4);
+        for (uint32_t j = 0; j < run_count && sample < count; j++, sample++) {
+            entries[sample].pts_ms = (uint32_t)(dts * 1000 / timescale);
+            dts += delta;
+        }
+    }
+    count = sample;
+
+    index->entries = entries;
+    index->count = count;
+    index->duration_ms = (uint32_t)(dts * 1000 / timescale);
+    return count > 0 ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+static esp_err_t mp4_build(int fd, uint32_t file_size, struct frame_index_t *index)
+{
+    uint32_t moov_size = 0;
+    uint8_t *moov = mp4_read_moov(fd, file_size, &moov_size);
+    if (!moov) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    const uint8_t *p = moov;
+    const uint8_t *end = moov + moov_size;
+    uint32_t trak_size;
+    const uint8_t *trak;
+    while ((trak = mp4_find(p, end, "trak", &trak_size)) != NULL) {
+        p = trak + trak_size;
+
+        uint32_t mdia_size, hdlr_size, mdhd_size, minf_size, stbl_size;
+        const uint8_t *mdia = mp4_find(trak, trak + trak_size, "mdia", &mdia_size);
+        const uint8_t *hdlr = mdia ? mp4_find(mdia, mdia + mdia_size, "hdlr", &hdlr_size) : NULL;
+        if (!hdlr || hdlr_size < 12 || memcmp(hdlr + 8, "vide", 4) != 0) {
+            continue;
+        }
+        const uint8_t *mdhd = mp4_find(mdia, mdia + mdia_size, "mdhd", &mdhd_size);
+        const uint8_t *minf = mp4_find(mdia, mdia + mdia_size, "minf", &minf_size);
+        const uint8_t *stbl = minf ? mp4_find(minf, minf + minf_size, "stbl", &stbl_size) : NULL;
+        if (!mdhd || mdhd_size < 24 || !stbl) {
+            break;
+        }
+        // Version 1 has 64-bit creation and modification times
+        uint32_t timescale = rd32be(mdhd + (mdhd[0] == 1 ? 20 : 12));
+        ret = mp4_expand_stbl(stbl, stbl_size, timescale, index);
+        break;
+    }
+
+    heap_caps_free(moov);
+    return ret;
+}
+
+// AVI: frame chunks of the first video stream listed in idx1
+
+static esp_err_t avi_build(int fd, uint32_t file_size, struct frame_index_t *index)
+{
+    uint32_t pos = 12;
+    uint32_t movi_pos = 0;
+    uint32_t idx1_pos = 0;
+    uint32_t idx1_size = 0;
+    int stream = -1;
+    uint32_t scale = 0;
+    uint32_t rate = 0;
+    uint8_t header[12];
+
+    while ((uint64_t)pos + 8 <= file_size) {
+        if (!read_at(fd, pos, header, 12)) {
+            break;
+        }
+        uint32_t size = rd32le(header + 4);
+        bool list = memcmp(header, "LIST", 4) == 0;
+
+        if (list && memcmp(header + 8, "movi", 4) == 0) {
+            movi_pos = pos + 8;
+        } else if (memcmp(header, "idx1", 4) == 0) {
+            idx1_pos = pos + 8;
+            idx1_size = size;
+        } else if (list && memcmp(header + 8, "hdrl", 4) == 0 && size <= AVI_HDRL_MAX_SIZE && size >= 4) {
+            uint8_t *hdrl = malloc(size - 4);
+            if (hdrl && read_at(fd, pos + 12, hdrl, size - 4)) {
+                // Streams are numbered in strl order
+                const uint8_t *p = hdrl;
+                const uint8_t *end = hdrl + size - 4;
+                for (int s = 0; end - p >= 12 && stream < 0; ) {
+                    uint32_t chunk_size = rd32le(p + 4);
+                    if (chunk_size > (uint32_t)(end - p) - 8) {
+                        break;
+                    }
+                    if (memcmp(p, "LIST", 4) == 0 && memcmp(p + 8, "strl", 4) == 0) {
+                        // strh: fccType, fccHandler, flags, priority+language, initial frames, scale, rate
+                        if (chunk_size >= 4 + 8 + 28 && memcmp(p + 12, "strh", 4) == 0 &&
+                                memcmp(p + 20, "vids", 4) == 0) {
+                            stream = s;
+                            scale = rd32le(p + 20 + 20);
+                            rate = rd32le(p + 20 + 24);
+                        }
+                        s++;
+                    }
+                    p += 8 + chunk_size + (chunk_size & 1);
+                }
+            }
+            free(hdrl);
+        }
+        pos += 8 + size + (size & 1);
+    }
+
+    if (stream < 0 || movi_pos == 0 || idx1_size < 16 || scale == 0 || rate == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t *idx1 = alloc_table(idx1_size);
+    if (!idx1) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    uint32_t records = idx1_size / 16;
+    frame_index_entry_t *entries = NULL;
+    if (!read_at(fd, idx1_pos, idx1, records * 16)) {
+        goto cleanup;
+    }
+    entries = alloc_entries(records);
+    if (!entries) {
+        ret = ESP_ERR_NO_MEM;
+        goto cleanup;
+    }
+
+    // Offsets count from the "movi" tag in most files and from the file start in some
+    char tag[3];
+    snprintf(tag, sizeof(tag), "%02u", (unsigned)stream % 100);
+    uint32_t base = rd32le(idx1 + 8) < movi_pos ? movi_pos : 0;
+    uint32_t frame = 0;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < records; i++) {
+        const uint8_t *record = idx1 + i * 16;
+        if (memcmp(record, tag, 2) != 0 || record[2] != 'd' || (record[3] != 'c' && record[3] != 'b')) {
+            continue;
+        }
+        // Empty chunks repeat the previous frame
+        uint32_t size = rd32le(record + 12);
+        if (size > 0) {
+            entries[count].offset = base + rd32le(record + 8) + 8;
+            entries[count].size = size;
+            entries[count].pts_ms = (uint32_t)((uint64_t)frame * 1000 * scale / rate);
+            count++;
+        }
+        frame++;
+    }
+    if (count > 0) {
+        index->entries = entries;
+        index->count = count;
+        index->duration_ms = (uint32_t)((uint64_t)frame * 1000 * scale / rate);
+        entries = NULL;
+        ret = ESP_OK;
+    }
+
+cleanup:
+    heap_caps_free(entries);
+    heap_caps_free(idx1);
+    return ret;
+}
+
+// Cache
+
+static void cache_file_path(const char *cache_dir, const char *path, char *out, size_t out_size)
+{
+    // FNV-1a; the path itself is stored in the file to rule out collisions
+    uint32_t hash = 2166136261u;
+    for (const char *c = path; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    snprintf(out, out_size, "%s/%08" PRIx32 ".fidx", cache_dir, hash);
+}
+
+// Open the cache file of path and check it still describes the clip. Returns the
+// file positioned at the entries, or NULL.
+static FILE *cache_open(const char *cache_file, const char *path, const struct stat *st,
+                        index_file_header_t *header)
+{
+    FILE *f = fopen(cache_file, "rb");
+    if (!f) {
+        return NULL;
+    }
+
+    char stored_path[256];
+    size_t path_len = strlen(path);
+    if (fread(header, sizeof(*header), 1, f) == 1 && header->magic == INDEX_FILE_MAGIC &&
+            header->version == INDEX_FILE_VERSION && header->file_size == (uint32_t)st->st_size &&
+            header->mtime == (int64_t)st->st_mtime && header->path_len == path_len &&
+            path_len < sizeof(stored_path) && fread(stored_path, 1, path_len, f) == path_len &&
+            memcmp(stored_path, path, path_len) == 0) {
+        return f;
+    }
+    fclose(f);
+    return NULL;
+}
+
+static bool cache_load(const char *cache_file, const char *path, const struct stat *st,
+                       struct frame_index_t *index)
+{
+    index_file_header_t header;
+    FILE *f = cache_open(cache_file, path, st, &header);
+    if (!f) {
+        return false;
+    }
+
+    bool ok = false;
+    frame_index_entry_t *entries = alloc_entries(header.count);
+    if (entries && fread(entries, sizeof(*entries), header.count, f) == header.count) {
+        index->entries = entries;
+        index->count = header.count;
+        index->duration_ms = header.duration_ms;
+        index->max_size = header.max_size;
+        ok = true;
+    } else {
+        heap_caps_free(entries);
+    }
+    fclose(f);
+    return ok;
+}
+
+static void cache_store(const char *cache_dir, const char *cache_file, const char *path,
+                        const struct stat *st, const struct frame_index_t *index)
+{
+    if (mkdir(cache_dir, 0755) != 0 && errno != EEXIST) {
+        ESP_LOGW(TAG, "Cannot create %s: %d", cache_dir, errno);
+        return;
+    }
+
+    // Written aside and renamed, so a pulled card never leaves a torn index
+    char tmp_file[280];
+    snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", cache_file);
+    FILE *f = fopen(tmp_file, "wb");
+    if (!f) {
+        ESP_LOGW(TAG, "Cannot write %s: %d", tmp_file, errno);
+        return;
+    }
+
+    index_file_header_t header = {
+        .magic = INDEX_FILE_MAGIC,
+        .version = INDEX_FILE_VERSION,
+        .file_size = (uint32_t)st->st_size,
+        .mtime = (int64_t)st->st_mtime,
+        .count = index->count,
+        .duration_ms = index->duration_ms,
+        .max_size = index->max_size,
+        .path_len = strlen(path),
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(path, 1, header.path_len, f) == header.path_len &&
+              fwrite(index->entries, sizeof(*index->entries), index->count, f) == index->count;
+    ok = fclose(f) == 0 && ok;
+
+    // FAT does not rename over an existing file
+    unlink(cache_file);
+    if (!ok || rename(tmp_file, cache_file) != 0) {
+        ESP_LOGW(TAG, "Failed to store %s", cache_file);
+        unlink(tmp_file);
+    }
+}
+
+esp_err_t frame_index_open(const char *path, const char *cache_dir, frame_index_handle_t *ret_index)
+{
+    if (!path || !ret_index) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    struct frame_index_t *index = calloc(1, sizeof(*index));
+    if (!index) {
+        return ESP_ERR_NO_MEM;
+    }
+    index->fd = open(path, O_RDONLY);
+    if (index->fd < 0) {
+        free(index);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = ESP_OK;
+    char cache_file[256];
+    bool cached = false;
+    if (cache_dir) {
+        cache_file_path(cache_dir, path, cache_file, sizeof(cache_file));
+        cached = cache_load(cache_file, path, &st, index);
+    }
+
+    if (!cached) {
+        uint8_t magic[12] = {0};
+        read_at(index->fd, 0, magic, sizeof(magic));
+        if (memcmp(magic, "RIFF", 4) == 0 && memcmp(magic + 8, "AVI ", 4) == 0) {
+            ret = avi_build(index->fd, (uint32_t)st.st_size, index);
+        } else {
+            ret = mp4_build(index->fd, (uint32_t)st.st_size, index);
+        }
+
+        // Every frame of an MJPEG track starts with an SOI marker
+        uint8_t soi[2] = {0};
+        if (ret == ESP_OK && (!read_at(index->fd, index->entries[0].offset, soi, 2) ||
+                              soi[0] != 0xFF || soi[1] != 0xD8)) {
+            ret = ESP_ERR_NOT_SUPPORTED;
+        }
+        for (uint32_t i = 0; ret == ESP_OK && i < index->count; i++) {
+            if (index->entries[i].size > index->max_size) {
+                index->max_size = index->entries[i].size;
+            }
+        }
+        if (ret == ESP_OK && cache_dir) {
+            cache_store(cache_dir, cache_file, path, &st, index);
+        }
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No frame index for %s: %s", path, esp_err_to_name(ret));
+        frame_index_close(index);
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "%s %" PRIu32 " frames of %s in %" PRId64 " ms", cached ? "Loaded" : "Indexed", index->count,
+             path, (esp_timer_get_time() - start_us) / 1000);
+    *ret_index = index;
+    return ESP_OK;
+}
+
+esp_err_t frame_index_peek_max_size(const char *path, const char *cache_dir, uint32_t *max_size)
+{
+    if (!path || !cache_dir || !max_size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    char cache_file[256];
+    cache_file_path(cache_dir, path, cache_file, sizeof(cache_file));
+    index_file_header_t header;
+    FILE *f = cache_open(cache_file, path, &st, &header);
+    if (!f) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    fclose(f);
+    *max_size = header.max_size;
+    return ESP_OK;
+}
+
+void frame_index_close(frame_index_handle_t index)
+{
+    if (!index) {
+        return;
+    }
+    if (index->fd >= 0) {
+        close(index->fd);
+    }
+    heap_caps_free(index->entries);
+    free(index);
+}
+
+uint32_t frame_index_count(frame_index_handle_t index)
+{
+    return index ? index->count : 0;
+}
+
+uint32_t frame_index_max_size(frame_index_handle_t index)
+{
+    return index ? index->max_size : 0;
+}
+
+uint32_t frame_index_duration_ms(frame_index_handle_t index)
+{
+    return index ? index->duration_ms : 0;
+}
+
+uint32_t frame_index_find(frame_index_handle_t index, uint32_t pts_ms)
+{
+    if (!index || index->count == 0) {
+        return 0;
+    }
+
+    const frame_index_entry_t *entries = index->entries;
+    uint32_t last = index->count - 1;
+    uint32_t n = entries[last].pts_ms > 0 ? (uint32_t)((uint64_t)pts_ms * last / entries[last].pts_ms) : 0;
+    if (n > last) {
+        n = last;
+    }
+    while (n > 0 && entries[n].pts_ms > pts_ms) {
+        n--;
+    }
+    while (n < last && entries[n + 1].pts_ms <= pts_ms) {
+        n++;
+    }
+    return n;
+}
+
+const frame_index_entry_t *frame_index_get(frame_index_handle_t index, uint32_t frame)
+{
+    return index && frame < index->count ? &index->entries[frame] : NULL;
+}
+
+esp_err_t frame_index_read(frame_index_handle_t index, uint32_t frame, uint8_t *buffer, size_t buffer_size)
+{
+    const frame_index_entry_t *entry = frame_index_get(index, frame);
+    if (!entry || !buffer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (entry->size > buffer_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return read_at(index->fd, entry->offset, buffer, entry->size) ? ESP_OK : ESP_FAIL;
+}
@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Frame offset index of an MJPEG clip: where each frame's JPEG bitstream sits
+// in the file and when it is shown. Every MJPEG frame is a key frame, so any
+// frame can be read and decoded on its own: seeking lands on an exact frame,
+// scrubbing decodes only the frames shown and thumbnails need no demuxer.
+//
+// The index is built from the container's own sample tables (MP4 stbl, AVI
+// idx1) and cached in a directory on the card, keyed by path and checked
+// against the clip's size and modification time.
+
+typedef struct frame_index_t *frame_index_handle_t;
+
+typedef struct {
+    uint32_t pts_ms;                // Presentation time
+    uint32_t offset;                // File offset of the JPEG bitstream
+    uint32_t size;                  // Bitstream bytes
+} frame_index_entry_t;
+
+// Load the index of a clip from cache_dir, or build it and store it there.
+// cache_dir may be NULL to always build. ESP_ERR_NOT_SUPPORTED when the clip's
+// first video track is not MJPEG, ESP_ERR_NOT_FOUND when it has no sample table.
+esp_err_t frame_index_open(const char *path, const char *cache_dir, frame_index_handle_t *ret_index);
+void frame_index_close(frame_index_handle_t index);
+
+// Largest frame of a clip indexed before, read from its cache entry alone, so a
+// clip's buffers can be sized before it is opened. ESP_ERR_NOT_FOUND when
+// cache_dir holds no valid index of the clip.
+esp_err_t frame_index_peek_max_size(const char *path, const char *cache_dir, uint32_t *max_size);
+
+uint32_t frame_index_count(frame_index_handle_t index);
+
+// Largest frame, the read buffer size that fits any frame
+uint32_t frame_index_max_size(frame_index_handle_t index);
+
+uint32_t frame_index_duration_ms(frame_index_handle_t index);
+
+// Frame on screen at pts_ms: the last one shown at or before it. Frames are
+// close to evenly spaced, so this is a guess and a step or two.
+uint32_t frame_index_find(frame_index_handle_t index, uint32_t pts_ms);
+
+const frame_index_entry_t *frame_index_get(frame_index_handle_t index, uint32_t frame);
+
+// Read a frame's bitstream into buffer, which must hold its size
+esp_err_t frame_index_read(frame_index_handle_t index, uint32_t frame, uint8_t *buffer, size_t buffer_size);
+
+#ifdef __cplusplus
+}
+#endif
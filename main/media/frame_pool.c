@@ -0,0 +1,254 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "frame_pool.h"
+#include "image_buffer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "frame_pool";
+
+typedef enum {
+    FRAME_BUF_FREE,
+    FRAME_BUF_ACQUIRED,             // Being written by the producer, or queued for display
+    FRAME_BUF_PRESENTED,            // Owned by the display until released
+} frame_buf_state_t;
+
+typedef struct {
+    uint8_t *data;                  // NULL until first use
+    size_t size;
+    frame_buf_state_t state;
+} frame_buf_t;
+
+struct frame_pool_t {
+    const char *name;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t free_count;   // Counts FREE entries
+    size_t buffer_size;
+    frame_pool_stats_t stats;
+    uint32_t depth;
+    frame_buf_t bufs[];
+};
+
+static void buf_free(struct frame_pool_t *pool, frame_buf_t *buf)
+{
+    if (buf->data) {
+        image_buffer_free(buf->data);
+        pool->stats.allocated--;
+        pool->stats.allocated_bytes -= buf->size;
+        buf->data = NULL;
+        buf->size = 0;
+    }
+}
+
+static frame_buf_t *buf_find(struct frame_pool_t *pool, const uint8_t *data)
+{
+    for (uint32_t i = 0; i < pool->depth; i++) {
+        if (pool->bufs[i].data && pool->bufs[i].data == data) {
+            return &pool->bufs[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t frame_pool_create(const frame_pool_config_t *config, frame_pool_handle_t *ret_pool)
+{
+    if (!config || !ret_pool || config->depth == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct frame_pool_t *pool = calloc(1, sizeof(*pool) + config->depth * sizeof(frame_buf_t));
+    if (!pool) {
+        return ESP_ERR_NO_MEM;
+    }
+    pool->name = config->name ? config->name : "frames";
+    pool->depth = config->depth;
+    pool->stats.depth = config->depth;
+
+    pool->lock = xSemaphoreCreateMutex();
+    pool->free_count = xSemaphoreCreateCounting(config->depth, config->depth);
+    if (!pool->lock || !pool->free_count) {
+        frame_pool_delete(pool);
+        return ESP_ERR_NO_MEM;
+    }
+
+    *ret_pool = pool;
+    return ESP_OK;
+}
+
+void frame_pool_delete(frame_pool_handle_t pool)
+{
+    if (!pool) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < pool->depth; i++) {
+        if (pool->bufs[i].state != FRAME_BUF_FREE) {
+            ESP_LOGW(TAG, "%s: buffer %p still in use, leaking it", pool->name, pool->bufs[i].data);
+            continue;
+        }
+        buf_free(pool, &pool->bufs[i]);
+    }
+    if (pool->free_count) {
+        vSemaphoreDelete(pool->free_count);
+    }
+    if (pool->lock) {
+        vSemaphoreDelete(pool->lock);
+    }
+    free(pool);
+}
+
+esp_err_t frame_pool_set_buffer_size(frame_pool_handle_t pool, size_t size)
+{
+    if (!pool) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    if (size != pool->buffer_size) {
+        pool->buffer_size = size;
+        pool->stats.buffer_size = size;
+        // Idle buffers of the old size go now, the rest in frame_pool_release()
+        for (uint32_t i = 0; i < pool->depth; i++) {
+            if (pool->bufs[i].state == FRAME_BUF_FREE) {
+                buf_free(pool, &pool->bufs[i]);
+            }
+        }
+        ESP_LOGI(TAG, "%s: %u x %zu bytes", pool->name, pool->depth, size);
+    }
+    xSemaphoreGive(pool->lock);
+    return ESP_OK;
+}
+
+uint8_t *frame_pool_acquire(frame_pool_handle_t pool, uint32_t timeout_ms, size_t *size)
+{
+    if (!pool || pool->buffer_size == 0) {
+        return NULL;
+    }
+
+    if (xSemaphoreTake(pool->free_count, 0) != pdTRUE) {
+        pool->stats.acquire_waits++;
+        if (xSemaphoreTake(pool->free_count, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+            return NULL;
+        }
+    }
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+
+    // Prefer a buffer that is already allocated at the current size
+    frame_buf_t *buf = NULL;
+    for (uint32_t i = 0; i < pool->depth; i++) {
+        frame_buf_t *candidate = &pool->bufs[i];
+        if (candidate->state != FRAME_BUF_FREE) {
+            continue;
+        }
+        if (candidate->data && candidate->size == pool->buffer_size) {
+            buf = candidate;
+            break;
+        }
+        if (!buf) {
+            buf = candidate;
+        }
+    }
+
+    if (buf && buf->size != pool->buffer_size) {
+        buf_free(pool, buf);
+        buf->data = image_buffer_alloc(pool->buffer_size, NULL);
+        if (buf->data) {
+            buf->size = pool->buffer_size;
+            pool->stats.allocated++;
+            pool->stats.allocated_bytes += buf->size;
+        } else {
+            ESP_LOGE(TAG, "%s: failed to allocate %zu byte buffer", pool->name, pool->buffer_size);
+            buf = NULL;
+        }
+    }
+
+    if (buf) {
+        buf->state = FRAME_BUF_ACQUIRED;
+        pool->stats.in_use++;
+        if (pool->stats.in_use > pool->stats.in_use_peak) {
+            pool->stats.in_use_peak = pool->stats.in_use;
+        }
+        if (size) {
+            *size = buf->size;
+        }
+    }
+    xSemaphoreGive(pool->lock);
+
+    if (!buf) {
+        xSemaphoreGive(pool->free_count);
+        return NULL;
+    }
+    return buf->data;
+}
+
+void frame_pool_mark_presented(frame_pool_handle_t pool, uint8_t *buffer)
+{
+    if (!pool || !buffer) {
+        return;
+    }
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    frame_buf_t *buf = buf_find(pool, buffer);
+    if (buf && buf->state == FRAME_BUF_ACQUIRED) {
+        buf->state = FRAME_BUF_PRESENTED;
+        pool->stats.presented++;
+    }
+    xSemaphoreGive(pool->lock);
+}
+
+void frame_pool_release(frame_pool_handle_t pool, uint8_t *buffer)
+{
+    if (!pool || !buffer) {
+        return;
+    }
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    frame_buf_t *buf = buf_find(pool, buffer);
+    if (!buf || buf->state == FRAME_BUF_FREE) {
+        xSemaphoreGive(pool->lock);
+        ESP_LOGE(TAG, "%s: release of buffer %p that is not in use", pool->name, buffer);
+        return;
+    }
+
+    if (buf->state == FRAME_BUF_PRESENTED) {
+        pool->stats.presented--;
+    }
+    buf->state = FRAME_BUF_FREE;
+    pool->stats.in_use--;
+    if (buf->size != pool->buffer_size) {
+        buf_free(pool, buf);
+    }
+    xSemaphoreGive(pool->lock);
+
+    xSemaphoreGive(pool->free_count);
+}
+
+bool frame_pool_owns(frame_pool_handle_t pool, const uint8_t *buffer)
+{
+    if (!pool || !buffer) {
+        return false;
+    }
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    bool owns = buf_find(pool, buffer) != NULL;
+    xSemaphoreGive(pool->lock);
+    return owns;
+}
+
+void frame_pool_get_stats(frame_pool_handle_t pool, frame_pool_stats_t *stats)
+{
+    if (!pool || !stats) {
+        return;
+    }
+
+    xSemaphoreTake(pool->lock, portMAX_DELAY);
+    *stats = pool->stats;
+    xSemaphoreGive(pool->lock);
+}
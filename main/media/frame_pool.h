@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fixed-depth pool of video frame buffers with explicit ownership.
+//
+// A buffer is acquired by the producer (decoder or SRM stage), handed to the
+// display with frame_pool_mark_presented() and released once the display has
+// finished reading it. Nothing writes into a buffer between acquire and
+// release by anyone else, so a frame still being scanned out is never
+// overwritten. Buffers are allocated on first use at the current buffer size;
+// resizing frees idle buffers at once and in-use ones when they are released.
+
+typedef struct frame_pool_t *frame_pool_handle_t;
+
+typedef struct {
+    const char *name;               // Used in logs
+    uint32_t depth;                 // Buffers in flight at most: being written, queued or on screen
+} frame_pool_config_t;
+
+typedef struct {
+    uint32_t depth;
+    size_t buffer_size;             // Size new buffers are allocated at
+    uint32_t allocated;             // Buffers currently backed by memory
+    size_t allocated_bytes;
+    uint32_t in_use;                // Acquired and not yet released
+    uint32_t in_use_peak;
+    uint32_t presented;             // Handed to the display, waiting for release
+    uint32_t acquire_waits;         // Acquires that had to wait for a release
+} frame_pool_stats_t;
+
+esp_err_t frame_pool_create(const frame_pool_config_t *config, frame_pool_handle_t *ret_pool);
+
+// Free the pool. Buffers still in use are leaked with a warning.
+void frame_pool_delete(frame_pool_handle_t pool);
+
+// Size for buffers acquired from now on; 0 frees idle buffers and fails acquires
+esp_err_t frame_pool_set_buffer_size(frame_pool_handle_t pool, size_t size);
+
+// Take a buffer of the current size, waiting up to timeout_ms for one to be
+// released. Returns NULL on timeout or allocation failure.
+uint8_t *frame_pool_acquire(frame_pool_handle_t pool, uint32_t timeout_ms, size_t *size);
+
+// Note that the display now owns the buffer
+void frame_pool_mark_presented(frame_pool_handle_t pool, uint8_t *buffer);
+
+// Give a buffer back; safe from any task
+void frame_pool_release(frame_pool_handle_t pool, uint8_t *buffer);
+
+bool frame_pool_owns(frame_pool_handle_t pool, const uint8_t *buffer);
+
+void frame_pool_get_stats(frame_pool_handle_t pool, frame_pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,281 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "h264_decoder.h"
+#include "esp_log.h"
+#include "esp_h264_dec.h"
+#include "esp_h264_dec_sw.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "h264_decoder";
+
+#define H264_PROFILE_BASELINE       66
+#define H264_CONSTRAINT_SET0        0x80    // Stream also conforms to baseline, e.g. Main without CABAC
+#define H264_NAL_TYPE_IDR           5
+#define H264_AVCC_HEADER_LEN        6
+
+struct h264_decoder_t {
+    esp_h264_dec_handle_t dec;
+    uint32_t max_width;
+    uint32_t max_height;
+    uint8_t *params;                // SPS and PPS from avcC with start codes, fed ahead of an IDR after a flush
+    uint32_t params_len;
+    uint8_t length_size;            // NAL length prefix of the samples, 0 for Annex-B
+    bool need_idr;
+};
+
+static const uint8_t s_start_code[4] = { 0, 0, 0, 1 };
+
+static bool has_start_code(const uint8_t *data, uint32_t size)
+{
+    return (size >= 4 && memcmp(data, s_start_code, 4) == 0) ||
+           (size >= 3 && data[0] == 0 && data[1] == 0 && data[2] == 1);
+}
+
+// Rewrite 4-byte NAL lengths to start codes, same size, and report whether the
+// access unit holds an IDR slice. False when a length runs past the sample.
+static bool length_prefix_to_annex_b(uint8_t *data, uint32_t size, bool *idr)
+{
+    uint32_t pos = 0;
+    while (pos + 4 < size) {
+        uint32_t len = ((uint32_t)data[pos] << 24) | ((uint32_t)data[pos + 1] << 16) |
+                       ((uint32_t)data[pos + 2] << 8) | data[pos + 3];
+        if (len == 0 || len > size - pos - 4) {
+            return false;
+        }
+        memcpy(data + pos, s_start_code, 4);
+        if ((data[pos + 4] & 0x1F) == H264_NAL_TYPE_IDR) {
+            *idr = true;
+        }
+        pos += 4 + len;
+    }
+    return true;
+}
+
+static bool annex_b_has_idr(const uint8_t *data, uint32_t size)
+{
+    for (uint32_t i = 0; i + 3 < size; i++) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1 &&
+                (data[i + 3] & 0x1F) == H264_NAL_TYPE_IDR) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Feed a whole buffer, keeping the last picture that came out
+static esp_err_t feed(h264_decoder_handle_t decoder, uint8_t *data, uint32_t size, esp_h264_dec_out_frame_t *out,
+                      bool *have_picture)
+{
+    esp_h264_dec_in_frame_t in = {
+        .raw_data = { .buffer = data, .len = size },
+    };
+    while (in.raw_data.len > 0) {
+        esp_h264_dec_out_frame_t frame = {0};
+        esp_h264_err_t err = esp_h264_dec_process(decoder->dec, &in, &frame);
+        if (err != ESP_H264_ERR_OK) {
+            ESP_LOGE(TAG, "Decode failed: %d", err);
+            return ESP_FAIL;
+        }
+        if (frame.out_size > 0) {
+            *out = frame;
+            *have_picture = true;
+        }
+        if (in.consume == 0 || in.consume > in.raw_data.len) {
+            break;
+        }
+        in.raw_data.buffer += in.consume;
+        in.raw_data.len -= in.consume;
+    }
+    return ESP_OK;
+}
+
+esp_err_t h264_decoder_create(uint32_t max_width, uint32_t max_height, h264_decoder_handle_t *ret_decoder)
+{
+    if (!ret_decoder || max_width == 0 || max_height == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    h264_decoder_handle_t decoder = calloc(1, sizeof(*decoder));
+    if (!decoder) {
+        return ESP_ERR_NO_MEM;
+    }
+    decoder->max_width = max_width;
+    decoder->max_height = max_height;
+    decoder->need_idr = true;
+
+    esp_h264_dec_cfg_sw_t cfg = {
+        .pic_type = ESP_H264_RAW_FMT_I420,
+    };
+    if (esp_h264_dec_sw_new(&cfg, &decoder->dec) != ESP_H264_ERR_OK) {
+        goto cleanup;
+    }
+    if (esp_h264_dec_open(decoder->dec) != ESP_H264_ERR_OK) {
+        goto cleanup;
+    }
+
+    *ret_decoder = decoder;
+    return ESP_OK;
+
+cleanup:
+    ESP_LOGE(TAG, "Failed to create the H.264 decoder");
+    h264_decoder_delete(decoder);
+    return ESP_ERR_NO_MEM;
+}
+
+void h264_decoder_delete(h264_decoder_handle_t decoder)
+{
+    if (!decoder) {
+        return;
+    }
+    if (decoder->dec) {
+        esp_h264_dec_close(decoder->dec);
+        esp_h264_dec_del(decoder->dec);
+    }
+    free(decoder->params);
+    free(decoder);
+}
+
+esp_err_t h264_decoder_set_config(h264_decoder_handle_t decoder, const uint8_t *avcc, uint32_t avcc_len)
+{
+    if (!decoder || (!avcc && avcc_len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    free(decoder->params);
+    decoder->params = NULL;
+    decoder->params_len = 0;
+    decoder->length_size = 0;
+    decoder->need_idr = true;
+
+    // No record, or parameter sets already in Annex-B form: the samples carry start codes
+    if (avcc_len < H264_AVCC_HEADER_LEN || avcc[0] != 1) {
+        return ESP_OK;
+    }
+
+    uint8_t profile = avcc[1];
+    if (profile != H264_PROFILE_BASELINE && !(avcc[2] & H264_CONSTRAINT_SET0)) {
+        ESP_LOGE(TAG, "H.264 profile %u not supported - encode with -profile:v baseline", profile);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    uint8_t length_size = (avcc[4] & 0x03) + 1;
+    if (length_size != 4) {
+        ESP_LOGE(TAG, "%u-byte NAL lengths not supported", length_size);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // Every parameter set grows by a start code in place of its 2-byte length
+    decoder->params = malloc(avcc_len * 2);
+    if (!decoder->params) {
+        return ESP_ERR_NO_MEM;
+    }
+    uint32_t pos = 5;
+    for (int set = 0; set < 2; set++) {
+        // SPS count in the low 5 bits, PPS count in a byte of its own
+        uint32_t count = set == 0 ? (avcc[pos] & 0x1F) : avcc[pos];
+        pos++;
+        for (uint32_t i = 0; i < count; i++) {
+            if (pos + 2 > avcc_len) {
+                goto malformed;
+            }
+            uint32_t len = ((uint32_t)avcc[pos] << 8) | avcc[pos + 1];
+            pos += 2;
+            if (len > avcc_len - pos) {
+                goto malformed;
+            }
+            memcpy(decoder->params + decoder->params_len, s_start_code, 4);
+            memcpy(decoder->params + decoder->params_len + 4, avcc + pos, len);
+            decoder->params_len += 4 + len;
+            pos += len;
+        }
+        if (set == 0 && pos >= avcc_len) {
+            goto malformed;
+        }
+    }
+    decoder->length_size = length_size;
+    return ESP_OK;
+
+malformed:
+    ESP_LOGE(TAG, "Malformed avcC record");
+    free(decoder->params);
+    decoder->params = NULL;
+    decoder->params_len = 0;
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t h264_decoder_decode(h264_decoder_handle_t decoder, uint8_t *data, uint32_t size, yuv_i420_t *picture)
+{
+    if (!decoder || !data || !picture) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    bool idr = false;
+    if (decoder->length_size > 0 && !has_start_code(data, size)) {
+        if (!length_prefix_to_annex_b(data, size, &idr)) {
+            ESP_LOGE(TAG, "Malformed sample of %u bytes", size);
+            return ESP_ERR_INVALID_SIZE;
+        }
+    } else if (decoder->need_idr) {
+        idr = annex_b_has_idr(data, size);
+    }
+
+    // References from before a seek are gone; a P frame now would decode to garbage
+    if (decoder->need_idr && !idr) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+
+    esp_h264_dec_out_frame_t out = {0};
+    bool have_picture = false;
+    if (decoder->need_idr && decoder->params_len > 0) {
+        esp_err_t ret = feed(decoder, decoder->params, decoder->params_len, &out, &have_picture);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    decoder->need_idr = false;
+
+    esp_err_t ret = feed(decoder, data, size, &out, &have_picture);
+    if (ret != ESP_OK) {
+        decoder->need_idr = true;
+        return ret;
+    }
+    if (!have_picture) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+
+    esp_h264_dec_param_sw_handle_t param = NULL;
+    esp_h264_resolution_t res = {0};
+    if (esp_h264_dec_sw_get_param_hd(decoder->dec, &param) != ESP_H264_ERR_OK ||
+            esp_h264_dec_get_resolution((esp_h264_dec_param_handle_t)param, &res) != ESP_H264_ERR_OK) {
+        return ESP_FAIL;
+    }
+    if (res.width > decoder->max_width || res.height > decoder->max_height) {
+        ESP_LOGE(TAG, "%ux%u exceeds the %ux%u H.264 limit", res.width, res.height,
+                 decoder->max_width, decoder->max_height);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    uint32_t luma = (uint32_t)res.width * res.height;
+    if (out.out_size < luma * 3 / 2) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    picture->y = out.outbuf;
+    picture->u = out.outbuf + luma;
+    picture->v = out.outbuf + luma + luma / 4;
+    picture->y_stride = res.width;
+    picture->uv_stride = res.width / 2;
+    picture->width = res.width;
+    picture->height = res.height;
+    return ESP_OK;
+}
+
+void h264_decoder_flush(h264_decoder_handle_t decoder)
+{
+    if (decoder) {
+        decoder->need_idr = true;
+    }
+}
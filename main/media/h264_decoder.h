@@ -0,0 +1,45 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "yuv_convert.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Software H.264 decoder for MP4 video tracks, baseline and constrained
+// baseline profiles only. Wraps the esp_h264 software decoder: one access unit
+// in, at most one I420 picture out, held by the decoder until the next call.
+//
+// Samples may come length-prefixed as stored in MP4 (after h264_decoder_set_config()
+// with the track's avcC record) or as an Annex-B byte stream. Unlike MJPEG, frames
+// depend on the ones before them: every access unit has to be decoded in order,
+// and after a seek decoding only resumes at the next IDR frame.
+
+typedef struct h264_decoder_t *h264_decoder_handle_t;
+
+// Pictures larger than max_width x max_height are refused rather than decoded late
+esp_err_t h264_decoder_create(uint32_t max_width, uint32_t max_height, h264_decoder_handle_t *ret_decoder);
+void h264_decoder_delete(h264_decoder_handle_t decoder);
+
+// Parameter sets and NAL length size from the track's avcC record. ESP_ERR_NOT_SUPPORTED
+// for profiles other than baseline, and for length prefixes other than 4 bytes.
+esp_err_t h264_decoder_set_config(h264_decoder_handle_t decoder, const uint8_t *avcc, uint32_t avcc_len);
+
+// Decode one access unit. Length prefixes are rewritten to start codes in place.
+// ESP_ERR_NOT_FINISHED when no picture came out: frames before the first IDR after a
+// flush are skipped. ESP_ERR_NOT_SUPPORTED when the picture exceeds the size limit.
+esp_err_t h264_decoder_decode(h264_decoder_handle_t decoder, uint8_t *data, uint32_t size, yuv_i420_t *picture);
+
+// Forget the stream position, after a seek. Frames are skipped up to the next IDR.
+void h264_decoder_flush(h264_decoder_handle_t decoder);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,52 +4,25 @@
  */
 
 #include "image_decoder.h"
-#include "app_stream_adapter.h"
 #include "photo_album_constants.h"
+#include "image_buffer.h"
+#include "hal_jpeg.h"
+#include "jpeg_sched.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "esp_memory_utils.h"
-#include "driver/jpeg_decode.h"
 #include "png.h"
 #include <string.h>
 #include <stdlib.h>
 #include "esp_cache.h"
 
 static const char *TAG = "img_dec";
-static jpeg_decoder_handle_t s_jpeg_decoder = NULL;
-static decoder_config_t s_config;
 
-// Cache sync helper function
-static esp_err_t safe_cache_sync(void *addr, size_t size, int flags)
-{
-    if (!addr || size == 0) {
-        return ESP_OK;
-    }
-    
-    // Check if address is in cacheable memory region
-    if (!esp_ptr_in_dram(addr) && !esp_ptr_external_ram(addr)) {
-        return ESP_OK; // Skip cache sync for non-cacheable memory
-    }
-    
-    // Handle alignment requirements based on direction
-    if (flags & ESP_CACHE_MSYNC_FLAG_DIR_C2M) {
-        // C2M direction supports UNALIGNED flag
-        return esp_cache_msync(addr, size, flags | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
-    } else {
-        // M2C direction doesn't support UNALIGNED flag - check alignment
-        size_t cache_line_size = 128; // Typical cache line size for ESP32-P4
-        bool aligned_addr = ((uintptr_t)addr % cache_line_size) == 0;
-        bool aligned_size = (size % cache_line_size) == 0;
-        
-        if (aligned_addr && aligned_size) {
-            // Properly aligned, can do sync
-            return esp_cache_msync(addr, size, flags);
-        } else {
-            // Not aligned, skip M2C sync (hardware will handle coherency)
-            return ESP_OK;
-        }
-    }
-}
+// Longest a decode waits for the JPEG engine; background work gives up while video keeps it busy
+#define JPEG_ENGINE_WAIT_MS     2000
+
+static hal_jpeg_handle_t s_jpeg_decoder = NULL;
+static decoder_config_t s_config;
 
 // PNG read callback
 static void png_read_callback(png_structp png_ptr, png_bytep data, png_size_t length)
@@ -60,7 +33,7 @@ static void png_read_callback(png_structp png_ptr, png_bytep data, png_size_t le
 }
 
 // Convert RGB888 to RGB565
-static void convert_rgb888_to_rgb565(const uint8_t *rgb888, uint16_t *rgb565, uint32_t pixel_count)
+void image_decoder_rgb888_to_rgb565(const uint8_t *rgb888, uint16_t *rgb565, uint32_t pixel_count)
 {
     for (uint32_t i = 0; i < pixel_count; i++) {
         uint8_t r = rgb888[i * BYTES_PER_PIXEL_RGB888 + 0] >> RGB888_TO_RGB565_R_SHIFT;
@@ -70,7 +43,8 @@ static void convert_rgb888_to_rgb565(const uint8_t *rgb888, uint16_t *rgb565, ui
     }
 }
 
-static esp_err_t decode_jpeg_image(const uint8_t *data, size_t data_size, decoded_image_t *output)
+static esp_err_t decode_jpeg_image(const uint8_t *data, size_t data_size, jpeg_sched_class_t job_class,
+                                   decoded_image_t *output)
 {
     if (!s_jpeg_decoder) {
         ESP_LOGE(TAG, "JPEG decoder not initialized");
@@ -89,8 +63,8 @@ static esp_err_t decode_jpeg_image(const uint8_t *data, size_t data_size, decode
     }
     
     // Get JPEG header info first
-    jpeg_decode_picture_info_t header_info;
-    esp_err_t ret = jpeg_decoder_get_info(data, data_size, &header_info);
+    hal_jpeg_info_t header_info;
+    esp_err_t ret = hal_jpeg_get_info(data, data_size, &header_info);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to get JPEG info: %s", esp_err_to_name(ret));
         return ret;
@@ -108,7 +82,7 @@ static esp_err_t decode_jpeg_image(const uint8_t *data, size_t data_size, decode
     uint64_t max_pixels = (uint64_t)MAX_DECODE_WIDTH * MAX_DECODE_HEIGHT;  // 1920x1080 = ~2M pixels
     
     if (total_pixels > max_pixels) {
-        ESP_LOGE(TAG, "JPEG resolution too large: %dx%d (%llu pixels, max: %llu pixels)", 
+        ESP_LOGE(TAG, "JPEG resolution too large: %dx%d (%" PRIu64 " pixels, max: %" PRIu64 " pixels)", 
                  header_info.width, header_info.height, total_pixels, max_pixels);
         return ESP_ERR_NOT_SUPPORTED;
     }
@@ -140,13 +114,9 @@ static esp_err_t decode_jpeg_image(const uint8_t *data, size_t data_size, decode
     
     output->data_size = calculated_size;
     
-    // Allocate output buffer using JPEG decoder alignment
-    jpeg_decode_memory_alloc_cfg_t mem_cfg = {
-        .buffer_direction = JPEG_DEC_ALLOC_OUTPUT_BUFFER,
-    };
-    
+    // Output comes from the shared aligned allocator so it can go straight to the PPA
     size_t allocated_size;
-    output->rgb_data = (uint8_t*)jpeg_alloc_decoder_mem(aligned_buffer_size, &mem_cfg, &allocated_size);
+    output->rgb_data = (uint8_t*)image_buffer_alloc(aligned_buffer_size, &allocated_size);
     if (!output->rgb_data) {
         ESP_LOGE(TAG, "Failed to allocate JPEG output buffer: need %zu bytes", aligned_buffer_size);
         
@@ -158,37 +128,35 @@ static esp_err_t decode_jpeg_image(const uint8_t *data, size_t data_size, decode
         return ESP_ERR_NO_MEM;
     }
     
-    // Cache sync for input data - ensure hardware sees latest data
-    ret = safe_cache_sync((void*)data, data_size, ESP_CACHE_MSYNC_FLAG_DIR_M2C);
+    // Write back input data so the decoder DMA sees what the CPU read from file
+    ret = image_buffer_cache_sync((void*)data, image_buffer_align_size(data_size), ESP_CACHE_MSYNC_FLAG_DIR_C2M);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Input cache sync failed: %s", esp_err_to_name(ret));
     }
     
     // Cache sync for output buffer - clear old cache data
-    ret = safe_cache_sync((void*)output->rgb_data, allocated_size, 
-                         ESP_CACHE_MSYNC_FLAG_DIR_M2C | ESP_CACHE_MSYNC_FLAG_INVALIDATE);
+    ret = image_buffer_cache_sync((void*)output->rgb_data, allocated_size, 
+                                  ESP_CACHE_MSYNC_FLAG_DIR_M2C | ESP_CACHE_MSYNC_FLAG_INVALIDATE);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Output buffer cache sync failed: %s", esp_err_to_name(ret));
     }
     
-    jpeg_decode_cfg_t decode_cfg = {
-        .output_format = JPEG_DECODE_OUT_FORMAT_RGB565,
-        .rgb_order = JPEG_DEC_RGB_ELEMENT_ORDER_BGR,
-        .conv_std = JPEG_YUV_RGB_CONV_STD_BT601,
-    };
-    
     uint32_t out_size;
-    ret = jpeg_decoder_process(s_jpeg_decoder, &decode_cfg, data, data_size, 
-                              output->rgb_data, allocated_size, &out_size);
+    ret = jpeg_sched_begin(job_class, JPEG_ENGINE_WAIT_MS);
+    if (ret == ESP_OK) {
+        ret = hal_jpeg_decode_rgb565(s_jpeg_decoder, data, data_size,
+                                     output->rgb_data, allocated_size, &out_size);
+        jpeg_sched_end(job_class);
+    }
     if (ret != ESP_OK) {
-        free(output->rgb_data);
+        image_buffer_free(output->rgb_data);
         output->rgb_data = NULL;
         ESP_LOGE(TAG, "JPEG decode failed: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    // Cache sync for result - ensure CPU sees decode results
-    ret = safe_cache_sync((void*)output->rgb_data, out_size, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+    // Invalidate the whole aligned buffer so the CPU sees decode results
+    ret = image_buffer_cache_sync((void*)output->rgb_data, allocated_size, ESP_CACHE_MSYNC_FLAG_DIR_M2C);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Result cache sync failed: %s", esp_err_to_name(ret));
     }
@@ -245,13 +213,8 @@ static esp_err_t decode_png_image(const uint8_t *data, size_t data_size, decoded
     
     output->data_size = output->width * output->height * BYTES_PER_PIXEL_RGB565;
     
-    // Allocate output buffer
-    if (s_config.use_psram) {
-        output->rgb_data = heap_caps_malloc(output->data_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    }
-    if (!output->rgb_data) {
-        output->rgb_data = malloc(output->data_size);
-    }
+    // Allocate output buffer aligned for PPA input
+    output->rgb_data = image_buffer_alloc(output->data_size, NULL);
     
     if (!output->rgb_data) {
         png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
@@ -267,7 +230,7 @@ static esp_err_t decode_png_image(const uint8_t *data, size_t data_size, decoded
         
         uint8_t *row_buffer = malloc(output->width * BYTES_PER_PIXEL_RGBA8888);
         if (!row_buffer) {
-            free(output->rgb_data);
+            image_buffer_free(output->rgb_data);
             png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
             return ESP_ERR_NO_MEM;
         }
@@ -311,7 +274,7 @@ static esp_err_t decode_png_image(const uint8_t *data, size_t data_size, decoded
         
         uint8_t *row_buffer = malloc(output->width * BYTES_PER_PIXEL_RGB888);
         if (!row_buffer) {
-            free(output->rgb_data);
+            image_buffer_free(output->rgb_data);
             png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
             return ESP_ERR_NO_MEM;
         }
@@ -321,7 +284,7 @@ static esp_err_t decode_png_image(const uint8_t *data, size_t data_size, decoded
         for (uint32_t y = 0; y < output->height; y++) {
             png_read_row(png_ptr, row_buffer, NULL);
             uint16_t *output_row = rgb565_data + y * output->width;
-            convert_rgb888_to_rgb565(row_buffer, output_row, output->width);
+            image_decoder_rgb888_to_rgb565(row_buffer, output_row, output->width);
         }
         free(row_buffer);
     }
@@ -344,17 +307,10 @@ esp_err_t image_decoder_init(const decoder_config_t *config)
     
     s_config = *config;
     
-    // Initialize shared JPEG decoder manager
-    esp_err_t ret = shared_jpeg_decoder_init();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize shared JPEG decoder: %d", ret);
-        return ret;
-    }
-    
-    // Get shared JPEG decoder handle
-    ret = shared_jpeg_decoder_acquire(&s_jpeg_decoder);
+    // Get the JPEG engine (shared with the video path on target)
+    esp_err_t ret = hal_jpeg_acquire(&s_jpeg_decoder);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to acquire shared JPEG decoder: %d", ret);
+        ESP_LOGE(TAG, "Failed to acquire JPEG decoder: %d", ret);
         return ret;
     }
     
@@ -368,15 +324,15 @@ esp_err_t image_decoder_deinit(void)
 {
     if (s_jpeg_decoder) {
         // Release shared JPEG decoder
-        shared_jpeg_decoder_release();
+        hal_jpeg_release(s_jpeg_decoder);
         s_jpeg_decoder = NULL;
         ESP_LOGI(TAG, "Image decoder deinitialized, shared JPEG decoder released");
     }
     return ESP_OK;
 }
 
-esp_err_t image_decoder_decode(const uint8_t *data, size_t data_size, 
-                              image_format_t format, decoded_image_t *output)
+static esp_err_t decode_image(const uint8_t *data, size_t data_size, image_format_t format,
+                              jpeg_sched_class_t job_class, decoded_image_t *output)
 {
     if (!data || !output || data_size == 0) {
         return ESP_ERR_INVALID_ARG;
@@ -386,7 +342,7 @@ esp_err_t image_decoder_decode(const uint8_t *data, size_t data_size,
     
     switch (format) {
         case IMAGE_FORMAT_JPEG:
-            return decode_jpeg_image(data, data_size, output);
+            return decode_jpeg_image(data, data_size, job_class, output);
         case IMAGE_FORMAT_PNG:
             return decode_png_image(data, data_size, output);
         default:
@@ -395,6 +351,18 @@ esp_err_t image_decoder_decode(const uint8_t *data, size_t data_size,
     }
 }
 
+esp_err_t image_decoder_decode(const uint8_t *data, size_t data_size, 
+                              image_format_t format, decoded_image_t *output)
+{
+    return decode_image(data, data_size, format, JPEG_SCHED_SLIDE, output);
+}
+
+esp_err_t image_decoder_decode_background(const uint8_t *data, size_t data_size,
+                                          image_format_t format, decoded_image_t *output)
+{
+    return decode_image(data, data_size, format, JPEG_SCHED_BACKGROUND, output);
+}
+
 esp_err_t image_decoder_get_info(const uint8_t *data, size_t data_size,
                                 image_format_t format, uint32_t *width, uint32_t *height)
 {
@@ -404,8 +372,8 @@ esp_err_t image_decoder_get_info(const uint8_t *data, size_t data_size,
     
     switch (format) {
         case IMAGE_FORMAT_JPEG: {
-            jpeg_decode_picture_info_t info;
-            esp_err_t ret = jpeg_decoder_get_info(data, data_size, &info);
+            hal_jpeg_info_t info;
+            esp_err_t ret = hal_jpeg_get_info(data, data_size, &info);
         if (ret == ESP_OK) {
                 *width = info.width;
                 *height = info.height;
@@ -423,7 +391,7 @@ esp_err_t image_decoder_get_info(const uint8_t *data, size_t data_size,
 void image_decoder_free_image(decoded_image_t *image)
 {
     if (image && image->rgb_data && image->owns_data) {
-        free(image->rgb_data);
+        image_buffer_free(image->rgb_data);
         memset(image, 0, sizeof(decoded_image_t));
     }
 } 
\ No newline at end of file
@@ -24,10 +24,16 @@ esp_err_t image_decoder_init(const decoder_config_t *config);
 esp_err_t image_decoder_deinit(void);
 esp_err_t image_decoder_decode(const uint8_t *data, size_t data_size, 
                               image_format_t format, decoded_image_t *output);
+// Same, for work ahead of the screen: the JPEG engine serves video and the slide first
+esp_err_t image_decoder_decode_background(const uint8_t *data, size_t data_size,
+                                          image_format_t format, decoded_image_t *output);
 esp_err_t image_decoder_get_info(const uint8_t *data, size_t data_size,
                                 image_format_t format, uint32_t *width, uint32_t *height);
 void image_decoder_free_image(decoded_image_t *image);
 
+// Convert packed RGB888 pixels to RGB565 (used by the PNG path)
+void image_decoder_rgb888_to_rgb565(const uint8_t *rgb888, uint16_t *rgb565, uint32_t pixel_count);
+
 #ifdef __cplusplus
 }
 #endif 
\ No newline at end of file
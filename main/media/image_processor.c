@@ -5,26 +5,48 @@
 
 #include "image_processor.h"
 #include "photo_album_constants.h"
+#include "image_buffer.h"
+#include "image_decoder.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "esp_cache.h"
-#include "esp_private/esp_cache_private.h"
-#include "driver/ppa.h"
+#include "hal_ppa.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include <string.h>
 #include <math.h>
 #include "esp_err.h"
 
 static const char *TAG = "img_proc";
 
-#define ALIGN_UP(num, align)    (((num) + ((align) - 1)) & ~((align) - 1))
 #define PPA_SCALE_STEP          0.125f
 #define PPA_MIN_SCALE           0.125f  
 #define PPA_MAX_SCALE           16.0f
 #define BYTES_PER_PIXEL_RGB565  2
-#define PPA_MAX_PENDING_TRANSACTIONS 1
 
-static ppa_client_handle_t s_ppa_client = NULL;
-static size_t data_cache_line_size = 0;
+// Queued PPA operation; one slot per pending PPA transaction
+typedef struct image_processor_job_t {
+    bool in_use;
+    SemaphoreHandle_t done_sem;
+    esp_err_t result;
+    decoded_image_t *output;
+    uint16_t *output_buffer;
+    uint32_t output_width;
+    uint32_t output_height;
+    image_processor_done_cb_t done_cb;
+    void *user_data;
+    int64_t submit_time_us;
+    int64_t done_time_us;
+    bool abandoned;               // Cancelled while queued, reclaimed once the PPA is done
+    decoded_image_t input;        // Input handed over on cancel, freed on reclaim
+} image_processor_job_t;
+
+static hal_ppa_client_handle_t s_ppa_client = NULL;
+static image_processor_job_t s_jobs[PPA_MAX_PENDING_TRANSACTIONS];
+static SemaphoreHandle_t s_jobs_mutex = NULL;
+static image_processor_stats_t s_stats;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
 
 // Adjust target scale to PPA supported values (0.125 multiples)
 static float calculate_valid_ppa_scale(float target_scale)
@@ -87,36 +109,189 @@ static void calculate_fit_params_preserve_orientation(uint32_t src_width, uint32
     params->scale_y = valid_scale;
 }
 
+// PPA transaction done callback (ISR context)
+static bool ppa_trans_done_cb(void *user_data)
+{
+    image_processor_job_t *job = (image_processor_job_t *)user_data;
+    BaseType_t high_task_woken = pdFALSE;
+
+    job->done_time_us = esp_timer_get_time();
+    job->result = ESP_OK;
+
+    bool need_yield = false;
+    if (job->done_cb) {
+        need_yield = job->done_cb(job, job->user_data);
+    }
+    xSemaphoreGiveFromISR(job->done_sem, &high_task_woken);
+
+    return need_yield || (high_task_woken == pdTRUE);
+}
+
+static void job_account_done(image_processor_job_t *job, esp_err_t result)
+{
+    int64_t busy_us = job->done_time_us - job->submit_time_us;
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.in_flight--;
+    if (result == ESP_OK) {
+        s_stats.jobs_completed++;
+        s_stats.busy_us += busy_us;
+        s_stats.last_busy_us = busy_us;
+    } else {
+        s_stats.jobs_failed++;
+    }
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
+
+// Free what a finished job still holds; caller holds s_jobs_mutex
+static void job_reclaim_locked(image_processor_job_t *job)
+{
+    if (job->output_buffer) {
+        // The operation ran to completion, but nobody takes its output
+        job_account_done(job, ESP_FAIL);
+        image_buffer_free(job->output_buffer);
+        job->output_buffer = NULL;
+    }
+    image_decoder_free_image(&job->input);
+    memset(&job->input, 0, sizeof(job->input));
+    job->abandoned = false;
+    job->in_use = false;
+}
+
+static int reclaim_abandoned_locked(void)
+{
+    int reclaimed = 0;
+
+    for (int i = 0; i < PPA_MAX_PENDING_TRANSACTIONS; i++) {
+        image_processor_job_t *job = &s_jobs[i];
+        if (job->in_use && job->abandoned && xSemaphoreTake(job->done_sem, 0) == pdTRUE) {
+            job_reclaim_locked(job);
+            reclaimed++;
+        }
+    }
+    return reclaimed;
+}
+
+static image_processor_job_t *job_alloc(void)
+{
+    image_processor_job_t *job = NULL;
+
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    reclaim_abandoned_locked();
+    for (int i = 0; i < PPA_MAX_PENDING_TRANSACTIONS; i++) {
+        if (!s_jobs[i].in_use) {
+            job = &s_jobs[i];
+            job->in_use = true;
+            break;
+        }
+    }
+    xSemaphoreGive(s_jobs_mutex);
+
+    if (job) {
+        // Drop a stale completion left by a job that was never waited on
+        xSemaphoreTake(job->done_sem, 0);
+        job->result = ESP_FAIL;
+        job->output = NULL;
+        job->output_buffer = NULL;
+        job->done_cb = NULL;
+        job->user_data = NULL;
+        job->submit_time_us = 0;
+        job->done_time_us = 0;
+        job->abandoned = false;
+        memset(&job->input, 0, sizeof(job->input));
+    }
+    return job;
+}
+
+static void job_release(image_processor_job_t *job)
+{
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    job->in_use = false;
+    xSemaphoreGive(s_jobs_mutex);
+}
+
 esp_err_t image_processor_init(void)
 {
-    ESP_ERROR_CHECK(esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &data_cache_line_size));
+    s_jobs_mutex = xSemaphoreCreateMutex();
+    if (!s_jobs_mutex) {
+        return ESP_ERR_NO_MEM;
+    }
 
-    ppa_client_config_t ppa_config = {
-        .oper_type = PPA_OPERATION_SRM,
-        .max_pending_trans_num = PPA_MAX_PENDING_TRANSACTIONS,
-        .data_burst_length = PPA_DATA_BURST_LENGTH_128,
+    for (int i = 0; i < PPA_MAX_PENDING_TRANSACTIONS; i++) {
+        memset(&s_jobs[i], 0, sizeof(s_jobs[i]));
+        s_jobs[i].done_sem = xSemaphoreCreateBinary();
+        if (!s_jobs[i].done_sem) {
+            image_processor_deinit();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    memset(&s_stats, 0, sizeof(s_stats));
+
+    hal_ppa_client_config_t ppa_config = {
+        .max_pending = PPA_MAX_PENDING_TRANSACTIONS,
+        .done_cb = ppa_trans_done_cb,
     };
     
-    esp_err_t ret = ppa_register_client(&ppa_config, &s_ppa_client);
+    esp_err_t ret = hal_ppa_client_create(&ppa_config, &s_ppa_client);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to register PPA client");
+        image_processor_deinit();
         return ret;
     }
     
-    ESP_LOGI(TAG, "Image processor initialized");
+    ESP_LOGI(TAG, "Image processor initialized (%d pending PPA transactions)", PPA_MAX_PENDING_TRANSACTIONS);
     return ESP_OK;
 }
 
 esp_err_t image_processor_deinit(void)
 {
     if (s_ppa_client) {
-        esp_err_t ret = ppa_unregister_client(s_ppa_client);
+        // The driver refuses while transactions are in flight; the PPA may still
+        // be writing abandoned jobs' buffers, so keep them, the client and the
+        // semaphores its callback gives until a later deinit succeeds
+        esp_err_t ret = hal_ppa_client_delete(s_ppa_client);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "PPA client still busy, keeping abandoned jobs: %s", esp_err_to_name(ret));
+            return ret;
+        }
         s_ppa_client = NULL;
-        return ret;
+    }
+
+    if (s_jobs_mutex) {
+        xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    }
+    for (int i = 0; i < PPA_MAX_PENDING_TRANSACTIONS; i++) {
+        // The client is gone, nothing can still be reading these buffers
+        if (s_jobs[i].in_use && s_jobs[i].abandoned) {
+            job_reclaim_locked(&s_jobs[i]);
+        }
+        if (s_jobs[i].done_sem) {
+            vSemaphoreDelete(s_jobs[i].done_sem);
+            s_jobs[i].done_sem = NULL;
+        }
+        s_jobs[i].in_use = false;
+    }
+
+    if (s_jobs_mutex) {
+        xSemaphoreGive(s_jobs_mutex);
+        vSemaphoreDelete(s_jobs_mutex);
+        s_jobs_mutex = NULL;
     }
     return ESP_OK;
 }
 
+scale_mode_t image_processor_select_display_mode(uint32_t src_width, uint32_t src_height,
+                                                 uint32_t dst_width, uint32_t dst_height)
+{
+    bool fits = (src_width <= dst_width && src_height <= dst_height);
+
+    // Landscape images larger than the screen are cropped, portrait ones fitted
+    if (src_width >= src_height) {
+        return fits ? SCALE_MODE_CENTER : SCALE_MODE_CROP_ONLY;
+    }
+    return fits ? SCALE_MODE_CENTER : SCALE_MODE_FIT;
+}
+
 esp_err_t image_processor_calculate_params(uint32_t src_width, uint32_t src_height,
                                           uint32_t dst_width, uint32_t dst_height,
                                           scale_mode_t mode, process_params_t *params)
@@ -206,16 +381,33 @@ esp_err_t image_processor_calculate_params(uint32_t src_width, uint32_t src_heig
     return ESP_OK;
 }
 
-esp_err_t image_processor_process(const decoded_image_t *input, 
+esp_err_t image_processor_submit(const decoded_image_t *input,
                                  decoded_image_t *output,
-                                 const process_params_t *params)
+                                 const process_params_t *params,
+                                 image_processor_done_cb_t done_cb,
+                                 void *user_data,
+                                 image_processor_job_handle_t *ret_job)
 {
-    if (!input || !output || !params || !input->rgb_data || !input->is_valid) {
+    if (!input || !output || !params || !ret_job || !input->rgb_data || !input->is_valid) {
         return ESP_ERR_INVALID_ARG;
     }
+
+    if (!s_ppa_client) {
+        return ESP_ERR_INVALID_STATE;
+    }
     
     ESP_LOGI(TAG, "Processing: %dx%d -> %dx%d", 
              input->width, input->height, params->target_width, params->target_height);
+
+    image_processor_job_t *job = job_alloc();
+    if (!job) {
+        ESP_LOGE(TAG, "No free PPA job slot");
+        return ESP_ERR_NO_MEM;
+    }
+    job->output = output;
+    job->done_cb = done_cb;
+    job->user_data = user_data;
+    job->submit_time_us = esp_timer_get_time();
     
     // If no processing needed, directly reference input data
     if (params->operation == PROCESS_OP_SCALE && 
@@ -228,7 +420,14 @@ esp_err_t image_processor_process(const decoded_image_t *input,
         output->rgb_data = input->rgb_data;  // Direct reference, no copy
         output->is_valid = true;
         output->owns_data = false;  // We don't own this data
-        
+
+        job->result = ESP_OK;
+        job->done_time_us = job->submit_time_us;
+        if (done_cb) {
+            done_cb(job, user_data);
+        }
+        xSemaphoreGive(job->done_sem);
+        *ret_job = job;
         return ESP_OK;
     }
     
@@ -240,54 +439,19 @@ esp_err_t image_processor_process(const decoded_image_t *input,
     uint32_t expected_size = input->width * input->height * 2;
     uint32_t jpeg_aligned_width = ((input->width + 15) & ~15);
     
-    // Check input buffer alignment for PPA
-    uint16_t *aligned_input_rgb565 = input_rgb565;
-    bool need_free_input = false;
-    
-    if ((uintptr_t)input_rgb565 % data_cache_line_size != 0) {
-        size_t input_buffer_size = ALIGN_UP(input_data_size, data_cache_line_size);
-        aligned_input_rgb565 = heap_caps_aligned_alloc(data_cache_line_size, input_buffer_size, 
-                                                      MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
-        if (!aligned_input_rgb565) {
-            aligned_input_rgb565 = heap_caps_aligned_alloc(data_cache_line_size, input_buffer_size, 
-                                                          MALLOC_CAP_SPIRAM);
-        }
-        
-        if (!aligned_input_rgb565) {
-            ESP_LOGE(TAG, "Failed to allocate aligned input buffer: %zu bytes", input_buffer_size);
-            return ESP_ERR_NO_MEM;
-        }
-        
-        memcpy(aligned_input_rgb565, input_rgb565, input_data_size);
-        need_free_input = true;
+    // Decoder output comes from image_buffer_alloc, so no realignment copy is needed
+    if (!image_buffer_check_dma_input(input_rgb565, input_data_size)) {
+        job_release(job);
+        return ESP_ERR_INVALID_ARG;
     }
     
     // Allocate output buffer
     uint32_t output_pixels = params->target_width * params->target_height;
-    size_t buffer_size = ALIGN_UP(output_pixels * sizeof(uint16_t), data_cache_line_size);
-    
-    size_t free_internal = heap_caps_get_free_size(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
-    size_t free_spiram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
-    
-    if (buffer_size > free_internal && buffer_size > free_spiram) {
-        ESP_LOGE(TAG, "Insufficient memory: need %d bytes", buffer_size);
-        if (need_free_input) {
-            free(aligned_input_rgb565);
-        }
-        return ESP_ERR_NO_MEM;
-    }
-    
-    uint16_t *output_rgb565 = heap_caps_aligned_alloc(data_cache_line_size, buffer_size, 
-                                                     MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
-    if (!output_rgb565) {
-        output_rgb565 = heap_caps_aligned_alloc(data_cache_line_size, buffer_size, MALLOC_CAP_SPIRAM);
-    }
-    
+    size_t buffer_size = 0;
+    uint16_t *output_rgb565 = image_buffer_alloc(output_pixels * sizeof(uint16_t), &buffer_size);
     if (!output_rgb565) {
         ESP_LOGE(TAG, "Failed to allocate output buffer");
-        if (need_free_input) {
-            free(aligned_input_rgb565);
-        }
+        job_release(job);
         return ESP_ERR_NO_MEM;
     }
     
@@ -349,10 +513,8 @@ esp_err_t image_processor_process(const decoded_image_t *input,
     // Validate block bounds
     if (block_offset_x + block_w > input->width || block_offset_y + block_h > input->height) {
         ESP_LOGE(TAG, "Block bounds exceed input dimensions");
-        free(output_rgb565);
-        if (need_free_input) {
-            free(aligned_input_rgb565);
-        }
+        image_buffer_free(output_rgb565);
+        job_release(job);
         return ESP_ERR_INVALID_ARG;
     }
     
@@ -362,64 +524,155 @@ esp_err_t image_processor_process(const decoded_image_t *input,
         ppa_pic_w = jpeg_aligned_width;  // Use correct 16-byte aligned stride
     }
     
-    ppa_srm_oper_config_t srm_config = {
-        .in = {
-            .buffer = aligned_input_rgb565,
-            .pic_w = ppa_pic_w,
-            .pic_h = input->height,
-            .block_w = block_w,
-            .block_h = block_h,
-            .block_offset_x = block_offset_x,
-            .block_offset_y = block_offset_y,
-            .srm_cm = PPA_SRM_COLOR_MODE_RGB565,
-        },
-        .out = {
-            .buffer = output_rgb565,
-            .buffer_size = buffer_size,
-            .pic_w = params->target_width,
-            .pic_h = params->target_height,
-            .block_offset_x = 0,
-            .block_offset_y = 0,
-            .srm_cm = PPA_SRM_COLOR_MODE_RGB565,
-        },
-        .rotation_angle = PPA_SRM_ROTATION_ANGLE_0,
+    hal_ppa_srm_op_t srm_op = {
+        .in_buffer = input_rgb565,
+        .in_pic_w = ppa_pic_w,
+        .in_pic_h = input->height,
+        .in_block_w = block_w,
+        .in_block_h = block_h,
+        .in_block_offset_x = block_offset_x,
+        .in_block_offset_y = block_offset_y,
+        .out_buffer = output_rgb565,
+        .out_buffer_size = buffer_size,
+        .out_pic_w = params->target_width,
+        .out_pic_h = params->target_height,
+        .out_block_offset_x = 0,
+        .out_block_offset_y = 0,
         .scale_x = scale_x,
         .scale_y = scale_y,
-        .mirror_x = false,
-        .mirror_y = false,
-        .rgb_swap = false,
-        .byte_swap = false,
-        .alpha_update_mode = PPA_ALPHA_NO_CHANGE,
-        .mode = PPA_TRANS_MODE_BLOCKING,
+        .user_data = job,
     };
     
-    // Ensure cache sync for input data
-    esp_cache_msync(aligned_input_rgb565, input_data_size, 
-                   ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
-    
-    // Execute PPA operation
-    esp_err_t ret = ppa_do_scale_rotate_mirror(s_ppa_client, &srm_config);
-    
-    if (need_free_input) {
-        free(aligned_input_rgb565);
+    // Ensure cache sync for input data, the allocation is padded to a whole cache line
+    image_buffer_cache_sync(input_rgb565, image_buffer_align_size(input_data_size),
+                            ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+
+    job->output_buffer = output_rgb565;
+    job->output_width = params->target_width;
+    job->output_height = params->target_height;
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    s_stats.jobs_submitted++;
+    s_stats.in_flight++;
+    if (s_stats.in_flight > s_stats.peak_in_flight) {
+        s_stats.peak_in_flight = s_stats.in_flight;
     }
+    taskEXIT_CRITICAL(&s_stats_lock);
     
+    // Queue PPA operation, completion is reported by ppa_trans_done_cb
+    esp_err_t ret = hal_ppa_srm_submit(s_ppa_client, &srm_op);
     if (ret != ESP_OK) {
-        free(output_rgb565);
         ESP_LOGE(TAG, "PPA operation failed: %s", esp_err_to_name(ret));
+        taskENTER_CRITICAL(&s_stats_lock);
+        s_stats.in_flight--;
+        s_stats.jobs_failed++;
+        taskEXIT_CRITICAL(&s_stats_lock);
+        image_buffer_free(output_rgb565);
+        job_release(job);
         return ret;
     }
-    
-    // Set output data
-    output->width = params->target_width;
-    output->height = params->target_height;
-    output->data_size = output_pixels * BYTES_PER_PIXEL_RGB565;
-    output->rgb_data = (uint8_t*)output_rgb565;
-    output->is_valid = true;
-    output->owns_data = true;
-    
-    ESP_LOGI(TAG, "Processed successfully: %dx%d -> %dx%d", 
-             input->width, input->height, output->width, output->height);
-    
+
+    *ret_job = job;
+    return ESP_OK;
+}
+
+esp_err_t image_processor_wait(image_processor_job_handle_t job, uint32_t timeout_ms)
+{
+    if (!job || !job->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    TickType_t ticks = (timeout_ms == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    if (xSemaphoreTake(job->done_sem, ticks) != pdTRUE) {
+        // Job stays owned by the PPA, caller may wait again or cancel it
+        ESP_LOGW(TAG, "PPA job not done within %"PRIu32" ms", timeout_ms);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    esp_err_t ret = job->result;
+
+    // Pass-through jobs never reach the PPA and have nothing to account for
+    if (job->output_buffer) {
+        int64_t busy_us = job->done_time_us - job->submit_time_us;
+
+        job_account_done(job, ret);
+
+        if (ret == ESP_OK) {
+            decoded_image_t *output = job->output;
+            output->width = job->output_width;
+            output->height = job->output_height;
+            output->data_size = job->output_width * job->output_height * BYTES_PER_PIXEL_RGB565;
+            output->rgb_data = (uint8_t*)job->output_buffer;
+            output->is_valid = true;
+            output->owns_data = true;
+
+            ESP_LOGI(TAG, "Processed successfully: -> %dx%d in %" PRId64 " us",
+                     output->width, output->height, busy_us);
+        } else {
+            image_buffer_free(job->output_buffer);
+        }
+    }
+
+    job_release(job);
+    return ret;
+}
+
+esp_err_t image_processor_cancel(image_processor_job_handle_t job, decoded_image_t *input)
+{
+    if (!job || !job->in_use || job->abandoned || !input) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    // The PPA cannot drop a queued transaction; keep the input alive until it is done
+    job->input = *input;
+    memset(input, 0, sizeof(*input));
+    job->abandoned = true;
+    bool reclaimed = (xSemaphoreTake(job->done_sem, 0) == pdTRUE);
+    if (reclaimed) {
+        job_reclaim_locked(job);
+    }
+    xSemaphoreGive(s_jobs_mutex);
+
+    if (!reclaimed) {
+        ESP_LOGW(TAG, "PPA job cancelled while queued, reclaimed once done");
+    }
     return ESP_OK;
-} 
\ No newline at end of file
+}
+
+int image_processor_reclaim(void)
+{
+    if (!s_jobs_mutex) {
+        return 0;
+    }
+
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    int reclaimed = reclaim_abandoned_locked();
+    xSemaphoreGive(s_jobs_mutex);
+    return reclaimed;
+}
+
+esp_err_t image_processor_process(const decoded_image_t *input, 
+                                 decoded_image_t *output,
+                                 const process_params_t *params)
+{
+    image_processor_job_handle_t job = NULL;
+    esp_err_t ret = image_processor_submit(input, output, params, NULL, NULL, &job);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    return image_processor_wait(job, portMAX_DELAY);
+}
+
+esp_err_t image_processor_get_stats(image_processor_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    taskENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_stats_lock);
+    return ESP_OK;
+}
@@ -35,12 +35,59 @@ typedef struct {
     float scale_y;
 } process_params_t;
 
+// Handle of a queued (non-blocking) PPA operation
+typedef struct image_processor_job_t *image_processor_job_handle_t;
+
+// Completion callback for queued operations.
+// May run in ISR context: keep it short and only use FromISR APIs.
+// Return true if a higher priority task was woken.
+typedef bool (*image_processor_done_cb_t)(image_processor_job_handle_t job, void *user_data);
+
+// Processing statistics
+typedef struct {
+    uint32_t jobs_submitted;
+    uint32_t jobs_completed;
+    uint32_t jobs_failed;
+    uint32_t in_flight;          // Jobs currently queued on the PPA
+    uint32_t peak_in_flight;     // Highest number of jobs queued at once
+    int64_t busy_us;             // Accumulated submit-to-done time of all jobs
+    int64_t last_busy_us;        // Submit-to-done time of the last completed job
+} image_processor_stats_t;
+
 // Image processor functions
 esp_err_t image_processor_init(void);
 esp_err_t image_processor_deinit(void);
 esp_err_t image_processor_process(const decoded_image_t *input, 
                                  decoded_image_t *output,
                                  const process_params_t *params);
+
+// Queue an operation on the PPA and return immediately.
+// input and output must stay valid until image_processor_wait() returns.
+esp_err_t image_processor_submit(const decoded_image_t *input,
+                                 decoded_image_t *output,
+                                 const process_params_t *params,
+                                 image_processor_done_cb_t done_cb,
+                                 void *user_data,
+                                 image_processor_job_handle_t *ret_job);
+
+// Wait for a queued operation, release the job and return its result.
+// On ESP_ERR_TIMEOUT the job is still queued: wait again or cancel it.
+esp_err_t image_processor_wait(image_processor_job_handle_t job, uint32_t timeout_ms);
+
+// Give up on a queued operation instead of waiting for it.
+// The PPA cannot drop a queued transaction, so the job takes over input
+// (the caller's copy is cleared) and frees it with the output buffer once
+// the PPA is done. The handle must not be used afterwards.
+esp_err_t image_processor_cancel(image_processor_job_handle_t job, decoded_image_t *input);
+
+// Release the slots and buffers of cancelled jobs the PPA has finished with.
+// Also done on every submit; returns the number of jobs reclaimed.
+int image_processor_reclaim(void);
+
+esp_err_t image_processor_get_stats(image_processor_stats_t *stats);
+// Scale mode the slideshow uses for an image of the given size
+scale_mode_t image_processor_select_display_mode(uint32_t src_width, uint32_t src_height,
+                                                 uint32_t dst_width, uint32_t dst_height);
 esp_err_t image_processor_calculate_params(uint32_t src_width, uint32_t src_height,
                                           uint32_t dst_width, uint32_t dst_height,
                                           scale_mode_t mode, process_params_t *params);
@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "jpeg_sched.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = "jpeg_sched";
+
+static const char *s_class_names[JPEG_SCHED_CLASS_COUNT] = {
+    [JPEG_SCHED_VIDEO] = "video",
+    [JPEG_SCHED_SLIDE] = "slide",
+    [JPEG_SCHED_BACKGROUND] = "background",
+};
+
+static struct {
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t turn[JPEG_SCHED_CLASS_COUNT];     // Counts the engine handed to waiters of a class
+    bool busy;
+    uint32_t waiting[JPEG_SCHED_CLASS_COUNT];
+    int64_t start_us;                                   // Of the job holding the engine
+    jpeg_sched_stats_t stats[JPEG_SCHED_CLASS_COUNT];
+} s_sched;
+
+esp_err_t jpeg_sched_init(void)
+{
+    if (s_sched.lock) {
+        return ESP_OK;
+    }
+
+    for (int i = 0; i < JPEG_SCHED_CLASS_COUNT; i++) {
+        s_sched.turn[i] = xSemaphoreCreateCounting(UINT16_MAX, 0);
+        if (!s_sched.turn[i]) {
+            goto cleanup;
+        }
+    }
+    s_sched.lock = xSemaphoreCreateMutex();
+    if (!s_sched.lock) {
+        goto cleanup;
+    }
+    return ESP_OK;
+
+cleanup:
+    for (int i = 0; i < JPEG_SCHED_CLASS_COUNT; i++) {
+        if (s_sched.turn[i]) {
+            vSemaphoreDelete(s_sched.turn[i]);
+            s_sched.turn[i] = NULL;
+        }
+    }
+    ESP_LOGE(TAG, "Failed to create the JPEG scheduler");
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t jpeg_sched_begin(jpeg_sched_class_t job_class, uint32_t timeout_ms)
+{
+    if (job_class >= JPEG_SCHED_CLASS_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_sched.lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    xSemaphoreTake(s_sched.lock, portMAX_DELAY);
+    bool granted = !s_sched.busy;
+    if (granted) {
+        s_sched.busy = true;
+    } else {
+        s_sched.waiting[job_class]++;
+    }
+    xSemaphoreGive(s_sched.lock);
+
+    if (!granted && xSemaphoreTake(s_sched.turn[job_class], pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        xSemaphoreTake(s_sched.lock, portMAX_DELAY);
+        // The engine may have been handed over between the timeout and the lock
+        granted = xSemaphoreTake(s_sched.turn[job_class], 0) == pdTRUE;
+        if (!granted) {
+            s_sched.waiting[job_class]--;
+            s_sched.stats[job_class].timeouts++;
+        }
+        xSemaphoreGive(s_sched.lock);
+        if (!granted) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    uint32_t wait_us = (uint32_t)(now_us - start_us);
+    xSemaphoreTake(s_sched.lock, portMAX_DELAY);
+    jpeg_sched_stats_t *stats = &s_sched.stats[job_class];
+    stats->jobs++;
+    stats->wait_us += wait_us;
+    if (wait_us > stats->wait_max_us) {
+        stats->wait_max_us = wait_us;
+    }
+    s_sched.start_us = now_us;
+    xSemaphoreGive(s_sched.lock);
+    return ESP_OK;
+}
+
+void jpeg_sched_end(jpeg_sched_class_t job_class)
+{
+    if (job_class >= JPEG_SCHED_CLASS_COUNT || !s_sched.lock) {
+        return;
+    }
+
+    xSemaphoreTake(s_sched.lock, portMAX_DELAY);
+    s_sched.stats[job_class].run_us += esp_timer_get_time() - s_sched.start_us;
+
+    int next = 0;
+    while (next < JPEG_SCHED_CLASS_COUNT && s_sched.waiting[next] == 0) {
+        next++;
+    }
+    if (next < JPEG_SCHED_CLASS_COUNT) {
+        // Still busy: the engine passes straight to a waiter of the highest class
+        s_sched.waiting[next]--;
+        for (int i = next + 1; i < JPEG_SCHED_CLASS_COUNT; i++) {
+            s_sched.stats[i].passed_over += s_sched.waiting[i];
+        }
+        xSemaphoreGive(s_sched.turn[next]);
+    } else {
+        s_sched.busy = false;
+    }
+    xSemaphoreGive(s_sched.lock);
+}
+
+void jpeg_sched_get_stats(jpeg_sched_class_t job_class, jpeg_sched_stats_t *stats)
+{
+    if (job_class >= JPEG_SCHED_CLASS_COUNT || !stats) {
+        return;
+    }
+    if (!s_sched.lock) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    xSemaphoreTake(s_sched.lock, portMAX_DELAY);
+    *stats = s_sched.stats[job_class];
+    xSemaphoreGive(s_sched.lock);
+}
+
+void jpeg_sched_reset_stats(void)
+{
+    if (!s_sched.lock) {
+        return;
+    }
+
+    xSemaphoreTake(s_sched.lock, portMAX_DELAY);
+    memset(s_sched.stats, 0, sizeof(s_sched.stats));
+    xSemaphoreGive(s_sched.lock);
+}
+
+void jpeg_sched_log_stats(void)
+{
+    for (int i = 0; i < JPEG_SCHED_CLASS_COUNT; i++) {
+        jpeg_sched_stats_t stats;
+        jpeg_sched_get_stats((jpeg_sched_class_t)i, &stats);
+        if (stats.jobs == 0 && stats.timeouts == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "JPEG engine %s: %u jobs, wait avg %u us max %u us, run avg %u us, "
+                 "passed over %u, timeouts %u", s_class_names[i], stats.jobs,
+                 stats.jobs ? (uint32_t)(stats.wait_us / stats.jobs) : 0, stats.wait_max_us,
+                 stats.jobs ? (uint32_t)(stats.run_us / stats.jobs) : 0, stats.passed_over, stats.timeouts);
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Arbitration of the one JPEG engine between the video pipeline, the slide on
+// screen and background decodes.
+//
+// Every decode runs as a job between jpeg_sched_begin() and jpeg_sched_end().
+// Jobs hold the engine one at a time. When one ends the engine goes to the
+// highest class with a job waiting, however long lower classes have waited,
+// so a video frame never queues behind a prefetch that arrived first. A job
+// that has started runs to the end: the engine decodes a frame in one pass,
+// so preemption happens between jobs.
+
+typedef enum {
+    JPEG_SCHED_VIDEO,               // Frames of the clip playing, due at the next vsync
+    JPEG_SCHED_SLIDE,               // The slide about to be shown
+    JPEG_SCHED_BACKGROUND,          // Prefetch and prepared clips, only when nothing else waits
+    JPEG_SCHED_CLASS_COUNT,
+} jpeg_sched_class_t;
+
+typedef struct {
+    uint32_t jobs;                  // Jobs that got the engine
+    uint32_t timeouts;              // Jobs that gave up waiting for it
+    uint64_t wait_us;               // Time jobs waited for the engine
+    uint32_t wait_max_us;
+    uint64_t run_us;                // Time jobs held it
+    uint32_t passed_over;           // Times a higher class got the engine while a job of this one waited
+} jpeg_sched_stats_t;
+
+// Create the scheduler; further calls do nothing. Call before any decoder runs.
+esp_err_t jpeg_sched_init(void);
+
+// Wait up to timeout_ms for the engine. ESP_ERR_TIMEOUT when it stayed busy.
+esp_err_t jpeg_sched_begin(jpeg_sched_class_t job_class, uint32_t timeout_ms);
+
+// Give the engine to the next job, after a successful jpeg_sched_begin()
+void jpeg_sched_end(jpeg_sched_class_t job_class);
+
+void jpeg_sched_get_stats(jpeg_sched_class_t job_class, jpeg_sched_stats_t *stats);
+void jpeg_sched_reset_stats(void);
+
+// One line per class that ran a job since the last reset
+void jpeg_sched_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
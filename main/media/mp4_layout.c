@@ -0,0 +1,96 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "mp4_layout.h"
+#include <fcntl.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ftyp, free, wide, mdat and moov in any order; a file with more top-level
+// boxes than this before its moov is not one a camera wrote
+#define MP4_LAYOUT_MAX_BOXES    32
+
+static inline uint32_t rd32be(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline uint64_t rd64be(const uint8_t *p)
+{
+    return ((uint64_t)rd32be(p) << 32) | rd32be(p + 4);
+}
+
+static bool read_at(int fd, uint32_t offset, void *buffer, size_t size)
+{
+    if (lseek(fd, offset, SEEK_SET) < 0) {
+        return false;
+    }
+    return read(fd, buffer, size) == (ssize_t)size;
+}
+
+esp_err_t mp4_layout_probe(const char *path, mp4_layout_t *layout)
+{
+    if (path == NULL || layout == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(layout, 0, sizeof(*layout));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return ESP_FAIL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return ESP_FAIL;
+    }
+
+    uint32_t file_size = (uint32_t)st.st_size;
+    uint32_t pos = 0;
+    bool have_mdat = false;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    uint8_t header[16];
+
+    // Only box headers are read: one seek and an 8 or 16 byte read per box
+    for (int boxes = 0; boxes < MP4_LAYOUT_MAX_BOXES && (uint64_t)pos + 8 <= file_size; boxes++) {
+        if (!read_at(fd, pos, header, 8)) {
+            ret = ESP_FAIL;
+            break;
+        }
+        uint64_t size = rd32be(header);
+        uint32_t header_size = 8;
+        if (size == 1) {
+            if (!read_at(fd, pos + 8, header + 8, 8)) {
+                ret = ESP_FAIL;
+                break;
+            }
+            size = rd64be(header + 8);
+            header_size = 16;
+        } else if (size == 0) {
+            size = file_size - pos;
+        }
+        if (size < header_size || size > file_size - pos) {
+            ret = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+
+        if (memcmp(header + 4, "mdat", 4) == 0 && !have_mdat) {
+            layout->mdat_offset = pos;
+            have_mdat = true;
+        } else if (memcmp(header + 4, "moov", 4) == 0) {
+            layout->moov_offset = pos;
+            layout->moov_size = (uint32_t)size;
+            layout->moov_at_end = have_mdat;
+            ret = ESP_OK;
+            break;
+        }
+        pos += (uint32_t)size;
+    }
+
+    close(fd);
+    return ret;
+}
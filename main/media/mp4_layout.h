@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Top-level box layout of an MP4 file, from the box headers alone.
+//
+// Cameras and phones write moov, the sample tables, after the media data once
+// recording ends. Opening such a clip has to reach the end of the file before
+// the first frame can be read; fast-start files carry moov up front. Telling
+// the two apart takes a few small reads, cheap enough to do for every clip at
+// scan time.
+
+typedef struct {
+    uint32_t moov_offset;           // Of the moov box header
+    uint32_t moov_size;             // Including its header
+    uint32_t mdat_offset;           // Of the first mdat box header, 0 without one
+    bool moov_at_end;               // moov follows the media data
+} mp4_layout_t;
+
+// ESP_ERR_NOT_FOUND when the file has no moov, as a recording cut short leaves
+// it; ESP_ERR_INVALID_SIZE when a box runs past the end of the file.
+esp_err_t mp4_layout_probe(const char *path, mp4_layout_t *layout);
+
+#ifdef __cplusplus
+}
+#endif
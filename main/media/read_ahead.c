@@ -0,0 +1,359 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "read_ahead.h"
+#include "image_buffer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *TAG = "read_ahead";
+
+// Longest a read sleeps before re-checking the window, a lost wakeup costs no more
+#define READ_AHEAD_WAIT_MS      50
+
+typedef enum {
+    BLOCK_EMPTY,
+    BLOCK_LOADING,              // Owned by the I/O task
+    BLOCK_READY,                // Owned by the reader until it moves past the block
+} block_state_t;
+
+typedef struct {
+    uint8_t *data;
+    uint32_t offset;
+    uint32_t len;
+    uint32_t generation;        // Window the load was started for
+    block_state_t state;
+} read_ahead_block_t;
+
+struct read_ahead_t {
+    int fd;
+    uint32_t size;
+    uint32_t position;          // Read position, only touched by the reader
+    size_t block_size;
+    uint32_t block_count;
+    read_ahead_block_t *blocks;
+
+    // Window state, under lock
+    SemaphoreHandle_t lock;
+    uint32_t next_offset;       // Next offset the I/O task loads
+    uint32_t generation;        // Bumped when the window restarts, older loads are dropped
+    bool error;                 // A load failed, until the window restarts
+
+    SemaphoreHandle_t work;     // I/O task: a block was freed or the window moved
+    SemaphoreHandle_t loaded;   // Reader: a load finished
+    SemaphoreHandle_t exited;   // close: the I/O task is gone
+    volatile bool closing;
+    read_ahead_stats_t *stats;
+    read_ahead_stats_t own_stats;
+};
+
+// Fill one block from the file, following short reads
+static ssize_t load_block(read_ahead_handle_t reader, off_t *fd_position, uint32_t offset, uint8_t *data, uint32_t len)
+{
+    if (*fd_position != (off_t)offset) {
+        if (lseek(reader->fd, offset, SEEK_SET) < 0) {
+            *fd_position = -1;
+            return -1;
+        }
+        *fd_position = offset;
+    }
+
+    uint32_t done = 0;
+    while (done < len) {
+        ssize_t n = read(reader->fd, data + done, len - done);
+        if (n < 0) {
+            *fd_position = -1;
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += n;
+        *fd_position += n;
+    }
+    return done;
+}
+
+static void io_task(void *arg)
+{
+    read_ahead_handle_t reader = (read_ahead_handle_t)arg;
+    off_t fd_position = 0;
+
+    while (!reader->closing) {
+        xSemaphoreTake(reader->lock, portMAX_DELAY);
+        read_ahead_block_t *block = NULL;
+        if (!reader->error && reader->next_offset < reader->size) {
+            for (uint32_t i = 0; i < reader->block_count; i++) {
+                if (reader->blocks[i].state == BLOCK_EMPTY) {
+                    block = &reader->blocks[i];
+                    break;
+                }
+            }
+        }
+        uint32_t offset = reader->next_offset;
+        uint32_t len = 0;
+        if (block) {
+            len = reader->size - offset;
+            if (len > reader->block_size) {
+                len = reader->block_size;
+            }
+            block->offset = offset;
+            block->generation = reader->generation;
+            block->state = BLOCK_LOADING;
+            reader->next_offset += len;
+        }
+        xSemaphoreGive(reader->lock);
+
+        if (!block) {
+            xSemaphoreTake(reader->work, portMAX_DELAY);
+            continue;
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        ssize_t loaded = load_block(reader, &fd_position, offset, block->data, len);
+        uint32_t load_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+        xSemaphoreTake(reader->lock, portMAX_DELAY);
+        if (block->generation != reader->generation) {
+            block->state = BLOCK_EMPTY;
+        } else if (loaded < 0) {
+            ESP_LOGE(TAG, "Read of %u bytes at %u failed: %d", len, offset, errno);
+            block->state = BLOCK_EMPTY;
+            reader->error = true;
+        } else {
+            block->len = loaded;
+            block->state = BLOCK_READY;
+            if ((uint32_t)loaded < len) {
+                // The file shrank since open; its end is where reads stop now
+                reader->size = offset + loaded;
+                reader->next_offset = reader->size;
+            }
+        }
+        if (loaded > 0) {
+            reader->stats->bytes += loaded;
+        }
+        reader->stats->io_us += load_us;
+        if (load_us > reader->stats->io_max_us) {
+            reader->stats->io_max_us = load_us;
+        }
+        xSemaphoreGive(reader->lock);
+        xSemaphoreGive(reader->loaded);
+    }
+
+    xSemaphoreGive(reader->exited);
+    vTaskDelete(NULL);
+}
+
+// Move the window to start at the block holding position. Called with lock held.
+static void restart_window(read_ahead_handle_t reader, uint32_t position)
+{
+    reader->generation++;
+    reader->error = false;
+    reader->next_offset = position - position % reader->block_size;
+    for (uint32_t i = 0; i < reader->block_count; i++) {
+        if (reader->blocks[i].state == BLOCK_READY) {
+            reader->blocks[i].state = BLOCK_EMPTY;
+        }
+    }
+    reader->stats->restarts++;
+    xSemaphoreGive(reader->work);
+}
+
+esp_err_t read_ahead_open(const char *path, const read_ahead_config_t *config, read_ahead_handle_t *ret_reader)
+{
+    if (!path || !config || !ret_reader || config->block_size == 0 || config->block_count < 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    read_ahead_handle_t reader = calloc(1, sizeof(*reader));
+    if (!reader) {
+        return ESP_ERR_NO_MEM;
+    }
+    reader->fd = -1;
+    reader->block_size = config->block_size;
+    reader->block_count = config->block_count;
+    reader->stats = config->stats ? config->stats : &reader->own_stats;
+    memset(reader->stats, 0, sizeof(*reader->stats));
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    struct stat st;
+    reader->fd = open(path, O_RDONLY);
+    if (reader->fd < 0 || fstat(reader->fd, &st) != 0) {
+        ESP_LOGE(TAG, "Failed to open %s: %d", path, errno);
+        goto cleanup;
+    }
+    reader->size = (uint32_t)st.st_size;
+
+    ret = ESP_ERR_NO_MEM;
+    reader->blocks = calloc(reader->block_count, sizeof(*reader->blocks));
+    if (!reader->blocks) {
+        goto cleanup;
+    }
+    for (uint32_t i = 0; i < reader->block_count; i++) {
+        reader->blocks[i].data = image_buffer_alloc(reader->block_size, NULL);
+        if (!reader->blocks[i].data) {
+            goto cleanup;
+        }
+    }
+
+    reader->lock = xSemaphoreCreateMutex();
+    reader->work = xSemaphoreCreateBinary();
+    reader->loaded = xSemaphoreCreateBinary();
+    reader->exited = xSemaphoreCreateBinary();
+    if (!reader->lock || !reader->work || !reader->loaded || !reader->exited) {
+        goto cleanup;
+    }
+
+    if (xTaskCreate(io_task, "read_ahead", config->task_stack_size, reader, config->task_priority,
+                    NULL) != pdPASS) {
+        goto cleanup;
+    }
+
+    *ret_reader = reader;
+    return ESP_OK;
+
+cleanup:
+    reader->closing = true;
+    read_ahead_close(reader);
+    return ret;
+}
+
+int read_ahead_read(read_ahead_handle_t reader, void *data, uint32_t size)
+{
+    if (!reader || !data) {
+        return -1;
+    }
+
+    uint8_t *out = (uint8_t *)data;
+    uint32_t copied = 0;
+
+    xSemaphoreTake(reader->lock, portMAX_DELAY);
+    while (copied < size && reader->position < reader->size) {
+        uint32_t position = reader->position;
+        read_ahead_block_t *block = NULL;
+        bool loading = false;
+        bool freed = false;
+
+        for (uint32_t i = 0; i < reader->block_count; i++) {
+            read_ahead_block_t *b = &reader->blocks[i];
+            if (b->state == BLOCK_READY) {
+                if (position >= b->offset && position < b->offset + b->len) {
+                    block = b;
+                } else if (b->offset + b->len <= position) {
+                    // Skipped past it, free the slot for what comes next
+                    b->state = BLOCK_EMPTY;
+                    freed = true;
+                }
+            } else if (b->state == BLOCK_LOADING && b->generation == reader->generation &&
+                       position >= b->offset && position < b->offset + reader->block_size) {
+                loading = true;
+            }
+        }
+        if (freed) {
+            xSemaphoreGive(reader->work);
+        }
+
+        if (block) {
+            // Ready blocks are only freed by this reader, copy without the lock
+            uint32_t n = block->offset + block->len - position;
+            if (n > size - copied) {
+                n = size - copied;
+            }
+            xSemaphoreGive(reader->lock);
+            memcpy(out + copied, block->data + (position - block->offset), n);
+            xSemaphoreTake(reader->lock, portMAX_DELAY);
+
+            copied += n;
+            reader->position += n;
+            if (reader->position >= block->offset + block->len) {
+                block->state = BLOCK_EMPTY;
+                xSemaphoreGive(reader->work);
+            }
+            continue;
+        }
+
+        if (reader->error) {
+            break;
+        }
+
+        // Next in line for the I/O task unless the window has to move here
+        bool queued = position >= reader->next_offset && position < reader->next_offset + reader->block_size;
+        if (!loading && !queued) {
+            restart_window(reader, position);
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        reader->stats->waits++;
+        xSemaphoreGive(reader->lock);
+        xSemaphoreTake(reader->loaded, pdMS_TO_TICKS(READ_AHEAD_WAIT_MS));
+        xSemaphoreTake(reader->lock, portMAX_DELAY);
+        reader->stats->wait_us += esp_timer_get_time() - start_us;
+    }
+    bool failed = copied == 0 && reader->error;
+    xSemaphoreGive(reader->lock);
+
+    return failed ? -1 : (int)copied;
+}
+
+esp_err_t read_ahead_seek(read_ahead_handle_t reader, uint32_t position)
+{
+    if (!reader) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // The window follows on the next read
+    reader->position = position;
+    return ESP_OK;
+}
+
+uint32_t read_ahead_size(read_ahead_handle_t reader)
+{
+    return reader ? reader->size : 0;
+}
+
+void read_ahead_close(read_ahead_handle_t reader)
+{
+    if (!reader) {
+        return;
+    }
+
+    if (reader->exited && !reader->closing) {
+        reader->closing = true;
+        xSemaphoreGive(reader->work);
+        xSemaphoreTake(reader->exited, portMAX_DELAY);
+    }
+
+    if (reader->blocks) {
+        for (uint32_t i = 0; i < reader->block_count; i++) {
+            image_buffer_free(reader->blocks[i].data);
+        }
+        free(reader->blocks);
+    }
+    if (reader->lock) {
+        vSemaphoreDelete(reader->lock);
+    }
+    if (reader->work) {
+        vSemaphoreDelete(reader->work);
+    }
+    if (reader->loaded) {
+        vSemaphoreDelete(reader->loaded);
+    }
+    if (reader->exited) {
+        vSemaphoreDelete(reader->exited);
+    }
+    if (reader->fd >= 0) {
+        close(reader->fd);
+    }
+    free(reader);
+}
@@ -0,0 +1,64 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sequential read-ahead over a file, behind the extractor's file callbacks.
+//
+// An I/O task keeps a window of block_count blocks loaded ahead of the read
+// position, each with one large read at a block aligned offset, so card latency
+// spikes land on that task instead of the demux loop. Reads and seeks inside the
+// window only copy; a seek anywhere else restarts the window at the new position.
+
+// Two blocks of a few card clusters each: long enough reads to reach the card's
+// sequential rate, small enough to keep a seek's restart short
+#define READ_AHEAD_DEFAULT_BLOCK_SIZE   (256 * 1024)
+#define READ_AHEAD_DEFAULT_BLOCK_COUNT  2
+#define READ_AHEAD_DEFAULT_TASK_PRIO    7           // Above the demux task it feeds, it mostly sleeps in I/O
+#define READ_AHEAD_DEFAULT_TASK_STACK   (3 * 1024)
+
+typedef struct read_ahead_t *read_ahead_handle_t;
+
+typedef struct {
+    uint64_t bytes;             // Loaded from the file by the I/O task
+    uint64_t io_us;             // Time the I/O task spent loading them
+    uint32_t io_max_us;         // Slowest block load
+    uint32_t waits;             // Times a read found its data not loaded yet
+    uint64_t wait_us;           // Time reads spent in those waits
+    uint32_t restarts;          // Seeks outside the window
+} read_ahead_stats_t;
+
+typedef struct {
+    size_t block_size;          // Bytes per load, a multiple of the card's cluster size reads best
+    uint32_t block_count;       // Blocks in the window, at least 2 so one loads while the other is read
+    uint32_t task_priority;
+    uint32_t task_stack_size;
+    read_ahead_stats_t *stats;  // Kept up to date while the file is open (NULL for none), must outlive it
+} read_ahead_config_t;
+
+esp_err_t read_ahead_open(const char *path, const read_ahead_config_t *config, read_ahead_handle_t *ret_reader);
+
+// Copy up to size bytes from the read position and advance it. Returns the bytes
+// copied, 0 at the end of the file and -1 on a read error.
+int read_ahead_read(read_ahead_handle_t reader, void *data, uint32_t size);
+
+esp_err_t read_ahead_seek(read_ahead_handle_t reader, uint32_t position);
+
+// Taken once at open
+uint32_t read_ahead_size(read_ahead_handle_t reader);
+
+void read_ahead_close(read_ahead_handle_t reader);
+
+#ifdef __cplusplus
+}
+#endif
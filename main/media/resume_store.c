@@ -0,0 +1,265 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "resume_store.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *TAG = "resume_store";
+
+#define RESUME_FILE_MAGIC       0x4d555352u     // "RSUM"
+#define RESUME_FILE_VERSION     1
+#define RESUME_MAX_STREAMS      8
+#define RESUME_MAX_BACK_SIZE    (16 * 1024 * 1024)  // Sample tables of a long clip, bounds a corrupt entry
+#define RESUME_PATH_MAX         256
+
+// Entry file: this header, the clip path, stream_num stream records with
+// back_data cleared, then each stream's back data in the same order
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t file_size;             // Of the clip when stored
+    int64_t mtime;
+    uint32_t position_ms;           // Updated in place by resume_store_set_position()
+    uint32_t path_len;
+    uint32_t extractor_type;
+    uint32_t byte_position;
+    uint32_t time;
+    uint32_t stream_num;
+} resume_file_header_t;
+
+static void entry_path(const char *dir, const char *path, char *out, size_t out_size)
+{
+    // FNV-1a; the path itself is stored in the file to rule out collisions
+    uint32_t hash = 2166136261u;
+    for (const char *c = path; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    snprintf(out, out_size, "%s/%08" PRIx32 ".rsm", dir, hash);
+}
+
+// Open the entry of path and check it still describes the clip. Returns the
+// file positioned after the path, or NULL.
+static FILE *entry_open(const char *dir, const char *path, const char *mode, resume_file_header_t *header)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return NULL;
+    }
+
+    char file[RESUME_PATH_MAX + 32];
+    entry_path(dir, path, file, sizeof(file));
+    FILE *f = fopen(file, mode);
+    if (!f) {
+        return NULL;
+    }
+
+    char stored_path[RESUME_PATH_MAX];
+    size_t path_len = strlen(path);
+    if (fread(header, sizeof(*header), 1, f) == 1 && header->magic == RESUME_FILE_MAGIC &&
+            header->version == RESUME_FILE_VERSION && header->file_size == (uint32_t)st.st_size &&
+            header->mtime == (int64_t)st.st_mtime && header->path_len == path_len &&
+            header->stream_num <= RESUME_MAX_STREAMS &&
+            path_len < sizeof(stored_path) && fread(stored_path, 1, path_len, f) == path_len &&
+            memcmp(stored_path, path, path_len) == 0) {
+        return f;
+    }
+    fclose(f);
+    return NULL;
+}
+
+esp_err_t resume_store_load(const char *dir, const char *path, esp_extractor_resume_info_t *info,
+                            uint32_t *position_ms)
+{
+    if (!dir || !path || !info || !position_ms) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(info, 0, sizeof(*info));
+    resume_file_header_t header;
+    FILE *f = entry_open(dir, path, "rb", &header);
+    if (!f) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    info->resume_streams = calloc(header.stream_num ? header.stream_num : 1, sizeof(*info->resume_streams));
+    if (!info->resume_streams) {
+        goto cleanup;
+    }
+
+    ret = ESP_ERR_INVALID_SIZE;
+    if (fread(info->resume_streams, sizeof(*info->resume_streams), header.stream_num, f) != header.stream_num) {
+        goto cleanup;
+    }
+    // Stored pointers are stale, cleared before anything can free them
+    for (uint32_t i = 0; i < header.stream_num; i++) {
+        info->resume_streams[i].back_data = NULL;
+    }
+    info->stream_num = (uint8_t)header.stream_num;
+
+    for (uint32_t i = 0; i < header.stream_num; i++) {
+        extractor_stream_resume_info_t *stream = &info->resume_streams[i];
+        if (stream->back_size == 0) {
+            continue;
+        }
+        if (stream->back_size > RESUME_MAX_BACK_SIZE) {
+            ret = ESP_ERR_INVALID_SIZE;
+            goto cleanup;
+        }
+        stream->back_data = heap_caps_malloc(stream->back_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!stream->back_data) {
+            ret = ESP_ERR_NO_MEM;
+            goto cleanup;
+        }
+        if (fread(stream->back_data, 1, stream->back_size, f) != stream->back_size) {
+            ret = ESP_ERR_INVALID_SIZE;
+            goto cleanup;
+        }
+    }
+
+    info->extractor_type = (esp_extractor_type_t)header.extractor_type;
+    info->position = header.byte_position;
+    info->time = header.time;
+    *position_ms = header.position_ms;
+    fclose(f);
+    return ESP_OK;
+
+cleanup:
+    fclose(f);
+    ESP_LOGW(TAG, "Dropping unreadable entry of %s: %s", path, esp_err_to_name(ret));
+    resume_store_free(info);
+    return ret;
+}
+
+esp_err_t resume_store_save(const char *dir, const char *path, const esp_extractor_resume_info_t *info,
+                            uint32_t position_ms)
+{
+    if (!dir || !path || !info || (info->stream_num && !info->resume_streams)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (info->stream_num > RESUME_MAX_STREAMS || strlen(path) >= RESUME_PATH_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        ESP_LOGW(TAG, "Cannot create %s: %d", dir, errno);
+        return ESP_FAIL;
+    }
+
+    char file[RESUME_PATH_MAX + 32];
+    char tmp_file[RESUME_PATH_MAX + 40];
+    entry_path(dir, path, file, sizeof(file));
+    snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", file);
+
+    // Written aside and renamed, so a pulled card never leaves a torn entry
+    FILE *f = fopen(tmp_file, "wb");
+    if (!f) {
+        ESP_LOGW(TAG, "Cannot write %s: %d", tmp_file, errno);
+        return ESP_FAIL;
+    }
+
+    resume_file_header_t header = {
+        .magic = RESUME_FILE_MAGIC,
+        .version = RESUME_FILE_VERSION,
+        .file_size = (uint32_t)st.st_size,
+        .mtime = (int64_t)st.st_mtime,
+        .position_ms = position_ms,
+        .path_len = strlen(path),
+        .extractor_type = (uint32_t)info->extractor_type,
+        .byte_position = info->position,
+        .time = info->time,
+        .stream_num = info->stream_num,
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(path, 1, header.path_len, f) == header.path_len;
+    for (uint32_t i = 0; ok && i < info->stream_num; i++) {
+        extractor_stream_resume_info_t stream = info->resume_streams[i];
+        stream.back_data = NULL;
+        if (!info->resume_streams[i].back_data) {
+            stream.back_size = 0;
+        }
+        ok = fwrite(&stream, sizeof(stream), 1, f) == 1;
+    }
+    for (uint32_t i = 0; ok && i < info->stream_num; i++) {
+        const extractor_stream_resume_info_t *stream = &info->resume_streams[i];
+        if (stream->back_data && stream->back_size) {
+            ok = fwrite(stream->back_data, 1, stream->back_size, f) == stream->back_size;
+        }
+    }
+    ok = fclose(f) == 0 && ok;
+
+    // FAT does not rename over an existing file
+    unlink(file);
+    if (!ok || rename(tmp_file, file) != 0) {
+        ESP_LOGW(TAG, "Failed to store %s", file);
+        unlink(tmp_file);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+bool resume_store_contains(const char *dir, const char *path)
+{
+    if (!dir || !path) {
+        return false;
+    }
+
+    resume_file_header_t header;
+    FILE *f = entry_open(dir, path, "rb", &header);
+    if (!f) {
+        return false;
+    }
+    fclose(f);
+    return true;
+}
+
+esp_err_t resume_store_set_position(const char *dir, const char *path, uint32_t position_ms)
+{
+    if (!dir || !path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    resume_file_header_t header;
+    FILE *f = entry_open(dir, path, "r+b", &header);
+    if (!f) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (header.position_ms == position_ms) {
+        fclose(f);
+        return ESP_OK;
+    }
+
+    // A single aligned word in the first sector, rewritten as a whole by FAT
+    bool ok = fseek(f, offsetof(resume_file_header_t, position_ms), SEEK_SET) == 0 &&
+              fwrite(&position_ms, sizeof(position_ms), 1, f) == 1;
+    ok = fclose(f) == 0 && ok;
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+void resume_store_free(esp_extractor_resume_info_t *info)
+{
+    if (!info) {
+        return;
+    }
+    for (uint32_t i = 0; info->resume_streams && i < info->stream_num; i++) {
+        heap_caps_free(info->resume_streams[i].back_data);
+    }
+    free(info->resume_streams);
+    memset(info, 0, sizeof(*info));
+}
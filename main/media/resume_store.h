@@ -0,0 +1,45 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_extractor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Where playback of a clip stopped, and the extractor state to reopen it with.
+//
+// The extractor's resume info carries the stream setup and parsed sample tables,
+// so a clip reopened with it skips the container parse. One small file per clip
+// is kept in a directory on the card, keyed by path and checked against the
+// clip's size and modification time; a changed clip simply has no entry.
+
+// Load the entry of path. info is filled for esp_extractor_set_resume_info() and
+// must be released with resume_store_free(). ESP_ERR_NOT_FOUND without a valid entry.
+esp_err_t resume_store_load(const char *dir, const char *path, esp_extractor_resume_info_t *info,
+                            uint32_t *position_ms);
+
+// Store info and the position playback stopped at, replacing any entry of path
+esp_err_t resume_store_save(const char *dir, const char *path, const esp_extractor_resume_info_t *info,
+                            uint32_t position_ms);
+
+// Whether path has a valid entry, checked from its header without reading the
+// extractor state
+bool resume_store_contains(const char *dir, const char *path);
+
+// Update only the position of an existing entry, without rewriting the extractor
+// state. ESP_ERR_NOT_FOUND when there is no valid entry to update.
+esp_err_t resume_store_set_position(const char *dir, const char *path, uint32_t position_ms);
+
+void resume_store_free(esp_extractor_resume_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,505 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "video_output.h"
+#include "hal_display.h"
+#include "hal_ppa.h"
+#include "image_buffer.h"
+#include "esp_cache.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "video_out";
+
+#define BLIT_TIMEOUT_MS         100
+// A frame buffer frees up at the next vsync, even at 30 Hz this is plenty
+#define FLIP_TIMEOUT_MS         100
+#define JPEG_MCU_WIDTH          16
+#define NO_FB                   (-1)
+
+typedef struct {
+    uint32_t x, y, w, h;
+} frame_rect_t;
+
+struct video_output_t;
+
+// Passed to the PPA with each copy, so a late completion is told from the current one
+typedef struct {
+    struct video_output_t *output;
+    uint32_t index;                             // Frame buffer written
+    uint32_t seq;                               // Copy number, from blit_seq
+} blit_tag_t;
+
+struct video_output_t {
+    uint8_t *fbs[HAL_DISPLAY_MAX_FBS];
+    uint32_t fb_count;
+    size_t fb_size;
+    frame_rect_t drawn[HAL_DISPLAY_MAX_FBS];    // Frame area last copied into each buffer
+    hal_ppa_client_handle_t ppa_client;
+    SemaphoreHandle_t blit_done;
+    blit_tag_t blit_tags[HAL_DISPLAY_MAX_FBS];
+    uint32_t blit_seq;                          // Last copy submitted
+    SemaphoreHandle_t free_count;               // Buffers neither scanned out, queued nor written
+    SemaphoreHandle_t landed;                   // The queued flip reached the panel
+    portMUX_TYPE lock;
+    volatile bool active;
+
+    // Guarded by lock, updated from the vsync callback
+    uint32_t scanout;
+    int32_t queued;                             // Flipped to but not latched yet, or NO_FB
+    uint32_t busy_mask;
+    uint32_t orphan_mask;                       // Copy timed out but still running, busy until it completes
+    uint32_t blit_done_seq;                     // Last copy completed
+    uint32_t vsyncs;
+    int64_t first_vsync_us;
+    int64_t last_vsync_us;
+    uint32_t frames;
+    int64_t last_frame_us;                      // 0 until the first frame after begin
+    uint32_t intervals;
+    uint64_t interval_sum_us;
+    uint64_t interval_sq_sum;
+    uint32_t interval_max_us;
+    uint32_t blit_us_last;
+    uint32_t blit_us_max;
+    uint32_t buffer_waits;
+    uint32_t failures;
+};
+
+// PPA transaction done callback (ISR context). A copy given up on frees its
+// buffer now; any other completion is reported to the waiting blit().
+static bool blit_done_cb(void *user_data)
+{
+    blit_tag_t *tag = (blit_tag_t *)user_data;
+    struct video_output_t *output = tag->output;
+    BaseType_t high_task_woken = pdFALSE;
+    bool orphan = false;
+    bool release = false;
+
+    taskENTER_CRITICAL_ISR(&output->lock);
+    if (output->orphan_mask & (1U << tag->index)) {
+        output->orphan_mask &= ~(1U << tag->index);
+        output->busy_mask &= ~(1U << tag->index);
+        orphan = true;
+        // Outside playback video_output_begin() recounts the free buffers
+        release = output->active;
+    } else {
+        output->blit_done_seq = tag->seq;
+    }
+    taskEXIT_CRITICAL_ISR(&output->lock);
+
+    if (release) {
+        xSemaphoreGiveFromISR(output->free_count, &high_task_woken);
+    } else if (!orphan) {
+        xSemaphoreGiveFromISR(output->blit_done, &high_task_woken);
+    }
+    return high_task_woken == pdTRUE;
+}
+
+// Panel refresh done (ISR context): a latched flip frees the buffer shown before it
+static bool vsync_cb(uint32_t scanout, int64_t time_us, void *user_data)
+{
+    struct video_output_t *output = (struct video_output_t *)user_data;
+    BaseType_t high_task_woken = pdFALSE;
+    bool landed = false;
+
+    if (!output->active) {
+        return false;
+    }
+
+    taskENTER_CRITICAL_ISR(&output->lock);
+    if (output->vsyncs++ == 0) {
+        output->first_vsync_us = time_us;
+    }
+    output->last_vsync_us = time_us;
+
+    if (output->queued != NO_FB && scanout == (uint32_t)output->queued) {
+        output->busy_mask &= ~(1U << output->scanout);
+        output->scanout = scanout;
+        output->queued = NO_FB;
+        landed = true;
+
+        output->frames++;
+        if (output->last_frame_us != 0) {
+            uint32_t interval_us = (uint32_t)(time_us - output->last_frame_us);
+            output->intervals++;
+            output->interval_sum_us += interval_us;
+            output->interval_sq_sum += (uint64_t)interval_us * interval_us;
+            if (interval_us > output->interval_max_us) {
+                output->interval_max_us = interval_us;
+            }
+        }
+        output->last_frame_us = time_us;
+    }
+    taskEXIT_CRITICAL_ISR(&output->lock);
+
+    if (landed) {
+        xSemaphoreGiveFromISR(output->free_count, &high_task_woken);
+        xSemaphoreGiveFromISR(output->landed, &high_task_woken);
+    }
+    return high_task_woken == pdTRUE;
+}
+
+esp_err_t video_output_create(video_output_handle_t *ret_output)
+{
+    if (!ret_output) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t fb_count = hal_display_fb_count();
+    if (fb_count < 2) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    struct video_output_t *output = calloc(1, sizeof(*output));
+    if (!output) {
+        return ESP_ERR_NO_MEM;
+    }
+    output->fb_count = fb_count;
+    output->fb_size = hal_display_fb_size();
+    for (uint32_t i = 0; i < fb_count; i++) {
+        output->fbs[i] = hal_display_fb_get(i);
+        output->blit_tags[i].output = output;
+        output->blit_tags[i].index = i;
+    }
+    output->queued = NO_FB;
+    portMUX_INITIALIZE(&output->lock);
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    output->blit_done = xSemaphoreCreateBinary();
+    output->landed = xSemaphoreCreateBinary();
+    output->free_count = xSemaphoreCreateCounting(fb_count, 0);
+    if (!output->blit_done || !output->landed || !output->free_count) {
+        goto cleanup;
+    }
+
+    // A copy that timed out may still hold a slot while the next one goes out
+    hal_ppa_client_config_t ppa_config = {
+        .max_pending = fb_count,
+        .done_cb = blit_done_cb,
+    };
+    ret = hal_ppa_client_create(&ppa_config, &output->ppa_client);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register PPA client: %s", esp_err_to_name(ret));
+        goto cleanup;
+    }
+
+    hal_display_set_vsync_cb(vsync_cb, output);
+
+    ESP_LOGI(TAG, "Direct video output: %u frame buffers of %dx%d", fb_count,
+             HAL_DISPLAY_H_RES, HAL_DISPLAY_V_RES);
+    *ret_output = output;
+    return ESP_OK;
+
+cleanup:
+    if (output->blit_done) {
+        vSemaphoreDelete(output->blit_done);
+    }
+    if (output->landed) {
+        vSemaphoreDelete(output->landed);
+    }
+    if (output->free_count) {
+        vSemaphoreDelete(output->free_count);
+    }
+    free(output);
+    return ret;
+}
+
+esp_err_t video_output_delete(video_output_handle_t output)
+{
+    if (!output) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (output->active) {
+        video_output_end(output);
+    }
+
+    hal_display_set_vsync_cb(NULL, NULL);
+    esp_err_t ret = hal_ppa_client_delete(output->ppa_client);
+    vSemaphoreDelete(output->blit_done);
+    vSemaphoreDelete(output->landed);
+    vSemaphoreDelete(output->free_count);
+    free(output);
+    return ret;
+}
+
+esp_err_t video_output_begin(video_output_handle_t output)
+{
+    if (!output) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (output->active) {
+        return ESP_OK;
+    }
+
+    // Whatever LVGL drew is stale for video, every buffer gets cleared on first use
+    memset(output->drawn, 0, sizeof(output->drawn));
+    while (xSemaphoreTake(output->free_count, 0) == pdTRUE) {
+    }
+    xSemaphoreTake(output->landed, 0);
+
+    hal_display_take_scanout(true);
+
+    taskENTER_CRITICAL(&output->lock);
+    output->scanout = hal_display_fb_scanout();
+    output->queued = NO_FB;
+    // Buffers a timed out copy still writes stay busy, blit_done_cb() frees them
+    output->busy_mask = (1U << output->scanout) | output->orphan_mask;
+    uint32_t free_fbs = output->fb_count - __builtin_popcount(output->busy_mask);
+    // Time spent on the LVGL canvas is not a frame interval
+    output->last_frame_us = 0;
+    output->active = true;
+    taskEXIT_CRITICAL(&output->lock);
+
+    for (uint32_t i = 0; i < free_fbs; i++) {
+        xSemaphoreGive(output->free_count);
+    }
+    return ESP_OK;
+}
+
+static void wait_for_flip(struct video_output_t *output)
+{
+    taskENTER_CRITICAL(&output->lock);
+    bool pending = output->queued != NO_FB;
+    taskEXIT_CRITICAL(&output->lock);
+
+    if (pending && xSemaphoreTake(output->landed, pdMS_TO_TICKS(FLIP_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Flip did not reach the panel");
+    }
+}
+
+void video_output_end(video_output_handle_t output)
+{
+    if (!output || !output->active) {
+        return;
+    }
+
+    wait_for_flip(output);
+    output->active = false;
+    hal_display_take_scanout(false);
+}
+
+bool video_output_is_active(video_output_handle_t output)
+{
+    return output && output->active;
+}
+
+static void release_fb(struct video_output_t *output, uint32_t index)
+{
+    taskENTER_CRITICAL(&output->lock);
+    output->busy_mask &= ~(1U << index);
+    output->failures++;
+    taskEXIT_CRITICAL(&output->lock);
+    xSemaphoreGive(output->free_count);
+}
+
+static esp_err_t blit(struct video_output_t *output, uint32_t index, const void *in, size_t in_size,
+                      uint32_t width, uint32_t height)
+{
+    uint32_t screen_w = HAL_DISPLAY_H_RES;
+    uint32_t screen_h = HAL_DISPLAY_V_RES;
+
+    // The JPEG decoder pads rows to whole MCUs when the width is not a multiple of them
+    uint32_t padded_w = (width + JPEG_MCU_WIDTH - 1) & ~(JPEG_MCU_WIDTH - 1);
+    uint32_t stride = (in_size > (size_t)width * height * 2) ? padded_w : width;
+    if (in_size < (size_t)stride * height * 2) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    frame_rect_t rect = {
+        .w = width < screen_w ? width : screen_w,
+        .h = height < screen_h ? height : screen_h,
+    };
+    rect.x = (screen_w - rect.w) / 2;
+    rect.y = (screen_h - rect.h) / 2;
+
+    // Borders only need clearing when the frame area changes
+    uint8_t *fb = output->fbs[index];
+    if (memcmp(&output->drawn[index], &rect, sizeof(rect)) != 0) {
+        memset(fb, 0, output->fb_size);
+        image_buffer_cache_sync(fb, output->fb_size, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+        output->drawn[index] = rect;
+    }
+
+    hal_ppa_srm_op_t op = {
+        .in_buffer = in,
+        .in_pic_w = stride,
+        .in_pic_h = height,
+        .in_block_w = rect.w,
+        .in_block_h = rect.h,
+        .in_block_offset_x = (width - rect.w) / 2,
+        .in_block_offset_y = (height - rect.h) / 2,
+        .out_buffer = fb,
+        .out_buffer_size = output->fb_size,
+        .out_pic_w = screen_w,
+        .out_pic_h = screen_h,
+        .out_block_offset_x = rect.x,
+        .out_block_offset_y = rect.y,
+        .scale_x = 1.0f,
+        .scale_y = 1.0f,
+        .user_data = &output->blit_tags[index],
+    };
+
+    uint32_t seq = ++output->blit_seq;
+    output->blit_tags[index].seq = seq;
+    esp_err_t ret = hal_ppa_srm_submit(output->ppa_client, &op);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // Completions of earlier copies may still be signalled, wait for this one
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(BLIT_TIMEOUT_MS);
+    while (true) {
+        taskENTER_CRITICAL(&output->lock);
+        bool done = output->blit_done_seq == seq;
+        taskEXIT_CRITICAL(&output->lock);
+        if (done) {
+            return ESP_OK;
+        }
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(deadline - now) <= 0 || xSemaphoreTake(output->blit_done, deadline - now) != pdTRUE) {
+            break;
+        }
+    }
+
+    // The PPA may still write the buffer; it stays busy until blit_done_cb() sees the copy finish
+    taskENTER_CRITICAL(&output->lock);
+    bool done = output->blit_done_seq == seq;
+    if (!done) {
+        output->orphan_mask |= 1U << index;
+    }
+    taskEXIT_CRITICAL(&output->lock);
+    return done ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t video_output_present(video_output_handle_t output, const void *in, size_t in_size,
+                               uint32_t width, uint32_t height)
+{
+    if (!output || !in || width == 0 || height == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!output->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (xSemaphoreTake(output->free_count, 0) != pdTRUE) {
+        output->buffer_waits++;
+        if (xSemaphoreTake(output->free_count, pdMS_TO_TICKS(FLIP_TIMEOUT_MS)) != pdTRUE) {
+            output->failures++;
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+
+    uint32_t index = 0;
+    taskENTER_CRITICAL(&output->lock);
+    while (index < output->fb_count && (output->busy_mask & (1U << index))) {
+        index++;
+    }
+    if (index < output->fb_count) {
+        output->busy_mask |= 1U << index;
+    }
+    taskEXIT_CRITICAL(&output->lock);
+    if (index == output->fb_count) {
+        // Cannot happen while free_count matches busy_mask
+        xSemaphoreGive(output->free_count);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = blit(output, index, in, in_size, width, height);
+    uint32_t blit_us = (uint32_t)(esp_timer_get_time() - start_us);
+    if (ret == ESP_ERR_TIMEOUT) {
+        // The buffer is orphaned, not free, until its copy completes
+        ESP_LOGE(TAG, "Frame copy %ux%u timed out", width, height);
+        taskENTER_CRITICAL(&output->lock);
+        output->failures++;
+        taskEXIT_CRITICAL(&output->lock);
+        return ret;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Frame copy %ux%u failed: %s", width, height, esp_err_to_name(ret));
+        release_fb(output, index);
+        return ret;
+    }
+
+    // One flip per refresh: the previous frame has to be on screen first
+    wait_for_flip(output);
+
+    // Only a flip queued from here on may signal landed
+    xSemaphoreTake(output->landed, 0);
+    taskENTER_CRITICAL(&output->lock);
+    output->queued = (int32_t)index;
+    output->blit_us_last = blit_us;
+    if (blit_us > output->blit_us_max) {
+        output->blit_us_max = blit_us;
+    }
+    taskEXIT_CRITICAL(&output->lock);
+
+    ret = hal_display_fb_flip(index);
+    if (ret != ESP_OK) {
+        taskENTER_CRITICAL(&output->lock);
+        output->queued = NO_FB;
+        taskEXIT_CRITICAL(&output->lock);
+        release_fb(output, index);
+    }
+    return ret;
+}
+
+esp_err_t video_output_get_stats(video_output_handle_t output, video_output_stats_t *stats)
+{
+    if (!output || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    taskENTER_CRITICAL(&output->lock);
+    stats->frames = output->frames;
+    stats->vsyncs = output->vsyncs;
+    if (output->vsyncs > 1) {
+        stats->refresh_us = (uint32_t)((output->last_vsync_us - output->first_vsync_us) / (output->vsyncs - 1));
+    }
+    uint32_t intervals = output->intervals;
+    uint64_t interval_sum_us = output->interval_sum_us;
+    uint64_t interval_sq_sum = output->interval_sq_sum;
+    stats->frame_us_max = output->interval_max_us;
+    stats->blit_us_last = output->blit_us_last;
+    stats->blit_us_max = output->blit_us_max;
+    stats->buffer_waits = output->buffer_waits;
+    stats->failures = output->failures;
+    taskEXIT_CRITICAL(&output->lock);
+
+    if (intervals > 0) {
+        double mean = (double)interval_sum_us / intervals;
+        double variance = (double)interval_sq_sum / intervals - mean * mean;
+        stats->frame_us_avg = (uint32_t)mean;
+        stats->jitter_us = variance > 0 ? (uint32_t)sqrt(variance) : 0;
+        stats->fps = (float)(1000000.0 / mean);
+    }
+    return ESP_OK;
+}
+
+void video_output_reset_stats(video_output_handle_t output)
+{
+    if (!output) {
+        return;
+    }
+    taskENTER_CRITICAL(&output->lock);
+    output->vsyncs = 0;
+    output->frames = 0;
+    output->last_frame_us = 0;
+    output->intervals = 0;
+    output->interval_sum_us = 0;
+    output->interval_sq_sum = 0;
+    output->interval_max_us = 0;
+    output->blit_us_last = 0;
+    output->blit_us_max = 0;
+    output->buffer_waits = 0;
+    output->failures = 0;
+    taskEXIT_CRITICAL(&output->lock);
+}
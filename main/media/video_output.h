@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Direct video output. While active, each RGB565 frame is copied centred into
+// a free panel frame buffer on the PPA and flipped to on the next vsync, so
+// video skips LVGL's canvas render and the direct-mode buffer sync. LVGL keeps
+// running for input but must not redraw: overlays go back through LVGL by
+// ending the output first. Needs at least two panel frame buffers; with three
+// a frame can be copied while the previous one waits for its vsync.
+
+typedef struct video_output_t *video_output_handle_t;
+
+typedef struct {
+    uint32_t frames;                // Frames that reached the panel
+    uint32_t vsyncs;                // Panel refreshes while active
+    uint32_t refresh_us;            // Measured refresh period
+    float fps;                      // Achieved frame rate on the panel
+    uint32_t frame_us_avg;          // Time each frame stayed on screen
+    uint32_t frame_us_max;
+    uint32_t jitter_us;             // Standard deviation of the on-screen time
+    uint32_t blit_us_last;          // Frame copy into the frame buffer
+    uint32_t blit_us_max;
+    uint32_t buffer_waits;          // Presents that waited for a frame buffer
+    uint32_t failures;
+} video_output_stats_t;
+
+// ESP_ERR_NOT_SUPPORTED when the display exposes fewer than two frame buffers
+esp_err_t video_output_create(video_output_handle_t *ret_output);
+esp_err_t video_output_delete(video_output_handle_t output);
+
+// Take scanout from LVGL. Call with the display lock held and nothing left
+// for LVGL to redraw.
+esp_err_t video_output_begin(video_output_handle_t output);
+
+// Wait for the last flip and give scanout back to LVGL, which then has to
+// redraw the whole screen. Call with the display lock held.
+void video_output_end(video_output_handle_t output);
+
+bool video_output_is_active(video_output_handle_t output);
+
+// Copy a decoded frame to the screen from the next vsync on. Rows may be padded
+// to the JPEG MCU width, as in_size tells; frames larger than the screen are
+// cropped around the centre. in is no longer read on return.
+esp_err_t video_output_present(video_output_handle_t output, const void *in, size_t in_size,
+                               uint32_t width, uint32_t height);
+
+esp_err_t video_output_get_stats(video_output_handle_t output, video_output_stats_t *stats);
+void video_output_reset_stats(video_output_handle_t output);
+
+#ifdef __cplusplus
+}
+#endif
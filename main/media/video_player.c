@@ -5,6 +5,9 @@
 
 #include "video_player.h"
 #include "app_stream_adapter.h"
+#include "video_transform.h"
+#include "video_output.h"
+#include "image_buffer.h"
 #include "ui_manager.h"
 #include "photo_album_constants.h"
 #include "esp_log.h"
@@ -13,14 +16,23 @@
 #include <string.h>
 #include "photo_album.h"
 #include "esp_timer.h"
-#include "slideshow_ctrl.h"
 
 static const char *TAG = "video";
 
+#if CONFIG_VIDEO_ROTATION_90
+#define VIDEO_SRM_ROTATION      VIDEO_ROTATION_90
+#elif CONFIG_VIDEO_ROTATION_180
+#define VIDEO_SRM_ROTATION      VIDEO_ROTATION_180
+#elif CONFIG_VIDEO_ROTATION_270
+#define VIDEO_SRM_ROTATION      VIDEO_ROTATION_270
+#else
+#define VIDEO_SRM_ROTATION      VIDEO_ROTATION_0
+#endif
+
 static struct {
     app_stream_adapter_handle_t adapter;
-    void *buffer_a;
-    void *buffer_b;
+    video_transform_handle_t transform;
+    video_output_handle_t output;
     video_state_t state;
     uint32_t width, height;
     bool playback_finished;
@@ -28,14 +40,17 @@ static struct {
     int current_volume;
     char current_file[256];  // Store current playing file
     bool has_error;          // Track error state
-    esp_timer_handle_t finish_timer;
+    int64_t switch_start_us;  // Play or switch request, until its first frame is shown
+    int64_t ended_us;         // End of the last clip, until the next one shows its first frame
 } s_video = {0};
 
-static void video_finish_timer_cb(void *arg)
+// Runs on the adapter's present task, which a stop would wait for: the album
+// worker moves on
+static void video_eos_callback(void *user_data)
 {
-    // Restart slideshow timer and move to next media
-    slideshow_ctrl_start();
-    photo_album_next();
+    s_video.playback_finished = true;
+    s_video.ended_us = esp_timer_get_time();
+    photo_album_video_ended();
 }
 
 static esp_err_t video_frame_callback(uint8_t *buffer, uint32_t buffer_size,
@@ -49,9 +64,103 @@ static esp_err_t video_frame_callback(uint8_t *buffer, uint32_t buffer_size,
     // Clear error state on successful frame callback
     s_video.has_error = false;
     
-    // Directly pass JPEG decoded buffer to Canvas
-    // Canvas will automatically handle cropping to display area
-    return ui_manager_display_video_frame(buffer, width, height);
+    // Zero-copy: the canvas shows the buffer directly, already fitted to the
+    // screen by the SRM stage when it is enabled
+    esp_err_t ret = ui_manager_display_video_frame(buffer, width, height);
+
+    if (ret == ESP_OK && frame_index == 0 && s_video.switch_start_us != 0) {
+        app_stream_stats_t stats;
+        app_stream_adapter_get_stats(s_video.adapter, &stats);
+        ESP_LOGI(TAG, "Switch latency %lld ms to first frame (%s%s, prepared in %u ms)",
+                 (esp_timer_get_time() - s_video.switch_start_us) / 1000,
+                 stats.started_prepared ? "prepared" : "cold", stats.resumed ? ", resumed" : "",
+                 stats.prepare_ms);
+        s_video.switch_start_us = 0;
+        if (s_video.ended_us != 0) {
+            ESP_LOGI(TAG, "Inter-clip gap %lld ms", (esp_timer_get_time() - s_video.ended_us) / 1000);
+            s_video.ended_us = 0;
+        }
+    }
+    return ret;
+}
+
+// The canvas has finished with a frame: give it back to the adapter's pool
+static void video_frame_release_callback(const uint8_t *frame_buffer, void *user_data)
+{
+    if (s_video.adapter) {
+        app_stream_adapter_release_frame(s_video.adapter, frame_buffer);
+    }
+}
+
+// Direct output: frames go straight into the panel frame buffers on vsync
+static void video_output_init(void)
+{
+#if CONFIG_VIDEO_DIRECT_OUTPUT
+    esp_err_t ret = video_output_create(&s_video.output);
+    if (ret == ESP_OK) {
+        ui_manager_set_video_output(s_video.output);
+    } else {
+        ESP_LOGW(TAG, "Direct video output unavailable (%s), using the LVGL canvas",
+                 esp_err_to_name(ret));
+    }
+#endif
+}
+
+static void video_output_deinit(void)
+{
+    if (s_video.output) {
+        ui_manager_set_video_output(NULL);
+        video_output_delete(s_video.output);
+        s_video.output = NULL;
+    }
+}
+
+static void video_output_log_stats(void)
+{
+    video_output_stats_t stats;
+    if (!s_video.output || video_output_get_stats(s_video.output, &stats) != ESP_OK || stats.frames == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "Direct output: %lu frames at %.1f fps, on screen %lu us avg / %lu max, jitter %lu us, "
+             "refresh %lu us",
+             (unsigned long)stats.frames, stats.fps, (unsigned long)stats.frame_us_avg,
+             (unsigned long)stats.frame_us_max, (unsigned long)stats.jitter_us, (unsigned long)stats.refresh_us);
+    ESP_LOGI(TAG, "Direct output: blit %lu us max, %lu buffer waits, %lu failures",
+             (unsigned long)stats.blit_us_max, (unsigned long)stats.buffer_waits, (unsigned long)stats.failures);
+    video_output_reset_stats(s_video.output);
+}
+
+static void video_srm_deinit(void)
+{
+    if (s_video.transform) {
+        video_transform_delete(s_video.transform);
+        s_video.transform = NULL;
+    }
+}
+
+// Scale/rotate/mirror stage: frames of any size are fitted to the screen
+static esp_err_t video_srm_init(void)
+{
+#if CONFIG_VIDEO_SRM_ENABLED
+    video_transform_config_t config = {
+        .screen_width = SCREEN_WIDTH,
+        .screen_height = SCREEN_HEIGHT,
+        .rotation = VIDEO_SRM_ROTATION,
+#if CONFIG_VIDEO_AUTO_ROTATE
+        .auto_rotate = true,
+#endif
+#if CONFIG_VIDEO_MIRROR_X
+        .mirror_x = true,
+#endif
+#if CONFIG_VIDEO_MIRROR_Y
+        .mirror_y = true,
+#endif
+    };
+
+    return video_transform_create(&config, &s_video.transform);
+#else
+    return ESP_OK;
+#endif
 }
 
 esp_err_t video_player_init(esp_codec_dev_handle_t audio_dev)
@@ -63,40 +172,41 @@ esp_err_t video_player_init(esp_codec_dev_handle_t audio_dev)
     s_video.has_error = false;
     memset(s_video.current_file, 0, sizeof(s_video.current_file));
     
-    // Allocate larger buffers to support high-resolution videos (up to 1080P)
-    // with margin for JPEG 16-byte alignment requirements
-    size_t buffer_size = VIDEO_BUFFER_SIZE;
-    size_t allocated_size_a, allocated_size_b;
-    
-    ESP_LOGI(TAG, "Allocating video buffers: %zu bytes each (supports up to %dx%d)", 
-             buffer_size, MAX_VIDEO_WIDTH, MAX_VIDEO_HEIGHT);
-    
-    s_video.buffer_a = shared_jpeg_alloc_output_buffer(buffer_size, &allocated_size_a);
-    s_video.buffer_b = shared_jpeg_alloc_output_buffer(buffer_size, &allocated_size_b);
-    
-    if (!s_video.buffer_a || !s_video.buffer_b) {
-        ESP_LOGE(TAG, "Buffer allocation failed");
-        if (s_video.buffer_a) shared_jpeg_free_buffer(s_video.buffer_a);
-        if (s_video.buffer_b) shared_jpeg_free_buffer(s_video.buffer_b);
-        return ESP_ERR_NO_MEM;
+    esp_err_t ret = video_srm_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Video SRM stage init failed: %s", esp_err_to_name(ret));
+        return ret;
     }
     
-    static void *buffers[2];
-    buffers[0] = s_video.buffer_a;
-    buffers[1] = s_video.buffer_b;
-    
     app_stream_adapter_config_t config = {
         .frame_cb = video_frame_callback,
+        .eos_cb = video_eos_callback,
         .user_data = NULL,
-        .decode_buffers = buffers,
-        .buffer_count = 2,
-        .buffer_size = buffer_size,
+        // Frame buffers are allocated on first use at the size of each stream,
+        // max_* only applies when a container reports no frame size
+        .frame_buffer_count = CONFIG_VIDEO_FRAME_BUFFERS,
+        .max_width = MAX_VIDEO_WIDTH,
+        .max_height = MAX_VIDEO_HEIGHT,
+        .display_releases_frames = true,
         .audio_dev = s_video.audio_dev,
-        .jpeg_config = APP_STREAM_JPEG_CONFIG_DEFAULT_RGB565()
+        .jpeg_config = APP_STREAM_JPEG_CONFIG_DEFAULT_RGB565(),
+        .transform = s_video.transform,
+#if CONFIG_VIDEO_FRAME_INDEX
+        .frame_index = true,
+#endif
+#if CONFIG_VIDEO_RESUME_PLAYBACK
+        .resume_playback = true,
+#endif
+#if CONFIG_VIDEO_SKIP_DUPLICATE_FRAMES
+        .skip_duplicate_frames = true,
+#endif
+        .cache_dir = VIDEO_CACHE_DIR,
     };
     
-    esp_err_t ret = app_stream_adapter_init(&config, &s_video.adapter);
+    ret = app_stream_adapter_init(&config, &s_video.adapter);
     if (ret == ESP_OK) {
+        ui_manager_set_video_frame_release_cb(video_frame_release_callback, NULL);
+        video_output_init();
         s_video.state = VIDEO_STATE_STOPPED;
         ESP_LOGI(TAG, "Video player initialized %s audio support", 
                  s_video.audio_dev ? "with" : "without");
@@ -109,6 +219,8 @@ esp_err_t video_player_play(const char *mp4_file)
 {
     if (!s_video.adapter) return ESP_ERR_INVALID_STATE;
     
+    s_video.switch_start_us = esp_timer_get_time();
+
     // Store current file path
     strncpy(s_video.current_file, mp4_file, sizeof(s_video.current_file) - 1);
     s_video.current_file[sizeof(s_video.current_file) - 1] = '\0';
@@ -133,30 +245,6 @@ esp_err_t video_player_play(const char *mp4_file)
         s_video.state = VIDEO_STATE_PLAYING;
         s_video.playback_finished = false;
         ui_manager_switch_mode(UI_MODE_VIDEO);
-
-        // Schedule automatic switch to next media after video duration
-        uint32_t duration_ms = 0;
-        if (app_stream_adapter_get_info(s_video.adapter, NULL, NULL, NULL, &duration_ms) == ESP_OK && duration_ms > 0) {
-            // Add a small margin (500ms)
-            uint64_t timeout_us = ((uint64_t)duration_ms + 500) * 1000ULL;
-
-            // Create timer if not created
-            if (s_video.finish_timer == NULL) {
-                esp_timer_create_args_t t_args = {
-                    .callback = video_finish_timer_cb,
-                    .arg = NULL,
-                    .name = "video_finish"
-                };
-                if (esp_timer_create(&t_args, &s_video.finish_timer) != ESP_OK) {
-                    ESP_LOGW(TAG, "Failed to create finish timer");
-                }
-            }
-            if (s_video.finish_timer) {
-                esp_timer_stop(s_video.finish_timer);
-                esp_timer_start_once(s_video.finish_timer, timeout_us);
-                ESP_LOGI(TAG, "Finish timer started: %u ms", duration_ms + 500);
-            }
-        }
     } else {
         ESP_LOGE(TAG, "Failed to start MP4 playback: %s", esp_err_to_name(ret));
         s_video.has_error = true;
@@ -188,6 +276,10 @@ esp_err_t video_player_resume(void)
         esp_err_t ret = app_stream_adapter_resume(s_video.adapter);
         if (ret == ESP_OK) {
             s_video.state = VIDEO_STATE_PLAYING;
+            // The album skipped the end of stream while the clip was paused
+            if (s_video.playback_finished) {
+                photo_album_video_ended();
+            }
         } else {
             ESP_LOGW(TAG, "Failed to resume video: %s", esp_err_to_name(ret));
             s_video.has_error = true;
@@ -198,6 +290,30 @@ esp_err_t video_player_resume(void)
     return ESP_OK;
 }
 
+esp_err_t video_player_scrub(uint32_t permille)
+{
+    if (s_video.state != VIDEO_STATE_PAUSED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t duration = 0;
+    esp_err_t ret = app_stream_adapter_get_info(s_video.adapter, NULL, NULL, NULL, &duration);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (permille > 1000) {
+        permille = 1000;
+    }
+    ret = app_stream_adapter_scrub(s_video.adapter, (uint32_t)((uint64_t)duration * permille / 1000));
+    if (ret == ESP_OK) {
+        // Resuming plays on from the scrubbed frame, towards a new end of stream
+        s_video.playback_finished = false;
+    } else if (ret == ESP_ERR_NOT_FINISHED) {
+        ESP_LOGD(TAG, "Frame index not ready yet, cannot scrub");
+    }
+    return ret;
+}
+
 esp_err_t video_player_stop(void)
 {
     if (s_video.adapter && s_video.state != VIDEO_STATE_STOPPED) {
@@ -209,11 +325,11 @@ esp_err_t video_player_stop(void)
         if (ret != ESP_OK) {
             ESP_LOGW(TAG, "Failed to stop adapter: %s", esp_err_to_name(ret));
         }
+        video_player_dump_stats();
+        s_video.ended_us = 0;
 
-        // Cancel finish timer if running
-        if (s_video.finish_timer) {
-            esp_timer_stop(s_video.finish_timer);
-        }
+        // Stills get the video memory back; the next clip allocates at its own size
+        app_stream_adapter_release_buffers(s_video.adapter);
     }
     return ESP_OK;
 }
@@ -247,9 +363,19 @@ esp_err_t video_player_restart_current(void)
     return video_player_play(s_video.current_file);
 }
 
+esp_err_t video_player_dump_stats(void)
+{
+    if (!s_video.adapter) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t ret = app_stream_adapter_dump_stats(s_video.adapter);
+    video_output_log_stats();
+    return ret;
+}
+
 bool video_player_is_finished(void)
 {
-    // Simple check: rely on finish_timer for accurate end detection
+    // Set by the adapter's end of stream, or a stop
     return s_video.playback_finished;
 }
 
@@ -257,20 +383,15 @@ esp_err_t video_player_deinit(void)
 {
     video_player_stop();
     
+    video_output_deinit();
+
     if (s_video.adapter) {
+        ui_manager_set_video_frame_release_cb(NULL, NULL);
         app_stream_adapter_deinit(s_video.adapter);
         s_video.adapter = NULL;
     }
-    
-    if (s_video.buffer_a) {
-        shared_jpeg_free_buffer(s_video.buffer_a);
-        s_video.buffer_a = NULL;
-    }
-    
-    if (s_video.buffer_b) {
-        shared_jpeg_free_buffer(s_video.buffer_b);
-        s_video.buffer_b = NULL;
-    }
+
+    video_srm_deinit();
     
     return ESP_OK;
 }
@@ -300,6 +421,24 @@ int video_player_get_volume(void)
     return s_video.current_volume;
 }
 
+esp_err_t video_player_set_loop(bool loop)
+{
+    if (!s_video.adapter) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return app_stream_adapter_set_loop(s_video.adapter, loop);
+}
+
+esp_err_t video_player_set_speed(uint32_t speed)
+{
+    if (s_video.state != VIDEO_STATE_PLAYING && s_video.state != VIDEO_STATE_PAUSED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (speed < APP_STREAM_SPEED_MIN) speed = APP_STREAM_SPEED_MIN;
+    if (speed > APP_STREAM_SPEED_MAX) speed = APP_STREAM_SPEED_MAX;
+    return app_stream_adapter_set_speed(s_video.adapter, speed);
+}
+
 esp_err_t video_player_switch_file(const char *mp4_file)
 {
     if (!s_video.adapter) {
@@ -313,16 +452,12 @@ esp_err_t video_player_switch_file(const char *mp4_file)
     }
     
     ESP_LOGI(TAG, "Switching to video: %s", mp4_file);
+    s_video.switch_start_us = esp_timer_get_time();
     
     // Store new file path
     strncpy(s_video.current_file, mp4_file, sizeof(s_video.current_file) - 1);
     s_video.current_file[sizeof(s_video.current_file) - 1] = '\0';
     
-    // Cancel any existing finish timer
-    if (s_video.finish_timer) {
-        esp_timer_stop(s_video.finish_timer);
-    }
-    
     // Soft stop: stop playback but keep adapter/buffers alive
     // This will properly close audio device and reset state flags
     if (s_video.state != VIDEO_STATE_STOPPED) {
@@ -330,6 +465,7 @@ esp_err_t video_player_switch_file(const char *mp4_file)
         if (ret != ESP_OK) {
             ESP_LOGW(TAG, "Failed to stop adapter for switch: %s", esp_err_to_name(ret));
         }
+        video_player_dump_stats();
     }
     
     // Clear error state
@@ -350,29 +486,6 @@ esp_err_t video_player_switch_file(const char *mp4_file)
     ret = app_stream_adapter_start(s_video.adapter);
     if (ret == ESP_OK) {
         s_video.state = VIDEO_STATE_PLAYING;
-        
-        // Setup finish timer for new video
-        uint32_t duration_ms = 0;
-        if (app_stream_adapter_get_info(s_video.adapter, NULL, NULL, NULL, &duration_ms) == ESP_OK && duration_ms > 0) {
-            uint64_t timeout_us = ((uint64_t)duration_ms + 500) * 1000ULL;
-            
-            if (s_video.finish_timer == NULL) {
-                esp_timer_create_args_t t_args = {
-                    .callback = video_finish_timer_cb,
-                    .arg = NULL,
-                    .name = "video_finish"
-                };
-                if (esp_timer_create(&t_args, &s_video.finish_timer) != ESP_OK) {
-                    ESP_LOGW(TAG, "Failed to create finish timer");
-                }
-            }
-            
-            if (s_video.finish_timer) {
-                esp_timer_start_once(s_video.finish_timer, timeout_us);
-                ESP_LOGI(TAG, "Finish timer restarted: %u ms", duration_ms + 500);
-            }
-        }
-        
         ESP_LOGI(TAG, "Video switched successfully: %s", mp4_file);
     } else {
         ESP_LOGE(TAG, "Failed to start new video: %s", esp_err_to_name(ret));
@@ -381,4 +494,36 @@ esp_err_t video_player_switch_file(const char *mp4_file)
     }
     
     return ret;
-} 
\ No newline at end of file
+} 
+
+esp_err_t video_player_prepare_next(const char *mp4_file)
+{
+    if (!s_video.adapter) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!mp4_file) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+#if CONFIG_VIDEO_PREPARE_NEXT
+    return app_stream_adapter_prepare(s_video.adapter, mp4_file, s_video.audio_dev != NULL);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t video_player_parse_ahead(const char *mp4_file)
+{
+    if (!s_video.adapter) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!mp4_file) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+#if CONFIG_VIDEO_PARSE_MOOV_AT_END
+    return app_stream_adapter_parse_ahead(s_video.adapter, mp4_file);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
@@ -24,6 +24,8 @@ esp_err_t video_player_init(esp_codec_dev_handle_t audio_dev);
 esp_err_t video_player_play(const char *mp4_file);
 esp_err_t video_player_pause(void);
 esp_err_t video_player_resume(void);
+// While paused, show the frame permille/1000 into the clip; resume continues from it
+esp_err_t video_player_scrub(uint32_t permille);
 esp_err_t video_player_stop(void);
 esp_err_t video_player_deinit(void);
 
@@ -31,12 +33,29 @@ esp_err_t video_player_deinit(void);
 esp_err_t video_player_set_volume(int volume);
 int video_player_get_volume(void);
 
+// Wrap clips around at their end, in place, instead of finishing them. Holds for
+// the clip playing and the ones after until turned off.
+esp_err_t video_player_set_loop(bool loop);
+
+// Playback speed of the current clip in percent, clamped to 50-800; audio is
+// muted away from 100. Every clip starts at 100.
+esp_err_t video_player_set_speed(uint32_t speed);
+
 video_state_t video_player_get_state(void);
 bool video_player_is_finished(void);
+esp_err_t video_player_dump_stats(void);  // Log the current clip's playback statistics, at any time
 bool video_player_has_error(void);
 esp_err_t video_player_restart_current(void);
 esp_err_t video_player_switch_file(const char *mp4_file);
 
+// Open the clip expected next in the background, so a later play or switch_file
+// of it starts from its first frame without a stall
+esp_err_t video_player_prepare_next(const char *mp4_file);
+
+// Parse the clip's container in the background if its moov sits at the end,
+// so its first play starts without reading through the file
+esp_err_t video_player_parse_ahead(const char *mp4_file);
+
 #ifdef __cplusplus
 }
 #endif 
\ No newline at end of file
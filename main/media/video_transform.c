@@ -0,0 +1,262 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "video_transform.h"
+#include "hal_ppa.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "video_srm";
+
+// The PPA scales in 1/16 steps; video uses the full precision to fill more of the screen
+#define SRM_SCALE_STEP          0.0625f
+#define SRM_MIN_SCALE           0.0625f
+#define SRM_MAX_SCALE           16.0f
+#define SRM_TIMEOUT_MS          200
+#define JPEG_MCU_WIDTH          16
+
+struct video_transform_t {
+    video_transform_config_t config;
+    hal_ppa_client_handle_t ppa_client;
+    SemaphoreHandle_t done_sem;
+    video_transform_stats_t stats;
+    portMUX_TYPE stats_lock;
+};
+
+// PPA transaction done callback (ISR context)
+static bool srm_done_cb(void *user_data)
+{
+    struct video_transform_t *transform = (struct video_transform_t *)user_data;
+    BaseType_t high_task_woken = pdFALSE;
+
+    xSemaphoreGiveFromISR(transform->done_sem, &high_task_woken);
+    return high_task_woken == pdTRUE;
+}
+
+esp_err_t video_transform_create(const video_transform_config_t *config, video_transform_handle_t *ret_transform)
+{
+    if (!config || !ret_transform || config->screen_width == 0 || config->screen_height == 0 ||
+        config->rotation > VIDEO_ROTATION_270) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct video_transform_t *transform = calloc(1, sizeof(*transform));
+    if (!transform) {
+        return ESP_ERR_NO_MEM;
+    }
+    transform->config = *config;
+    portMUX_INITIALIZE(&transform->stats_lock);
+
+    esp_err_t ret = ESP_OK;
+    transform->done_sem = xSemaphoreCreateBinary();
+    if (!transform->done_sem) {
+        ret = ESP_ERR_NO_MEM;
+        goto cleanup;
+    }
+
+    // One frame at a time: the stage waits for each frame before presenting it
+    hal_ppa_client_config_t ppa_config = {
+        .max_pending = 1,
+        .done_cb = srm_done_cb,
+    };
+    ret = hal_ppa_client_create(&ppa_config, &transform->ppa_client);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register PPA client: %s", esp_err_to_name(ret));
+        goto cleanup;
+    }
+
+    ESP_LOGI(TAG, "Video SRM stage: fit to %ux%u, rotation %u deg%s%s%s",
+             config->screen_width, config->screen_height, config->rotation * 90,
+             config->auto_rotate ? " (auto)" : "",
+             config->mirror_x ? ", mirror x" : "", config->mirror_y ? ", mirror y" : "");
+    *ret_transform = transform;
+    return ESP_OK;
+
+cleanup:
+    if (transform->done_sem) {
+        vSemaphoreDelete(transform->done_sem);
+    }
+    free(transform);
+    return ret;
+}
+
+esp_err_t video_transform_delete(video_transform_handle_t transform)
+{
+    if (!transform) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = hal_ppa_client_delete(transform->ppa_client);
+    vSemaphoreDelete(transform->done_sem);
+    free(transform);
+    return ret;
+}
+
+esp_err_t video_transform_plan(video_transform_handle_t transform, uint32_t width, uint32_t height,
+                               size_t decoded_size, video_transform_plan_t *plan)
+{
+    if (!transform || !plan || width == 0 || height == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const video_transform_config_t *config = &transform->config;
+    uint32_t screen_w = config->screen_width;
+    uint32_t screen_h = config->screen_height;
+
+    video_rotation_t rotation = config->rotation;
+    if (config->auto_rotate && (width >= height) != (screen_w >= screen_h)) {
+        rotation = (video_rotation_t)((rotation + 1) % (VIDEO_ROTATION_270 + 1));
+    }
+    bool transposed = (rotation == VIDEO_ROTATION_90 || rotation == VIDEO_ROTATION_270);
+
+    // Source size as it lands on screen
+    uint32_t rotated_w = transposed ? height : width;
+    uint32_t rotated_h = transposed ? width : height;
+
+    // Largest PPA scale step that still fits, so the whole picture stays visible
+    float fit_x = (float)screen_w / rotated_w;
+    float fit_y = (float)screen_h / rotated_h;
+    float scale = floorf((fit_x < fit_y ? fit_x : fit_y) / SRM_SCALE_STEP) * SRM_SCALE_STEP;
+    if (scale < SRM_MIN_SCALE) {
+        scale = SRM_MIN_SCALE;
+    }
+    if (scale > SRM_MAX_SCALE) {
+        scale = SRM_MAX_SCALE;
+    }
+
+    memset(plan, 0, sizeof(*plan));
+    plan->scale = scale;
+    plan->rotation = rotation;
+    plan->in_block_w = width;
+    plan->in_block_h = height;
+
+    // The JPEG decoder pads rows to whole MCUs when the width is not a multiple of them
+    uint32_t padded_w = (width + JPEG_MCU_WIDTH - 1) & ~(JPEG_MCU_WIDTH - 1);
+    plan->in_stride = (decoded_size > (size_t)width * height * 2) ? padded_w : width;
+
+    // Only sources too large even at the minimum scale are cropped, around the centre
+    uint32_t *src_for_w = transposed ? &plan->in_block_h : &plan->in_block_w;
+    uint32_t *src_for_h = transposed ? &plan->in_block_w : &plan->in_block_h;
+    uint32_t *offset_for_w = transposed ? &plan->in_offset_y : &plan->in_offset_x;
+    uint32_t *offset_for_h = transposed ? &plan->in_offset_x : &plan->in_offset_y;
+
+    plan->out_width = (uint32_t)(*src_for_w * scale);
+    if (plan->out_width > screen_w) {
+        uint32_t full = *src_for_w;
+        *src_for_w = (uint32_t)(screen_w / scale);
+        *offset_for_w = (full - *src_for_w) / 2;
+        plan->out_width = screen_w;
+    }
+    plan->out_height = (uint32_t)(*src_for_h * scale);
+    if (plan->out_height > screen_h) {
+        uint32_t full = *src_for_h;
+        *src_for_h = (uint32_t)(screen_h / scale);
+        *offset_for_h = (full - *src_for_h) / 2;
+        plan->out_height = screen_h;
+    }
+
+    plan->passthrough = (scale == 1.0f && rotation == VIDEO_ROTATION_0 &&
+                         !config->mirror_x && !config->mirror_y &&
+                         plan->in_stride == width &&
+                         plan->in_block_w == width && plan->in_block_h == height);
+    return ESP_OK;
+}
+
+esp_err_t video_transform_run(video_transform_handle_t transform, const video_transform_plan_t *plan,
+                              const void *in, size_t in_size, void *out, size_t out_size)
+{
+    if (!transform || !plan || !in || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (out_size < (size_t)plan->out_width * plan->out_height * 2 ||
+        in_size < (size_t)plan->in_stride * (plan->in_offset_y + plan->in_block_h) * 2) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    hal_ppa_srm_op_t op = {
+        .in_buffer = in,
+        .in_pic_w = plan->in_stride,
+        .in_pic_h = plan->in_offset_y + plan->in_block_h,
+        .in_block_w = plan->in_block_w,
+        .in_block_h = plan->in_block_h,
+        .in_block_offset_x = plan->in_offset_x,
+        .in_block_offset_y = plan->in_offset_y,
+        .out_buffer = out,
+        .out_buffer_size = out_size,
+        .out_pic_w = plan->out_width,
+        .out_pic_h = plan->out_height,
+        .scale_x = plan->scale,
+        .scale_y = plan->scale,
+        .rotation = (hal_ppa_rotation_t)plan->rotation,
+        .mirror_x = transform->config.mirror_x,
+        .mirror_y = transform->config.mirror_y,
+        .user_data = transform,
+    };
+
+    // Drop a completion left by a frame that timed out
+    xSemaphoreTake(transform->done_sem, 0);
+
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = hal_ppa_srm_submit(transform->ppa_client, &op);
+    if (ret == ESP_OK && xSemaphoreTake(transform->done_sem, pdMS_TO_TICKS(SRM_TIMEOUT_MS)) != pdTRUE) {
+        ret = ESP_ERR_TIMEOUT;
+    }
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+
+    taskENTER_CRITICAL(&transform->stats_lock);
+    if (ret == ESP_OK) {
+        transform->stats.frames++;
+        transform->stats.last_us = elapsed_us;
+        transform->stats.total_us += elapsed_us;
+        if (elapsed_us > transform->stats.max_us) {
+            transform->stats.max_us = elapsed_us;
+        }
+    } else {
+        transform->stats.failures++;
+    }
+    taskEXIT_CRITICAL(&transform->stats_lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SRM %ux%u -> %ux%u failed: %s", plan->in_block_w, plan->in_block_h,
+                 plan->out_width, plan->out_height, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+void video_transform_count_passthrough(video_transform_handle_t transform)
+{
+    if (!transform) {
+        return;
+    }
+    taskENTER_CRITICAL(&transform->stats_lock);
+    transform->stats.passthrough++;
+    taskEXIT_CRITICAL(&transform->stats_lock);
+}
+
+esp_err_t video_transform_get_stats(video_transform_handle_t transform, video_transform_stats_t *stats)
+{
+    if (!transform || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    taskENTER_CRITICAL(&transform->stats_lock);
+    *stats = transform->stats;
+    taskEXIT_CRITICAL(&transform->stats_lock);
+    return ESP_OK;
+}
+
+void video_transform_reset_stats(video_transform_handle_t transform)
+{
+    if (!transform) {
+        return;
+    }
+    taskENTER_CRITICAL(&transform->stats_lock);
+    memset(&transform->stats, 0, sizeof(transform->stats));
+    taskEXIT_CRITICAL(&transform->stats_lock);
+}
@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Scale-rotate-mirror stage between video decode and present. Each decoded
+// RGB565 frame is fitted into a screen-sized presentation buffer on the PPA
+// (software SRM in the host build), so sources of any size and orientation
+// play without transcoding.
+
+typedef struct video_transform_t *video_transform_handle_t;
+
+// Counter-clockwise, VIDEO_ROTATION_90 matches ffmpeg's transpose=2
+typedef enum {
+    VIDEO_ROTATION_0 = 0,
+    VIDEO_ROTATION_90,
+    VIDEO_ROTATION_180,
+    VIDEO_ROTATION_270,
+} video_rotation_t;
+
+typedef struct {
+    uint32_t screen_width;          // Frames are fitted into this box
+    uint32_t screen_height;
+    video_rotation_t rotation;
+    bool auto_rotate;               // Add 90 degrees when the source and screen orientations differ
+    bool mirror_x;
+    bool mirror_y;
+} video_transform_config_t;
+
+// Geometry chosen for one source size
+typedef struct {
+    uint32_t in_stride;             // Decoder row stride in pixels
+    uint32_t in_block_w;            // Source block, centred, cropped only below PPA minimum scale
+    uint32_t in_block_h;
+    uint32_t in_offset_x;
+    uint32_t in_offset_y;
+    uint32_t out_width;             // Presented frame, at most the screen size
+    uint32_t out_height;
+    float scale;
+    video_rotation_t rotation;
+    bool passthrough;               // Already screen-fitted and upright: present the decoded buffer
+} video_transform_plan_t;
+
+typedef struct {
+    uint32_t frames;                // Frames run through the PPA
+    uint32_t passthrough;           // Frames presented from the decode buffer directly
+    uint32_t failures;
+    uint32_t last_us;               // Submit-to-done time of the last frame
+    uint32_t max_us;
+    uint64_t total_us;
+} video_transform_stats_t;
+
+esp_err_t video_transform_create(const video_transform_config_t *config, video_transform_handle_t *ret_transform);
+esp_err_t video_transform_delete(video_transform_handle_t transform);
+
+// Geometry for a decoded frame of the given size. decoded_size tells whether the
+// decoder padded rows to its 16 pixel MCU width.
+esp_err_t video_transform_plan(video_transform_handle_t transform, uint32_t width, uint32_t height,
+                               size_t decoded_size, video_transform_plan_t *plan);
+
+// Run a planned transform and wait for it. out must come from image_buffer_alloc
+// and hold at least out_width x out_height RGB565 pixels.
+esp_err_t video_transform_run(video_transform_handle_t transform, const video_transform_plan_t *plan,
+                              const void *in, size_t in_size, void *out, size_t out_size);
+
+// Count a frame presented without running the PPA
+void video_transform_count_passthrough(video_transform_handle_t transform);
+
+esp_err_t video_transform_get_stats(video_transform_handle_t transform, video_transform_stats_t *stats);
+void video_transform_reset_stats(video_transform_handle_t transform);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "yuv_convert.h"
+#include <stddef.h>
+
+// BT.601 limited range in 8.8 fixed point: 255/219 for luma, the rest scaled alike
+#define YUV_Y_MUL       298
+#define YUV_RV_MUL      409
+#define YUV_GU_MUL      100
+#define YUV_GV_MUL      208
+#define YUV_BU_MUL      516
+
+// Chroma terms of one 2x2 block, shared by its four pixels
+typedef struct {
+    int32_t r;
+    int32_t g;
+    int32_t b;
+} yuv_chroma_t;
+
+static inline uint8_t clamp_u8(int32_t v)
+{
+    return v < 0 ? 0 : (v > 255 ? 255 : (uint8_t)v);
+}
+
+static inline yuv_chroma_t chroma_terms(uint8_t u, uint8_t v)
+{
+    int32_t d = (int32_t)u - 128;
+    int32_t e = (int32_t)v - 128;
+    yuv_chroma_t c = {
+        .r = YUV_RV_MUL * e + 128,
+        .g = -YUV_GU_MUL * d - YUV_GV_MUL * e + 128,
+        .b = YUV_BU_MUL * d + 128,
+    };
+    return c;
+}
+
+static inline uint16_t pixel_rgb565(uint8_t y, const yuv_chroma_t *c, bool bgr_order)
+{
+    int32_t l = YUV_Y_MUL * ((int32_t)y - 16);
+    uint8_t r = clamp_u8((l + c->r) >> 8);
+    uint8_t g = clamp_u8((l + c->g) >> 8);
+    uint8_t b = clamp_u8((l + c->b) >> 8);
+    uint16_t px = (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+    return bgr_order ? px : (uint16_t)((px << 8) | (px >> 8));
+}
+
+static inline void pixel_rgb888(uint8_t y, const yuv_chroma_t *c, bool bgr_order, uint8_t *out)
+{
+    int32_t l = YUV_Y_MUL * ((int32_t)y - 16);
+    uint8_t r = clamp_u8((l + c->r) >> 8);
+    uint8_t g = clamp_u8((l + c->g) >> 8);
+    uint8_t b = clamp_u8((l + c->b) >> 8);
+    out[0] = bgr_order ? b : r;
+    out[1] = g;
+    out[2] = bgr_order ? r : b;
+}
+
+// Both converters walk the picture a chroma row, so two luma rows, at a time
+void yuv_i420_to_rgb565(const yuv_i420_t *in, uint16_t *out, uint32_t out_stride, bool bgr_order)
+{
+    for (uint32_t row = 0; row + 1 < in->height; row += 2) {
+        const uint8_t *y0 = in->y + row * in->y_stride;
+        const uint8_t *y1 = y0 + in->y_stride;
+        const uint8_t *u = in->u + (row / 2) * in->uv_stride;
+        const uint8_t *v = in->v + (row / 2) * in->uv_stride;
+        uint16_t *out0 = out + row * out_stride;
+        uint16_t *out1 = out0 + out_stride;
+
+        for (uint32_t col = 0; col + 1 < in->width; col += 2) {
+            yuv_chroma_t c = chroma_terms(u[col / 2], v[col / 2]);
+            out0[col] = pixel_rgb565(y0[col], &c, bgr_order);
+            out0[col + 1] = pixel_rgb565(y0[col + 1], &c, bgr_order);
+            out1[col] = pixel_rgb565(y1[col], &c, bgr_order);
+            out1[col + 1] = pixel_rgb565(y1[col + 1], &c, bgr_order);
+        }
+    }
+}
+
+void yuv_i420_to_rgb888(const yuv_i420_t *in, uint8_t *out, uint32_t out_stride, bool bgr_order)
+{
+    for (uint32_t row = 0; row + 1 < in->height; row += 2) {
+        const uint8_t *y0 = in->y + row * in->y_stride;
+        const uint8_t *y1 = y0 + in->y_stride;
+        const uint8_t *u = in->u + (row / 2) * in->uv_stride;
+        const uint8_t *v = in->v + (row / 2) * in->uv_stride;
+        uint8_t *out0 = out + (size_t)row * out_stride * 3;
+        uint8_t *out1 = out0 + (size_t)out_stride * 3;
+
+        for (uint32_t col = 0; col + 1 < in->width; col += 2) {
+            yuv_chroma_t c = chroma_terms(u[col / 2], v[col / 2]);
+            pixel_rgb888(y0[col], &c, bgr_order, out0 + col * 3);
+            pixel_rgb888(y0[col + 1], &c, bgr_order, out0 + col * 3 + 3);
+            pixel_rgb888(y1[col], &c, bgr_order, out1 + col * 3);
+            pixel_rgb888(y1[col + 1], &c, bgr_order, out1 + col * 3 + 3);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Colour conversion of decoded video pictures into the layouts the JPEG engine
+// writes, so H.264 frames take the same transform and display path as MJPEG.
+// BT.601 limited range, the colour space of H.264 baseline streams.
+
+// Planar 4:2:0 picture, chroma planes at half the width and height
+typedef struct {
+    const uint8_t *y;
+    const uint8_t *u;
+    const uint8_t *v;
+    uint32_t y_stride;              // Bytes per row
+    uint32_t uv_stride;
+    uint32_t width;                 // Even sizes, as H.264 4:2:0 streams have
+    uint32_t height;
+} yuv_i420_t;
+
+// Rows of width pixels at out_stride pixels apart. bgr_order matches the JPEG
+// engine's element order: native 16-bit pixels with it, byte-swapped without.
+void yuv_i420_to_rgb565(const yuv_i420_t *in, uint16_t *out, uint32_t out_stride, bool bgr_order);
+
+// Three bytes per pixel, B G R in memory with bgr_order and R G B without
+void yuv_i420_to_rgb888(const yuv_i420_t *in, uint8_t *out, uint32_t out_stride, bool bgr_order);
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,7 +5,9 @@
 
 #include "file_manager.h"
 #include "photo_album_constants.h"
-#include "bsp/esp-bsp.h"
+#include "image_buffer.h"
+#include "hal_sdcard.h"
+#include "hal_jpeg.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include <dirent.h>
@@ -16,7 +18,6 @@
 #include <unistd.h>
 #include <errno.h>
 #include "esp_timer.h"
-#include "driver/jpeg_decode.h"
 
 static const char *TAG = "file_mgr";
 static sd_status_t s_sd_status = SD_STATUS_UNMOUNTED;
@@ -153,8 +154,8 @@ static bool validate_image_file(const char *file_path, image_format_t format, si
     }
 
     if (format == IMAGE_FORMAT_JPEG) {
-        jpeg_decode_picture_info_t pic_info;
-        esp_err_t ret = jpeg_decoder_get_info(header_buf, (uint32_t)bytes, &pic_info);
+        hal_jpeg_info_t pic_info;
+        esp_err_t ret = hal_jpeg_get_info(header_buf, (size_t)bytes, &pic_info);
         if (ret != ESP_OK) {
             ESP_LOGW(TAG, "Skip %s: JPEG header parse err (%s)", file_path, esp_err_to_name(ret));
             return false;
@@ -178,7 +179,7 @@ static bool validate_image_file(const char *file_path, image_format_t format, si
         const uint64_t MAX_DECODE_BUFFER = PRACTICAL_DECODE_BUFFER_LIMIT; // Use practical decode buffer limit
         
         if (required_bytes > MAX_DECODE_BUFFER) {
-            ESP_LOGW(TAG, "Skip %s: %ux%u requires %llu bytes, exceeds decode buffer %llu bytes", 
+            ESP_LOGW(TAG, "Skip %s: %ux%u requires %" PRIu64 " bytes, exceeds decode buffer %" PRIu64 " bytes", 
                      file_path, pic_info.width, pic_info.height, required_bytes, MAX_DECODE_BUFFER);
             return false;
         }
@@ -188,7 +189,7 @@ static bool validate_image_file(const char *file_path, image_format_t format, si
             uint64_t total_pixels = (uint64_t)pic_info.width * pic_info.height;
             uint64_t max_pixels   = (uint64_t)MAX_DECODE_WIDTH * MAX_DECODE_HEIGHT;
             if (total_pixels > max_pixels) {
-                ESP_LOGW(TAG, "Skip %s: %ux%u (%llu px) exceeds pixel budget %llu px", 
+                ESP_LOGW(TAG, "Skip %s: %ux%u (%" PRIu64 " px) exceeds pixel budget %" PRIu64 " px", 
                          file_path, pic_info.width, pic_info.height, total_pixels, max_pixels);
                 return false;
             }
@@ -214,7 +215,7 @@ static bool validate_image_file(const char *file_path, image_format_t format, si
         const uint64_t MAX_DECODE_BUFFER = PRACTICAL_DECODE_BUFFER_LIMIT;
         
         if (required_bytes > MAX_DECODE_BUFFER) {
-            ESP_LOGW(TAG, "Skip %s: PNG %ux%u requires %llu bytes, exceeds decode buffer", 
+            ESP_LOGW(TAG, "Skip %s: PNG %ux%u requires %" PRIu64 " bytes, exceeds decode buffer", 
                      file_path, width, height, required_bytes);
             return false;
         }
@@ -224,7 +225,7 @@ static bool validate_image_file(const char *file_path, image_format_t format, si
             uint64_t total_pixels = (uint64_t)width * height;
             uint64_t max_pixels = (uint64_t)MAX_DECODE_WIDTH * MAX_DECODE_HEIGHT;
             if (total_pixels > max_pixels) {
-                ESP_LOGW(TAG, "Skip %s: PNG %ux%u (%llu px) exceeds pixel budget %llu px", 
+                ESP_LOGW(TAG, "Skip %s: PNG %ux%u (%" PRIu64 " px) exceeds pixel budget %" PRIu64 " px", 
                          file_path, width, height, total_pixels, max_pixels);
                 return false;
             }
@@ -292,7 +293,7 @@ static esp_err_t scan_directory_recursive(const char *dir_path, photo_collection
 
 esp_err_t file_manager_init(void)
 {
-    esp_err_t ret = bsp_sdcard_mount();
+    esp_err_t ret = hal_sdcard_mount();
     if (ret == ESP_OK) {
         s_sd_status = SD_STATUS_MOUNTED;
         ESP_LOGD(TAG, "SD card mounted successfully");
@@ -314,7 +315,7 @@ esp_err_t file_manager_init(void)
 
 esp_err_t file_manager_deinit(void)
 {
-    esp_err_t ret = bsp_sdcard_unmount();
+    esp_err_t ret = hal_sdcard_unmount();
     s_sd_status = SD_STATUS_UNMOUNTED;
     return ret;
 }
@@ -381,18 +382,12 @@ esp_err_t file_manager_load_image(const char *file_path, uint8_t **data, size_t
         return ESP_FAIL;
     }
     
-    // Allocate memory (prefer PSRAM for large images)
-    *data = heap_caps_malloc(*size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    // Allocate cache-aligned memory so the decoder can DMA from it directly
+    *data = image_buffer_alloc(*size, NULL);
     if (!*data) {
-        *data = malloc(*size);
-        if (!*data) {
-            ESP_LOGE(TAG, "Failed to allocate memory for %zu bytes", *size);
-            close(fd);
-            return ESP_ERR_NO_MEM;
-        }
-        ESP_LOGD(TAG, "Using internal RAM for %zu bytes (PSRAM unavailable)", *size);
-    } else {
-        ESP_LOGD(TAG, "Using PSRAM for %zu bytes", *size);
+        ESP_LOGE(TAG, "Failed to allocate memory for %zu bytes", *size);
+        close(fd);
+        return ESP_ERR_NO_MEM;
     }
     
     // Read file using POSIX read() with optimized buffer size for better SD card performance
@@ -412,7 +407,7 @@ esp_err_t file_manager_load_image(const char *file_path, uint8_t **data, size_t
         ssize_t result = read(fd, buffer_ptr + bytes_read, to_read);
         if (result < 0) {
             ESP_LOGE(TAG, "Failed to read from file: %s (errno: %d)", file_path, errno);
-            free(*data);
+            image_buffer_free(*data);
             *data = NULL;
             close(fd);
             return ESP_FAIL;
@@ -420,7 +415,7 @@ esp_err_t file_manager_load_image(const char *file_path, uint8_t **data, size_t
             // End of file reached unexpectedly
             ESP_LOGE(TAG, "Unexpected EOF in file: %s (read %zu/%zu bytes)", 
                      file_path, bytes_read, *size);
-            free(*data);
+            image_buffer_free(*data);
             *data = NULL;
             close(fd);
             return ESP_FAIL;
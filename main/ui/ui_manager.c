@@ -8,27 +8,34 @@
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "bsp/esp-bsp.h"
+#include "hal_display.h"
 #include <string.h>
 #include <math.h>
 #include "esp_timer.h"
 
 // Forward declaration for volume auto-hide callback
 static void volume_hide_timer_cb(void *arg);
+static void video_retire_frame(void);
+static void video_direct_exit(void);
 
 static const char *TAG = "ui_mgr";
 
+// Replaced video frames waiting for a refresh to finish: up to every frame buffer
+// of both adapter pools
+#define UI_VIDEO_RETIRED_MAX    12
+
 // Helper macros for LVGL locking
 #define UI_LOCK() do { \
-    if (!bsp_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) { \
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) { \
         ESP_LOGE(TAG, "Failed to acquire display lock"); \
         return ESP_ERR_TIMEOUT; \
     } \
 } while(0)
 
-#define UI_UNLOCK() bsp_display_unlock()
+#define UI_UNLOCK() hal_display_unlock()
 
 #define UI_LOCK_VOID() do { \
-    if (!bsp_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) { \
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) { \
         ESP_LOGE(TAG, "Failed to acquire display lock"); \
         return; \
     } \
@@ -43,6 +50,15 @@ static struct {
     lv_obj_t *time_roller;
     lv_obj_t *progress_label;
     lv_obj_t *video_canvas;
+    const uint8_t *video_frame;     // Buffer the canvas shows
+    const uint8_t *video_retired[UI_VIDEO_RETIRED_MAX];
+    uint32_t video_retired_count;
+    uint32_t video_width;
+    uint32_t video_height;
+    ui_video_frame_release_cb_t video_release_cb;
+    void *video_release_user_data;
+    bool video_refr_event_added;
+    video_output_handle_t video_output;
     lv_indev_t *touch_indev;
     ui_event_cb_t event_cb;
     void *user_data;
@@ -55,6 +71,10 @@ static struct {
     lv_point_t touch_start_pos;
     lv_point_t touch_last_pos;
     bool swipe_detected;
+    // Scrubbing (paused video)
+    bool scrub_enabled;
+    bool scrubbing;
+    uint32_t scrub_position;
     // Volume UI
     lv_obj_t *volume_container;
     lv_obj_t *volume_bar;
@@ -84,9 +104,35 @@ static void main_screen_event_cb(lv_event_t *e)
             s_ui.touch_last_pos = point;
             s_ui.touch_started = true;
             s_ui.swipe_detected = false;
+            s_ui.scrubbing = false;
+        }
+    }
+
+    if (code == LV_EVENT_PRESSING && s_ui.touch_started && s_ui.scrub_enabled &&
+            s_ui.current_mode == UI_MODE_VIDEO && indev) {
+        lv_point_t point;
+        lv_indev_get_point(indev, &point);
+        int32_t dx = point.x - s_ui.touch_start_pos.x;
+        int32_t dy = point.y - s_ui.touch_start_pos.y;
+
+        // A horizontal drag becomes a scrub; the finger's position picks the time
+        if (!s_ui.scrubbing && abs(dx) > 30 && abs(dx) > abs(dy)) {
+            s_ui.scrubbing = true;
+            s_ui.swipe_detected = true;
+        }
+        int32_t width = lv_display_get_horizontal_resolution(NULL);
+        if (s_ui.scrubbing && point.x != s_ui.touch_last_pos.x && width > 0) {
+            int32_t x = point.x < 0 ? 0 : (point.x >= width ? width - 1 : point.x);
+            s_ui.scrub_position = (uint32_t)x * 1000 / (uint32_t)width;
+            s_ui.touch_last_pos = point;
+            if (s_ui.event_cb) s_ui.event_cb(UI_EVENT_SCRUB, s_ui.user_data);
         }
     }
     
+    if (code == LV_EVENT_RELEASED && s_ui.touch_started && s_ui.scrubbing) {
+        s_ui.touch_started = false;
+    }
+
     if (code == LV_EVENT_RELEASED && s_ui.touch_started) {
         if (indev) {
             lv_point_t point;
@@ -136,7 +182,7 @@ static void main_screen_event_cb(lv_event_t *e)
         }
     }
     
-    if (code == LV_EVENT_GESTURE) {
+    if (code == LV_EVENT_GESTURE && !(s_ui.scrub_enabled && s_ui.current_mode == UI_MODE_VIDEO)) {
         lv_dir_t dir = lv_indev_get_gesture_dir(indev);
         if (dir == LV_DIR_LEFT) {
             if (s_ui.event_cb) s_ui.event_cb(UI_EVENT_SWIPE_LEFT, s_ui.user_data);
@@ -170,7 +216,7 @@ static void settings_cancel_event_cb(lv_event_t *e)
 
 static void create_main_screen(void)
 {
-    if (!bsp_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
         ESP_LOGE(TAG, "Failed to acquire display lock");
         return;
     }
@@ -237,19 +283,19 @@ static void create_main_screen(void)
     lv_scr_load(s_ui.main_screen);
     
     // Get touch input device for debugging
-    s_ui.touch_indev = bsp_display_get_input_dev();
+    s_ui.touch_indev = lv_indev_get_next(NULL);
     if (s_ui.touch_indev) {
         ESP_LOGD(TAG, "Touch device found: %p", s_ui.touch_indev);
     } else {
         ESP_LOGW(TAG, "Touch device not found!");
     }
     
-    bsp_display_unlock();
+    hal_display_unlock();
 }
 
 static void create_settings_panel(void)
 {
-    if (!bsp_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
         ESP_LOGE(TAG, "Failed to acquire display lock for settings panel creation");
         return;
     }
@@ -364,15 +410,15 @@ static void create_settings_panel(void)
     lv_obj_set_style_text_font(cancel_label, &lv_font_montserrat_20, 0);  // Larger font
     lv_obj_center(cancel_label);
     
-    bsp_display_unlock();
+    hal_display_unlock();
 }
 
 static void volume_hide_timer_cb(void *arg)
 {
-    if (!bsp_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) return;
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) return;
     lv_obj_add_flag(s_ui.volume_container, LV_OBJ_FLAG_HIDDEN);
     s_ui.volume_visible = false;
-    bsp_display_unlock();
+    hal_display_unlock();
 }
 
 esp_err_t ui_manager_init(ui_event_cb_t event_cb, void *user_data)
@@ -461,7 +507,9 @@ esp_err_t ui_manager_show_loading(void)
     UI_LOCK();
     
     if (s_ui.current_mode == UI_MODE_VIDEO && s_ui.video_canvas) {
+        video_direct_exit();
         lv_obj_add_flag(s_ui.video_canvas, LV_OBJ_FLAG_HIDDEN);
+        video_retire_frame();
     }
     
     lv_obj_clear_flag(s_ui.loading_spinner, LV_OBJ_FLAG_HIDDEN);
@@ -485,6 +533,7 @@ esp_err_t ui_manager_show_settings(uint32_t current_interval)
     }
     
     UI_LOCK();
+    video_direct_exit();
     
     for (size_t i = 0; i < time_count; i++) {
         if (time_intervals[i] == current_interval) {
@@ -547,14 +596,14 @@ uint32_t ui_manager_get_selected_interval(void)
         return DEFAULT_SLIDESHOW_MS;
     }
     
-    if (!bsp_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
         ESP_LOGE(TAG, "Failed to acquire display lock");
         return DEFAULT_SLIDESHOW_MS;
     }
     
     uint16_t selected = lv_roller_get_selected(s_ui.time_roller);
     
-    bsp_display_unlock();
+    hal_display_unlock();
     
     if (selected < time_count) {
         return time_intervals[selected]; // Already in milliseconds
@@ -563,9 +612,163 @@ uint32_t ui_manager_get_selected_interval(void)
     return DEFAULT_SLIDESHOW_MS;
 }
 
+// -------------------- Video frame release --------------------
+// All of these run with the display lock held.
+
+static void video_release_retired(void)
+{
+    for (uint32_t i = 0; i < s_ui.video_retired_count; i++) {
+        if (s_ui.video_release_cb) {
+            s_ui.video_release_cb(s_ui.video_retired[i], s_ui.video_release_user_data);
+        }
+    }
+    s_ui.video_retired_count = 0;
+}
+
+// The canvas no longer points at the current frame; release it after the next refresh.
+// Frames shown by the direct output were copied to the panel and go back at once.
+static void video_retire_frame(void)
+{
+    if (!s_ui.video_frame) {
+        return;
+    }
+    if (video_output_is_active(s_ui.video_output)) {
+        if (s_ui.video_release_cb) {
+            s_ui.video_release_cb(s_ui.video_frame, s_ui.video_release_user_data);
+        }
+        s_ui.video_frame = NULL;
+        return;
+    }
+    if (s_ui.video_retired_count == UI_VIDEO_RETIRED_MAX) {
+        // Cannot happen with the adapter's pool depths; never leak a buffer
+        ESP_LOGW(TAG, "Too many video frames waiting for a refresh");
+        video_release_retired();
+    }
+    s_ui.video_retired[s_ui.video_retired_count++] = s_ui.video_frame;
+    s_ui.video_frame = NULL;
+}
+
+// A refresh has rendered everything invalidated before it started, so frames
+// retired earlier are no longer read
+static void video_refr_ready_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_REFR_READY) {
+        video_release_retired();
+    }
+}
+
+esp_err_t ui_manager_set_video_frame_release_cb(ui_video_frame_release_cb_t cb, void *user_data)
+{
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    if (!s_ui.video_refr_event_added && cb) {
+        lv_display_t *disp = lv_display_get_default();
+        if (disp) {
+            lv_display_add_event_cb(disp, video_refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+            s_ui.video_refr_event_added = true;
+        }
+    }
+
+    // No refresh is running while the lock is held, and retired frames are no
+    // longer referenced, so hand them back before switching owners
+    video_release_retired();
+    s_ui.video_release_cb = cb;
+    s_ui.video_release_user_data = user_data;
+
+    hal_display_unlock();
+    return ESP_OK;
+}
+
+esp_err_t ui_manager_set_video_scrub(bool enabled)
+{
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    s_ui.scrub_enabled = enabled;
+    s_ui.scrubbing = false;
+    hal_display_unlock();
+    return ESP_OK;
+}
+
+uint32_t ui_manager_get_scrub_position(void)
+{
+    return s_ui.scrub_position;
+}
+
+esp_err_t ui_manager_set_video_output(video_output_handle_t output)
+{
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    video_direct_exit();
+    s_ui.video_output = output;
+    hal_display_unlock();
+    return ESP_OK;
+}
+
+static bool video_overlay_visible(void)
+{
+    return s_ui.settings_visible || s_ui.volume_visible ||
+           !lv_obj_has_flag(s_ui.loading_spinner, LV_OBJ_FLAG_HIDDEN);
+}
+
+// Hand the panel back to LVGL with the last direct frame on the canvas, so an
+// overlay can be composited over it
+static void video_direct_exit(void)
+{
+    if (!video_output_is_active(s_ui.video_output)) {
+        return;
+    }
+    video_output_end(s_ui.video_output);
+
+    if (s_ui.video_frame && s_ui.video_canvas) {
+        lv_canvas_set_buffer(s_ui.video_canvas, (void*)s_ui.video_frame,
+                             s_ui.video_width, s_ui.video_height, LV_COLOR_FORMAT_RGB565);
+        lv_obj_set_size(s_ui.video_canvas, s_ui.video_width, s_ui.video_height);
+        lv_obj_center(s_ui.video_canvas);
+        lv_obj_clear_flag(s_ui.video_canvas, LV_OBJ_FLAG_HIDDEN);
+    }
+    // Scanout may still be on a buffer LVGL has not drawn
+    lv_obj_invalidate(lv_screen_active());
+}
+
+// Show a frame through the direct output, taking the panel from LVGL first if needed
+static esp_err_t video_direct_present(const uint8_t *frame_buffer, uint32_t width, uint32_t height)
+{
+    if (!video_output_is_active(s_ui.video_output)) {
+        // Let LVGL draw the hidden canvas and release what it showed before
+        // it stops flipping
+        if (s_ui.video_canvas) {
+            lv_obj_add_flag(s_ui.video_canvas, LV_OBJ_FLAG_HIDDEN);
+        }
+        video_retire_frame();
+        lv_refr_now(NULL);
+
+        esp_err_t ret = video_output_begin(s_ui.video_output);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    esp_err_t ret = video_output_present(s_ui.video_output, frame_buffer,
+                                         (size_t)width * height * 2, width, height);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // Kept until the next frame so video_direct_exit() can put it on the canvas
+    video_retire_frame();
+    s_ui.video_frame = frame_buffer;
+    s_ui.video_width = width;
+    s_ui.video_height = height;
+    return ESP_OK;
+}
+
 esp_err_t ui_manager_switch_mode(ui_mode_t mode)
 {
-    if (!bsp_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
         return ESP_ERR_TIMEOUT;
     }
     
@@ -573,11 +776,13 @@ esp_err_t ui_manager_switch_mode(ui_mode_t mode)
     
     switch (mode) {
         case UI_MODE_IMAGE:
+            video_direct_exit();
             lv_obj_clear_flag(s_ui.img_obj, LV_OBJ_FLAG_HIDDEN);
             lv_obj_clear_flag(s_ui.progress_label, LV_OBJ_FLAG_HIDDEN);
             if (s_ui.video_canvas) {
                 lv_obj_add_flag(s_ui.video_canvas, LV_OBJ_FLAG_HIDDEN);
             }
+            video_retire_frame();
             break;
             
         case UI_MODE_VIDEO:
@@ -586,7 +791,7 @@ esp_err_t ui_manager_switch_mode(ui_mode_t mode)
             break;
     }
     
-    bsp_display_unlock();
+    hal_display_unlock();
     return ESP_OK;
 }
 
@@ -594,9 +799,20 @@ esp_err_t ui_manager_display_video_frame(const uint8_t *frame_buffer, uint32_t w
 {
     if (!frame_buffer) return ESP_ERR_INVALID_ARG;
     
-    if (!bsp_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) {
         return ESP_ERR_TIMEOUT;
     }
+
+    // Straight to the panel unless LVGL has something to draw over the video
+    if (s_ui.video_output && s_ui.current_mode == UI_MODE_VIDEO && !video_overlay_visible()) {
+        esp_err_t ret = video_direct_present(frame_buffer, width, height);
+        if (ret == ESP_OK) {
+            hal_display_unlock();
+            return ESP_OK;
+        }
+        ESP_LOGW(TAG, "Direct video output failed, using the canvas: %s", esp_err_to_name(ret));
+    }
+    video_direct_exit();
     
     if (!s_ui.video_canvas) {
         s_ui.video_canvas = lv_canvas_create(s_ui.main_screen);
@@ -607,16 +823,21 @@ esp_err_t ui_manager_display_video_frame(const uint8_t *frame_buffer, uint32_t w
         lv_obj_clear_flag(s_ui.video_canvas, LV_OBJ_FLAG_CLICKABLE);
     }
     
-    // Zero-copy: directly set buffer pointer
+    // Zero-copy: directly set buffer pointer. The previous frame stays owned by
+    // the display until the refresh that replaces it has finished.
+    video_retire_frame();
     lv_canvas_set_buffer(s_ui.video_canvas, (void*)frame_buffer,
                         width, height, LV_COLOR_FORMAT_RGB565);
+    s_ui.video_frame = frame_buffer;
+    s_ui.video_width = width;
+    s_ui.video_height = height;
     
     lv_obj_set_size(s_ui.video_canvas, width, height);
     lv_obj_center(s_ui.video_canvas);
     lv_obj_clear_flag(s_ui.video_canvas, LV_OBJ_FLAG_HIDDEN);
     lv_obj_add_flag(s_ui.loading_spinner, LV_OBJ_FLAG_HIDDEN);
     
-    bsp_display_unlock();
+    hal_display_unlock();
     return ESP_OK;
 }
 
@@ -628,6 +849,7 @@ esp_err_t ui_manager_show_volume(int volume_percent)
     if (volume_percent > MAX_AUDIO_VOLUME) volume_percent = MAX_AUDIO_VOLUME;
 
     UI_LOCK();
+    video_direct_exit();
 
     lv_bar_set_value(s_ui.volume_bar, volume_percent, LV_ANIM_OFF);
     lv_label_set_text_fmt(s_ui.volume_label, "%d%%", volume_percent);
@@ -8,6 +8,7 @@
 #include "photo_album.h"
 #include "esp_err.h"
 #include "lvgl.h"
+#include "video_output.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,7 +29,8 @@ typedef enum {
     UI_EVENT_LONG_PRESS,
     UI_EVENT_TAP,
     UI_EVENT_SETTINGS_CLOSE,
-    UI_EVENT_SETTINGS_CANCEL
+    UI_EVENT_SETTINGS_CANCEL,
+    UI_EVENT_SCRUB          // Horizontal drag while scrubbing is enabled, see ui_manager_get_scrub_position()
 } ui_event_t;
 
 // UI event callback
@@ -49,6 +51,23 @@ uint32_t ui_manager_get_selected_interval(void);
 esp_err_t ui_manager_switch_mode(ui_mode_t mode);
 esp_err_t ui_manager_display_video_frame(const uint8_t *frame_buffer, uint32_t width, uint32_t height);
 
+// Called once the display can no longer read a frame passed to
+// ui_manager_display_video_frame(): it was replaced or hidden and a refresh
+// has completed since. Runs in the LVGL task with the display lock held.
+typedef void (*ui_video_frame_release_cb_t)(const uint8_t *frame_buffer, void *user_data);
+esp_err_t ui_manager_set_video_frame_release_cb(ui_video_frame_release_cb_t cb, void *user_data);
+
+// Present video frames straight to the panel while no overlay is visible,
+// falling back to the LVGL canvas whenever one is. NULL keeps the canvas only.
+esp_err_t ui_manager_set_video_output(video_output_handle_t output);
+
+// While enabled, horizontal drags in video mode scrub instead of swiping to
+// the next item: UI_EVENT_SCRUB is sent as the finger moves
+esp_err_t ui_manager_set_video_scrub(bool enabled);
+
+// Finger position of the last UI_EVENT_SCRUB across the screen, 0-1000
+uint32_t ui_manager_get_scrub_position(void);
+
 // Volume display (video mode)
 esp_err_t ui_manager_show_volume(int volume_percent);
 
@@ -5,6 +5,7 @@
 
 #include "usb_status_ui.h"
 #include "usb_manager.h"
+#include "hal_display.h"
 #include "photo_album_constants.h"
 #include "bsp/esp-bsp.h"
 #include "esp_log.h"
@@ -15,16 +16,16 @@ static const char *TAG = "usb_status_ui";
 
 // Helper macros for LVGL locking
 #define UI_LOCK() do { \
-    if (!bsp_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) { \
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) { \
         ESP_LOGE(TAG, "Failed to acquire display lock"); \
         return ESP_ERR_TIMEOUT; \
     } \
 } while(0)
 
-#define UI_UNLOCK() bsp_display_unlock()
+#define UI_UNLOCK() hal_display_unlock()
 
 #define UI_LOCK_VOID() do { \
-    if (!bsp_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) { \
+    if (!hal_display_lock(UI_DISPLAY_LOCK_TIMEOUT)) { \
         ESP_LOGE(TAG, "Failed to acquire display lock"); \
         return; \
     } \